@@ -21,6 +21,12 @@ OpenAce::PostConstruct AceSpi::postConstruct()
     gpio_set_function(clk, GPIO_FUNC_SPI);
     gpio_set_function(mosi, GPIO_FUNC_SPI);
 
+    // Without DMA channels all transfers are blocking, which is slower but works
+    if (!dma.init())
+    {
+        puts("AceSpi: No DMA channels available, using blocking transfers");
+    }
+
     // Reset ALL devices
     resetDevices();
     printf("Initialised on miso:%d clk:%d mosi:%d rst:%d (devices reset) ", miso, clk, mosi, rst);
@@ -53,6 +59,7 @@ void AceSpi::aceSpiTask(void *arg)
                 lastBusFrequency = comsumerRequest.busFrequency;
                 spi_init(OPENACE_SPI_DEFAULT, lastBusFrequency * 1000'000);
             }
+            aceSpi->dma.owner(comsumerRequest.taskHandle);
             xTaskNotify( comsumerRequest.taskHandle, comsumerRequest.notificationValue, eSetBits);
             if (!ulTaskNotifyTake( pdTRUE,  TASK_DELAY_MS(INIT_SPI_MAX_WAIT)))
             {
@@ -67,6 +74,16 @@ void AceSpi::aceSpiTask(void *arg)
     }
 }
 
+void AceSpi::getData(etl::string_stream &stream, const etl::string_view path) const
+{
+    (void)path;
+    stream << "{";
+    stream << "\"dmaTransfers\":" << dma.dmaTransfers();
+    stream << ",\"blockingTransfers\":" << dma.blockingTransfers();
+    stream << ",\"dmaTimeouts\":" << dma.timeouts();
+    stream << "}\n";
+}
+
 void AceSpi::on_receive_unknown(const etl::imessage& msg)
 {
     (void)msg;
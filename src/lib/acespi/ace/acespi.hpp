@@ -23,6 +23,8 @@
 #include "ace/basemodule.hpp"
 #include "ace/messages.hpp"
 
+#include "spidma.hpp"
+
 
 
 
@@ -49,6 +51,7 @@ private:
     const uint8_t rst;
     QueueHandle_t spiConsumerQueue;
     TaskHandle_t taskHandle;
+    mutable SpiDma dma;
 public:
     static constexpr const etl::string_view NAME = "AceSpi";
     AceSpi(etl::imessage_bus& bus, const OpenAce::PinTypeMap &pins) : SpiModule(bus),
@@ -57,7 +60,8 @@ public:
         miso(pins.at(OpenAce::PinType::MISO)),
         rst(pins.at(OpenAce::PinType::RST)),
         spiConsumerQueue(nullptr),
-        taskHandle(nullptr)
+        taskHandle(nullptr),
+        dma(OPENACE_SPI_DEFAULT)
     {
     }
     AceSpi(etl::imessage_bus& bus, const Configuration &config) : AceSpi(bus, config.pinMap(NAME))
@@ -71,12 +75,12 @@ public:
     virtual void start() override
     {
         xTaskCreate(aceSpiTask, "AceSpiTask", configMINIMAL_STACK_SIZE+128, this, tskIDLE_PRIORITY, &taskHandle);
-        getBus().subscribe(*this);
+        subscribe(*this);
     };
 
     virtual void stop() override
     {
-        getBus().unsubscribe(*this);
+        unsubscribe(*this);
         vTaskDelete(taskHandle);
     };
 
@@ -86,7 +90,7 @@ public:
         cs_select(cs);
         spi_write_blocking(OPENACE_SPI_DEFAULT, &reg, 1);
         vTaskDelay(TASK_DELAY_MS(delayMs));
-        spi_read_blocking(OPENACE_SPI_DEFAULT, 0, buf, len);
+        dma.read(buf, len);
         cs_deselect(cs);
         vTaskDelay(TASK_DELAY_MS(delayMs));
     }
@@ -100,7 +104,7 @@ public:
 
     virtual void read_registers_read(uint8_t cs, uint8_t *buf, uint16_t len) const override
     {
-        spi_read_blocking(OPENACE_SPI_DEFAULT, 0, buf, len);
+        dma.read(buf, len);
         cs_deselect(cs);
     }
 
@@ -121,7 +125,7 @@ public:
     virtual void write_array(uint8_t cs, uint8_t *data, uint8_t length, uint8_t delayMs) const override
     {
         cs_select(cs);
-        spi_write_blocking(OPENACE_SPI_DEFAULT, data, length);
+        dma.write(data, length);
         cs_deselect(cs);
         vTaskDelay(TASK_DELAY_MS(delayMs));
     }
@@ -131,6 +135,16 @@ public:
         write_array(cs, &data, 1, delayMs);
     }
 
+    virtual int write_data(const uint8_t *data, size_t length) const override
+    {
+        return dma.write(data, length);
+    }
+
+    virtual int read_data(uint8_t *buf, size_t length) const override
+    {
+        return dma.read(buf, length);
+    }
+
     /**
      * Client registering to be called every xxms
     */
@@ -138,6 +152,7 @@ public:
 
     virtual void releaseSlot() const override
     {
+        dma.owner(nullptr);
         xTaskNotifyGive(taskHandle);
     }
 
@@ -154,5 +169,7 @@ public:
 
     static void aceSpiTask(void *arg);
 
+    virtual void getData(etl::string_stream &stream, const etl::string_view path) const override;
+
     void on_receive_unknown(const etl::imessage& msg);
 };
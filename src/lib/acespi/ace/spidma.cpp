@@ -0,0 +1,128 @@
+#include "spidma.hpp"
+
+bool SpiDma::init()
+{
+    txChannel = dma_claim_unused_channel(false);
+    rxChannel = dma_claim_unused_channel(false);
+    if (txChannel < 0 || rxChannel < 0)
+    {
+        deinit();
+        return false;
+    }
+
+    interruptHandler = this;
+    irq_add_shared_handler(DMA_IRQ, dmaInterrupt, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    dma_channel_set_irq1_enabled(rxChannel, true);
+    irq_set_enabled(DMA_IRQ, true);
+    return true;
+}
+
+void SpiDma::deinit()
+{
+    if (rxChannel >= 0 && interruptHandler == this)
+    {
+        dma_channel_set_irq1_enabled(rxChannel, false);
+        irq_remove_handler(DMA_IRQ, dmaInterrupt);
+        interruptHandler = nullptr;
+    }
+    if (txChannel >= 0)
+    {
+        dma_channel_unclaim(txChannel);
+        txChannel = -1;
+    }
+    if (rxChannel >= 0)
+    {
+        dma_channel_unclaim(rxChannel);
+        rxChannel = -1;
+    }
+}
+
+bool SpiDma::useDma(size_t length) const
+{
+    return length >= MIN_DMA_LENGTH &&
+           rxChannel >= 0 &&
+           slotOwner != nullptr &&
+           xTaskGetSchedulerState() == taskSCHEDULER_RUNNING &&
+           xTaskGetCurrentTaskHandle() == slotOwner;
+}
+
+int SpiDma::transfer(const uint8_t *src, uint8_t *dst, size_t length)
+{
+    if (!useDma(length))
+    {
+        statistics.blockingTransfers++;
+        if (dst != nullptr)
+        {
+            return spi_read_blocking(spi, 0, dst, length);
+        }
+        return spi_write_blocking(spi, src, length);
+    }
+
+    dma_channel_config config = dma_channel_get_default_config(txChannel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+    channel_config_set_dreq(&config, spi_get_dreq(spi, true));
+    channel_config_set_read_increment(&config, src != nullptr);
+    channel_config_set_write_increment(&config, false);
+    dma_channel_configure(txChannel, &config, &spi_get_hw(spi)->dr, src != nullptr ? src : &txZero, length, false);
+
+    config = dma_channel_get_default_config(rxChannel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+    channel_config_set_dreq(&config, spi_get_dreq(spi, false));
+    channel_config_set_read_increment(&config, false);
+    channel_config_set_write_increment(&config, dst != nullptr);
+    dma_channel_configure(rxChannel, &config, dst != nullptr ? dst : &rxSink, &spi_get_hw(spi)->dr, length, false);
+
+    // A completion that raced the abort of a timed out transfer would otherwise end this transfer right away
+    ulTaskNotifyValueClear(nullptr, SpiModule::SPI_TRANSFER_DONE);
+    waitingTask = slotOwner;
+    dma_start_channel_mask((1u << txChannel) | (1u << rxChannel));
+
+    // Other notifications stay pending for the consumer's own task loop, only the done bit is cleared
+    uint32_t notifiedValue = 0;
+    while ((notifiedValue & SpiModule::SPI_TRANSFER_DONE) == 0)
+    {
+        if (xTaskNotifyWait(0, SpiModule::SPI_TRANSFER_DONE, &notifiedValue, TASK_DELAY_MS(MAX_TRANSFER_MS)) == pdFALSE)
+        {
+            statistics.timeouts++;
+            abort();
+            return 0;
+        }
+    }
+    statistics.dmaTransfers++;
+    return length;
+}
+
+void SpiDma::abort()
+{
+    // Disable the interrupt first, aborting a channel can raise it (RP2040-E13)
+    dma_channel_set_irq1_enabled(rxChannel, false);
+    waitingTask = nullptr;
+    dma_channel_abort(txChannel);
+    dma_channel_abort(rxChannel);
+    dma_channel_acknowledge_irq1(rxChannel);
+    dma_channel_set_irq1_enabled(rxChannel, true);
+
+    while (spi_is_readable(spi))
+    {
+        (void)spi_get_hw(spi)->dr;
+    }
+}
+
+void SpiDma::dmaInterrupt()
+{
+    SpiDma *dma = interruptHandler;
+    if (dma == nullptr || !dma_channel_get_irq1_status(dma->rxChannel))
+    {
+        return;
+    }
+    dma_channel_acknowledge_irq1(dma->rxChannel);
+
+    TaskHandle_t task = dma->waitingTask;
+    dma->waitingTask = nullptr;
+    if (task != nullptr)
+    {
+        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+        xTaskNotifyFromISR(task, SpiModule::SPI_TRANSFER_DONE, eSetBits, &xHigherPriorityTaskWoken);
+        portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    }
+}
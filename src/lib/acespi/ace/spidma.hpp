@@ -0,0 +1,110 @@
+#pragma once
+
+/* System. */
+#include <stdint.h>
+#include <stddef.h>
+
+/* FreeRTOS. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* PICO. */
+#include "hardware/spi.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+/* OpenACE. */
+#include "ace/basemodule.hpp"
+
+/**
+ * DMA transfers on the SPI bus for the task that holds the SPI slot.
+ * The task that started the transfer blocks on a task notification (SpiModule::SPI_TRANSFER_DONE) that is given from the DMA interrupt,
+ * so the CPU and the other SPI consumers can run while a larger frame is shifted in or out.
+ *
+ * - Short transfers, transfers outside of a slot and transfers before the scheduler runs use the blocking SDK calls
+ * - The RX channel always runs, also for writes, so the transfer is only done when the last byte is clocked out
+ *   and the RX FIFO is left empty, just like spi_write_blocking
+ */
+class SpiDma
+{
+public:
+    static constexpr size_t MIN_DMA_LENGTH = 16;     // Below this the notification costs more than polling the FIFO
+    static constexpr uint32_t MAX_TRANSFER_MS = 10;  // 255 bytes at 1Mhz is about 2ms
+    static constexpr uint DMA_IRQ = DMA_IRQ_1;
+
+private:
+    spi_inst_t *const spi;
+    int txChannel;
+    int rxChannel;
+    TaskHandle_t slotOwner;             // Consumer that was given the SPI slot
+    volatile TaskHandle_t waitingTask;  // Task to notify when the RX channel is done
+    uint8_t txZero;                     // Clocked out while reading
+    uint8_t rxSink;                     // Received bytes while writing
+
+    inline static SpiDma *interruptHandler = nullptr;
+
+    struct
+    {
+        uint32_t dmaTransfers = 0;
+        uint32_t blockingTransfers = 0;
+        uint32_t timeouts = 0;
+    } statistics;
+
+    static void dmaInterrupt();
+
+    /**
+     * Transfer length bytes, src or dst can be nullptr when only writing or reading
+     * returns the number of bytes transfered
+     */
+    int transfer(const uint8_t *src, uint8_t *dst, size_t length);
+
+    bool useDma(size_t length) const;
+
+    void abort();
+
+public:
+    SpiDma(spi_inst_t *spi_) : spi(spi_), txChannel(-1), rxChannel(-1), slotOwner(nullptr), waitingTask(nullptr), txZero(0), rxSink(0)
+    {
+    }
+
+    /**
+     * Claim two DMA channels and install the interrupt handler, returns false when no channels are available.
+     * Without channels all transfers are blocking
+     */
+    bool init();
+
+    void deinit();
+
+    /**
+     * Set by AceSpi when it gives the slot to a consumer, nullptr when the slot is released
+     */
+    void owner(TaskHandle_t taskHandle)
+    {
+        slotOwner = taskHandle;
+    }
+
+    int write(const uint8_t *src, size_t length)
+    {
+        return transfer(src, nullptr, length);
+    }
+
+    int read(uint8_t *dst, size_t length)
+    {
+        return transfer(nullptr, dst, length);
+    }
+
+    uint32_t dmaTransfers() const
+    {
+        return statistics.dmaTransfers;
+    }
+
+    uint32_t blockingTransfers() const
+    {
+        return statistics.blockingTransfers;
+    }
+
+    uint32_t timeouts() const
+    {
+        return statistics.timeouts;
+    }
+};
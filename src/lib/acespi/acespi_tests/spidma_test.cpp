@@ -0,0 +1,143 @@
+#include <catch2/catch_test_macros.hpp>
+
+#define private public
+
+#include "spidma.hpp"
+
+static const TaskHandle_t CONSUMER = reinterpret_cast<TaskHandle_t>(0x1000);
+static const TaskHandle_t OTHER_TASK = reinterpret_cast<TaskHandle_t>(0x2000);
+
+TEST_CASE("DMA transfers for the slot consumer", "[single-file]")
+{
+    mockSpiPeripheral.reset();
+    mockDmaComplete = true;
+    xTaskNotifyFromISRValue = 0;
+    xTaskGetCurrentTaskHandleValue = CONSUMER;
+
+    SpiDma dma{spi0};
+    REQUIRE(dma.init());
+    REQUIRE(mockIrqHandlers[SpiDma::DMA_IRQ] == SpiDma::dmaInterrupt);
+    dma.owner(CONSUMER);
+
+    SECTION("Reading a frame")
+    {
+        for (size_t i = 0; i < MockSpiPeripheral::SIZE; i++)
+        {
+            mockSpiPeripheral.miso[i] = i;
+        }
+        uint8_t frame[56] = {};
+        REQUIRE(dma.read(frame, sizeof(frame)) == sizeof(frame));
+        REQUIRE(frame[0] == 0);
+        REQUIRE(frame[55] == 55);
+        REQUIRE(mockSpiPeripheral.mosiLength == sizeof(frame));
+        REQUIRE(mockSpiPeripheral.mosi[55] == 0);
+        REQUIRE(dma.dmaTransfers() == 1);
+        REQUIRE(dma.blockingTransfers() == 0);
+        // The done bit is cleared again
+        REQUIRE(xTaskNotifyFromISRValue == 0);
+    }
+
+    SECTION("Writing a frame")
+    {
+        uint8_t frame[32];
+        for (size_t i = 0; i < sizeof(frame); i++)
+        {
+            frame[i] = 0xA0 + i;
+        }
+        REQUIRE(dma.write(frame, sizeof(frame)) == sizeof(frame));
+        REQUIRE(mockSpiPeripheral.mosiLength == sizeof(frame));
+        REQUIRE(mockSpiPeripheral.mosi[0] == 0xA0);
+        REQUIRE(mockSpiPeripheral.mosi[31] == 0xA0 + 31);
+        REQUIRE(dma.dmaTransfers() == 1);
+    }
+
+    SECTION("Other notifications stay pending for the consumer")
+    {
+        xTaskNotifyFromISRValue = SpiModule::SPI_BUS_READY | 1 << 3;
+        uint8_t frame[56];
+        REQUIRE(dma.read(frame, sizeof(frame)) == sizeof(frame));
+        REQUIRE(xTaskNotifyFromISRValue == (SpiModule::SPI_BUS_READY | 1 << 3));
+    }
+
+    SECTION("Short transfers are blocking")
+    {
+        uint8_t command[] = {0x1D, 0x00, 0x00};
+        REQUIRE(dma.write(command, sizeof(command)) == sizeof(command));
+        REQUIRE(mockSpiPeripheral.mosiLength == sizeof(command));
+        REQUIRE(dma.blockingTransfers() == 1);
+        REQUIRE(dma.dmaTransfers() == 0);
+    }
+
+    SECTION("Transfers outside of the slot are blocking")
+    {
+        uint8_t frame[56];
+        dma.owner(nullptr);
+        REQUIRE(dma.read(frame, sizeof(frame)) == sizeof(frame));
+        dma.owner(CONSUMER);
+        xTaskGetCurrentTaskHandleValue = OTHER_TASK;
+        REQUIRE(dma.read(frame, sizeof(frame)) == sizeof(frame));
+        xTaskGetCurrentTaskHandleValue = CONSUMER;
+        xTaskGetSchedulerStateValue = taskSCHEDULER_NOT_STARTED;
+        REQUIRE(dma.read(frame, sizeof(frame)) == sizeof(frame));
+        xTaskGetSchedulerStateValue = taskSCHEDULER_RUNNING;
+
+        REQUIRE(dma.blockingTransfers() == 3);
+        REQUIRE(dma.dmaTransfers() == 0);
+        REQUIRE(mockSpiPeripheral.mosiLength == 3 * sizeof(frame));
+    }
+
+    SECTION("Transfers that never finish are aborted")
+    {
+        mockDmaComplete = false;
+        uint8_t frame[56];
+        REQUIRE(dma.read(frame, sizeof(frame)) == 0);
+        REQUIRE(dma.timeouts() == 1);
+        REQUIRE(dma.waitingTask == nullptr);
+        REQUIRE(mockDmaChannels[dma.rxChannel].irq1Enabled);
+    }
+
+    SECTION("A late completion does not end the next transfer")
+    {
+        mockDmaComplete = false;
+        uint8_t frame[56];
+        REQUIRE(dma.read(frame, sizeof(frame)) == 0);
+        // The interrupt fired between the timeout and the abort
+        xTaskNotifyFromISRValue |= SpiModule::SPI_TRANSFER_DONE;
+        REQUIRE(dma.read(frame, sizeof(frame)) == 0);
+        REQUIRE(dma.timeouts() == 2);
+        REQUIRE(dma.dmaTransfers() == 0);
+
+        xTaskNotifyFromISRValue |= SpiModule::SPI_TRANSFER_DONE;
+        mockDmaComplete = true;
+        REQUIRE(dma.read(frame, sizeof(frame)) == sizeof(frame));
+        REQUIRE(dma.dmaTransfers() == 1);
+        REQUIRE(xTaskNotifyFromISRValue == 0);
+    }
+
+    dma.deinit();
+    REQUIRE(mockIrqHandlers[SpiDma::DMA_IRQ] == nullptr);
+}
+
+TEST_CASE("Blocking transfers without DMA channels", "[single-file]")
+{
+    mockSpiPeripheral.reset();
+    mockDmaComplete = true;
+    xTaskGetCurrentTaskHandleValue = CONSUMER;
+
+    for (auto &channel : mockDmaChannels)
+    {
+        channel.claimed = true;
+    }
+    SpiDma dma{spi0};
+    REQUIRE_FALSE(dma.init());
+    dma.owner(CONSUMER);
+
+    uint8_t frame[56];
+    REQUIRE(dma.read(frame, sizeof(frame)) == sizeof(frame));
+    REQUIRE(dma.blockingTransfers() == 1);
+
+    for (auto &channel : mockDmaChannels)
+    {
+        channel.claimed = false;
+    }
+}
@@ -21,12 +21,12 @@ OpenAce::PostConstruct ADSBDecoder::postConstruct()
 
 void ADSBDecoder::start()
 {
-    getBus().subscribe(*this);
+    subscribe(*this);
 };
 
 void ADSBDecoder::stop()
 {
-    getBus().unsubscribe(*this);
+    unsubscribe(*this);
 };
 
 void ADSBDecoder::on_receive(const OpenAce::OwnshipPositionMsg &msg)
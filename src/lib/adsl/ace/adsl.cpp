@@ -9,13 +9,6 @@ constexpr float POSITION_ENDECODE = 1.f / POSITION_DECODE;
 OpenAce::PostConstruct ADSL::postConstruct()
 {
     //    BaseModule::moduleByName(*this, Tuner::NAME);
-
-    frameConsumerQueue = xQueueCreate(4, sizeof(OpenAce::RadioRxFrame));
-    if (frameConsumerQueue == nullptr)
-    {
-        return OpenAce::PostConstruct::XQUEUE_ERROR;
-    }
-
     return OpenAce::PostConstruct::OK;
 }
 
@@ -24,17 +17,16 @@ void ADSL::start()
     xTaskCreate(adslReceiveTask, "adslReceiveTask", configMINIMAL_STACK_SIZE + 1024, this, tskIDLE_PRIORITY, &taskHandle);
     // auto tuner = static_cast<Tuner*>(BaseModule::moduleByName(*this, Tuner::NAME));
     // tuner->startListen(OpenAce::DataSource::ADSL);
-    getBus().subscribe(*this);
+    subscribe(*this);
 };
 
 void ADSL::stop()
 {
-    getBus().unsubscribe(*this);
+    unsubscribe(*this);
     // auto tuner = static_cast<Tuner*>(BaseModule::moduleByName(*this, Tuner::NAME));
     // tuner->stopListen(OpenAce::DataSource::ADSL);
 
     vTaskDelete(taskHandle);
-    vQueueDelete(frameConsumerQueue);
 };
 
 void ADSL::getData(etl::string_stream &stream, const etl::string_view path) const
@@ -85,13 +77,13 @@ void ADSL::addReceiveStat(uint32_t frequency)
 }
 void ADSL::on_receive(const OpenAce::RadioRxFrame &msg)
 {
-    if (msg.dataSource == OpenAce::DataSource::ADSL)
+    if (frameRing.push(msg))
     {
-        const OpenAce::RadioRxFrame cpy = msg;
-        if (xQueueSendToBack(frameConsumerQueue, &cpy, TASK_DELAY_MS(5)) != pdPASS)
-        {
-            statistics.queueFullErr++;
-        }
+        xTaskNotify(taskHandle, 1, eSetBits);
+    }
+    else
+    {
+        statistics.queueFullErr++;
     }
 }
 
@@ -329,16 +321,17 @@ void ADSL::adslReceiveTask(void *arg)
     OpenAce::RadioRxFrame msg;
     while (true)
     {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
         // msg length expected to be 0x1b == 25byte
-        if (xQueueReceive(adsl->frameConsumerQueue, &msg, portMAX_DELAY) == pdPASS)
+        while (adsl->frameRing.pop(msg))
         {
-            auto check = ADSL_Packet::Correct((uint8_t *)msg.frame + 1, (uint8_t *)msg.err + 1); // +1 because the length is not part of the CRC calculations
+            auto check = ADSL_Packet::Correct((uint8_t *)msg.frame() + 1, (uint8_t *)msg.err() + 1); // +1 because the length is not part of the CRC calculations
             if (check == -1)
             {
                 adsl->statistics.fecErr++;
                 continue;
             }
-            memcpy(&packet.length, msg.frame, ADSL_Packet::TotalTxBytes);
+            memcpy(&packet.length, msg.frame(), ADSL_Packet::TotalTxBytes);
             packet.Descramble();
 
             if (packet.key != 0)
@@ -27,6 +27,7 @@
 // #include "ace/utils.hpp"
 #include "ace/coreutils.hpp"
 #include "ace/basemodule.hpp"
+#include "ace/mpscring.hpp"
 
 /* Utils. */
 #include "ace/ldpc.hpp"
@@ -72,7 +73,7 @@ class ADSL : public BaseModule, public etl::message_router<ADSL,
     etl::vector<DataSourceTimeStats, 2> dataSourceTimeStats;
 
     TaskHandle_t taskHandle;
-    QueueHandle_t frameConsumerQueue;
+    OpenAce::MpscRing<OpenAce::RadioRxFrame, 4> frameRing;
     OpenAce::OwnshipPositionInfo ownshipPosition;
     OpenAce::Config::OpenAceConfiguration openAceConfiguration;
     OpenAce::BarometricPressure lastBarometricPressure;
@@ -83,8 +84,8 @@ public:
     static constexpr const etl::string_view NAME = "ADSL";
     ADSL(etl::imessage_bus& bus, const Configuration &config) :
         BaseModule(bus, NAME),
+        message_router(OpenAce::lockFreeRouterId(OpenAce::DataSource::ADSL)),
         taskHandle(nullptr),
-        frameConsumerQueue(nullptr),
         ownshipPosition()
     {
         int32_t v = config.valueByPath(25000, "ADSL", "distanceIgnore");
@@ -101,8 +102,10 @@ public:
 
 private:
     /**
-     * Send a FreeRTOS message when a ADSL is received
+     * Push the ADSL frame in the frame ring and notify the receive task
      * This will release the sender from the task and allow it to continue in a seperate thread
+     * Called without the bus mutex, so only touch the ring here
+     * The bus only delivers frames from our own DataSource
     */
     void on_receive(const OpenAce::RadioRxFrame &msg);
     void on_receive(const OpenAce::OwnshipPositionMsg &msg);
@@ -5,6 +5,7 @@
 #include "ace/moreutils.hpp"
 
 #include "etl/algorithm.h"
+#include "etl/array.h"
 
 OpenAce::PostConstruct AircraftTracker::postConstruct()
 {
@@ -23,12 +24,12 @@ void AircraftTracker::start()
     // taskHandle = xTaskCreateStatic(aircraftTrackerTask, "AircraftTracker", STACK_SIZE, this, tskIDLE_PRIORITY, xStack, &xTaskBuffer);
     xTaskCreate(aircraftTrackerTask, "AircraftTracker", TASK_STACK_SIZE, this, tskIDLE_PRIORITY, &taskHandle);
     xTimerStart(maintenanceTimerHandle, TASK_DELAY_MS(25));
-    getBus().subscribe(*this);
+    subscribe(*this);
 };
 
 void AircraftTracker::stop()
 {
-    getBus().unsubscribe(*this);
+    unsubscribe(*this);
     xTaskNotify(taskHandle, TaskState::EXIT, eSetBits);
     while (eTaskGetState(taskHandle) != eDeleted)
     {
@@ -61,6 +62,8 @@ void AircraftTracker::getData(etl::string_stream &stream, const etl::string_view
     stream << ",\"trackedFullErr\":" << statistics.trackedFullErr;
     stream << ",\"numberofPlanesTracking\":" << statistics.numberofPlanesTracking;
     stream << ",\"positionsProcessed\":" << statistics.positionsProcessed;
+    stream << ",\"reportsFused\":" << statistics.reportsFused;
+    stream << ",\"reportsIgnored\":" << statistics.reportsIgnored;
     stream << ",\"lastTrackPoint\":" << statistics.lastTrackPoint;
     stream << ",\"autoDistanceTrack\":" << autoDistanceTrack;
     stream << "}\n";
@@ -145,41 +148,56 @@ void AircraftTracker::aircraftTrackerTask(void *arg)
 
 void AircraftTracker::handleNew()
 {
-    struct FindByIcao
-    {
-        FindByIcao(const OpenAce::AircraftPositionInfo &api) : address(api.address) {}
-        bool operator()(const TrackInfo &i)
-        {
-            return i.position.address == address;
-        }
-
-    private:
-        OpenAce::AircraftAddress address;
-    };
-
     uint16_t spread = 0;
-    auto time = CoreUtils::msSinceBoot() + 1'000;
+    auto now = CoreUtils::msSinceBoot();
+    auto time = now + 1'000;
     OpenAce::AircraftPositionInfo position;
-    while (queue.pop(position) && !trackedAircraft.full())
+    while (queue.pop(position))
     {
-        // Remove the Aircraft from the existing trackers
-        const auto &it = etl::find_if(trackedAircraft.cbegin(), trackedAircraft.cend(), FindByIcao(position));
-        if (it != trackedAircraft.cend())
+        TrackInfo *track = trackedAircraft.find(position.address, position.addressType);
+        if (track == nullptr)
         {
-            trackedAircraft.erase(it);
+            track = findSameAircraft(position, now);
         }
 
-        // Put it at the back of the queue if within distance of aircraft that is beeing tracked
-        if (position.distanceFromOwn < autoDistanceTrack)
+        if (track != nullptr)
         {
-            trackedAircraft.emplace_back(TrackInfo{time + spread, 0, position});
+            // Keep the better source as long as it is fresh
+            if (!TrackFusion::accept(*track, position, now))
+            {
+                statistics.reportsIgnored++;
+                continue;
+            }
 
-            // Send
-            // getBus().receive(
-            //     OpenAce::TrackedAircraftPositionMsg(position));
+            // Matched on position, keep the known address and drop the random one
+            if (track->position.address != position.address || track->position.addressType != position.addressType)
+            {
+                statistics.reportsFused++;
+                if (position.addressType == OpenAce::AddressType::RANDOM)
+                {
+                    position.address = track->position.address;
+                    position.addressType = track->position.addressType;
+                }
+                else
+                {
+                    trackedAircraft.erase(track->position.address, track->position.addressType);
+                }
+            }
+        }
 
-            // Increase spread
-            spread += 10;
+        // Track (or re-track) the aircraft at the back of the schedule if within distance of aircraft that is beeing tracked
+        if (position.distanceFromOwn < autoDistanceTrack)
+        {
+            // When full only already tracked aircraft are updated, trackedFullErr is counted by the task
+            if (trackedAircraft.insert(position, now, time + spread) != nullptr)
+            {
+                // Increase spread
+                spread += 10;
+            }
+        }
+        else
+        {
+            trackedAircraft.erase(position.address, position.addressType);
         }
     }
 
@@ -189,29 +207,36 @@ void AircraftTracker::handleNew()
 
 void AircraftTracker::handleTimer()
 {
-    auto next = trackedAircraft.begin();
-    while (next != trackedAircraft.end() && next->nextSendTime < (CoreUtils::msSinceBoot() + 75)) // Subtract 75 ms to also send any other aircraft within 75ms, for efficienty
+    OpenAce::OwnshipPositionInfo ownship{};
     {
+        SemaphoreGuard<25> guard{ownshipMutex};
+        if (guard)
+        {
+            ownship = ownshipPosition;
+        }
+    }
 
-        // Update stats for this entry
-        next->nextSendTime += 1'000;
+    auto now = CoreUtils::msSinceBoot();
+    auto next = trackedAircraft.next();
+    // Add 75 ms to also send any other aircraft within 75ms, for efficienty
+    while (next != nullptr && static_cast<int32_t>(next->nextSendTime - (now + 75)) < 0)
+    {
+        // Update stats for this entry and move it to the back of the schedule
         next->numberOfTries++;
-
-        // Move to end of the queue
-        trackedAircraft.splice(trackedAircraft.end(), trackedAircraft, next);
+        trackedAircraft.reschedule(*next, next->nextSendTime + 1'000);
 
         // Send
         getBus().receive(
-            OpenAce::TrackedAircraftPositionMsg(next->position));
+            OpenAce::TrackedAircraftPositionMsg(predictPosition(*next, now, ownship)));
 
         statistics.positionsProcessed++;
 
         // Look for a other item that can be send
-        next = trackedAircraft.begin();
+        next = trackedAircraft.next();
     }
 
     // If the queue still holds entries set a timer so processing keeps happening
-    if (next != trackedAircraft.end())
+    if (next != nullptr)
     {
         // +1 added to ensure to never get a 0 delay which is invalid
         uint16_t delay = next->nextSendTime - CoreUtils::msSinceBoot();
@@ -223,27 +248,104 @@ void AircraftTracker::handleTimer()
     }
 }
 
-void AircraftTracker::removeStaleEntries()
+AircraftTracker::TrackInfo *AircraftTracker::findSameAircraft(const OpenAce::AircraftPositionInfo &position, uint32_t now)
 {
+    // Only aircraft with a random address can hide behind an other address
+    auto sameAircraft = [&position, now](const TrackInfo &track)
+    {
+        return TrackFusion::isSameAircraft(track, position, now);
+    };
+    TrackInfo *match = trackedAircraft.findIf(sameAircraft);
+    if (match == nullptr)
+    {
+        return nullptr;
+    }
 
+    // Never guess when more than one aircraft matches
+    auto otherMatch = trackedAircraft.findIf([match, &sameAircraft](const TrackInfo &track)
+    {
+        return &track != match && sameAircraft(track);
+    });
+    return otherMatch == nullptr ? match : nullptr;
+}
+
+OpenAce::AircraftPositionInfo AircraftTracker::predictPosition(const TrackInfo &track, uint32_t now, const OpenAce::OwnshipPositionInfo &ownship) const
+{
+    OpenAce::AircraftPositionInfo position = track.position;
+    DeadReckoning::extrapolate(position, static_cast<int32_t>(now - track.receivedTime) / 1000.f);
+
+    // Without ownship position keep what the decoder calculated
+    if (ownship.timestamp != 0)
+    {
+        auto fromOwn = CoreUtils::getDistanceRelNorthRelEastInt(ownship, position);
+        position.distanceFromOwn = fromOwn.distance;
+        position.relNorthFromOwn = fromOwn.relNorth;
+        position.relEastFromOwn = fromOwn.relEast;
+        position.bearingFromOwn = fromOwn.bearing;
+    }
+    return position;
+}
+
+void AircraftTracker::removeStaleEntries()
+{
     // Remove entries, trying to guarantee that we make room for new aircraft by removing older entries
     // Removal based on distance from own and how many times the airplane was tracked
-    uint8_t trackPoints = MAX_POSITION_INTERPOLATIONS;
-    do
+    // Each round lowers the allowed number of tries by one, and while the store stays above CLEAR_UP_SIZE
+    // distanceEstimator() lowers the tracking distance as well. A histogram on tries and the last round an aircraft
+    // is within the tracking distance finds the final round, so all entries can be removed in a single pass
+    etl::array<float, REMOVAL_ROUNDS> trackDistances;
+    trackDistances[0] = autoDistanceTrack;
+    for (uint8_t round = 1; round < REMOVAL_ROUNDS; round++)
+    {
+        trackDistances[round] = etl::max(MIN_TRACKING_DISTANCE, etl::min(trackDistances[round - 1] - AUTO_DISTANCE_STEP, MAX_TRACKING_DISTANCE));
+    }
+
+    etl::array<etl::array<uint16_t, REMOVAL_ROUNDS>, MAX_POSITION_INTERPOLATIONS + 1> histogram{};
+    trackedAircraft.forEach([&histogram, &trackDistances](const TrackInfo &track)
+    {
+        uint8_t rounds = 0;
+        while (rounds < REMOVAL_ROUNDS && track.position.distanceFromOwn <= trackDistances[rounds])
+        {
+            rounds++;
+        }
+        if (rounds > 0 && track.numberOfTries <= MAX_POSITION_INTERPOLATIONS)
+        {
+            histogram[track.numberOfTries][rounds - 1]++;
+        }
+    });
+
+    uint8_t round = 0;
+    while (true)
     {
-        float trackDistance = autoDistanceTrack;
-        trackedAircraft.erase(etl::remove_if(trackedAircraft.begin(), trackedAircraft.end(), [trackPoints, trackDistance](const auto &it)
+        uint8_t trackPoints = MAX_POSITION_INTERPOLATIONS - round;
+        uint16_t remaining = 0;
+        for (uint8_t tries = 0; tries <= trackPoints; tries++)
+        {
+            for (uint8_t last = round; last < REMOVAL_ROUNDS; last++)
+            {
+                remaining += histogram[tries][last];
+            }
+        }
+        if (remaining <= CLEAR_UP_SIZE || round == REMOVAL_ROUNDS - 1)
         {
-            return it.numberOfTries > trackPoints || it.position.distanceFromOwn > trackDistance;
-        }),
-        trackedAircraft.end());
-        trackPoints--;
-        // Call the distance estimator to quickly autoDistanceTrack
-        distanceEstimator();
+            break;
+        }
+        round++;
     }
-    while ((trackedAircraft.size() > CLEAR_UP_SIZE) && trackPoints > 2);
 
-    statistics.lastTrackPoint = trackPoints;
+    uint8_t trackPoints = MAX_POSITION_INTERPOLATIONS - round;
+    float trackDistance = trackDistances[round];
+    trackedAircraft.removeIf([trackPoints, trackDistance](const TrackInfo &track)
+    {
+        return track.numberOfTries > trackPoints || track.position.distanceFromOwn > trackDistance;
+    });
+
+    // Each earlier round went on because the store was above CLEAR_UP_SIZE, where the distance estimator shrinks
+    // the distance. Call the distance estimator for the last round to quickly autoDistanceTrack
+    autoDistanceTrack = trackDistance;
+    distanceEstimator();
+
+    statistics.lastTrackPoint = trackPoints - 1;
 }
 
 void AircraftTracker::distanceEstimator()
@@ -254,11 +356,11 @@ void AircraftTracker::distanceEstimator()
      */
     if ((trackedAircraft.size() > AUTO_DISTANCE_TRACK_UPPER))
     {
-        autoDistanceTrack = etl::max(MIN_TRACKING_DISTANCE, etl::min(autoDistanceTrack - 5000, MAX_TRACKING_DISTANCE));
+        autoDistanceTrack = etl::max(MIN_TRACKING_DISTANCE, etl::min(autoDistanceTrack - AUTO_DISTANCE_STEP, MAX_TRACKING_DISTANCE));
     }
     else if ((trackedAircraft.size() < AUTO_DISTANCE_TRACK_LOWER))
     {
         // Increase autoDistanceTrack each them with 1000 meters up untill MAX_TRACKING_DISTANCE when there is room again
-        autoDistanceTrack = etl::max(MIN_TRACKING_DISTANCE, etl::min(autoDistanceTrack + 5000, MAX_TRACKING_DISTANCE));
+        autoDistanceTrack = etl::max(MIN_TRACKING_DISTANCE, etl::min(autoDistanceTrack + AUTO_DISTANCE_STEP, MAX_TRACKING_DISTANCE));
     }
 }
\ No newline at end of file
@@ -10,14 +10,16 @@
 #include "pico/stdlib.h"
 
 #include "etl/message_bus.h"
-#include "etl/list.h"
-#include "etl/forward_list.h"
 #include "etl/queue_spsc_atomic.h"
 
 #include "ace/constants.hpp"
 #include "ace/basemodule.hpp"
 #include "ace/messages.hpp"
 
+#include "trackstore.hpp"
+#include "deadreckoning.hpp"
+#include "trackfusion.hpp"
+
 /**
  * Client that can connect to a host and a port and expect to receive line terminated NMEA Messages
  * Part of this code taken from the example from Raspbery
@@ -27,8 +29,9 @@ class AircraftTracker : public BaseModule, public etl::message_router<AircraftTr
 private:
     friend class message_router;
 
-    static constexpr uint8_t MAX_TRACKING_PLANES = 32;
-    static constexpr uint8_t MAX_POSITION_INTERPOLATIONS = 10; // Maximum number of times we interpolate position of a plate when it was not received, after that we removed it from the tracker
+    static constexpr uint16_t MAX_TRACKING_PLANES = 128;
+    static constexpr uint8_t POSITION_QUEUE_SIZE = 8;
+    static constexpr uint8_t MAX_POSITION_INTERPOLATIONS = 10; // Maximum number of times we extrapolate position of a plane when it was not received, after that we removed it from the tracker
     static constexpr uint16_t TASK_STACK_SIZE = configMINIMAL_STACK_SIZE + 256;
 
     static constexpr uint32_t CLEAR_UP_SIZE = (MAX_TRACKING_PLANES * 95) / 100;
@@ -37,6 +40,8 @@ private:
     static constexpr uint32_t AUTO_DISTANCE_TRACK_LOWER = (MAX_TRACKING_PLANES * 80) / 100;
     static constexpr float MAX_TRACKING_DISTANCE = 75000; // In meters
     static constexpr float MIN_TRACKING_DISTANCE = 10000; // In meters
+    static constexpr float AUTO_DISTANCE_STEP = 5000;     // In meters
+    static constexpr uint8_t REMOVAL_ROUNDS = MAX_POSITION_INTERPOLATIONS - 2; // removeStaleEntries() lowers the number of tries down to 3
 
 
     struct
@@ -44,23 +49,14 @@ private:
         uint32_t queueFullErr = 0;
         uint32_t trackedFullErr = 0;
         uint32_t positionsProcessed = 0;
-        uint8_t numberofPlanesTracking = 0;
-        uint8_t lastTrackPoint = 0; // Need a better name for this.
+        uint32_t reportsFused = 0;   // Reports merged into a track of an other address
+        uint32_t reportsIgnored = 0; // Reports ignored because a better source is tracking the aircraft
+        uint16_t numberofPlanesTracking = 0;
+        uint16_t lastTrackPoint = 0; // Need a better name for this.
     } statistics;
 
 private:
-    struct TrackInfo
-    {
-        uint32_t nextSendTime;
-        uint8_t numberOfTries;
-        OpenAce::AircraftPositionInfo position;
-        //  TrackInfo( OpenAce::AircraftPositionInfo position_) : nextSendTime(0), position(position_) {}
-
-        bool operator<(const TrackInfo &other) const
-        {
-            return nextSendTime < other.nextSendTime;
-        }
-    };
+    using TrackInfo = OpenAce::TrackInfo;
 
     //    StaticTask_t xTaskBuffer;
     //    StackType_t xStack[TASK_STACK_SIZE];
@@ -77,11 +73,11 @@ private:
     SemaphoreHandle_t ownshipMutex;
     //    StaticSemaphore_t ownshipMutexBuffer;
 
-    using TrackedAircrafts = etl::list<TrackInfo, MAX_TRACKING_PLANES>;
+    using TrackedAircrafts = OpenAce::TrackStore<MAX_TRACKING_PLANES>;
     TrackedAircrafts trackedAircraft;
 
     // Producer Consumer queue to handle data between this task and the send task
-    etl::queue_spsc_atomic<OpenAce::AircraftPositionInfo, 2> queue;
+    etl::queue_spsc_atomic<OpenAce::AircraftPositionInfo, POSITION_QUEUE_SIZE> queue;
 
     OpenAce::OwnshipPositionInfo ownshipPosition;
 
@@ -95,24 +91,6 @@ private:
         MAINTENANCE = 1 << 3
     };
 
-    struct FindNewlyArrived
-    {
-        bool operator()(const TrackInfo &i)
-        {
-            return i.nextSendTime == 0;
-        }
-    };
-
-    struct StaleAircraft
-    {
-        uint64_t msSinceEpoch;
-        StaleAircraft(uint64_t msSinceEpoch_) : msSinceEpoch(msSinceEpoch_) {}
-        bool operator()(const TrackInfo &i)
-        {
-            return i.position.timestamp < msSinceEpoch;
-        }
-    };
-
     void on_receive_unknown(const etl::imessage &msg);
 
     void on_receive(const OpenAce::ConfigUpdatedMsg &msg);
@@ -123,13 +101,15 @@ private:
     static void maintenanceTimerTask(TimerHandle_t timer);
     void handleNew();
     void handleTimer();
+    TrackInfo *findSameAircraft(const OpenAce::AircraftPositionInfo &position, uint32_t now);
+    OpenAce::AircraftPositionInfo predictPosition(const TrackInfo &track, uint32_t now, const OpenAce::OwnshipPositionInfo &ownship) const;
     void removeStaleEntries();
     void distanceEstimator();
 
 public:
     static constexpr const etl::string_view NAME = "AircraftTracker";
     AircraftTracker(etl::imessage_bus &bus, const Configuration &config) : BaseModule(bus, NAME),
-        taskHandle(nullptr), timerHandle(nullptr), aircraftMutex(nullptr), ownshipMutex(nullptr), autoDistanceTrack(MAX_TRACKING_DISTANCE)
+        taskHandle(nullptr), timerHandle(nullptr), aircraftMutex(nullptr), ownshipMutex(nullptr), ownshipPosition{}, autoDistanceTrack(MAX_TRACKING_DISTANCE)
     {
         (void)config;
     }
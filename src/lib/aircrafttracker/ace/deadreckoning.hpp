@@ -0,0 +1,66 @@
+#pragma once
+
+/* System. */
+#include <stdint.h>
+#include <math.h>
+
+/* OpenACE. */
+#include "ace/constants.hpp"
+#include "ace/models.hpp"
+
+/**
+ * Predict where an aircraft is after some time from it's last known position, speed, course, turn rate and vertical speed.
+ * Uses a flat earth approximation which is accurate enough for the few seconds and few km we extrapolate
+ */
+class DeadReckoning
+{
+    static constexpr float METERS_PER_DEG_LAT = 111139.f;
+    static constexpr float METERS_PER_DEG_LON = 111321.f; // At the equator
+    static constexpr float MIN_TURN_RATE = 0.1f;          // deg/s, below this the aircraft flies a straight line
+
+public:
+    /**
+     * Move position along it's track for seconds.
+     * Aircraft on the ground or without track information only get there altitude extrapolated
+     */
+    static void extrapolate(OpenAce::AircraftPositionInfo &position, float seconds)
+    {
+        if (seconds <= 0.f)
+        {
+            return;
+        }
+
+        position.altitudeWgs84 = static_cast<int16_t>(position.altitudeWgs84 + position.verticalSpeed * seconds + 0.5f);
+
+        if (!position.airborne || position.noTrack || position.groundSpeed <= 0.f)
+        {
+            return;
+        }
+
+        float course = position.course * DEG_TO_RADS;
+        float north;
+        float east;
+        if (fabsf(position.hTurnRate) < MIN_TURN_RATE)
+        {
+            float distance = position.groundSpeed * seconds;
+            north = cosf(course) * distance;
+            east = sinf(course) * distance;
+        }
+        else
+        {
+            // Constant turn rate, the aircraft flies an arc with radius groundSpeed / turnRate
+            float turnRate = position.hTurnRate * DEG_TO_RADS;
+            float newCourse = course + turnRate * seconds;
+            float radius = position.groundSpeed / turnRate;
+            north = radius * (sinf(newCourse) - sinf(course));
+            east = radius * (cosf(course) - cosf(newCourse));
+
+            float courseDeg = fmodf(newCourse * RADS_TO_DEG, 360.f);
+            courseDeg = courseDeg < 0.f ? courseDeg + 360.f : courseDeg;
+            position.course = static_cast<int16_t>(courseDeg + 0.5f) % 360;
+        }
+
+        position.lat += north / METERS_PER_DEG_LAT;
+        position.lon += east / (METERS_PER_DEG_LON * cosf(position.lat * DEG_TO_RADS));
+    }
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+/* System. */
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+
+/* OpenACE. */
+#include "ace/constants.hpp"
+#include "ace/models.hpp"
+
+#include "trackstore.hpp"
+#include "deadreckoning.hpp"
+
+/**
+ * Rules to fuse reports of the same aircraft received over different protocols into a single track.
+ * Reports with the same address and address type always belong to the same track. Aircraft with a random address
+ * can't be matched on address, these are matched on position, altitude, course and speed against the existing tracks.
+ * Matching is conservative, two aircraft flying close together must never be merged into one.
+ */
+class TrackFusion
+{
+    static constexpr float MATCH_HORIZONTAL = 50.f;  // In meters, after extrapolating the track to the time of the report
+    static constexpr float MATCH_VERTICAL = 30.f;    // In meters
+    static constexpr int16_t MATCH_COURSE = 30;      // In degrees
+    static constexpr float MATCH_GROUNDSPEED = 5.f;  // In m/s
+
+public:
+    static constexpr uint32_t SOURCE_HOLD_MS = 2'000; // A better source is preferred as long as it is fresher than this
+
+    /**
+     * Quality of a source, sources with integrity, turn rate and a high update rate score higher
+     */
+    static uint8_t quality(OpenAce::DataSource dataSource)
+    {
+        switch (dataSource)
+        {
+        case OpenAce::DataSource::FLARM:
+        case OpenAce::DataSource::ADSL:
+            return 4;
+        case OpenAce::DataSource::ADSB:
+        case OpenAce::DataSource::OGN1:
+            return 3;
+        case OpenAce::DataSource::FANET:
+        case OpenAce::DataSource::PAW:
+            return 2;
+        case OpenAce::DataSource::MODES:
+            return 1;
+        default:
+            return 0;
+        }
+    }
+
+    /**
+     * Returns true when the report may replace the position of the track. A lower quality source only takes over when
+     * the track was not updated for SOURCE_HOLD_MS
+     */
+    static bool accept(const OpenAce::TrackInfo &track, const OpenAce::AircraftPositionInfo &position, uint32_t now)
+    {
+        if (quality(position.dataSource) >= quality(track.position.dataSource))
+        {
+            return true;
+        }
+        return (now - track.receivedTime) > SOURCE_HOLD_MS;
+    }
+
+    /**
+     * Returns true when the report is very likely from the aircraft of the track while the addresses differ.
+     * Only used when one of the two has a random address, two known addresses are always different aircraft
+     */
+    static bool isSameAircraft(const OpenAce::TrackInfo &track, const OpenAce::AircraftPositionInfo &position, uint32_t now)
+    {
+        if (track.position.addressType != OpenAce::AddressType::RANDOM && position.addressType != OpenAce::AddressType::RANDOM)
+        {
+            return false;
+        }
+        if (track.position.address == position.address && track.position.addressType == position.addressType)
+        {
+            return false;
+        }
+        if (track.position.airborne != position.airborne)
+        {
+            return false;
+        }
+
+        OpenAce::AircraftPositionInfo predicted = track.position;
+        DeadReckoning::extrapolate(predicted, static_cast<int32_t>(now - track.receivedTime) / 1000.f);
+
+        if (abs(predicted.altitudeWgs84 - position.altitudeWgs84) > MATCH_VERTICAL)
+        {
+            return false;
+        }
+
+        float north = (position.lat - predicted.lat) * 111139.f;
+        float east = (position.lon - predicted.lon) * 111321.f * cosf(position.lat * DEG_TO_RADS);
+        if ((north * north + east * east) > MATCH_HORIZONTAL * MATCH_HORIZONTAL)
+        {
+            return false;
+        }
+
+        if (fabsf(predicted.groundSpeed - position.groundSpeed) > MATCH_GROUNDSPEED)
+        {
+            return false;
+        }
+
+        if (!predicted.noTrack && !position.noTrack && position.airborne)
+        {
+            int16_t courseDiff = abs(predicted.course - position.course) % 360;
+            courseDiff = courseDiff > 180 ? 360 - courseDiff : courseDiff;
+            if (courseDiff > MATCH_COURSE)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
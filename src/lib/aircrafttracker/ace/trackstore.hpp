@@ -0,0 +1,310 @@
+#pragma once
+
+/* System. */
+#include <stdint.h>
+#include <stddef.h>
+
+/* Vendor. */
+#include "etl/array.h"
+#include "etl/vector.h"
+#include "etl/unordered_map.h"
+#include "etl/utility.h"
+
+/* OpenACE. */
+#include "ace/models.hpp"
+
+namespace OpenAce
+{
+
+    struct TrackInfo
+    {
+        uint32_t nextSendTime;
+        uint32_t receivedTime; // ms since boot when position was received
+        uint8_t numberOfTries;
+        OpenAce::AircraftPositionInfo position;
+    };
+
+    /**
+     * Fixed size storage for tracked aircraft.
+     * Tracks live in fixed slots. An index on address and address type gives O(1) lookup and an indexed binary min-heap
+     * on nextSendTime gives the next aircraft to send in O(1), (re)scheduling and removal are O(log n).
+     * nextSendTime is compared with wrap around in mind, so ms since boot can be used directly.
+     */
+    template <size_t MAX_TRACKS>
+    class TrackStore
+    {
+        static_assert(MAX_TRACKS > 0 && MAX_TRACKS < UINT16_MAX, "TrackStore MAX_TRACKS out of range");
+        using Slot = uint16_t;
+        using Key = uint32_t;
+
+        etl::array<TrackInfo, MAX_TRACKS> tracks;
+        etl::array<Slot, MAX_TRACKS> heapPos;  // Position of each slot in the heap
+        etl::vector<Slot, MAX_TRACKS> heap;    // Slots ordered as a min-heap on nextSendTime
+        etl::vector<Slot, MAX_TRACKS> freeSlots;
+        etl::unordered_map<Key, Slot, MAX_TRACKS> index;
+
+        // Addresses are 24 bit, the address type goes in the upper byte
+        static constexpr Key keyOf(OpenAce::AircraftAddress address, OpenAce::AddressType addressType)
+        {
+            return (static_cast<Key>(addressType) << 24) | (address & 0x00ffffff);
+        }
+
+        static constexpr Key keyOf(const OpenAce::AircraftPositionInfo &position)
+        {
+            return keyOf(position.address, position.addressType);
+        }
+
+        bool before(Slot a, Slot b) const
+        {
+            return static_cast<int32_t>(tracks[a].nextSendTime - tracks[b].nextSendTime) < 0;
+        }
+
+        void place(size_t pos, Slot slot)
+        {
+            heap[pos] = slot;
+            heapPos[slot] = static_cast<Slot>(pos);
+        }
+
+        void siftUp(size_t pos)
+        {
+            Slot slot = heap[pos];
+            while (pos > 0)
+            {
+                size_t parent = (pos - 1) / 2;
+                if (!before(slot, heap[parent]))
+                {
+                    break;
+                }
+                place(pos, heap[parent]);
+                pos = parent;
+            }
+            place(pos, slot);
+        }
+
+        void siftDown(size_t pos)
+        {
+            Slot slot = heap[pos];
+            size_t size = heap.size();
+            while (true)
+            {
+                size_t child = pos * 2 + 1;
+                if (child >= size)
+                {
+                    break;
+                }
+                if (child + 1 < size && before(heap[child + 1], heap[child]))
+                {
+                    child++;
+                }
+                if (!before(heap[child], slot))
+                {
+                    break;
+                }
+                place(pos, heap[child]);
+                pos = child;
+            }
+            place(pos, slot);
+        }
+
+        void update(size_t pos)
+        {
+            if (pos > 0 && before(heap[pos], heap[(pos - 1) / 2]))
+            {
+                siftUp(pos);
+            }
+            else
+            {
+                siftDown(pos);
+            }
+        }
+
+        void removeAt(size_t pos)
+        {
+            Slot slot = heap[pos];
+            index.erase(keyOf(tracks[slot].position));
+            freeSlots.push_back(slot);
+
+            Slot last = heap.back();
+            heap.pop_back();
+            if (pos < heap.size())
+            {
+                place(pos, last);
+                update(pos);
+            }
+        }
+
+        Slot slotOf(const TrackInfo &track) const
+        {
+            return static_cast<Slot>(&track - tracks.data());
+        }
+
+    public:
+        TrackStore()
+        {
+            clear();
+        }
+
+        TrackStore(const TrackStore &) = delete;
+        TrackStore &operator=(const TrackStore &) = delete;
+
+        void clear()
+        {
+            index.clear();
+            heap.clear();
+            freeSlots.clear();
+            for (size_t i = MAX_TRACKS; i > 0; i--)
+            {
+                freeSlots.push_back(static_cast<Slot>(i - 1));
+            }
+        }
+
+        size_t size() const
+        {
+            return heap.size();
+        }
+
+        bool empty() const
+        {
+            return heap.empty();
+        }
+
+        bool full() const
+        {
+            return heap.full();
+        }
+
+        static constexpr size_t capacity()
+        {
+            return MAX_TRACKS;
+        }
+
+        TrackInfo *find(OpenAce::AircraftAddress address, OpenAce::AddressType addressType)
+        {
+            auto it = index.find(keyOf(address, addressType));
+            return it == index.end() ? nullptr : &tracks[it->second];
+        }
+
+        /**
+         * Find the first track matching the predicate, O(n)
+         */
+        template <typename TPredicate>
+        TrackInfo *findIf(TPredicate predicate)
+        {
+            for (auto slot : heap)
+            {
+                if (predicate(static_cast<const TrackInfo &>(tracks[slot])))
+                {
+                    return &tracks[slot];
+                }
+            }
+            return nullptr;
+        }
+
+        /**
+         * Insert a new track or replace the track of the same address and address type.
+         * The number of tries is reset. A replaced track keeps it's nextSendTime when that is earlier so frequent
+         * updates can't postpone sending. Returns nullptr when the address is new and the store is full
+         */
+        TrackInfo *insert(const OpenAce::AircraftPositionInfo &position, uint32_t receivedTime, uint32_t nextSendTime)
+        {
+            auto it = index.find(keyOf(position));
+            if (it != index.end())
+            {
+                TrackInfo &track = tracks[it->second];
+                track.position = position;
+                track.receivedTime = receivedTime;
+                track.numberOfTries = 0;
+                if (static_cast<int32_t>(nextSendTime - track.nextSendTime) < 0)
+                {
+                    reschedule(track, nextSendTime);
+                }
+                return &track;
+            }
+
+            if (full())
+            {
+                return nullptr;
+            }
+
+            Slot slot = freeSlots.back();
+            freeSlots.pop_back();
+            tracks[slot] = TrackInfo{nextSendTime, receivedTime, 0, position};
+            index.insert(etl::make_pair(keyOf(position), slot));
+            heap.push_back(slot);
+            siftUp(heap.size() - 1);
+            return &tracks[slot];
+        }
+
+        bool erase(OpenAce::AircraftAddress address, OpenAce::AddressType addressType)
+        {
+            auto it = index.find(keyOf(address, addressType));
+            if (it == index.end())
+            {
+                return false;
+            }
+            removeAt(heapPos[it->second]);
+            return true;
+        }
+
+        /**
+         * Track with the earliest nextSendTime, nullptr when empty
+         */
+        TrackInfo *next()
+        {
+            return heap.empty() ? nullptr : &tracks[heap.front()];
+        }
+
+        /**
+         * Change the nextSendTime of a track that is held by this store
+         */
+        void reschedule(TrackInfo &track, uint32_t nextSendTime)
+        {
+            track.nextSendTime = nextSendTime;
+            update(heapPos[slotOf(track)]);
+        }
+
+        /**
+         * Remove all tracks matching the predicate in a single pass and re-heapify, O(n)
+         */
+        template <typename TPredicate>
+        size_t removeIf(TPredicate predicate)
+        {
+            size_t kept = 0;
+            size_t size = heap.size();
+            for (size_t i = 0; i < size; i++)
+            {
+                Slot slot = heap[i];
+                const TrackInfo &track = tracks[slot];
+                if (predicate(track))
+                {
+                    index.erase(keyOf(track.position));
+                    freeSlots.push_back(slot);
+                }
+                else
+                {
+                    place(kept++, slot);
+                }
+            }
+            heap.resize(kept);
+
+            for (size_t i = kept / 2; i > 0; i--)
+            {
+                siftDown(i - 1);
+            }
+            return size - kept;
+        }
+
+        /**
+         * Visit all tracks in no particular order
+         */
+        template <typename TFunction>
+        void forEach(TFunction function) const
+        {
+            for (auto slot : heap)
+            {
+                function(tracks[slot]);
+            }
+        }
+    };
+
+}
@@ -0,0 +1,59 @@
+#include <catch2/catch_test_macros.hpp>
+
+#define private public
+
+#include "mockconfig.h"
+
+#include "aircrafttracker.hpp"
+
+OpenAce::ThreadSafeBus<50> bus;
+MockConfig mockConfig{bus};
+
+static OpenAce::AircraftPositionInfo aircraft(OpenAce::AircraftAddress address, float distance)
+{
+    OpenAce::AircraftPositionInfo position;
+    position.address = address;
+    position.addressType = OpenAce::AddressType::RANDOM;
+    position.distanceFromOwn = distance;
+    return position;
+}
+
+TEST_CASE("Stale entries of a full tracker with only fresh aircraft", "[single-file]")
+{
+    AircraftTracker tracker{bus, mockConfig};
+
+    // Every aircraft was just received, spread up to 73.66Km from ownship
+    for (uint32_t i = 0; i < AircraftTracker::MAX_TRACKING_PLANES; i++)
+    {
+        REQUIRE(tracker.trackedAircraft.insert(aircraft(0x1000 + i, i * 580.f), 0, 0) != nullptr);
+    }
+    REQUIRE(tracker.trackedAircraft.full());
+
+    // Only the distance can make room, it shrinks until the tracker is below CLEAR_UP_SIZE
+    tracker.removeStaleEntries();
+    REQUIRE(tracker.trackedAircraft.size() == 121);
+    REQUIRE(tracker.trackedAircraft.size() <= AircraftTracker::CLEAR_UP_SIZE);
+    REQUIRE(tracker.trackedAircraft.find(0x1000 + 120, OpenAce::AddressType::RANDOM) != nullptr);
+    REQUIRE(tracker.trackedAircraft.find(0x1000 + 121, OpenAce::AddressType::RANDOM) == nullptr);
+    // Still above AUTO_DISTANCE_TRACK_UPPER, so the distance keeps shrinking for new aircraft
+    REQUIRE(tracker.autoDistanceTrack == 65000);
+    REQUIRE(tracker.statistics.lastTrackPoint == 8);
+}
+
+TEST_CASE("Stale entries are removed on tries first", "[single-file]")
+{
+    AircraftTracker tracker{bus, mockConfig};
+
+    for (uint32_t i = 0; i < AircraftTracker::MAX_TRACKING_PLANES; i++)
+    {
+        auto track = tracker.trackedAircraft.insert(aircraft(0x1000 + i, 1000.f), 0, 0);
+        track->numberOfTries = i < 10 ? 9 : 0;
+    }
+
+    tracker.removeStaleEntries();
+    REQUIRE(tracker.trackedAircraft.size() == AircraftTracker::MAX_TRACKING_PLANES - 10);
+    REQUIRE(tracker.trackedAircraft.find(0x1000, OpenAce::AddressType::RANDOM) == nullptr);
+    REQUIRE(tracker.statistics.lastTrackPoint == 7);
+    // The distance shrank in each round the tracker was still too full, and once more after
+    REQUIRE(tracker.autoDistanceTrack == AircraftTracker::MAX_TRACKING_DISTANCE - 3 * AircraftTracker::AUTO_DISTANCE_STEP);
+}
@@ -0,0 +1,76 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include "deadreckoning.hpp"
+
+static OpenAce::AircraftPositionInfo flying(int16_t course, float groundSpeed, float hTurnRate)
+{
+    OpenAce::AircraftPositionInfo position;
+    position.airborne = true;
+    position.lat = 52.f;
+    position.lon = 5.f;
+    position.altitudeWgs84 = 1000;
+    position.verticalSpeed = 2.f;
+    position.course = course;
+    position.groundSpeed = groundSpeed;
+    position.hTurnRate = hTurnRate;
+    return position;
+}
+
+TEST_CASE("DeadReckoning straight line", "[single-file]")
+{
+    // North at 30m/s for 10 seconds
+    auto north = flying(0, 30.f, 0.f);
+    DeadReckoning::extrapolate(north, 10.f);
+    REQUIRE(north.lat == Catch::Approx(52.f + 300.f / 111139.f));
+    REQUIRE(north.lon == Catch::Approx(5.f));
+    REQUIRE(north.altitudeWgs84 == 1020);
+    REQUIRE(north.course == 0);
+
+    // East at 30m/s for 10 seconds
+    auto east = flying(90, 30.f, 0.f);
+    DeadReckoning::extrapolate(east, 10.f);
+    REQUIRE(east.lat == Catch::Approx(52.f));
+    REQUIRE(east.lon == Catch::Approx(5.f + 300.f / (111321.f * cosf(52.f * DEG_TO_RADS))).epsilon(0.0001));
+}
+
+TEST_CASE("DeadReckoning constant turn", "[single-file]")
+{
+    // Full circle comes back to the start
+    auto circle = flying(0, 25.f, 18.f);
+    DeadReckoning::extrapolate(circle, 20.f);
+    REQUIRE(circle.lat == Catch::Approx(52.f).margin(0.00001));
+    REQUIRE(circle.lon == Catch::Approx(5.f).margin(0.00001));
+    REQUIRE(circle.course == 0);
+
+    // Half a circle turning right from north ends up east at twice the radius, heading south
+    auto half = flying(0, 25.f, 18.f);
+    DeadReckoning::extrapolate(half, 10.f);
+    float diameter = 2.f * 25.f / (18.f * DEG_TO_RADS);
+    REQUIRE(half.lat == Catch::Approx(52.f).margin(0.00001));
+    REQUIRE(half.lon == Catch::Approx(5.f + diameter / (111321.f * cosf(52.f * DEG_TO_RADS))).epsilon(0.0001));
+    REQUIRE(half.course == 180);
+
+    // Turning left from north
+    auto left = flying(0, 25.f, -9.f);
+    DeadReckoning::extrapolate(left, 10.f);
+    REQUIRE(left.lon < 5.f);
+    REQUIRE(left.course == 270);
+}
+
+TEST_CASE("DeadReckoning keeps aircraft on the ground", "[single-file]")
+{
+    auto ground = flying(90, 10.f, 0.f);
+    ground.airborne = false;
+    ground.verticalSpeed = 0.f;
+    DeadReckoning::extrapolate(ground, 5.f);
+    REQUIRE(ground.lat == 52.f);
+    REQUIRE(ground.lon == 5.f);
+    REQUIRE(ground.altitudeWgs84 == 1000);
+
+    auto noTrack = flying(90, 10.f, 0.f);
+    noTrack.noTrack = true;
+    DeadReckoning::extrapolate(noTrack, 5.f);
+    REQUIRE(noTrack.lon == 5.f);
+    REQUIRE(noTrack.altitudeWgs84 == 1010);
+}
@@ -0,0 +1,72 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "trackfusion.hpp"
+
+static OpenAce::AircraftPositionInfo glider(OpenAce::AircraftAddress address, OpenAce::AddressType addressType, OpenAce::DataSource dataSource)
+{
+    OpenAce::AircraftPositionInfo position;
+    position.address = address;
+    position.addressType = addressType;
+    position.dataSource = dataSource;
+    position.airborne = true;
+    position.lat = 52.f;
+    position.lon = 5.f;
+    position.altitudeWgs84 = 1000;
+    position.course = 90;
+    position.groundSpeed = 25.f;
+    return position;
+}
+
+TEST_CASE("TrackFusion prefers the better source while it is fresh", "[single-file]")
+{
+    OpenAce::TrackInfo flarm{0, 1'000, 0, glider(0x100, OpenAce::AddressType::ICAO, OpenAce::DataSource::FLARM)};
+    auto ogn = glider(0x100, OpenAce::AddressType::ICAO, OpenAce::DataSource::OGN1);
+    auto adsl = glider(0x100, OpenAce::AddressType::ICAO, OpenAce::DataSource::ADSL);
+
+    REQUIRE(!TrackFusion::accept(flarm, ogn, 1'500));
+    REQUIRE(TrackFusion::accept(flarm, adsl, 1'500));
+    REQUIRE(TrackFusion::accept(flarm, ogn, 1'000 + TrackFusion::SOURCE_HOLD_MS + 1));
+
+    OpenAce::TrackInfo tracked{0, 1'000, 0, ogn};
+    REQUIRE(TrackFusion::accept(tracked, glider(0x100, OpenAce::AddressType::ICAO, OpenAce::DataSource::FLARM), 1'500));
+}
+
+TEST_CASE("TrackFusion matches random addresses on position", "[single-file]")
+{
+    OpenAce::TrackInfo known{0, 1'000, 0, glider(0x100, OpenAce::AddressType::ICAO, OpenAce::DataSource::OGN1)};
+
+    // One second later the glider moved 25m to the east
+    auto random = glider(0x555, OpenAce::AddressType::RANDOM, OpenAce::DataSource::FLARM);
+    random.lon += 25.f / (111321.f * cosf(52.f * DEG_TO_RADS));
+    REQUIRE(TrackFusion::isSameAircraft(known, random, 2'000));
+
+    // A different known address is never the same aircraft
+    auto other = random;
+    other.address = 0x200;
+    other.addressType = OpenAce::AddressType::ICAO;
+    REQUIRE(!TrackFusion::isSameAircraft(known, other, 2'000));
+
+    // Too far, too high, other course or speed
+    auto far = random;
+    far.lat += 100.f / 111139.f;
+    REQUIRE(!TrackFusion::isSameAircraft(known, far, 2'000));
+
+    auto high = random;
+    high.altitudeWgs84 += 50;
+    REQUIRE(!TrackFusion::isSameAircraft(known, high, 2'000));
+
+    auto turned = random;
+    turned.course = 180;
+    REQUIRE(!TrackFusion::isSameAircraft(known, turned, 2'000));
+
+    auto faster = random;
+    faster.groundSpeed = 40.f;
+    REQUIRE(!TrackFusion::isSameAircraft(known, faster, 2'000));
+
+    // Course across north
+    OpenAce::TrackInfo north{0, 1'000, 0, glider(0x100, OpenAce::AddressType::ICAO, OpenAce::DataSource::OGN1)};
+    north.position.course = 355;
+    auto northRandom = glider(0x555, OpenAce::AddressType::RANDOM, OpenAce::DataSource::FLARM);
+    northRandom.course = 5;
+    REQUIRE(TrackFusion::isSameAircraft(north, northRandom, 1'000));
+}
@@ -0,0 +1,163 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "trackstore.hpp"
+
+static constexpr OpenAce::AddressType RANDOM = OpenAce::AddressType::RANDOM;
+
+static OpenAce::AircraftPositionInfo aircraft(OpenAce::AircraftAddress address, uint32_t distance = 1000)
+{
+    OpenAce::AircraftPositionInfo position;
+    position.address = address;
+    position.distanceFromOwn = distance;
+    return position;
+}
+
+TEST_CASE("TrackStore insert and find", "[single-file]")
+{
+    OpenAce::TrackStore<4> store;
+    REQUIRE(store.empty());
+    REQUIRE(store.next() == nullptr);
+
+    REQUIRE(store.insert(aircraft(0x100), 0, 300) != nullptr);
+    REQUIRE(store.insert(aircraft(0x200), 0, 100) != nullptr);
+    REQUIRE(store.insert(aircraft(0x300), 0, 200) != nullptr);
+    REQUIRE(store.size() == 3);
+
+    REQUIRE(store.find(0x200, RANDOM)->nextSendTime == 100);
+    REQUIRE(store.find(0x400, RANDOM) == nullptr);
+    REQUIRE(store.next()->position.address == 0x200);
+}
+
+TEST_CASE("TrackStore replaces an existing address", "[single-file]")
+{
+    OpenAce::TrackStore<4> store;
+    store.insert(aircraft(0x100), 0, 100);
+    store.insert(aircraft(0x200), 0, 200);
+    store.find(0x100, RANDOM)->numberOfTries = 5;
+
+    REQUIRE(store.insert(aircraft(0x100, 500), 50, 300) != nullptr);
+    REQUIRE(store.size() == 2);
+    REQUIRE(store.find(0x100, RANDOM)->numberOfTries == 0);
+    REQUIRE(store.find(0x100, RANDOM)->receivedTime == 50);
+    REQUIRE(store.find(0x100, RANDOM)->position.distanceFromOwn == 500);
+
+    // Updates never postpone sending
+    REQUIRE(store.find(0x100, RANDOM)->nextSendTime == 100);
+    REQUIRE(store.next()->position.address == 0x100);
+    store.insert(aircraft(0x200), 0, 150);
+    REQUIRE(store.find(0x200, RANDOM)->nextSendTime == 150);
+}
+
+TEST_CASE("TrackStore keys on address and address type", "[single-file]")
+{
+    OpenAce::TrackStore<4> store;
+    auto icao = aircraft(0x100);
+    icao.addressType = OpenAce::AddressType::ICAO;
+    store.insert(aircraft(0x100), 0, 100);
+    store.insert(icao, 0, 200);
+    REQUIRE(store.size() == 2);
+    REQUIRE(store.find(0x100, OpenAce::AddressType::ICAO)->nextSendTime == 200);
+    REQUIRE(store.find(0x100, OpenAce::AddressType::FLARM) == nullptr);
+
+    REQUIRE(store.erase(0x100, OpenAce::AddressType::ICAO));
+    REQUIRE(store.find(0x100, RANDOM) != nullptr);
+
+    REQUIRE(store.findIf([](const OpenAce::TrackInfo &track)
+    {
+        return track.nextSendTime == 100;
+    }) == store.find(0x100, RANDOM));
+}
+
+TEST_CASE("TrackStore full", "[single-file]")
+{
+    OpenAce::TrackStore<2> store;
+    store.insert(aircraft(0x100), 0, 100);
+    store.insert(aircraft(0x200), 0, 200);
+    REQUIRE(store.full());
+    REQUIRE(store.insert(aircraft(0x300), 0, 300) == nullptr);
+
+    // Existing aircraft can still be updated
+    REQUIRE(store.insert(aircraft(0x100), 0, 400) != nullptr);
+
+    REQUIRE(store.erase(0x200, RANDOM));
+    REQUIRE(!store.erase(0x200, RANDOM));
+    REQUIRE(store.insert(aircraft(0x300), 0, 50) != nullptr);
+    REQUIRE(store.next()->position.address == 0x300);
+}
+
+TEST_CASE("TrackStore schedules in nextSendTime order", "[single-file]")
+{
+    OpenAce::TrackStore<128> store;
+    for (uint32_t i = 0; i < store.capacity(); i++)
+    {
+        // Pseudo random but unique send times
+        store.insert(aircraft(i), 0, (i * 37) % 128);
+    }
+    REQUIRE(store.full());
+
+    // Send each aircraft once and move it 1000ms further, the order must follow nextSendTime
+    uint32_t last = 0;
+    for (uint32_t i = 0; i < store.capacity(); i++)
+    {
+        auto next = store.next();
+        REQUIRE(next->nextSendTime >= last);
+        last = next->nextSendTime;
+        store.reschedule(*next, next->nextSendTime + 1'000);
+    }
+    REQUIRE(store.next()->nextSendTime == 1'000);
+
+    // Removing from the middle keeps the order
+    for (uint32_t i = 0; i < store.capacity(); i += 3)
+    {
+        REQUIRE(store.erase(i, RANDOM));
+    }
+    last = 0;
+    while (!store.empty())
+    {
+        auto next = store.next();
+        REQUIRE(next->nextSendTime >= last);
+        last = next->nextSendTime;
+        REQUIRE(store.erase(next->position.address, RANDOM));
+    }
+}
+
+TEST_CASE("TrackStore handles time wrap around", "[single-file]")
+{
+    OpenAce::TrackStore<4> store;
+    store.insert(aircraft(0x100), 0, 10);
+    store.insert(aircraft(0x200), 0, UINT32_MAX - 10);
+    REQUIRE(store.next()->position.address == 0x200);
+}
+
+TEST_CASE("TrackStore removeIf", "[single-file]")
+{
+    OpenAce::TrackStore<16> store;
+    for (uint32_t i = 0; i < 16; i++)
+    {
+        store.insert(aircraft(i, i * 1000), 0, 100 - i);
+    }
+
+    REQUIRE(store.removeIf([](const OpenAce::TrackInfo &track)
+    {
+        return track.position.distanceFromOwn >= 8000;
+    }) == 8);
+    REQUIRE(store.size() == 8);
+    REQUIRE(store.find(8, RANDOM) == nullptr);
+    REQUIRE(store.find(7, RANDOM) != nullptr);
+    REQUIRE(store.next()->position.address == 7);
+
+    // Freed slots are available again
+    for (uint32_t i = 100; i < 108; i++)
+    {
+        REQUIRE(store.insert(aircraft(i), 0, i) != nullptr);
+    }
+    REQUIRE(store.full());
+
+    uint32_t count = 0;
+    store.forEach([&count](const OpenAce::TrackInfo &track)
+    {
+        (void)track;
+        count++;
+    });
+    REQUIRE(count == 16);
+}
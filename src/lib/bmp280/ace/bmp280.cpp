@@ -5,12 +5,12 @@
 void Bmp280::start()
 {
     xTaskCreate(bmp280Task, "Bmp280Task", configMINIMAL_STACK_SIZE+128, this, tskIDLE_PRIORITY, &taskHandle);
-    getBus().subscribe(*this);
+    subscribe(*this);
 };
 
 void Bmp280::stop()
 {
-    getBus().unsubscribe(*this);
+    unsubscribe(*this);
     xTaskNotify( taskHandle, 1, eSetBits);
 };
 
@@ -0,0 +1,2 @@
+#pragma once
+#include "../include/FreeRTOSConfig.h"
\ No newline at end of file
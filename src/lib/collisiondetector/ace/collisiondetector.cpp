@@ -0,0 +1,281 @@
+#include "collisiondetector.hpp"
+#include "ace/coreutils.hpp"
+#include "ace/semaphoreguard.hpp"
+
+#include "etl/algorithm.h"
+
+OpenAce::PostConstruct CollisionDetector::postConstruct()
+{
+    timerHandle = xTimerCreate("evaluateTimerTask", TASK_DELAY_MS(1'000), pdTRUE, this, evaluateTimerTask);
+    targetsMutex = xSemaphoreCreateMutex();
+    return OpenAce::PostConstruct::OK;
+}
+
+void CollisionDetector::start()
+{
+    xTaskCreate(collisionDetectorTask, "CollisionDetector", TASK_STACK_SIZE, this, tskIDLE_PRIORITY, &taskHandle);
+    xTimerStart(timerHandle, TASK_DELAY_MS(25));
+    subscribe(*this);
+};
+
+void CollisionDetector::stop()
+{
+    unsubscribe(*this);
+    xTaskNotify(taskHandle, TaskState::EXIT, eSetBits);
+    while (eTaskGetState(taskHandle) != eDeleted)
+    {
+        vTaskDelay(TASK_DELAY_MS(50));
+    }
+    xTimerDelete(timerHandle, TASK_DELAY_MS(250));
+    vSemaphoreDelete(targetsMutex);
+};
+
+void CollisionDetector::on_receive(const OpenAce::ConfigUpdatedMsg &msg)
+{
+    (void)msg;
+}
+
+void CollisionDetector::on_receive_unknown(const etl::imessage &msg)
+{
+    (void)msg;
+}
+
+void CollisionDetector::getData(etl::string_stream &stream, const etl::string_view path) const
+{
+    (void)path;
+    stream << "{";
+    stream << "\"evaluations\":" << statistics.evaluations;
+    stream << ",\"targets\":" << statistics.targets;
+    stream << ",\"targetsFullErr\":" << statistics.targetsFullErr;
+    stream << ",\"lastEvaluationUs\":" << statistics.lastEvaluationUs;
+    stream << ",\"maxEvaluationUs\":" << statistics.maxEvaluationUs;
+    stream << ",\"alarms\":[" << statistics.alarms[0] << "," << statistics.alarms[1] << "," << statistics.alarms[2] << "," << statistics.alarms[3] << "]";
+    stream << "}\n";
+}
+
+void CollisionDetector::on_receive(const OpenAce::TrackedAircraftPositionMsg &msg)
+{
+    const auto &position = msg.position;
+    SemaphoreGuard<25> guard{targetsMutex};
+    if (!guard)
+    {
+        return;
+    }
+
+    auto key = keyOf(position.address, position.addressType);
+    auto it = targets.find(key);
+    if (position.distanceFromOwn > DETECTION_RANGE)
+    {
+        if (it != targets.end())
+        {
+            targets.erase(it);
+        }
+        return;
+    }
+
+    if (it == targets.end())
+    {
+        if (targets.full())
+        {
+            statistics.targetsFullErr++;
+            return;
+        }
+        it = targets.insert(etl::make_pair(key, Target{})).first;
+    }
+
+    Target &target = it->second;
+    target.receivedTime = CoreUtils::msSinceBoot();
+    target.address = position.address;
+    target.addressType = position.addressType;
+    target.aircraftType = position.aircraftType;
+    target.dataSource = position.dataSource;
+    target.noTrack = position.noTrack;
+    target.airborne = position.airborne;
+    target.lat = position.lat;
+    target.lon = position.lon;
+    target.altitudeWgs84 = position.altitudeWgs84;
+    target.course = position.course;
+    target.groundSpeed = position.groundSpeed;
+    target.verticalSpeed = position.verticalSpeed;
+    target.hTurnRate = position.hTurnRate;
+}
+
+void CollisionDetector::on_receive(const OpenAce::OwnshipPositionMsg &msg)
+{
+    SemaphoreGuard<25> guard{targetsMutex};
+    if (guard)
+    {
+        ownshipPosition = msg.position;
+    }
+}
+
+void CollisionDetector::evaluateTimerTask(TimerHandle_t timer)
+{
+    CollisionDetector *cd = (CollisionDetector *)pvTimerGetTimerID(timer);
+    xTaskNotify(cd->taskHandle, TaskState::EVALUATE, eSetBits);
+}
+
+void CollisionDetector::collisionDetectorTask(void *arg)
+{
+    CollisionDetector *cd = static_cast<CollisionDetector *>(arg);
+    while (true)
+    {
+        if (uint32_t notifyValue = ulTaskNotifyTake(pdTRUE, TASK_DELAY_MS(2'000)))
+        {
+            if (notifyValue & TaskState::EXIT)
+            {
+                vTaskDelete(nullptr);
+                return;
+            }
+
+            if (notifyValue & TaskState::EVALUATE)
+            {
+                cd->evaluate();
+            }
+        }
+    }
+}
+
+void CollisionDetector::evaluateTargets(uint32_t now)
+{
+    // Build the batch relative to ownship, flat earth is good enough within DETECTION_RANGE
+    float metersPerDegLon = 111321.f * cosf(ownshipPosition.lat * DEG_TO_RADS);
+    for (const auto &entry : targets)
+    {
+        const Target &target = entry.second;
+        if (!target.airborne)
+        {
+            continue;
+        }
+
+        float age = (now - target.receivedTime) / 1000.f;
+        float course = target.course * DEG_TO_RADS;
+        float speed = target.noTrack ? 0.f : target.groundSpeed;
+        float velocityNorth = cosf(course) * speed;
+        float velocityEast = sinf(course) * speed;
+
+        Predictor::Kinematics kinematics
+        {
+            (target.lat - ownshipPosition.lat) * 111139.f + velocityNorth * age,
+            (target.lon - ownshipPosition.lon) * metersPerDegLon + velocityEast * age,
+            static_cast<float>(target.altitudeWgs84 - ownshipPosition.altitudeWgs84) + target.verticalSpeed * age,
+            velocityNorth,
+            velocityEast,
+            target.verticalSpeed,
+            target.noTrack ? 0.f : target.hTurnRate
+        };
+        auto idx = predictor.add(kinematics);
+        if (idx < 0)
+        {
+            statistics.targetsFullErr++;
+            break;
+        }
+        batchKey[idx] = entry.first;
+    }
+
+    predictor.evaluate(Predictor::Kinematics{0.f, 0.f, 0.f,
+                                             ownshipPosition.velocityNorth,
+                                             ownshipPosition.velocityEast,
+                                             ownshipPosition.verticalSpeed,
+                                             ownshipPosition.hTurnRate},
+                       conflicts.data());
+
+    for (size_t i = 0; i < predictor.size(); i++)
+    {
+        Target &target = targets.find(batchKey[i])->second;
+        target.alarmLevel = conflicts[i].alarmLevel;
+        target.secondsToImpact = conflicts[i].alarmLevel > 0 ? conflicts[i].secondsToImpact : 0;
+    }
+}
+
+void CollisionDetector::addWarning(const Target &target, float metersPerDegLon)
+{
+    OpenAce::CollisionWarning warning;
+    warning.address = target.address;
+    warning.addressType = target.addressType;
+    warning.aircraftType = target.aircraftType;
+    warning.dataSource = target.dataSource;
+    warning.alarmLevel = target.alarmLevel;
+    warning.secondsToImpact = target.secondsToImpact;
+    warning.relativeNorth = (target.lat - ownshipPosition.lat) * 111139.f;
+    warning.relativeEast = (target.lon - ownshipPosition.lon) * metersPerDegLon;
+    warning.relativeVertical = target.altitudeWgs84 - ownshipPosition.altitudeWgs84;
+    warning.track = target.course;
+    warning.turnRate = target.hTurnRate;
+    warning.groundSpeed = target.groundSpeed;
+    warning.climbRate = target.verticalSpeed;
+    warning.noTrack = target.noTrack;
+    warnings.push_back(warning);
+    statistics.alarms[target.alarmLevel]++;
+}
+
+void CollisionDetector::evaluate()
+{
+    uint64_t startUs = CoreUtils::usSinceBoot();
+    warnings.clear();
+    predictor.clear();
+
+    {
+        SemaphoreGuard<25> guard{targetsMutex};
+        if (!guard)
+        {
+            return;
+        }
+
+        uint32_t now = CoreUtils::msSinceBoot();
+        float metersPerDegLon = 111321.f * cosf(ownshipPosition.lat * DEG_TO_RADS);
+
+        // Remove targets the tracker stopped sending, a target that was in conflict gets it's final level 0 warning
+        for (auto it = targets.begin(); it != targets.end();)
+        {
+            if ((now - it->second.receivedTime) > TARGET_TIMEOUT_MS)
+            {
+                if (it->second.alarmLevel > 0)
+                {
+                    it->second.alarmLevel = 0;
+                    it->second.secondsToImpact = 0;
+                    addWarning(it->second, metersPerDegLon);
+                }
+                it = targets.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        statistics.targets = targets.size();
+
+        for (auto &entry : targets)
+        {
+            entry.second.previousAlarmLevel = entry.second.alarmLevel;
+            entry.second.alarmLevel = 0;
+            entry.second.secondsToImpact = 0;
+        }
+
+        // No alarms while we are on the ground
+        if (ownshipPosition.airborne && ownshipPosition.timestamp != 0)
+        {
+            evaluateTargets(now);
+        }
+
+        // Warnings for targets in conflict and for targets that just left a conflict
+        for (const auto &entry : targets)
+        {
+            const Target &target = entry.second;
+            if (target.alarmLevel != 0 || target.previousAlarmLevel != 0)
+            {
+                addWarning(target, metersPerDegLon);
+            }
+        }
+    }
+
+    // Send outside of the lock, the bus might be delivering a position to us at the same time
+    for (const auto &warning : warnings)
+    {
+        getBus().receive(warning);
+    }
+
+    statistics.evaluations++;
+    statistics.lastEvaluationUs = CoreUtils::usSinceBoot() - startUs;
+    statistics.maxEvaluationUs = etl::max(statistics.maxEvaluationUs, statistics.lastEvaluationUs);
+}
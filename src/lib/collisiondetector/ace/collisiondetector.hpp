@@ -0,0 +1,124 @@
+#pragma once
+
+#include <stdint.h>
+
+/* FreeRTOS. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "timers.h"
+
+/* Vendor. */
+#include "etl/message_bus.h"
+#include "etl/unordered_map.h"
+#include "etl/vector.h"
+
+/* OpenACE. */
+#include "ace/constants.hpp"
+#include "ace/basemodule.hpp"
+#include "ace/messages.hpp"
+
+#include "conflictpredictor.hpp"
+
+/**
+ * Predicts conflicts between ownship and tracked aircraft and publishes CollisionWarning messages.
+ * Targets are collected from TrackedAircraftPositionMsg, once a second all targets are evaluated in one batch over a 30 second horizon
+ */
+class CollisionDetector : public BaseModule, public etl::message_router<CollisionDetector, OpenAce::ConfigUpdatedMsg, OpenAce::OwnshipPositionMsg, OpenAce::TrackedAircraftPositionMsg>
+{
+private:
+    friend class message_router;
+
+    static constexpr uint8_t MAX_TARGETS = 64;
+    static constexpr float DETECTION_RANGE = 10'000;       // In meters, targets further away can't reach us within the horizon
+    static constexpr uint32_t TARGET_TIMEOUT_MS = 3'000;  // Targets are send by the tracker every second
+    static constexpr uint16_t TASK_STACK_SIZE = configMINIMAL_STACK_SIZE + 256;
+
+    using Predictor = OpenAce::ConflictPredictor<MAX_TARGETS>;
+    using Key = uint32_t;
+
+    // Same key as the TrackStore of the tracker, addresses are 24 bit and the address type goes in the upper byte
+    static constexpr Key keyOf(OpenAce::AircraftAddress address, OpenAce::AddressType addressType)
+    {
+        return (static_cast<Key>(addressType) << 24) | (address & 0x00ffffff);
+    }
+
+    struct
+    {
+        uint32_t evaluations = 0;
+        uint32_t targetsFullErr = 0;
+        uint32_t lastEvaluationUs = 0;
+        uint32_t maxEvaluationUs = 0;
+        uint16_t targets = 0;
+        uint32_t alarms[4] = {0, 0, 0, 0};
+    } statistics;
+
+    struct Target
+    {
+        uint32_t receivedTime; // ms since boot
+        OpenAce::AircraftAddress address;
+        OpenAce::AddressType addressType;
+        OpenAce::AircraftCategory aircraftType;
+        OpenAce::DataSource dataSource;
+        bool noTrack;
+        bool airborne;
+        uint8_t alarmLevel;         // Alarm level of the last evaluation
+        uint8_t previousAlarmLevel; // Alarm level of the evaluation before, to send a final level 0 warning
+        uint8_t secondsToImpact;
+        float lat;
+        float lon;
+        int16_t altitudeWgs84;
+        int16_t course;
+        float groundSpeed;
+        float verticalSpeed;
+        float hTurnRate;
+    };
+
+    TaskHandle_t taskHandle;
+    TimerHandle_t timerHandle;
+    SemaphoreHandle_t targetsMutex;
+
+    etl::unordered_map<Key, Target, MAX_TARGETS> targets;
+    OpenAce::OwnshipPositionInfo ownshipPosition;
+
+    // Work area for the evaluation, only used from the task
+    Predictor predictor;
+    etl::array<Predictor::Conflict, MAX_TARGETS> conflicts;
+    etl::array<Key, MAX_TARGETS> batchKey;
+    etl::vector<OpenAce::CollisionWarning, MAX_TARGETS> warnings;
+
+    enum TaskState : uint32_t
+    {
+        EXIT = 1 << 0,
+        EVALUATE = 1 << 1
+    };
+
+    void on_receive_unknown(const etl::imessage &msg);
+
+    void on_receive(const OpenAce::ConfigUpdatedMsg &msg);
+    void on_receive(const OpenAce::TrackedAircraftPositionMsg &msg);
+    void on_receive(const OpenAce::OwnshipPositionMsg &msg);
+    static void collisionDetectorTask(void *arg);
+    static void evaluateTimerTask(TimerHandle_t timer);
+    void evaluate();
+    void addWarning(const Target &target, float metersPerDegLon);
+    void evaluateTargets(uint32_t now);
+
+public:
+    static constexpr const etl::string_view NAME = "CollisionDetector";
+    CollisionDetector(etl::imessage_bus &bus, const Configuration &config) : BaseModule(bus, NAME),
+        taskHandle(nullptr), timerHandle(nullptr), targetsMutex(nullptr), ownshipPosition{}
+    {
+        (void)config;
+    }
+
+    virtual ~CollisionDetector() = default;
+
+    virtual OpenAce::PostConstruct postConstruct() override;
+
+    virtual void start() override;
+
+    virtual void stop() override;
+
+    virtual void getData(etl::string_stream &stream, const etl::string_view path) const override;
+};
@@ -0,0 +1,219 @@
+#pragma once
+
+/* System. */
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+/* Vendor. */
+#include "etl/array.h"
+
+/* OpenACE. */
+#include "ace/constants.hpp"
+
+namespace OpenAce
+{
+
+    /**
+     * Batch conflict prediction of ownship against a set of targets.
+     * Targets are stored as structure of arrays so the inner loop only does a handful of multiply/adds per target per second
+     * of the prediction horizon, no trigonometry and no allocations. Each aircraft is predicted on a constant turn rate
+     * trajectory. The turn over a one second step is applied as a precomputed rotation of the velocity vector, the step itself
+     * is the exact chord of the arc.
+     * All positions are relative in meters (north, east, up), velocities in m/s and turn rates in deg/s
+     */
+    template <size_t MAX_TARGETS>
+    class ConflictPredictor
+    {
+    public:
+        static constexpr uint8_t HORIZON = 30;                // Seconds to look ahead
+        static constexpr float HORIZONTAL_PROTECTION = 150.f; // Radius in meters of the protected zone
+        static constexpr float VERTICAL_PROTECTION = 75.f;    // Half height in meters of the protected zone
+        static constexpr uint8_t LEVEL3_SECONDS = 8;          // Urgent alarm when impact is within this time
+        static constexpr uint8_t LEVEL2_SECONDS = 12;         // Important alarm
+        static constexpr uint8_t LEVEL1_SECONDS = 18;         // Low level alarm
+        static constexpr uint8_t NO_IMPACT = 0xff;
+
+        struct Kinematics
+        {
+            float north;
+            float east;
+            float up;
+            float velocityNorth;
+            float velocityEast;
+            float velocityUp;
+            float turnRate;
+        };
+
+        struct Conflict
+        {
+            uint8_t alarmLevel;      // 0..3
+            uint8_t secondsToImpact; // 0..HORIZON, NO_IMPACT when the protected zone is not entered
+            uint8_t cpaSeconds;      // Time of closest point of approach within the horizon
+            float cpaDistance;       // Horizontal distance at the closest point of approach
+        };
+
+    private:
+        // Target state, structure of arrays
+        etl::array<float, MAX_TARGETS> north;
+        etl::array<float, MAX_TARGETS> east;
+        etl::array<float, MAX_TARGETS> up;
+        etl::array<float, MAX_TARGETS> velocityNorth;
+        etl::array<float, MAX_TARGETS> velocityEast;
+        etl::array<float, MAX_TARGETS> velocityUp;
+        etl::array<float, MAX_TARGETS> stepA; // Chord of one second: stepA * v + stepB * v rotated by 90 degrees
+        etl::array<float, MAX_TARGETS> stepB;
+        etl::array<float, MAX_TARGETS> rotCos; // Rotation of the velocity vector in one second
+        etl::array<float, MAX_TARGETS> rotSin;
+        size_t count = 0;
+
+        // Ownship trajectory, shared by all targets
+        etl::array<float, HORIZON + 1> ownNorth;
+        etl::array<float, HORIZON + 1> ownEast;
+        etl::array<float, HORIZON + 1> ownUp;
+
+        struct Step
+        {
+            float a;
+            float b;
+            float cos;
+            float sin;
+        };
+
+        static Step stepFor(float turnRate)
+        {
+            float w = turnRate * DEG_TO_RADS;
+            float halfW = 0.5f * w;
+            // sin(x)/x, for small turn rates the aircraft flies a straight line
+            float chord = fabsf(halfW) < 1e-4f ? 1.f : sinf(halfW) / halfW;
+            return {chord * cosf(halfW), chord * sinf(halfW), cosf(w), sinf(w)};
+        }
+
+    public:
+        void clear()
+        {
+            count = 0;
+        }
+
+        size_t size() const
+        {
+            return count;
+        }
+
+        bool full() const
+        {
+            return count == MAX_TARGETS;
+        }
+
+        static constexpr size_t capacity()
+        {
+            return MAX_TARGETS;
+        }
+
+        /**
+         * Add a target relative to ownship, returns the index of the target or -1 when full
+         */
+        int16_t add(const Kinematics &target)
+        {
+            if (full())
+            {
+                return -1;
+            }
+            Step step = stepFor(target.turnRate);
+            north[count] = target.north;
+            east[count] = target.east;
+            up[count] = target.up;
+            velocityNorth[count] = target.velocityNorth;
+            velocityEast[count] = target.velocityEast;
+            velocityUp[count] = target.velocityUp;
+            stepA[count] = step.a;
+            stepB[count] = step.b;
+            rotCos[count] = step.cos;
+            rotSin[count] = step.sin;
+            return static_cast<int16_t>(count++);
+        }
+
+        /**
+         * Predict all added targets against ownship, results are written at the same index as the targets were added
+         */
+        void evaluate(const Kinematics &ownship, Conflict *results)
+        {
+            // Ownship trajectory once for all targets
+            Step step = stepFor(ownship.turnRate);
+            float n = ownship.north;
+            float e = ownship.east;
+            float vn = ownship.velocityNorth;
+            float ve = ownship.velocityEast;
+            for (uint8_t t = 0; t <= HORIZON; t++)
+            {
+                ownNorth[t] = n;
+                ownEast[t] = e;
+                ownUp[t] = ownship.up + ownship.velocityUp * t;
+                n += step.a * vn - step.b * ve;
+                e += step.a * ve + step.b * vn;
+                float rvn = vn * step.cos - ve * step.sin;
+                ve = ve * step.cos + vn * step.sin;
+                vn = rvn;
+            }
+
+            constexpr float HORIZONTAL_PROTECTION2 = HORIZONTAL_PROTECTION * HORIZONTAL_PROTECTION;
+            for (size_t i = 0; i < count; i++)
+            {
+                float tn = north[i];
+                float te = east[i];
+                float tvn = velocityNorth[i];
+                float tve = velocityEast[i];
+                const float a = stepA[i];
+                const float b = stepB[i];
+                const float c = rotCos[i];
+                const float s = rotSin[i];
+
+                float minDistance2 = INFINITY;
+                uint8_t cpaSeconds = 0;
+                uint8_t secondsToImpact = NO_IMPACT;
+                for (uint8_t t = 0; t <= HORIZON; t++)
+                {
+                    float dn = tn - ownNorth[t];
+                    float de = te - ownEast[t];
+                    float distance2 = dn * dn + de * de;
+                    if (distance2 < minDistance2)
+                    {
+                        minDistance2 = distance2;
+                        cpaSeconds = t;
+                    }
+                    if (secondsToImpact == NO_IMPACT && distance2 < HORIZONTAL_PROTECTION2 &&
+                        fabsf(up[i] + velocityUp[i] * t - ownUp[t]) < VERTICAL_PROTECTION)
+                    {
+                        secondsToImpact = t;
+                    }
+
+                    tn += a * tvn - b * tve;
+                    te += a * tve + b * tvn;
+                    float rvn = tvn * c - tve * s;
+                    tve = tve * c + tvn * s;
+                    tvn = rvn;
+                }
+
+                results[i] = {alarmLevel(secondsToImpact), secondsToImpact, cpaSeconds, sqrtf(minDistance2)};
+            }
+        }
+
+        static uint8_t alarmLevel(uint8_t secondsToImpact)
+        {
+            if (secondsToImpact <= LEVEL3_SECONDS)
+            {
+                return 3;
+            }
+            else if (secondsToImpact <= LEVEL2_SECONDS)
+            {
+                return 2;
+            }
+            else if (secondsToImpact <= LEVEL1_SECONDS)
+            {
+                return 1;
+            }
+            return 0;
+        }
+    };
+
+}
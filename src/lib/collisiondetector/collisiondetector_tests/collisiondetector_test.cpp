@@ -0,0 +1,66 @@
+#include <catch2/catch_test_macros.hpp>
+
+#define private public
+
+#include "mockconfig.h"
+#include "pico/time.h"
+
+#include "collisiondetector.hpp"
+
+OpenAce::ThreadSafeBus<50> bus;
+MockConfig mockConfig{bus};
+
+class WarningSubscriber : public etl::message_router<WarningSubscriber, OpenAce::CollisionWarning>
+{
+public:
+    etl::vector<OpenAce::CollisionWarning, 8> warnings;
+
+    void on_receive(const OpenAce::CollisionWarning &msg)
+    {
+        warnings.push_back(msg);
+    }
+    void on_receive_unknown(const etl::imessage &msg)
+    {
+        (void)msg;
+    }
+};
+
+static CollisionDetector::Target target(OpenAce::AircraftAddress address, uint32_t receivedTime, uint8_t alarmLevel)
+{
+    CollisionDetector::Target target{};
+    target.address = address;
+    target.addressType = OpenAce::AddressType::ICAO;
+    target.receivedTime = receivedTime;
+    target.alarmLevel = alarmLevel;
+    target.secondsToImpact = alarmLevel > 0 ? 10 : 0;
+    return target;
+}
+
+TEST_CASE("A target that times out while alarmed gets a final warning", "[single-file]")
+{
+    CollisionDetector detector{bus, mockConfig};
+    WarningSubscriber subscriber;
+    bus.subscribe(subscriber);
+    xSemaphoreTakeReturn = pdTRUE;
+    get_absolute_timeValue = 10'000'000;
+
+    // Two targets the tracker stopped sending, one of them in conflict, and one that is still received
+    detector.targets.insert(etl::make_pair(CollisionDetector::keyOf(0x100, OpenAce::AddressType::ICAO), target(0x100, 5'000, 2)));
+    detector.targets.insert(etl::make_pair(CollisionDetector::keyOf(0x200, OpenAce::AddressType::ICAO), target(0x200, 5'000, 0)));
+    detector.targets.insert(etl::make_pair(CollisionDetector::keyOf(0x300, OpenAce::AddressType::ICAO), target(0x300, 9'500, 0)));
+
+    detector.evaluate();
+    REQUIRE(detector.targets.size() == 1);
+    REQUIRE(subscriber.warnings.size() == 1);
+    REQUIRE(subscriber.warnings[0].address == 0x100);
+    REQUIRE(subscriber.warnings[0].alarmLevel == 0);
+    REQUIRE(subscriber.warnings[0].secondsToImpact == 0);
+    REQUIRE(detector.statistics.alarms[0] == 1);
+
+    // Only once
+    detector.evaluate();
+    REQUIRE(subscriber.warnings.size() == 1);
+
+    bus.unsubscribe(subscriber);
+    xSemaphoreTakeReturn = pdFALSE;
+}
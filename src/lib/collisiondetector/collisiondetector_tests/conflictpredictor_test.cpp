@@ -0,0 +1,105 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#include "conflictpredictor.hpp"
+
+using Predictor = OpenAce::ConflictPredictor<8>;
+
+// Ownship at the origin flying north at 30m/s
+static const Predictor::Kinematics ownship{0.f, 0.f, 0.f, 30.f, 0.f, 0.f, 0.f};
+
+TEST_CASE("ConflictPredictor head on", "[single-file]")
+{
+    Predictor predictor;
+    Predictor::Conflict results[8];
+
+    // Head on, 600 meters ahead flying south at 30m/s, impact zone is entered after (600-150)/60 = 7.5 seconds
+    predictor.add({600.f, 0.f, 0.f, -30.f, 0.f, 0.f, 0.f});
+    // Same but 1500 meters ahead
+    predictor.add({1500.f, 0.f, 0.f, -30.f, 0.f, 0.f, 0.f});
+    // Head on but 200 meters higher
+    predictor.add({600.f, 0.f, 200.f, -30.f, 0.f, 0.f, 0.f});
+    predictor.evaluate(ownship, results);
+
+    REQUIRE(results[0].secondsToImpact == 8);
+    REQUIRE(results[0].alarmLevel == 3);
+    REQUIRE(results[0].cpaSeconds == 10);
+    REQUIRE(results[0].cpaDistance == Catch::Approx(0.f).margin(0.01));
+
+    REQUIRE(results[1].secondsToImpact == 23);
+    REQUIRE(results[1].alarmLevel == 0);
+    REQUIRE(results[1].cpaSeconds == 25);
+
+    REQUIRE(results[2].secondsToImpact == Predictor::NO_IMPACT);
+    REQUIRE(results[2].alarmLevel == 0);
+}
+
+TEST_CASE("ConflictPredictor parallel traffic", "[single-file]")
+{
+    Predictor predictor;
+    Predictor::Conflict results[8];
+
+    // Same speed and course 300 meters to the east
+    predictor.add({0.f, 300.f, 0.f, 30.f, 0.f, 0.f, 0.f});
+    predictor.evaluate(ownship, results);
+
+    REQUIRE(results[0].alarmLevel == 0);
+    REQUIRE(results[0].secondsToImpact == Predictor::NO_IMPACT);
+    REQUIRE(results[0].cpaDistance == Catch::Approx(300.f));
+}
+
+TEST_CASE("ConflictPredictor turning traffic", "[single-file]")
+{
+    Predictor predictor;
+    Predictor::Conflict results[8];
+
+    // Opposite traffic 200m east, turning right at 3 deg/s towards our track
+    predictor.add({600.f, 200.f, 0.f, -30.f, 0.f, 0.f, 3.f});
+    // Same traffic without the turn passes at 200m
+    predictor.add({600.f, 200.f, 0.f, -30.f, 0.f, 0.f, 0.f});
+    predictor.evaluate(ownship, results);
+
+    REQUIRE(results[0].alarmLevel > 0);
+    REQUIRE(results[0].cpaDistance < Predictor::HORIZONTAL_PROTECTION);
+    REQUIRE(results[1].alarmLevel == 0);
+    REQUIRE(results[1].cpaDistance == Catch::Approx(200.f));
+}
+
+TEST_CASE("ConflictPredictor ownship turn", "[single-file]")
+{
+    Predictor predictor;
+    Predictor::Conflict results[8];
+
+    // A full circle of ownship at 12deg/s brings ownship back at the start after 30 seconds, where a static target waits
+    Predictor::Kinematics circling{0.f, 0.f, 0.f, 30.f, 0.f, 0.f, 12.f};
+    predictor.add({0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f});
+    predictor.evaluate(circling, results);
+    REQUIRE(results[0].secondsToImpact == 0);
+
+    // Diameter of the circle is 2 * 30 / (12 deg/s in rad)
+    predictor.clear();
+    float diameter = 2.f * 30.f / (12.f * DEG_TO_RADS);
+    predictor.add({0.f, diameter, 0.f, 0.f, 0.f, 0.f, 0.f});
+    predictor.evaluate(circling, results);
+    REQUIRE(results[0].cpaSeconds == 15);
+    REQUIRE(results[0].cpaDistance == Catch::Approx(0.f).margin(1.f));
+}
+
+TEST_CASE("ConflictPredictor alarm levels and capacity", "[single-file]")
+{
+    REQUIRE(Predictor::alarmLevel(0) == 3);
+    REQUIRE(Predictor::alarmLevel(8) == 3);
+    REQUIRE(Predictor::alarmLevel(9) == 2);
+    REQUIRE(Predictor::alarmLevel(12) == 2);
+    REQUIRE(Predictor::alarmLevel(18) == 1);
+    REQUIRE(Predictor::alarmLevel(19) == 0);
+    REQUIRE(Predictor::alarmLevel(Predictor::NO_IMPACT) == 0);
+
+    Predictor predictor;
+    for (size_t i = 0; i < predictor.capacity(); i++)
+    {
+        REQUIRE(predictor.add({0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f}) == static_cast<int16_t>(i));
+    }
+    REQUIRE(predictor.full());
+    REQUIRE(predictor.add({0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f}) == -1);
+}
@@ -66,12 +66,12 @@ OpenAce::PostConstruct Config::postConstruct()
 
 void Config::start()
 {
-    getBus().subscribe(*this);
+    subscribe(*this);
 }
 
 void Config::stop()
 {
-    getBus().unsubscribe(*this);
+    unsubscribe(*this);
 }
 
 void Config::getData(etl::string_stream &stream, const etl::string_view fullPath) const
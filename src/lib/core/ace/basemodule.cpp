@@ -1,4 +1,5 @@
 #include "basemodule.hpp"
+#include "messagerouter.hpp"
 
 /* FreeRTOS. */
 #include "FreeRTOS.h"
@@ -61,6 +62,36 @@ BaseModule::BaseModule(etl::imessage_bus &bus_, const etl::string_view name_) :
     }
 }
 
+bool BaseModule::subscribe(etl::imessage_router &router)
+{
+    if (xSemaphoreTakeRecursive(BaseModule::xMutex, portMAX_DELAY) == pdTRUE)
+    {
+        if (!routerNames.full() || routerNames.contains(&router))
+        {
+            routerNames[&router] = moduleName;
+        }
+        xSemaphoreGiveRecursive(BaseModule::xMutex);
+    }
+    // The bus is always a ThreadSafeBus, it gives the router a slot for it's statistics
+    return static_cast<OpenAce::ThreadSafeBusBase &>(bus).subscribe(router);
+}
+
+void BaseModule::unsubscribe(etl::imessage_router &router)
+{
+    static_cast<OpenAce::ThreadSafeBusBase &>(bus).unsubscribe(router);
+    if (xSemaphoreTakeRecursive(BaseModule::xMutex, portMAX_DELAY) == pdTRUE)
+    {
+        routerNames.erase(&router);
+        xSemaphoreGiveRecursive(BaseModule::xMutex);
+    }
+}
+
+etl::string_view BaseModule::routerName(const etl::imessage_router *router)
+{
+    auto it = routerNames.find(router);
+    return it != routerNames.end() ? it->second : etl::string_view{};
+}
+
 BaseModule *BaseModule::moduleByName(const BaseModule &that, const etl::string_view requesting, bool panicIfNotFound)
 {
     // printf("Looking %s depends on %s\n", that.name(), requesting);
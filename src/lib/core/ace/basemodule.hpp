@@ -42,6 +42,8 @@ private:
         pinInterruptHandler() : event(0x00), handler(nullptr), callback(nullptr), notificationValue(0x00) {}
     };
     inline static etl::map<uint8_t, BaseModule::pinInterruptHandler, 8> pinInteruptHandlers;
+    // Module name of each router that is subscribed to the bus, used to name the subscribers in the bus statistics
+    inline static etl::map<const etl::imessage_router *, etl::string_view, MAX_MODULES> routerNames;
 
 public:
     static void initBase()
@@ -100,6 +102,11 @@ public:
         return moduleLoaderMap;
     }
 
+    /**
+     * Name of the module that subscribed the router, empty when the router was not subscribed by a module
+     */
+    static etl::string_view routerName(const etl::imessage_router *router);
+
     // Called after construction but before running
     virtual OpenAce::PostConstruct postConstruct() = 0;
 
@@ -121,6 +128,13 @@ public:
         return bus;
     }
 
+    /**
+     * Subscribe or unsubscribe a router of this module to the bus
+     * The router is remembered with the name of this module for the bus statistics
+     */
+    bool subscribe(etl::imessage_router &router);
+    void unsubscribe(etl::imessage_router &router);
+
     /**
      * get any data out of a module. THis will usually show some internal informatoion about an module
      *
@@ -215,6 +229,7 @@ class SpiModule : public BaseModule
 {
 public:
     static constexpr uint32_t SPI_BUS_READY = 1 << 30;
+    static constexpr uint32_t SPI_TRANSFER_DONE = 1 << 29; // Given to the slot consumer when a DMA transfer is done
     static constexpr const etl::string_view NAME = "_SPI";
 
     SpiModule(etl::imessage_bus &bus) : BaseModule(bus, NAME)
@@ -229,6 +244,12 @@ public:
     virtual void cs_deselect(uint8_t cs) const = 0;
     virtual void write_array(uint8_t cs, uint8_t *data, uint8_t length, uint8_t delayMs) const = 0;
     virtual void write_byte(uint8_t cs, uint8_t data, uint8_t delayMs) const = 0;
+    /**
+     * Write or read length bytes without touching CS, for drivers that handle CS themselves.
+     * Larger transfers within a slot use DMA and the calling task blocks until done, returns the number of bytes transfered
+     */
+    virtual int write_data(const uint8_t *data, size_t length) const = 0;
+    virtual int read_data(uint8_t *buf, size_t length) const = 0;
     virtual void releaseSlot() const = 0;
     virtual bool aquireSlot(uint8_t busFrequencyMhz, TaskHandle_t consumerHandle, uint32_t bits = 0) const = 0;
 };
@@ -247,8 +268,9 @@ public:
     enum class Mode
     {
         NONE,
-        GFSK,
+        GFSK,     // GFSK, Manchester encoded at 100kbps (FLARM, OGN, ADS-L)
         LORA,
+        GFSK_NRZ, // GFSK at 38.4kbps without Manchester encoding (PilotAware)
     };
 
     static const char *modeString(Mode mode)
@@ -259,6 +281,8 @@ public:
             return "GFSK";
         case Mode::LORA:
             return "LORA";
+        case Mode::GFSK_NRZ:
+            return "GFSK_NRZ";
         default:
             return "UNK";
         }
@@ -281,14 +305,26 @@ public:
               syncWord(other.syncWord) {}
     };
 
+    /**
+     * Listen before talk. When the channel is busy the radio waits a random backoffMinMs..backoffMaxMs and listens again,
+     * as long as the transmission can still start before txBeforeMs (ms since boot). Without a txBeforeMs the radio does not listen
+     */
+    struct CarrierSense
+    {
+        uint8_t backoffMinMs;
+        uint8_t backoffMaxMs;
+        uint32_t txBeforeMs;
+    };
+
     struct RadioParameters
     {
         Radio::ProtocolConfig config;
         uint32_t frequency;
         int8_t powerdBm;
+        CarrierSense carrierSense; // Only used for transmissions
 
-        constexpr RadioParameters(const Radio::ProtocolConfig &_config, uint32_t _frequency, int8_t _powerdBm) : config(_config), frequency(_frequency), powerdBm(_powerdBm) {}
-        constexpr RadioParameters(const Radio::RadioParameters &_params) : config(_params.config), frequency(_params.frequency), powerdBm(_params.powerdBm) {}
+        constexpr RadioParameters(const Radio::ProtocolConfig &_config, uint32_t _frequency, int8_t _powerdBm, const CarrierSense &_carrierSense = CarrierSense{0, 0, 0}) : config(_config), frequency(_frequency), powerdBm(_powerdBm), carrierSense(_carrierSense) {}
+        constexpr RadioParameters(const Radio::RadioParameters &_params) : config(_params.config), frequency(_params.frequency), powerdBm(_params.powerdBm), carrierSense(_params.carrierSense) {}
         RadioParameters& operator=(const RadioParameters& other) = default;
     };
 
@@ -2,43 +2,168 @@
 
 /* FreeRTOS. */
 #include "FreeRTOS.h"
+#include "task.h"
 #include "semphr.h"
 
 #include "coreutils.hpp"
+#include "basemodule.hpp"
+#include "messages.hpp"
+#include "mpscring.hpp"
 
 /* Vendor. */
 #include "etl/message_router.h"
 #include "etl/message_bus.h"
 #include "etl/vector.h"
+#include "etl/array.h"
+#include "etl/algorithm.h"
+#include "etl/iterator.h"
+#include "etl/string_stream.h"
+#include "etl/message_packet.h"
 
 // The successor functionality is to allow routers to be chained together, so that if a message is not handled by the current router, then it will be passed on to the next.
-// Should we use a queue ?? QueuedMessageRouter.cpp
 namespace OpenAce
 {
+    /**
+     * Router id for subscribers that accept RadioRxFrame's from any task at the same time.
+     * Such a subscriber only copies the frame into it's own ring (see MpscRing) and processes it in it's own task.
+     * The bus delivers frames to these routers without taking the bus mutex, so the burst of radio frames after PPS
+     * does not wait for slow, low priority handlers. All other messages are still delivered under the mutex.
+     * Construct the message_router with this id to opt in: message_router(OpenAce::LOCKFREE_ROUTER_ID)
+     */
+    static constexpr etl::message_router_id_t LOCKFREE_ROUTER_ID = 200;
+
+    /**
+     * Router id for a lock free subscriber that only wants RadioRxFrame's from one DataSource.
+     * The bus hands each frame directly to the decoders of it's dataSource, other decoders are not called at all.
+     * Construct the message_router with this id to opt in: message_router(OpenAce::lockFreeRouterId(OpenAce::DataSource::FLARM))
+     */
+    static constexpr etl::message_router_id_t lockFreeRouterId(OpenAce::DataSource dataSource)
+    {
+        return LOCKFREE_ROUTER_ID + 1 + static_cast<uint8_t>(dataSource);
+    }
+
+    static constexpr bool isLockFreeRouterId(etl::message_router_id_t id)
+    {
+        return id >= LOCKFREE_ROUTER_ID && id < lockFreeRouterId(OpenAce::DataSource::_ITEMS);
+    }
+
+    /**
+     * Highest message ID + 1 we keep per message statistics for
+     */
+    static constexpr uint8_t MAX_MESSAGE_IDS = 32;
+
+    /**
+     * Messages are delivered in one of two lanes.
+     * IMMEDIATE: Delivered on the task of the publisher. Used for radio frames, ownship and traffic data
+     *            The handlers of these messages only copy data into their own queue or state
+     * DEFERRED:  Copied in a bounded ring and delivered from the bus task under it's own mutex. Used for statistics,
+     *            configuration and GDL output so a slow UDP send never holds the mutex a radio task waits on
+     */
+    enum class Lane : uint8_t
+    {
+        IMMEDIATE,
+        DEFERRED
+    };
+
+    using DeferredPacket = etl::message_packet<OpenAce::GDLMsg, OpenAce::AccessPointClientsMsg, OpenAce::GpsStatsMsg, OpenAce::ConfigUpdatedMsg>;
+
+    static constexpr Lane laneOf(etl::message_id_t id)
+    {
+        switch (id)
+        {
+        case OpenAce::GDLMsg::ID:
+        case OpenAce::AccessPointClientsMsg::ID:
+        case OpenAce::GpsStatsMsg::ID:
+        case OpenAce::ConfigUpdatedMsg::ID:
+            return Lane::DEFERRED;
+        default:
+            return Lane::IMMEDIATE;
+        }
+    }
+
+    /**
+     * The part of ThreadSafeBus that does not depend on the number of routers.
+     * BaseModule subscribes through it, so the bus can prepare the statistics of a router when it subscribes
+     */
+    class ThreadSafeBusBase : public etl::imessage_bus
+    {
+    protected:
+        ThreadSafeBusBase(etl::ivector<etl::imessage_router *> &list) : etl::imessage_bus(list)
+        {
+        }
+
+        ThreadSafeBusBase(etl::ivector<etl::imessage_router *> &list, etl::imessage_router &successor) : etl::imessage_bus(list, successor)
+        {
+        }
+
+    public:
+        virtual bool subscribe(etl::imessage_router &router) = 0;
+        virtual void unsubscribe(etl::imessage_router &router) = 0;
+    };
 
     template <uint_least8_t MAX_ROUTERS_>
-    class ThreadSafeBus : public etl::imessage_bus
+    class ThreadSafeBus : public ThreadSafeBusBase
     {
-        struct
+    private:
+        /**
+         * Time spend in the on_receive handlers of a subscriber
+         */
+        struct HandlerStats
+        {
+            const etl::imessage_router *router = nullptr;
+            uint32_t calls = 0;
+            uint32_t minUs = UINT32_MAX;
+            uint32_t maxUs = 0;
+            uint64_t totalUs = 0;
+        };
+
+        mutable struct
         {
             uint32_t mutexErr = 0;
             uint32_t totalMessages = 0;
+            uint32_t mutexWaitMaxUs = 0;
+            uint64_t mutexWaitTotalUs = 0;
+            uint32_t deferred = 0;
+            uint32_t deferredFull = 0;
+            etl::array<uint32_t, MAX_MESSAGE_IDS> messages{};
+            etl::array<uint32_t, MAX_MESSAGE_IDS> dropped{};
+            etl::array<HandlerStats, MAX_ROUTERS_> handlers{};
         } statistics;
 
+        // A tracker burst publishes a GDL message for each of the up to 128 tracked aircraft in one go
+        static constexpr size_t DEFERRED_QUEUE_SIZE = 128;
+        // Above the module tasks, which all run at idle priority, so the ring is drained while a burst is published
+        static constexpr UBaseType_t DEFERRED_TASK_PRIORITY = tskIDLE_PRIORITY + 1;
+
         etl::vector<etl::imessage_router *, MAX_ROUTERS_> router_list;
-        SemaphoreHandle_t xMutex;
-        uint32_t lastMessages;
-        uint32_t lastTime;
+        etl::vector<uint8_t, MAX_ROUTERS_> routerSlots; // Slot in statistics.handlers of the router at the same position in router_list
+        MpscRing<DeferredPacket, DEFERRED_QUEUE_SIZE> deferredRing;
+        SemaphoreHandle_t xMutex;         // IMMEDIATE lane
+        SemaphoreHandle_t xDeferredMutex; // DEFERRED lane
+        TaskHandle_t deferredTaskHandle;
+        mutable uint32_t lastMessages;
+        mutable uint32_t lastTime;
 
     public:
-        ThreadSafeBus() : etl::imessage_bus(router_list), xMutex(nullptr), lastMessages(0), lastTime(0)
+        ThreadSafeBus() : ThreadSafeBusBase(router_list), xMutex(nullptr), xDeferredMutex(nullptr), deferredTaskHandle(nullptr), lastMessages(0), lastTime(0)
         {
             xMutex = xSemaphoreCreateRecursiveMutex();
+            xDeferredMutex = xSemaphoreCreateRecursiveMutex();
         }
 
-        ThreadSafeBus(etl::imessage_router &successor) : etl::imessage_bus(router_list, successor), xMutex(nullptr), lastMessages(0), lastTime(0)
+        ThreadSafeBus(etl::imessage_router &successor) : ThreadSafeBusBase(router_list, successor), xMutex(nullptr), xDeferredMutex(nullptr), deferredTaskHandle(nullptr), lastMessages(0), lastTime(0)
         {
             xMutex = xSemaphoreCreateRecursiveMutex();
+            xDeferredMutex = xSemaphoreCreateRecursiveMutex();
+        }
+
+        /**
+         * Start the task that delivers the DEFERRED lane.
+         * Until this is called, deferred messages are delivered on the task of the publisher
+         */
+        bool start()
+        {
+            return xTaskCreate(deferredTask, "busDeferredTask", configMINIMAL_STACK_SIZE + 1024, this, DEFERRED_TASK_PRIORITY, &deferredTaskHandle) == pdPASS;
         }
 
         virtual ~ThreadSafeBus()
@@ -48,62 +173,286 @@ namespace OpenAce
         }
 
         /**
-         * Calculate total messages per second that goes over the messagebus
+         * Subscribe the router and give it a slot for it's handler statistics.
+         * Both lanes are locked, in the same order as a deferred handler that publishes does. The lock free lane expects subscriptions to only change during start() and stop() of a module
+         */
+        virtual bool subscribe(etl::imessage_router &router) override
+        {
+            bool ok = false;
+            if (xSemaphoreTakeRecursive(xDeferredMutex, portMAX_DELAY) == pdTRUE)
+            {
+                if (xSemaphoreTakeRecursive(xMutex, portMAX_DELAY) == pdTRUE)
+                {
+                    ok = etl::imessage_bus::subscribe(router);
+                    auto position = etl::find(router_list.begin(), router_list.end(), &router);
+                    if (ok && position != router_list.end())
+                    {
+                        // There is a slot for each router the bus can hold, so a free slot is always found
+                        uint8_t slot = 0;
+                        while (statistics.handlers[slot].router != nullptr)
+                        {
+                            slot++;
+                        }
+                        statistics.handlers[slot] = HandlerStats{};
+                        statistics.handlers[slot].router = &router;
+                        routerSlots.insert(routerSlots.begin() + etl::distance(router_list.begin(), position), slot);
+                    }
+                    xSemaphoreGiveRecursive(xMutex);
+                }
+                xSemaphoreGiveRecursive(xDeferredMutex);
+            }
+            return ok;
+        }
+
+        virtual void unsubscribe(etl::imessage_router &router) override
+        {
+            if (xSemaphoreTakeRecursive(xDeferredMutex, portMAX_DELAY) == pdTRUE)
+            {
+                if (xSemaphoreTakeRecursive(xMutex, portMAX_DELAY) == pdTRUE)
+                {
+                    auto position = etl::find(router_list.begin(), router_list.end(), &router);
+                    if (position != router_list.end())
+                    {
+                        auto slot = routerSlots.begin() + etl::distance(router_list.begin(), position);
+                        statistics.handlers[*slot] = HandlerStats{};
+                        routerSlots.erase(slot);
+                    }
+                    etl::imessage_bus::unsubscribe(router);
+                    xSemaphoreGiveRecursive(xMutex);
+                }
+                xSemaphoreGiveRecursive(xDeferredMutex);
+            }
+        }
+
+        /**
+         * Calculate total messages per second that goes over the messagebus since the previous call
          * Returns 0 if no calculation could be made
          */
-        uint16_t messagesPerSec()
+        uint16_t messagesPerSec() const
         {
             uint32_t msBoot = CoreUtils::msSinceBoot();
             uint32_t elapsed = CoreUtils::msElapsed(lastTime, msBoot);
             if (elapsed > 100)
             {
                 // Calculate number of messages per second
+                uint32_t messages = statistics.totalMessages - lastMessages;
                 lastMessages = statistics.totalMessages;
                 lastTime = msBoot;
-                return (statistics.totalMessages - lastMessages) * (1000 / elapsed);
+                return (messages * 1000) / elapsed;
             }
             return 0;
         }
 
-        //*******************************************
-        virtual void receive(const etl::imessage &message) override
+        /**
+         * Number of messages with this id that could not be delivered to the locked subscribers
+         */
+        uint32_t dropped(etl::message_id_t id) const
+        {
+            return id < MAX_MESSAGE_IDS ? statistics.dropped[id] : 0;
+        }
+
+        /**
+         * Write the bus statistics as JSON.
+         * Subscribers are named after the module they belong to, or their index when they are not a module
+         */
+        void getData(etl::string_stream &stream) const
         {
-            /**
-             * Specify extra delay for configuration changes to ensure they are delivered
-             * TODO: For development purpose create statistics of the message ID's per
-             */
+            stream << "{";
+            stream << "\"totalMessages\":" << statistics.totalMessages;
+            stream << ",\"messagesPerSec\":" << messagesPerSec();
+            stream << ",\"mutexErr\":" << statistics.mutexErr;
+            stream << ",\"mutexWaitMaxUs\":" << statistics.mutexWaitMaxUs;
+            stream << ",\"deferred\":" << statistics.deferred;
+            stream << ",\"deferredFull\":" << statistics.deferredFull;
+            stream << ",\"mutexWaitAvgUs\":" << (statistics.totalMessages ? static_cast<uint32_t>(statistics.mutexWaitTotalUs / statistics.totalMessages) : 0);
 
-            // When updating configurations the mutex did not work, Not sure yet why this was
-            // So it's now hacked to not use a mutex
-            auto skipMutex = message.get_message_id() == 20;
-            if (skipMutex || (xSemaphoreTakeRecursive(xMutex, TASK_DELAY_MS(10)) == pdTRUE))
+            stream << ",\"messages\":{";
+            const char *sep = "";
+            for (uint8_t id = 0; id < MAX_MESSAGE_IDS; id++)
             {
-                statistics.totalMessages++;
-                etl::imessage_bus::receive(etl::imessage_router::ALL_MESSAGE_ROUTERS, message);
-                if (!skipMutex)
+                if (statistics.messages[id] || statistics.dropped[id])
                 {
-                    xSemaphoreGiveRecursive(xMutex);
+                    stream << sep << "\"" << static_cast<uint32_t>(id) << "\":{\"count\":" << statistics.messages[id] << ",\"dropped\":" << statistics.dropped[id] << "}";
+                    sep = ",";
                 }
             }
+            stream << "}";
+
+            stream << ",\"handlers\":{";
+            sep = "";
+            for (uint8_t i = 0; i < MAX_ROUTERS_; i++)
+            {
+                const auto &handler = statistics.handlers[i];
+                if (handler.router == nullptr)
+                {
+                    continue;
+                }
+                stream << sep << "\"";
+                auto owner = BaseModule::routerName(handler.router);
+                if (owner.empty())
+                {
+                    stream << "router" << static_cast<uint32_t>(i);
+                }
+                else
+                {
+                    stream << owner;
+                }
+                stream << "\":{\"calls\":" << handler.calls;
+                stream << ",\"minUs\":" << (handler.calls ? handler.minUs : 0);
+                stream << ",\"avgUs\":" << (handler.calls ? static_cast<uint32_t>(handler.totalUs / handler.calls) : 0);
+                stream << ",\"maxUs\":" << handler.maxUs << "}";
+                sep = ",";
+            }
+            stream << "}";
+            stream << "}\n";
+        }
+
+        //*******************************************
+        virtual void receive(const etl::imessage &message) override
+        {
+            publish(message);
         }
 
         //*******************************************
         virtual void receive(etl::shared_message shared_msg) override
         {
+            // The shared message is kept alive by shared_msg until dispatch returns
+            publish(shared_msg.get_message());
+        }
+
+    private:
+        static void deferredTask(void *arg)
+        {
+            ThreadSafeBus *bus = static_cast<ThreadSafeBus *>(arg);
+            DeferredPacket packet;
+            while (true)
+            {
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                while (bus->deferredRing.pop(packet))
+                {
+                    bus->dispatch(packet.get());
+                }
+            }
+        }
+
+        void publish(const etl::imessage &message)
+        {
+            auto id = message.get_message_id();
+            if (deferredTaskHandle == nullptr || laneOf(id) == Lane::IMMEDIATE)
+            {
+                dispatch(message);
+                return;
+            }
+
+            if (deferredRing.push(DeferredPacket{message}))
+            {
+                statistics.deferred++;
+                xTaskNotify(deferredTaskHandle, 1, eSetBits);
+            }
+            else
+            {
+                statistics.deferredFull++;
+                if (id < MAX_MESSAGE_IDS)
+                {
+                    statistics.dropped[id]++;
+                }
+            }
+        }
+
+        /**
+         * Deliver the message to the router at position in router_list
+         */
+        void deliver(size_t position, const etl::imessage &message)
+        {
+            uint64_t start = CoreUtils::usSinceBoot();
+            router_list[position]->receive(message);
+            uint32_t took = static_cast<uint32_t>(CoreUtils::usSinceBoot() - start);
+
+            // Not atomic, lock free deliveries of two tasks to the same router at the same time might lose a count
+            auto &handler = statistics.handlers[routerSlots[position]];
+            handler.calls++;
+            handler.totalUs += took;
+            handler.minUs = etl::min(handler.minUs, took);
+            handler.maxUs = etl::max(handler.maxUs, took);
+        }
+
+        void dispatch(const etl::imessage &message)
+        {
+            auto id = message.get_message_id();
+            statistics.totalMessages++;
+            if (id < MAX_MESSAGE_IDS)
+            {
+                statistics.messages[id]++;
+            }
+
+            // Lock free subscribers first, they only copy the frame into their own ring and return
+            // Subscriptions only change during start() and stop() of a module
+            bool lockFree = id == OpenAce::RadioRxFrame::ID;
+            if (lockFree)
+            {
+                auto keyedId = lockFreeRouterId(static_cast<const OpenAce::RadioRxFrame &>(message).dataSource);
+                bool locked = has_successor();
+                for (size_t position = 0; position < router_list.size(); position++)
+                {
+                    auto *router = router_list[position];
+                    auto routerId = router->get_message_router_id();
+                    if (router->accepts(id))
+                    {
+                        if (routerId == keyedId || routerId == LOCKFREE_ROUTER_ID)
+                        {
+                            deliver(position, message);
+                        }
+                        else if (!isLockFreeRouterId(routerId))
+                        {
+                            locked = true;
+                        }
+                    }
+                }
+
+                // Usually only decoders take frames, then the frame is delivered and the mutex is not needed
+                if (!locked)
+                {
+                    return;
+                }
+            }
 
-            /**
-             * Specify extra delay for configuration changes to ensure they are delivered
-             */
             // When updating configurations the mutex did not work, Not sure yet why this was
-            // So it's now hacked to not use a mutex
-            auto skipMutex = shared_msg.get_message().get_message_id() == 20;
-            if (skipMutex || (xSemaphoreTakeRecursive(xMutex, TASK_DELAY_MS(10)) == pdTRUE))
+            // So configuration updates are still delivered without taking the mutex
+            auto skipMutex = id == OpenAce::ConfigUpdatedMsg::ID;
+            // Each lane has it's own mutex, a handler of the deferred lane never blocks a publisher of the immediate lane
+            SemaphoreHandle_t mutex = laneOf(id) == Lane::DEFERRED ? xDeferredMutex : xMutex;
+            uint64_t waitStart = CoreUtils::usSinceBoot();
+            if (skipMutex || (xSemaphoreTakeRecursive(mutex, TASK_DELAY_MS(10)) == pdTRUE))
             {
-                statistics.totalMessages++;
-                etl::imessage_bus::receive(etl::imessage_router::ALL_MESSAGE_ROUTERS, shared_msg);
+                uint32_t waited = static_cast<uint32_t>(CoreUtils::usSinceBoot() - waitStart);
+                statistics.mutexWaitTotalUs += waited;
+                statistics.mutexWaitMaxUs = etl::max(statistics.mutexWaitMaxUs, waited);
+
+                for (size_t position = 0; position < router_list.size(); position++)
+                {
+                    auto *router = router_list[position];
+                    if (!(lockFree && isLockFreeRouterId(router->get_message_router_id())) && router->accepts(id))
+                    {
+                        deliver(position, message);
+                    }
+                }
+
+                if (has_successor())
+                {
+                    get_successor().receive(message);
+                }
+
                 if (!skipMutex)
                 {
-                    xSemaphoreGiveRecursive(xMutex);
+                    xSemaphoreGiveRecursive(mutex);
+                }
+            }
+            else
+            {
+                statistics.mutexErr++;
+                if (id < MAX_MESSAGE_IDS)
+                {
+                    statistics.dropped[id]++;
                 }
             }
         }
@@ -3,6 +3,7 @@
 #include "constants.hpp"
 #include "basemodule.hpp"
 #include "models.hpp"
+#include "radioframepool.hpp"
 
 #include "etl/message.h"
 #include "etl/message_router.h"
@@ -11,6 +12,7 @@
 #include "etl/string.h"
 #include "etl/set.h"
 #include "etl/array.h"
+#include "etl/utility.h"
 
 namespace OpenAce
 {
@@ -115,23 +117,27 @@ namespace OpenAce
     //     AircraftAddress address;
     // };
 
-    // struct CollisionWarning : public etl::message<11>
-    // {
-    //     AircraftAddress address;
-    //     AddressType addressType;
-    //     AircraftCategory aircraftType;
-    //     DataSource dataSource;
-    //     uint8_t alarmLevel;      // 0..3
-    //     uint8_t secondsToImpact; // 0..30
-    //     float relativeNorth;     // relative position
-    //     float relativeEast;
-    //     float relativeVertical; // relative Altitude above ownship in meter
-    //     float track;            // Track of aircraft
-    //     float turnRate;         // Turnrate of aircraft
-    //     float groundSpeed;      // Groundspeed of aircraft
-    //     float climbRate;        // Clibrate of aircraft
-    //     bool noTrack;           // Privacy option see dataport of explanation
-    // };
+    /**
+     * Collision warning for a single target, send by the CollisionDetector every second while a target is in conflict
+     * and once with alarmLevel 0 when the conflict is resolved
+     */
+    struct CollisionWarning : public etl::message<11>
+    {
+        AircraftAddress address;
+        AddressType addressType;
+        AircraftCategory aircraftType;
+        DataSource dataSource;
+        uint8_t alarmLevel;      // 0..3
+        uint8_t secondsToImpact; // 0..30
+        float relativeNorth;     // relative position
+        float relativeEast;
+        float relativeVertical; // relative Altitude above ownship in meter
+        float track;            // Track of aircraft
+        float turnRate;         // Turnrate of aircraft
+        float groundSpeed;      // Groundspeed of aircraft
+        float climbRate;        // Clibrate of aircraft
+        bool noTrack;           // Privacy option see dataport of explanation
+    };
 
     struct GpsTime : public etl::message<12>
     {
@@ -196,26 +202,30 @@ namespace OpenAce
         BarometricPressure() : pressurehPa(0), msSinceBoot(0) {};
     };
 
+    /**
+     * A received radio frame. The frame data lives in the RadioFramePool and is shared by reference,
+     * so copying this message does not copy the frame.
+     */
     struct RadioRxFrame : public etl::message<16>
     {
-        uint32_t frame[OpenAce::RADIO_MAX_FRAME_WORD_LENGTH];
-        uint32_t err[OpenAce::RADIO_MAX_FRAME_WORD_LENGTH];
+        RadioFrameRef buffer;
         uint32_t epochSeconds;
         uint8_t length; // TODO: CHange this to length in words
         int8_t rssidBm;
         uint32_t frequency;
         OpenAce::DataSource dataSource;
-        RadioRxFrame(uint8_t length_, uint32_t epochSeconds_, int8_t rssidBm_, uint32_t frequency_, OpenAce::DataSource dataSource_) : epochSeconds(epochSeconds_), length(length_), rssidBm(rssidBm_), frequency(frequency_), dataSource(dataSource_)
+        RadioRxFrame(RadioFrameRef &&buffer_, uint8_t length_, uint32_t epochSeconds_, int8_t rssidBm_, uint32_t frequency_, OpenAce::DataSource dataSource_) : buffer(etl::move(buffer_)), epochSeconds(epochSeconds_), length(length_), rssidBm(rssidBm_), frequency(frequency_), dataSource(dataSource_) {};
+        RadioRxFrame() : buffer(), epochSeconds(0), length(0), rssidBm(0), frequency(0), dataSource(OpenAce::DataSource::NONE) {};
+
+        uint32_t *frame() const
         {
-            // TODO: Decide if we need to do this
-            memset(frame, 0, sizeof(frame));
-            memset(err, 0, sizeof(frame));
-        };
-        RadioRxFrame() : epochSeconds(0), length(0), rssidBm(0), frequency(0), dataSource(OpenAce::DataSource::NONE)
+            return buffer.frame();
+        }
+
+        uint32_t *err() const
         {
-            memset(frame, 0, sizeof(frame));
-            memset(err, 0, sizeof(frame));
-        };
+            return buffer.err();
+        }
     };
 
     struct RadioTxPositionRequest : public etl::message<2>
@@ -232,6 +242,19 @@ namespace OpenAce
         RadioTxFrame(const Radio::TxPacket &txPacket_, uint8_t radioNo_) : txPacket(txPacket_), radioNo(radioNo_) {}
     };
 
+    /**
+     * Send by the radio when a transmission is done, used to keep track of the airtime of each channel
+     */
+    struct RadioTxDoneMsg : public etl::message<24>
+    {
+        OpenAce::DataSource dataSource;
+        uint32_t frequency;
+        uint32_t airtimeUs;   // Time from the start of the transmission until TX_DONE, or until the TX timeout
+        uint32_t msSinceBoot; // Time the transmission was done
+        uint8_t radioNo;
+        RadioTxDoneMsg(OpenAce::DataSource dataSource_, uint32_t frequency_, uint32_t airtimeUs_, uint32_t msSinceBoot_, uint8_t radioNo_) : dataSource(dataSource_), frequency(frequency_), airtimeUs(airtimeUs_), msSinceBoot(msSinceBoot_), radioNo(radioNo_) {}
+    };
+
     struct ConfigUpdatedMsg : public etl::message<20> /* Don't change from 20!!!! They are used in MessageRouter*/
     {
         const Configuration &config;
@@ -0,0 +1,124 @@
+#pragma once
+
+/* System. */
+#include <stdint.h>
+#include <stddef.h>
+
+/* Vendor. */
+#include "etl/array.h"
+#include "etl/atomic.h"
+#include "etl/utility.h"
+
+namespace OpenAce
+{
+
+    /**
+     * Bounded lock free multi producer, single consumer ring.
+     * Each cell carries a sequence number so producers can claim a slot with a single CAS on the head
+     * and publish it by bumping the cell sequence. The consumer never blocks a producer and a producer
+     * never blocks another producer, a full ring simply returns false so the caller can count the drop.
+     *
+     * Based on the bounded MPMC queue from Dmitry Vyukov, reduced to a single consumer.
+     * With a single producer it behaves as an SPSC ring, the CAS will then never fail.
+     */
+    template <typename T, size_t SIZE>
+    class MpscRing
+    {
+        static_assert(SIZE >= 2 && (SIZE & (SIZE - 1)) == 0, "MpscRing SIZE must be a power of 2");
+        static constexpr uint32_t MASK = SIZE - 1;
+
+        struct Cell
+        {
+            etl::atomic<uint32_t> sequence;
+            T data;
+        };
+
+        etl::array<Cell, SIZE> cells;
+        etl::atomic<uint32_t> head; // Written by producers
+        uint32_t tail;              // Only touched by the consumer
+
+    public:
+        MpscRing() : head(0), tail(0)
+        {
+            for (uint32_t i = 0; i < SIZE; i++)
+            {
+                cells[i].sequence.store(i, etl::memory_order_relaxed);
+            }
+        }
+
+        MpscRing(const MpscRing &) = delete;
+        MpscRing &operator=(const MpscRing &) = delete;
+
+        /**
+         * Push an item from any task, returns false when the ring is full
+         */
+        bool push(const T &item)
+        {
+            Cell *cell;
+            uint32_t pos = head.load(etl::memory_order_relaxed);
+            while (true)
+            {
+                cell = &cells[pos & MASK];
+                uint32_t sequence = cell->sequence.load(etl::memory_order_acquire);
+                int32_t diff = static_cast<int32_t>(sequence - pos);
+                if (diff == 0)
+                {
+                    if (head.compare_exchange_weak(pos, pos + 1, etl::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = head.load(etl::memory_order_relaxed);
+                }
+            }
+
+            cell->data = item;
+            cell->sequence.store(pos + 1, etl::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Pop an item, only call this from the owning (consumer) task
+         */
+        bool pop(T &item)
+        {
+            Cell &cell = cells[tail & MASK];
+            uint32_t sequence = cell.sequence.load(etl::memory_order_acquire);
+            if (static_cast<int32_t>(sequence - (tail + 1)) < 0)
+            {
+                return false;
+            }
+
+            // Move so the cell does not keep a reference to shared data around
+            item = etl::move(cell.data);
+            cell.sequence.store(tail + SIZE, etl::memory_order_release);
+            tail++;
+            return true;
+        }
+
+        /**
+         * Number of items in the ring, only accurate when called from the consumer
+         */
+        size_t size() const
+        {
+            return head.load(etl::memory_order_relaxed) - tail;
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        static constexpr size_t capacity()
+        {
+            return SIZE;
+        }
+    };
+
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+/* System. */
+#include <stdint.h>
+#include <stddef.h>
+
+/* Vendor. */
+#include "etl/array.h"
+#include "etl/atomic.h"
+
+/* OpenACE. */
+#include "constants.hpp"
+
+namespace OpenAce
+{
+
+    /**
+     * Storage for the decoded data of one received radio frame.
+     * A buffer is free when it's refCount is 0
+     */
+    struct RadioFrameBuffer
+    {
+        uint32_t frame[OpenAce::RADIO_MAX_FRAME_WORD_LENGTH];
+        uint32_t err[OpenAce::RADIO_MAX_FRAME_WORD_LENGTH];
+        etl::atomic<uint8_t> refCount{0};
+    };
+
+    /**
+     * Reference counted handle to a RadioFrameBuffer.
+     * Copying the handle shares the buffer, the buffer is returned to the pool when the last handle is gone.
+     */
+    class RadioFrameRef
+    {
+        RadioFrameBuffer *buffer;
+
+    public:
+        RadioFrameRef() : buffer(nullptr) {}
+
+        // Takes over the count already held on the buffer
+        explicit RadioFrameRef(RadioFrameBuffer *buffer_) : buffer(buffer_) {}
+
+        RadioFrameRef(const RadioFrameRef &other) : buffer(other.buffer)
+        {
+            if (buffer != nullptr)
+            {
+                buffer->refCount.fetch_add(1, etl::memory_order_relaxed);
+            }
+        }
+
+        RadioFrameRef(RadioFrameRef &&other) : buffer(other.buffer)
+        {
+            other.buffer = nullptr;
+        }
+
+        RadioFrameRef &operator=(const RadioFrameRef &other)
+        {
+            if (buffer != other.buffer)
+            {
+                release();
+                buffer = other.buffer;
+                if (buffer != nullptr)
+                {
+                    buffer->refCount.fetch_add(1, etl::memory_order_relaxed);
+                }
+            }
+            return *this;
+        }
+
+        RadioFrameRef &operator=(RadioFrameRef &&other)
+        {
+            if (this != &other)
+            {
+                release();
+                buffer = other.buffer;
+                other.buffer = nullptr;
+            }
+            return *this;
+        }
+
+        ~RadioFrameRef()
+        {
+            release();
+        }
+
+        void release()
+        {
+            if (buffer != nullptr)
+            {
+                buffer->refCount.fetch_sub(1, etl::memory_order_acq_rel);
+                buffer = nullptr;
+            }
+        }
+
+        bool valid() const
+        {
+            return buffer != nullptr;
+        }
+
+        uint32_t *frame() const
+        {
+            return buffer->frame;
+        }
+
+        uint32_t *err() const
+        {
+            return buffer->err;
+        }
+    };
+
+    /**
+     * Fixed size pool of radio frame buffers shared by all radios.
+     * The radio writes a frame once into a buffer and the decoder reads it in place, only a small
+     * handle travels over the bus and through the decoder rings.
+     */
+    class RadioFramePool
+    {
+    public:
+        // 3 decoders with a ring of 4 frames each, plus the frames in flight from two radios
+        static constexpr size_t POOL_SIZE = 16;
+
+    private:
+        inline static etl::array<RadioFrameBuffer, POOL_SIZE> buffers;
+        inline static uint32_t exhaustedCount = 0;
+
+    public:
+        /**
+         * Get a free buffer, returns an invalid handle when all buffers are in use.
+         * The content of the buffer is not cleared
+         */
+        static RadioFrameRef acquire()
+        {
+            for (auto &buffer : buffers)
+            {
+                uint8_t expected = 0;
+                if (buffer.refCount.compare_exchange_strong(expected, 1, etl::memory_order_acquire))
+                {
+                    return RadioFrameRef{&buffer};
+                }
+            }
+            exhaustedCount++;
+            return RadioFrameRef{};
+        }
+
+        /**
+         * Number of free buffers, for statistics only
+         */
+        static size_t available()
+        {
+            size_t count = 0;
+            for (const auto &buffer : buffers)
+            {
+                count += buffer.refCount.load(etl::memory_order_relaxed) == 0;
+            }
+            return count;
+        }
+
+        /**
+         * Number of times acquire() could not find a free buffer
+         */
+        static uint32_t exhausted()
+        {
+            return exhaustedCount;
+        }
+    };
+
+}
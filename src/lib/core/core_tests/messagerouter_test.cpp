@@ -0,0 +1,285 @@
+#include <catch2/catch_test_macros.hpp>
+
+#define private public
+
+#include "pico/time.h"
+#include "queue.h"
+#include "messagerouter.hpp"
+#include "mockconfig.h"
+
+class Subscriber : public etl::message_router<Subscriber, OpenAce::BarometricPressure, OpenAce::RadioRxFrame>
+{
+public:
+    uint32_t pressures = 0;
+    uint32_t frames = 0;
+    Subscriber() = default;
+    Subscriber(etl::message_router_id_t id) : message_router(id) {}
+
+    void on_receive(const OpenAce::BarometricPressure &msg)
+    {
+        (void)msg;
+        time_us_64Value += 25;
+        pressures++;
+    }
+    void on_receive(const OpenAce::RadioRxFrame &msg)
+    {
+        (void)msg;
+        frames++;
+    }
+    void on_receive_unknown(const etl::imessage &msg)
+    {
+        (void)msg;
+    }
+};
+
+TEST_CASE("ThreadSafeBus counts messages per id", "[single-file]")
+{
+    OpenAce::ThreadSafeBus<4> bus;
+    Subscriber subscriber;
+    bus.subscribe(subscriber);
+
+    bus.receive(OpenAce::BarometricPressure{1013.f, 0});
+    bus.receive(OpenAce::BarometricPressure{1013.f, 0});
+    bus.receive(OpenAce::RadioRxFrame{});
+
+    REQUIRE(subscriber.pressures == 2);
+    REQUIRE(subscriber.frames == 1);
+    REQUIRE(bus.statistics.totalMessages == 3);
+    REQUIRE(bus.statistics.messages[OpenAce::BarometricPressure::ID] == 2);
+    REQUIRE(bus.statistics.messages[OpenAce::RadioRxFrame::ID] == 1);
+}
+
+TEST_CASE("ThreadSafeBus handler timing", "[single-file]")
+{
+    OpenAce::ThreadSafeBus<4> bus;
+    Subscriber subscriber;
+    bus.subscribe(subscriber);
+
+    bus.receive(OpenAce::BarometricPressure{1013.f, 0});
+    bus.receive(OpenAce::RadioRxFrame{});
+
+    const auto &handler = bus.statistics.handlers[0];
+    REQUIRE(handler.router == &subscriber);
+    REQUIRE(handler.calls == 2);
+    REQUIRE(handler.minUs == 0);
+    REQUIRE(handler.maxUs == 25);
+    REQUIRE(handler.totalUs == 25);
+}
+
+TEST_CASE("ThreadSafeBus gives each subscriber a handler slot", "[single-file]")
+{
+    OpenAce::ThreadSafeBus<4> bus;
+    Subscriber first{20};
+    Subscriber second{10};
+    Subscriber third{5};
+    // Routers are kept ordered on their id, the slots in the order they subscribed
+    bus.subscribe(first);
+    bus.subscribe(second);
+    REQUIRE(bus.router_list[0] == &second);
+    REQUIRE(bus.statistics.handlers[0].router == &first);
+    REQUIRE(bus.statistics.handlers[1].router == &second);
+
+    bus.receive(OpenAce::BarometricPressure{1013.f, 0});
+    REQUIRE(bus.statistics.handlers[0].calls == 1);
+    REQUIRE(bus.statistics.handlers[1].calls == 1);
+
+    // A free slot is reused by the next subscriber
+    bus.unsubscribe(second);
+    REQUIRE(bus.statistics.handlers[1].router == nullptr);
+    bus.subscribe(third);
+    REQUIRE(bus.statistics.handlers[1].router == &third);
+
+    bus.receive(OpenAce::BarometricPressure{1013.f, 0});
+    REQUIRE(first.pressures == 2);
+    REQUIRE(third.pressures == 1);
+    REQUIRE(bus.statistics.handlers[0].calls == 2);
+    REQUIRE(bus.statistics.handlers[1].calls == 1);
+}
+
+TEST_CASE("ThreadSafeBus counts dropped messages", "[single-file]")
+{
+    OpenAce::ThreadSafeBus<4> bus;
+    Subscriber subscriber;
+    bus.subscribe(subscriber);
+
+    xQueueTakeMutexRecursiveReturn = pdFALSE;
+    bus.receive(OpenAce::BarometricPressure{1013.f, 0});
+    bus.receive(OpenAce::RadioRxFrame{});
+    xQueueTakeMutexRecursiveReturn = pdTRUE;
+
+    REQUIRE(subscriber.frames == 0);
+    REQUIRE(subscriber.pressures == 0);
+    REQUIRE(bus.dropped(OpenAce::BarometricPressure::ID) == 1);
+    REQUIRE(bus.dropped(OpenAce::RadioRxFrame::ID) == 1);
+    REQUIRE(bus.statistics.mutexErr == 2);
+}
+
+TEST_CASE("ThreadSafeBus delivers frames to lock free subscribers without the mutex", "[single-file]")
+{
+    OpenAce::ThreadSafeBus<4> bus;
+    Subscriber lockFree{OpenAce::LOCKFREE_ROUTER_ID};
+    Subscriber flarm{OpenAce::lockFreeRouterId(OpenAce::DataSource::FLARM)};
+    bus.subscribe(lockFree);
+    bus.subscribe(flarm);
+
+    // The mutex is not taken, so it can not time out
+    xQueueTakeMutexRecursiveReturn = pdFALSE;
+    OpenAce::RadioRxFrame frame;
+    frame.dataSource = OpenAce::DataSource::OGN1;
+    bus.receive(frame);
+    xQueueTakeMutexRecursiveReturn = pdTRUE;
+
+    REQUIRE(lockFree.frames == 1);
+    REQUIRE(flarm.frames == 0);
+    REQUIRE(bus.dropped(OpenAce::RadioRxFrame::ID) == 0);
+    REQUIRE(bus.statistics.mutexErr == 0);
+    REQUIRE(bus.statistics.messages[OpenAce::RadioRxFrame::ID] == 1);
+}
+
+TEST_CASE("ThreadSafeBus names subscribers after their module", "[single-file]")
+{
+    OpenAce::ThreadSafeBus<4> bus;
+    MockConfig config{bus};
+    Subscriber subscriber;
+    Subscriber anonymous;
+    config.subscribe(subscriber);
+    bus.subscribe(anonymous);
+
+    bus.receive(OpenAce::BarometricPressure{1013.f, 0});
+
+    etl::string<512> data;
+    etl::string_stream stream(data);
+    bus.getData(stream);
+    REQUIRE(data.find("\"_Configuration\":{\"calls\":1") != etl::string<512>::npos);
+    REQUIRE(data.find("\"router1\":{\"calls\":1") != etl::string<512>::npos);
+
+    config.unsubscribe(subscriber);
+    REQUIRE(BaseModule::routerName(&subscriber).empty());
+}
+
+TEST_CASE("ThreadSafeBus messagesPerSec", "[single-file]")
+{
+    OpenAce::ThreadSafeBus<4> bus;
+    get_absolute_timeValue = 0;
+    REQUIRE(bus.messagesPerSec() == 0);
+
+    for (int i = 0; i < 50; i++)
+    {
+        bus.receive(OpenAce::BarometricPressure{1013.f, 0});
+    }
+    get_absolute_timeValue = 500'000;
+    REQUIRE(bus.messagesPerSec() == 100);
+
+    get_absolute_timeValue = 1'500'000;
+    REQUIRE(bus.messagesPerSec() == 0);
+}
+
+class GpsStatsSubscriber : public etl::message_router<GpsStatsSubscriber, OpenAce::GpsStatsMsg>
+{
+public:
+    uint32_t received = 0;
+    void on_receive(const OpenAce::GpsStatsMsg &msg)
+    {
+        (void)msg;
+        received++;
+    }
+    void on_receive_unknown(const etl::imessage &msg)
+    {
+        (void)msg;
+    }
+};
+
+TEST_CASE("ThreadSafeBus lanes", "[single-file]")
+{
+    REQUIRE(OpenAce::laneOf(OpenAce::RadioRxFrame::ID) == OpenAce::Lane::IMMEDIATE);
+    REQUIRE(OpenAce::laneOf(OpenAce::AircraftPositionMsg::ID) == OpenAce::Lane::IMMEDIATE);
+    REQUIRE(OpenAce::laneOf(OpenAce::OwnshipPositionMsg::ID) == OpenAce::Lane::IMMEDIATE);
+    REQUIRE(OpenAce::laneOf(OpenAce::GDLMsg::ID) == OpenAce::Lane::DEFERRED);
+    REQUIRE(OpenAce::laneOf(OpenAce::GpsStatsMsg::ID) == OpenAce::Lane::DEFERRED);
+    REQUIRE(OpenAce::laneOf(OpenAce::ConfigUpdatedMsg::ID) == OpenAce::Lane::DEFERRED);
+}
+
+TEST_CASE("ThreadSafeBus deferred lane", "[single-file]")
+{
+    OpenAce::ThreadSafeBus<4> bus;
+    GpsStatsSubscriber subscriber;
+    bus.subscribe(subscriber);
+
+    // Without a running bus task deferred messages are delivered right away
+    bus.receive(OpenAce::GpsStatsMsg{});
+    REQUIRE(subscriber.received == 1);
+
+    // Pretend the bus task is running
+    int dummy;
+    bus.deferredTaskHandle = reinterpret_cast<TaskHandle_t>(&dummy);
+    for (size_t i = 0; i < bus.DEFERRED_QUEUE_SIZE + 2; i++)
+    {
+        bus.receive(OpenAce::GpsStatsMsg{});
+    }
+    REQUIRE(subscriber.received == 1);
+    REQUIRE(bus.statistics.deferred == bus.DEFERRED_QUEUE_SIZE);
+    REQUIRE(bus.statistics.deferredFull == 2);
+    REQUIRE(bus.dropped(OpenAce::GpsStatsMsg::ID) == 2);
+
+    OpenAce::DeferredPacket packet;
+    while (bus.deferredRing.pop(packet))
+    {
+        bus.dispatch(packet.get());
+    }
+    REQUIRE(subscriber.received == 1 + bus.DEFERRED_QUEUE_SIZE);
+}
+
+TEST_CASE("ThreadSafeBus lanes have their own mutex", "[single-file]")
+{
+    OpenAce::ThreadSafeBus<4> bus;
+    GpsStatsSubscriber gpsStats;
+    Subscriber subscriber;
+    bus.subscribe(gpsStats);
+    bus.subscribe(subscriber);
+    REQUIRE(bus.xMutex != bus.xDeferredMutex);
+
+    // A slow GDL or config handler holds the deferred lane, immediate messages are still delivered
+    xQueueTakeMutexRecursiveBusy = static_cast<QueueHandle_t>(bus.xDeferredMutex);
+    bus.receive(OpenAce::BarometricPressure{1013.f, 0});
+    bus.receive(OpenAce::GpsStatsMsg{});
+    REQUIRE(subscriber.pressures == 1);
+    REQUIRE(gpsStats.received == 0);
+    REQUIRE(bus.dropped(OpenAce::GpsStatsMsg::ID) == 1);
+
+    // And the other way around
+    xQueueTakeMutexRecursiveBusy = static_cast<QueueHandle_t>(bus.xMutex);
+    bus.receive(OpenAce::BarometricPressure{1013.f, 0});
+    bus.receive(OpenAce::GpsStatsMsg{});
+    xQueueTakeMutexRecursiveBusy = nullptr;
+    REQUIRE(subscriber.pressures == 1);
+    REQUIRE(gpsStats.received == 1);
+    REQUIRE(bus.dropped(OpenAce::BarometricPressure::ID) == 1);
+}
+
+TEST_CASE("ThreadSafeBus keyed RadioRxFrame dispatch", "[single-file]")
+{
+    OpenAce::ThreadSafeBus<4> bus;
+    Subscriber flarm{OpenAce::lockFreeRouterId(OpenAce::DataSource::FLARM)};
+    Subscriber ogn{OpenAce::lockFreeRouterId(OpenAce::DataSource::OGN1)};
+    Subscriber all{OpenAce::LOCKFREE_ROUTER_ID};
+    bus.subscribe(flarm);
+    bus.subscribe(ogn);
+    bus.subscribe(all);
+
+    OpenAce::RadioRxFrame frame;
+    frame.dataSource = OpenAce::DataSource::FLARM;
+    bus.receive(frame);
+    bus.receive(frame);
+    frame.dataSource = OpenAce::DataSource::OGN1;
+    bus.receive(frame);
+
+    REQUIRE(flarm.frames == 2);
+    REQUIRE(ogn.frames == 1);
+    REQUIRE(all.frames == 3);
+
+    // Other messages are still delivered to all keyed subscribers
+    bus.receive(OpenAce::BarometricPressure{1013.f, 0});
+    REQUIRE(flarm.pressures == 1);
+    REQUIRE(ogn.pressures == 1);
+    REQUIRE(all.pressures == 1);
+}
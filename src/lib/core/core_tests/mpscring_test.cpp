@@ -0,0 +1,56 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "mpscring.hpp"
+
+TEST_CASE("MpscRing push and pop in order", "[single-file]")
+{
+    OpenAce::MpscRing<uint32_t, 4> ring;
+    REQUIRE(ring.empty());
+
+    REQUIRE(ring.push(1));
+    REQUIRE(ring.push(2));
+    REQUIRE(ring.push(3));
+    REQUIRE(ring.size() == 3);
+
+    uint32_t value = 0;
+    REQUIRE(ring.pop(value));
+    REQUIRE(value == 1);
+    REQUIRE(ring.pop(value));
+    REQUIRE(value == 2);
+    REQUIRE(ring.pop(value));
+    REQUIRE(value == 3);
+    REQUIRE(!ring.pop(value));
+    REQUIRE(ring.empty());
+}
+
+TEST_CASE("MpscRing drops when full", "[single-file]")
+{
+    OpenAce::MpscRing<uint32_t, 4> ring;
+    for (uint32_t i = 0; i < ring.capacity(); i++)
+    {
+        REQUIRE(ring.push(i));
+    }
+    REQUIRE(!ring.push(99));
+    REQUIRE(ring.size() == 4);
+
+    uint32_t value = 0;
+    REQUIRE(ring.pop(value));
+    REQUIRE(value == 0);
+    REQUIRE(ring.push(99));
+}
+
+TEST_CASE("MpscRing wraps around", "[single-file]")
+{
+    OpenAce::MpscRing<uint32_t, 4> ring;
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        REQUIRE(ring.push(i));
+        REQUIRE(ring.push(i + 1));
+        REQUIRE(ring.pop(value));
+        REQUIRE(value == i);
+        REQUIRE(ring.pop(value));
+        REQUIRE(value == i + 1);
+    }
+    REQUIRE(ring.empty());
+}
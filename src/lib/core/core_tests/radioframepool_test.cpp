@@ -0,0 +1,61 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "messages.hpp"
+#include "radioframepool.hpp"
+
+using OpenAce::RadioFramePool;
+
+TEST_CASE("RadioFramePool returns buffers when the last handle is gone", "[single-file]")
+{
+    REQUIRE(RadioFramePool::available() == RadioFramePool::POOL_SIZE);
+    {
+        auto buffer = RadioFramePool::acquire();
+        REQUIRE(buffer.valid());
+        REQUIRE(RadioFramePool::available() == RadioFramePool::POOL_SIZE - 1);
+
+        buffer.frame()[0] = 0x12345678;
+        OpenAce::RadioRxFrame frame{etl::move(buffer), 26, 0, -80, 868'200'000, OpenAce::DataSource::FLARM};
+        REQUIRE(!buffer.valid());
+
+        // Copies share the same data
+        OpenAce::RadioRxFrame copy = frame;
+        REQUIRE(copy.frame() == frame.frame());
+        REQUIRE(copy.frame()[0] == 0x12345678);
+        REQUIRE(RadioFramePool::available() == RadioFramePool::POOL_SIZE - 1);
+    }
+    REQUIRE(RadioFramePool::available() == RadioFramePool::POOL_SIZE);
+}
+
+TEST_CASE("RadioFramePool exhausted", "[single-file]")
+{
+    etl::vector<OpenAce::RadioFrameRef, RadioFramePool::POOL_SIZE> refs;
+    for (size_t i = 0; i < RadioFramePool::POOL_SIZE; i++)
+    {
+        refs.push_back(RadioFramePool::acquire());
+        REQUIRE(refs.back().valid());
+    }
+
+    auto exhausted = RadioFramePool::exhausted();
+    REQUIRE(!RadioFramePool::acquire().valid());
+    REQUIRE(RadioFramePool::exhausted() == exhausted + 1);
+
+    refs.pop_back();
+    REQUIRE(RadioFramePool::acquire().valid());
+    refs.clear();
+    REQUIRE(RadioFramePool::available() == RadioFramePool::POOL_SIZE);
+}
+
+TEST_CASE("RadioFrameRef assignment", "[single-file]")
+{
+    auto a = RadioFramePool::acquire();
+    auto b = RadioFramePool::acquire();
+    REQUIRE(RadioFramePool::available() == RadioFramePool::POOL_SIZE - 2);
+
+    b = a;
+    REQUIRE(b.frame() == a.frame());
+    REQUIRE(RadioFramePool::available() == RadioFramePool::POOL_SIZE - 1);
+
+    a.release();
+    b.release();
+    REQUIRE(RadioFramePool::available() == RadioFramePool::POOL_SIZE);
+}
@@ -39,13 +39,13 @@ void Dump1090Client::stop()
 {
     // xTimerDelete(timerHandle, TASK_DELAY_MS(250));
     tcpClient.stop();
-    getBus().unsubscribe(*this);
+    unsubscribe(*this);
 };
 
 void Dump1090Client::start()
 {
     xTaskCreate(dump1090Task, "Bmp280Task", configMINIMAL_STACK_SIZE + 128, this, tskIDLE_PRIORITY, &taskHandle);
-    getBus().subscribe(*this);
+    subscribe(*this);
 };
 
 void Dump1090Client::dump1090Task(void *arg)
@@ -0,0 +1,385 @@
+
+#include <stdio.h>
+#include <math.h>
+
+#include "fanet.hpp"
+
+OpenAce::PostConstruct Fanet::postConstruct()
+{
+    return OpenAce::PostConstruct::OK;
+}
+
+void Fanet::start()
+{
+    xTaskCreate(fanetReceiveTask, "fanetReceiveTask", configMINIMAL_STACK_SIZE + 256, this, tskIDLE_PRIORITY, &taskHandle);
+    subscribe(*this);
+};
+
+void Fanet::stop()
+{
+    unsubscribe(*this);
+    vTaskDelete(taskHandle);
+};
+
+void Fanet::getData(etl::string_stream &stream, const etl::string_view path) const
+{
+    (void)path;
+    stream << "{";
+    stream << "\"receivedAircraftPositions\":" << statistics.receivedAircraftPositions;
+    stream << ",\"transmittedAircraftPositions\":" << statistics.transmittedAircraftPositions;
+    stream << ",\"invalidFrames\":" << statistics.invalidFrames;
+    stream << ",\"outOfDistance\":" << statistics.outOfDistance;
+    stream << ",\"queueFullErr\":" << statistics.queueFullErr;
+    stream << ",\"forwarded\":" << statistics.forwarded;
+    stream << ",\"messageType\":[";
+    for (size_t i = 0; i < statistics.messageType.size(); i++)
+    {
+        stream << (i == 0 ? "" : ",") << statistics.messageType[i];
+    }
+    stream << "]";
+    stream << "}\n";
+}
+
+void Fanet::on_receive(const OpenAce::RadioRxFrame &msg)
+{
+    if (frameRing.push(msg))
+    {
+        xTaskNotify(taskHandle, 1, eSetBits);
+    }
+    else
+    {
+        statistics.queueFullErr++;
+    }
+}
+
+void Fanet::on_receive(const OpenAce::OwnshipPositionMsg &msg)
+{
+    ownshipPosition = msg.position;
+}
+
+void Fanet::on_receive(const OpenAce::ConfigUpdatedMsg &msg)
+{
+    if (msg.moduleName == "config")
+    {
+        openAceConfiguration = msg.config.openAceConfig();
+    }
+}
+
+void Fanet::on_receive(const OpenAce::RadioTxPositionRequest &msg)
+{
+    if (msg.radioParameters.config.dataSource != OpenAce::DataSource::FANET)
+    {
+        return;
+    }
+
+    // Tracking messages are for airborne aircraft only, ground tracking (type 7) is not send
+    if (!ownshipPosition.airborne)
+    {
+        return;
+    }
+
+    // The tuner requests a position every second, keep within the duty cycle
+    auto msSinceBoot = CoreUtils::msSinceBoot();
+    if (statistics.transmittedAircraftPositions != 0 && CoreUtils::msElapsed(lastTxMs, msSinceBoot) < TX_INTERVAL_MS)
+    {
+        return;
+    }
+    lastTxMs = msSinceBoot;
+
+    Tracking tracking{
+        ownshipPosition.lat,
+        ownshipPosition.lon,
+        ownshipPosition.altitudeWgs84,
+        mapAircraftCategory(openAceConfiguration.category),
+        !openAceConfiguration.stealth,
+        ownshipPosition.groundSpeed,
+        ownshipPosition.verticalSpeed,
+        ownshipPosition.course,
+        ownshipPosition.hTurnRate};
+
+    uint8_t frame[OpenAce::RADIO_MAX_FRAME_LENGTH];
+    uint8_t length = encodeTracking(frame, MANUFACTURER_UNREGISTERED, openAceConfiguration.address & 0xFFFF, tracking);
+
+    getBus().receive(OpenAce::RadioTxFrame{
+        Radio::TxPacket{
+            msg.radioParameters,
+            length,
+            (const void *)frame},
+        msg.radioNo});
+    statistics.transmittedAircraftPositions++;
+}
+
+bool Fanet::decodeHeader(const uint8_t *frame, uint8_t length, Header &header)
+{
+    if (length < HEADER_LENGTH)
+    {
+        return false;
+    }
+
+    // 7 extended header, 6 forward, 5..0 type
+    header.type = static_cast<MessageType>(frame[0] & 0x3F);
+    header.forward = frame[0] & 0x40;
+    header.manufacturer = frame[1];
+    header.id = frame[2] | (frame[3] << 8);
+    header.payloadOffset = HEADER_LENGTH;
+
+    if (frame[0] & 0x80)
+    {
+        if (length <= HEADER_LENGTH)
+        {
+            return false;
+        }
+        // 7..6 ack, 5 unicast, 4 signature
+        uint8_t extendedHeader = frame[HEADER_LENGTH];
+        header.payloadOffset++;
+        if (extendedHeader & 0x20)
+        {
+            header.payloadOffset += 3; // Destination manufacturer and id
+        }
+        if (extendedHeader & 0x10)
+        {
+            header.payloadOffset += 4; // Signature
+        }
+    }
+
+    return header.payloadOffset <= length;
+}
+
+bool Fanet::decodeTracking(const uint8_t *payload, uint8_t length, Tracking &tracking)
+{
+    if (length < TRACKING_LENGTH)
+    {
+        return false;
+    }
+
+    // 24 bit two's complement little endian
+    int32_t lat = payload[0] | (payload[1] << 8) | (payload[2] << 16);
+    int32_t lon = payload[3] | (payload[4] << 8) | (payload[5] << 16);
+    lat -= (lat & 0x800000) ? 0x1000000 : 0;
+    lon -= (lon & 0x800000) ? 0x1000000 : 0;
+    tracking.lat = lat / LATITUDE_SCALE;
+    tracking.lon = lon / LONGITUDE_SCALE;
+
+    // 15 online tracking, 14..12 aircraft type, 11 altitude scale x4, 10..0 altitude in m
+    uint16_t type = payload[6] | (payload[7] << 8);
+    tracking.onlineTracking = type & 0x8000;
+    tracking.aircraftType = static_cast<AircraftType>((type >> 12) & 0x07);
+    tracking.altitude = (type & 0x07FF) * ((type & 0x0800) ? 4 : 1);
+
+    // 7 scale x5, 6..0 in 0.5km/h
+    tracking.groundSpeed = (payload[8] & 0x7F) * ((payload[8] & 0x80) ? 5 : 1) * 0.5f * KPH_TO_MS;
+
+    // 7 scale x5, 6..0 7 bit two's complement in 0.1m/s
+    int8_t climb = (payload[9] & 0x7F) - ((payload[9] & 0x40) ? 0x80 : 0);
+    tracking.verticalSpeed = climb * ((payload[9] & 0x80) ? 5 : 1) * 0.1f;
+
+    tracking.course = payload[10] * 360.f / 256.f;
+
+    // 7 scale x4, 6..0 7 bit two's complement in 0.25deg/s
+    if (length >= TRACKING_TURNRATE_LENGTH)
+    {
+        int8_t turnRate = (payload[11] & 0x7F) - ((payload[11] & 0x40) ? 0x80 : 0);
+        tracking.hTurnRate = turnRate * ((payload[11] & 0x80) ? 4 : 1) * 0.25f;
+    }
+    else
+    {
+        tracking.hTurnRate = 0.f;
+    }
+
+    return true;
+}
+
+/**
+ * Scale a signed value in 7 bits, with the 8th bit set when it was divided by scale
+ */
+static uint8_t scaledSigned7(int32_t value, int32_t scale)
+{
+    if (value >= -64 && value <= 63)
+    {
+        return value & 0x7F;
+    }
+    value = std::max((int32_t)-64, std::min((int32_t)lroundf(value / (float)scale), (int32_t)63));
+    return 0x80 | (value & 0x7F);
+}
+
+uint8_t Fanet::encodeTracking(uint8_t *frame, uint8_t manufacturer, uint16_t id, const Tracking &tracking)
+{
+    frame[0] = static_cast<uint8_t>(MessageType::TRACKING);
+    frame[1] = manufacturer;
+    frame[2] = id & 0xFF;
+    frame[3] = id >> 8;
+
+    uint8_t *payload = frame + HEADER_LENGTH;
+    int32_t lat = lroundf(tracking.lat * LATITUDE_SCALE);
+    int32_t lon = lroundf(tracking.lon * LONGITUDE_SCALE);
+    payload[0] = lat;
+    payload[1] = lat >> 8;
+    payload[2] = lat >> 16;
+    payload[3] = lon;
+    payload[4] = lon >> 8;
+    payload[5] = lon >> 16;
+
+    int32_t altitude = std::max((int32_t)0, (int32_t)tracking.altitude);
+    uint16_t type = altitude > 0x07FF ? (0x0800 | std::min((altitude + 2) / 4, (int32_t)0x07FF)) : altitude;
+    type |= (static_cast<uint8_t>(tracking.aircraftType) & 0x07) << 12;
+    type |= tracking.onlineTracking ? 0x8000 : 0;
+    payload[6] = type;
+    payload[7] = type >> 8;
+
+    int32_t speed = lroundf(tracking.groundSpeed * MS_TO_KPH * 2.f);
+    speed = std::max((int32_t)0, speed);
+    payload[8] = speed > 0x7F ? (0x80 | std::min((speed + 2) / 5, (int32_t)0x7F)) : speed;
+    payload[9] = scaledSigned7(lroundf(tracking.verticalSpeed * 10.f), 5);
+
+    int32_t course = lroundf(tracking.course * 256.f / 360.f);
+    payload[10] = course & 0xFF;
+    payload[11] = scaledSigned7(lroundf(tracking.hTurnRate * 4.f), 4);
+
+    return HEADER_LENGTH + TRACKING_TURNRATE_LENGTH;
+}
+
+OpenAce::AircraftCategory Fanet::mapAircraftCategory(AircraftType aircraftType)
+{
+    switch (aircraftType)
+    {
+    case AircraftType::PARAGLIDER:
+        return OpenAce::AircraftCategory::Paraglider;
+    case AircraftType::HANGGLIDER:
+        return OpenAce::AircraftCategory::HangGlider;
+    case AircraftType::BALLOON:
+        return OpenAce::AircraftCategory::Balloon;
+    case AircraftType::GLIDER:
+        return OpenAce::AircraftCategory::GliderMotorGlider;
+    case AircraftType::POWERED:
+        return OpenAce::AircraftCategory::ReciprocatingEngine;
+    case AircraftType::HELICOPTER:
+        return OpenAce::AircraftCategory::Helicopter;
+    case AircraftType::UAV:
+        return OpenAce::AircraftCategory::Uav;
+    case AircraftType::OTHER:
+    default:
+        return OpenAce::AircraftCategory::Unknown;
+    }
+}
+
+Fanet::AircraftType Fanet::mapAircraftCategory(OpenAce::AircraftCategory category)
+{
+    switch (category)
+    {
+    case OpenAce::AircraftCategory::Paraglider:
+        return AircraftType::PARAGLIDER;
+    case OpenAce::AircraftCategory::HangGlider:
+        return AircraftType::HANGGLIDER;
+    case OpenAce::AircraftCategory::Balloon:
+    case OpenAce::AircraftCategory::Airship:
+        return AircraftType::BALLOON;
+    case OpenAce::AircraftCategory::GliderMotorGlider:
+        return AircraftType::GLIDER;
+    case OpenAce::AircraftCategory::TowPlane:
+    case OpenAce::AircraftCategory::DropPlane:
+    case OpenAce::AircraftCategory::ReciprocatingEngine:
+    case OpenAce::AircraftCategory::JetTurbopropEngine:
+        return AircraftType::POWERED;
+    case OpenAce::AircraftCategory::Helicopter:
+        return AircraftType::HELICOPTER;
+    case OpenAce::AircraftCategory::Uav:
+        return AircraftType::UAV;
+    default:
+        return AircraftType::OTHER;
+    }
+}
+
+int8_t Fanet::handleFrame(const uint8_t *frame, uint8_t length, int8_t rssidBm)
+{
+    Header header;
+    if (!decodeHeader(frame, length, header))
+    {
+        statistics.invalidFrames++;
+        return -2;
+    }
+
+    auto type = std::min(static_cast<uint8_t>(header.type), static_cast<uint8_t>(MessageType::OTHER));
+    statistics.messageType[type]++;
+    if (header.forward)
+    {
+        statistics.forwarded++;
+    }
+
+    if (header.type != MessageType::TRACKING)
+    {
+        return -3;
+    }
+
+    // Ignore ownship, also when forwarded by other devices
+    if (header.address() == ownAddress())
+    {
+        return -4;
+    }
+
+    Tracking tracking;
+    if (!decodeTracking(frame + header.payloadOffset, length - header.payloadOffset, tracking))
+    {
+        statistics.invalidFrames++;
+        return -2;
+    }
+
+    return parseFrame(header, tracking, rssidBm);
+}
+
+int8_t Fanet::parseFrame(const Header &header, const Tracking &tracking, int8_t rssidBm)
+{
+    OpenAce::positionTs positionTs = CoreUtils::getPositionTs();
+
+    auto fromOwn = CoreUtils::getDistanceRelNorthRelEastInt(ownshipPosition.lat, ownshipPosition.lon, tracking.lat, tracking.lon);
+    if (fromOwn.distance > distanceIgnore)
+    {
+        statistics.outOfDistance++;
+        return -1;
+    }
+
+    OpenAce::IcaoAddress icaoAddress;
+    etl::string_stream stream(icaoAddress);
+    stream << etl::hex << header.address();
+
+    OpenAce::AircraftPositionMsg aircraftPosition{
+        OpenAce::AircraftPositionInfo{
+            positionTs,
+            icaoAddress,
+            header.address(),
+            OpenAce::AddressType::FANET,
+            OpenAce::DataSource::FANET,
+            mapAircraftCategory(tracking.aircraftType),
+            !tracking.onlineTracking,
+            false,
+            true, // Tracking messages are only send when airborne
+            tracking.lat,
+            tracking.lon,
+            tracking.altitude,
+            tracking.verticalSpeed,
+            tracking.groundSpeed,
+            static_cast<int16_t>(tracking.course),
+            tracking.hTurnRate,
+            static_cast<uint16_t>(fromOwn.distance),
+            fromOwn.relNorth,
+            fromOwn.relEast,
+            fromOwn.bearing},
+        rssidBm};
+    statistics.receivedAircraftPositions++;
+    getBus().receive(aircraftPosition);
+    return 0;
+}
+
+void Fanet::fanetReceiveTask(void *arg)
+{
+    Fanet *fanet = static_cast<Fanet *>(arg);
+    OpenAce::RadioRxFrame msg;
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        // The radio checked the CRC, frames are not Manchester encoded
+        while (fanet->frameRing.pop(msg))
+        {
+            fanet->handleFrame((const uint8_t *)msg.frame(), msg.length, msg.rssidBm);
+        }
+    }
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+/* System. */
+#include <stdint.h>
+#include <algorithm>
+
+/* Vendor. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* PICO. */
+#include "pico/stdlib.h"
+
+/* Vendor. */
+#include "etl/message_bus.h"
+#include "etl/string.h"
+#include "etl/array.h"
+
+/* OpenACE. */
+#include "ace/constants.hpp"
+#include "ace/messagerouter.hpp"
+#include "ace/basemodule.hpp"
+#include "ace/messages.hpp"
+#include "ace/coreutils.hpp"
+#include "ace/mpscring.hpp"
+
+/**
+ * FANET receiver and transmitter for paragliders and hanggliders
+ * Frames are send with LoRa (SF7, 250Khz, CR4/5, sync word 0xF1) and received by the radio in the FANET slot of the tuner.
+ * Only tracking (type 1) messages are decoded and send, other types are counted.
+ *
+ * Based on https://github.com/3s1d/fanet-stm32/blob/master/Src/fanet/radio/protocol.txt
+ */
+class Fanet : public BaseModule, public etl::message_router<Fanet,
+    OpenAce::RadioRxFrame,
+    OpenAce::OwnshipPositionMsg,
+    OpenAce::RadioTxPositionRequest,
+    OpenAce::ConfigUpdatedMsg>
+{
+    static constexpr int32_t DEFAULT_IGNORE_DISTANCE = 25000;
+    static constexpr int32_t MAX_IGNORE_DISTANCE = 50000;
+    // FANET shares 868.2Mhz with FLARM and OGN under a 1% duty cycle. A tracking frame takes about 25ms on air
+    static constexpr uint32_t TX_INTERVAL_MS = 5000;
+    // Manufacturer reserved for unregistered devices, the lower 16 bits of our address are used as the device id
+    static constexpr uint8_t MANUFACTURER_UNREGISTERED = 0xFC;
+
+    static constexpr uint8_t HEADER_LENGTH = 4;
+    static constexpr uint8_t TRACKING_LENGTH = 11;          // Without the optional turn rate
+    static constexpr uint8_t TRACKING_TURNRATE_LENGTH = 12; // With turn rate
+    static constexpr float LATITUDE_SCALE = 93206.f;
+    static constexpr float LONGITUDE_SCALE = 46603.f;
+
+    friend class message_router;
+public:
+    enum class MessageType : uint8_t
+    {
+        ACK = 0,
+        TRACKING = 1,
+        NAME = 2,
+        MESSAGE = 3,
+        SERVICE = 4,
+        LANDMARKS = 5,
+        REMOTE_CONFIG = 6,
+        GROUND_TRACKING = 7,
+        OTHER = 8 // Used for statistics only
+    };
+
+    /**
+     * Aircraft types as send in the tracking message
+     */
+    enum class AircraftType : uint8_t
+    {
+        OTHER = 0,
+        PARAGLIDER = 1,
+        HANGGLIDER = 2,
+        BALLOON = 3,
+        GLIDER = 4,
+        POWERED = 5,
+        HELICOPTER = 6,
+        UAV = 7
+    };
+
+    struct Header
+    {
+        MessageType type;
+        bool forward;
+        uint8_t manufacturer;
+        uint16_t id;
+        uint8_t payloadOffset; // Start of the payload after the (extended) header, destination and signature
+
+        OpenAce::AircraftAddress address() const
+        {
+            return (manufacturer << 16) | id;
+        }
+    };
+
+    struct Tracking
+    {
+        float lat;
+        float lon;
+        int16_t altitude;      // in meters
+        AircraftType aircraftType;
+        bool onlineTracking;   // Pilot allows the position to be shown online
+        float groundSpeed;     // in m/s
+        float verticalSpeed;   // in m/s
+        float course;          // 0..359
+        float hTurnRate;       // deg/s
+    };
+
+private:
+    mutable struct
+    {
+        uint32_t receivedAircraftPositions = 0;
+        uint32_t transmittedAircraftPositions = 0;
+        uint32_t invalidFrames = 0;
+        uint32_t outOfDistance = 0;
+        uint32_t queueFullErr = 0;
+        uint32_t forwarded = 0;
+        etl::array<uint32_t, static_cast<uint8_t>(MessageType::OTHER) + 1> messageType = {};
+    } statistics;
+
+    TaskHandle_t taskHandle;
+    OpenAce::MpscRing<OpenAce::RadioRxFrame, 4> frameRing;
+    OpenAce::OwnshipPositionInfo ownshipPosition;
+    OpenAce::Config::OpenAceConfiguration openAceConfiguration;
+    uint32_t lastTxMs;
+    uint16_t distanceIgnore;
+
+public:
+    static constexpr const etl::string_view NAME = "Fanet";
+    Fanet(etl::imessage_bus &bus, const Configuration &config) :
+        BaseModule(bus, NAME),
+        message_router(OpenAce::lockFreeRouterId(OpenAce::DataSource::FANET)),
+        taskHandle(nullptr),
+        ownshipPosition(),
+        lastTxMs(0)
+    {
+        int32_t v = config.valueByPath(DEFAULT_IGNORE_DISTANCE, "Fanet", "distanceIgnore");
+        distanceIgnore = std::max((int32_t)0, std::min(v, MAX_IGNORE_DISTANCE));
+        openAceConfiguration = config.openAceConfig();
+    }
+
+    virtual ~Fanet() = default;
+
+    virtual OpenAce::PostConstruct postConstruct() override;
+    virtual void start() override;
+    virtual void stop() override;
+    virtual void getData(etl::string_stream &stream, const etl::string_view path) const override;
+
+    /**
+     * Decode the header of a frame, returns false when the frame is too short for the header
+     */
+    static bool decodeHeader(const uint8_t *frame, uint8_t length, Header &header);
+
+    /**
+     * Decode the payload of a tracking message, returns false when the payload is too short
+     */
+    static bool decodeTracking(const uint8_t *payload, uint8_t length, Tracking &tracking);
+
+    /**
+     * Encode a tracking frame including the header, returns the length of the frame
+     * frame must hold at least HEADER_LENGTH + TRACKING_TURNRATE_LENGTH bytes
+     */
+    static uint8_t encodeTracking(uint8_t *frame, uint8_t manufacturer, uint16_t id, const Tracking &tracking);
+
+    static OpenAce::AircraftCategory mapAircraftCategory(AircraftType aircraftType);
+    static AircraftType mapAircraftCategory(OpenAce::AircraftCategory category);
+
+private:
+    /**
+     * Push the FANET frame in the frame ring and notify the receive task
+     * Called without the bus mutex, so only touch the ring here
+     * The bus only delivers frames from our own DataSource
+    */
+    void on_receive(const OpenAce::RadioRxFrame &msg);
+    void on_receive(const OpenAce::OwnshipPositionMsg &msg);
+    void on_receive(const OpenAce::RadioTxPositionRequest &msg);
+    void on_receive(const OpenAce::ConfigUpdatedMsg &msg);
+    void on_receive_unknown(const etl::imessage &msg)
+    {
+        (void)msg;
+    }
+
+    /**
+     * Address as send by this device
+     */
+    OpenAce::AircraftAddress ownAddress() const
+    {
+        return (MANUFACTURER_UNREGISTERED << 16) | (openAceConfiguration.address & 0xFFFF);
+    }
+
+    /**
+     * Decode a received frame and send tracking messages on the bus
+     * Returns 0 when an aircraft position was send, negative otherwise
+     */
+    int8_t handleFrame(const uint8_t *frame, uint8_t length, int8_t rssidBm);
+    int8_t parseFrame(const Header &header, const Tracking &tracking, int8_t rssidBm);
+
+    static void fanetReceiveTask(void *arg);
+};
@@ -0,0 +1,156 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#define private public
+
+#include <string.h>
+
+#include "mockconfig.h"
+
+#include "pico/time.h"
+#include "fanet.hpp"
+
+OpenAce::ThreadSafeBus<50> bus;
+MockConfig mockConfig{bus};
+Fanet fanet{bus, mockConfig};
+
+static Fanet::Tracking paraglider()
+{
+    return Fanet::Tracking{47.1234f, -8.5432f, 1234, Fanet::AircraftType::PARAGLIDER, true, 10.f, -2.3f, 271.f, -10.f};
+}
+
+TEST_CASE("encode and decode tracking", "[single-file]")
+{
+    uint8_t frame[OpenAce::RADIO_MAX_FRAME_LENGTH];
+    uint8_t length = Fanet::encodeTracking(frame, 0xFC, 0x1234, paraglider());
+    REQUIRE(length == 16);
+    REQUIRE(frame[0] == 0x01);
+    REQUIRE(frame[1] == 0xFC);
+    REQUIRE(frame[2] == 0x34);
+    REQUIRE(frame[3] == 0x12);
+
+    Fanet::Header header;
+    REQUIRE(Fanet::decodeHeader(frame, length, header));
+    REQUIRE(header.type == Fanet::MessageType::TRACKING);
+    REQUIRE_FALSE(header.forward);
+    REQUIRE(header.address() == 0xFC1234);
+    REQUIRE(header.payloadOffset == 4);
+
+    Fanet::Tracking tracking;
+    REQUIRE(Fanet::decodeTracking(frame + header.payloadOffset, length - header.payloadOffset, tracking));
+    REQUIRE(tracking.lat == Catch::Approx(47.1234f).margin(0.00002f));
+    REQUIRE(tracking.lon == Catch::Approx(-8.5432f).margin(0.00003f));
+    REQUIRE(tracking.altitude == 1234);
+    REQUIRE(tracking.aircraftType == Fanet::AircraftType::PARAGLIDER);
+    REQUIRE(tracking.onlineTracking);
+    REQUIRE(tracking.groundSpeed == Catch::Approx(10.f).margin(0.07f));
+    REQUIRE(tracking.verticalSpeed == Catch::Approx(-2.3f));
+    REQUIRE(tracking.course == Catch::Approx(271.f).margin(1.5f));
+    REQUIRE(tracking.hTurnRate == Catch::Approx(-10.f));
+}
+
+TEST_CASE("encode and decode scaled values", "[single-file]")
+{
+    uint8_t frame[OpenAce::RADIO_MAX_FRAME_LENGTH];
+    Fanet::Tracking glider{-33.9f, 151.2f, 5000, Fanet::AircraftType::GLIDER, false, 60.f, 12.f, 5.f, 30.f};
+    uint8_t length = Fanet::encodeTracking(frame, 0xFC, 0x1234, glider);
+
+    // Altitude, speed, climb and turn rate all need the scale bit
+    REQUIRE((frame[4 + 7] & 0x08) == 0x08);
+    REQUIRE((frame[4 + 8] & 0x80) == 0x80);
+    REQUIRE((frame[4 + 9] & 0x80) == 0x80);
+    REQUIRE((frame[4 + 11] & 0x80) == 0x80);
+
+    Fanet::Tracking tracking;
+    REQUIRE(Fanet::decodeTracking(frame + 4, length - 4, tracking));
+    REQUIRE(tracking.lat == Catch::Approx(-33.9f).margin(0.00002f));
+    REQUIRE(tracking.lon == Catch::Approx(151.2f).margin(0.00003f));
+    REQUIRE(tracking.altitude == 5000);
+    REQUIRE_FALSE(tracking.onlineTracking);
+    REQUIRE(tracking.groundSpeed == Catch::Approx(60.f).margin(0.4f));
+    REQUIRE(tracking.verticalSpeed == Catch::Approx(12.f));
+    REQUIRE(tracking.hTurnRate == Catch::Approx(30.f));
+
+    // Largest values
+    uint8_t payload[] = {0, 0, 0, 0, 0, 0, 0xFF, 0x0F, 0xFF, 0xC0, 0x80};
+    REQUIRE(Fanet::decodeTracking(payload, sizeof(payload), tracking));
+    REQUIRE(tracking.altitude == 0x7FF * 4);
+    REQUIRE(tracking.groundSpeed == Catch::Approx(317.5f / 3.6f));
+    REQUIRE(tracking.verticalSpeed == Catch::Approx(-32.f));
+    REQUIRE(tracking.course == Catch::Approx(180.f));
+    REQUIRE(tracking.hTurnRate == 0.f);
+}
+
+TEST_CASE("decode extended header", "[single-file]")
+{
+    // Extended header with unicast destination and signature in front of the tracking payload
+    uint8_t frame[4 + 1 + 3 + 4 + 11] = {0xC1, 0x11, 0x22, 0x33, 0x30};
+    Fanet::Header header;
+    REQUIRE(Fanet::decodeHeader(frame, sizeof(frame), header));
+    REQUIRE(header.type == Fanet::MessageType::TRACKING);
+    REQUIRE(header.forward);
+    REQUIRE(header.address() == 0x113322);
+    REQUIRE(header.payloadOffset == 12);
+
+    REQUIRE_FALSE(Fanet::decodeHeader(frame, 3, header));
+    REQUIRE_FALSE(Fanet::decodeHeader(frame, 4, header));
+    REQUIRE_FALSE(Fanet::decodeHeader(frame, 11, header));
+
+    Fanet::Tracking tracking;
+    REQUIRE_FALSE(Fanet::decodeTracking(frame + header.payloadOffset, 10, tracking));
+}
+
+TEST_CASE("aircraft category mapping", "[single-file]")
+{
+    for (uint8_t type = 0; type < 8; type++)
+    {
+        auto aircraftType = static_cast<Fanet::AircraftType>(type);
+        REQUIRE(Fanet::mapAircraftCategory(Fanet::mapAircraftCategory(aircraftType)) == aircraftType);
+    }
+    REQUIRE(Fanet::mapAircraftCategory(OpenAce::AircraftCategory::TowPlane) == Fanet::AircraftType::POWERED);
+    REQUIRE(Fanet::mapAircraftCategory(OpenAce::AircraftCategory::StaticObstacle) == Fanet::AircraftType::OTHER);
+}
+
+TEST_CASE("handle received frames", "[single-file]")
+{
+    fanet.distanceIgnore = 25000; // MockConfig returns 0 for all values
+    fanet.ownshipPosition.lat = 47.13f;
+    fanet.ownshipPosition.lon = -8.54f;
+
+    // Sections run the test case from the start, compare to the counts before
+    auto statistics = fanet.statistics;
+
+    uint8_t frame[OpenAce::RADIO_MAX_FRAME_LENGTH];
+    uint8_t length = Fanet::encodeTracking(frame, 0x11, 0x0001, paraglider());
+    REQUIRE(fanet.handleFrame(frame, length, -90) == 0);
+    REQUIRE(fanet.statistics.receivedAircraftPositions == statistics.receivedAircraftPositions + 1);
+    REQUIRE(fanet.statistics.messageType[1] == statistics.messageType[1] + 1);
+
+    SECTION("Other message types are counted only")
+    {
+        frame[0] = 0x02; // Name
+        REQUIRE(fanet.handleFrame(frame, length, -90) == -3);
+        REQUIRE(fanet.statistics.messageType[2] == statistics.messageType[2] + 1);
+        frame[0] = 0x3F;
+        REQUIRE(fanet.handleFrame(frame, length, -90) == -3);
+        REQUIRE(fanet.statistics.messageType[8] == statistics.messageType[8] + 1);
+    }
+
+    SECTION("Own frames are ignored")
+    {
+        length = Fanet::encodeTracking(frame, 0xFC, mockConfig.openAceConfig().address & 0xFFFF, paraglider());
+        REQUIRE(fanet.handleFrame(frame, length, -90) == -4);
+    }
+
+    SECTION("Too far away")
+    {
+        fanet.ownshipPosition.lat = 48.f;
+        REQUIRE(fanet.handleFrame(frame, length, -90) == -1);
+        REQUIRE(fanet.statistics.outOfDistance == statistics.outOfDistance + 1);
+    }
+
+    SECTION("Too short")
+    {
+        REQUIRE(fanet.handleFrame(frame, 10, -90) == -2);
+    }
+}
@@ -1,7 +1,9 @@
 #include <stdio.h>
+#include <string.h>
 
 #include <math.h>
 #include "flarm2024.hpp"
+#include "flarm_2023.hpp"
 #include "flarm_utils.hpp"
 #include "ace/manchester.hpp"
 
@@ -51,13 +53,13 @@ void Flarm2024::bteaDecode(uint32_t *data) const
 }
 
 
-void Flarm2024::scramble(uint32_t *data, uint32_t timestamp) const
+void Flarm2024::scrambleKey(const uint32_t *data, uint32_t window, uint32_t *keys) const
 {
     constexpr uint8_t numKeys = 4;
     constexpr uint8_t numIterations = 2;
     constexpr uint8_t byteLength = numKeys * sizeof(uint32_t);
 
-    uint32_t wkeys[] = {data[0], data[1], timestamp >> 4, SCRAMBLE};
+    uint32_t wkeys[] = {data[0], data[1], window, SCRAMBLE};
     uint8_t *bkeys = reinterpret_cast<uint8_t *>(&wkeys);
 
     uint16_t y, x;
@@ -85,31 +87,87 @@ void Flarm2024::scramble(uint32_t *data, uint32_t timestamp) const
 
     for (uint8_t i = 0; i < numKeys; ++i)
     {
-        data[2 + i] ^= wkeys[i];
+        keys[i] = wkeys[i];
     }
 }
 
-OpenAce::PostConstruct Flarm2024::postConstruct()
+void Flarm2024::scramble(uint32_t *data, uint32_t timestamp) const
+{
+    uint32_t keys[SCRAMBLE_KEYS];
+    scrambleKey(data, timestamp >> 4, keys);
+    for (uint8_t i = 0; i < SCRAMBLE_KEYS; ++i)
+    {
+        data[2 + i] ^= keys[i];
+    }
+}
+
+const uint32_t *Flarm2024::cachedScrambleKey(const uint32_t *data, uint32_t window)
 {
-    frameConsumerQueue = xQueueCreate(4, sizeof(OpenAce::RadioRxFrame));
-    if (frameConsumerQueue == nullptr)
+    // Both windows of an aircraft around a window boundary get their own slot
+    auto &entry = keyCache[((data[0] << 1) | (window & 1)) & (KEY_CACHE_SIZE - 1)];
+    if (entry.window != window || entry.header[0] != data[0] || entry.header[1] != data[1])
+    {
+        statistics.keyCacheMisses++;
+        entry.header[0] = data[0];
+        entry.header[1] = data[1];
+        entry.window = window;
+        scrambleKey(data, window, entry.keys);
+    }
+    return entry.keys;
+}
+
+uint32_t Flarm2024::decrypt(uint32_t *packet, uint32_t epochSeconds)
+{
+    bteaDecode(packet + 2);
+    uint32_t decoded[SCRAMBLE_KEYS];
+    memcpy(decoded, packet + 2, sizeof(decoded));
+
+    // The time of sending lies in at most two windows of 16 seconds, try the newest first
+    uint32_t firstWindow = (epochSeconds - MAX_FRAME_AGE) >> 4;
+    uint32_t lastWindow = (epochSeconds + MAX_FRAME_AHEAD) >> 4;
+    uint32_t window = lastWindow;
+    while (true)
     {
-        return OpenAce::PostConstruct::XQUEUE_ERROR;
+        const uint32_t *keys = cachedScrambleKey(packet, window);
+        for (uint8_t i = 0; i < SCRAMBLE_KEYS; ++i)
+        {
+            packet[2 + i] = decoded[i] ^ keys[i];
+        }
+
+        // Copy to read the bit fields of the words just written
+        RadioPacket radioPacket;
+        memcpy(&radioPacket, packet, RadioPacket::packetLength);
+        uint32_t sendAt = (window << 4) | radioPacket.flarmTimestampLSB;
+        if (radioPacket.reserved7 == 0 && radioPacket.reserved8 == 0 &&
+            sendAt + MAX_FRAME_AGE >= epochSeconds && sendAt <= epochSeconds + MAX_FRAME_AHEAD)
+        {
+            return sendAt;
+        }
+        if (window == firstWindow)
+        {
+            return 0;
+        }
+        window--;
     }
+}
+
+OpenAce::PostConstruct Flarm2024::postConstruct()
+{
+    // Frames with the v7 header are handed to the legacy decoder, when loaded
+    flarm2023 = static_cast<Flarm2023 *>(BaseModule::moduleByName(*this, Flarm2023::NAME, false));
     return OpenAce::PostConstruct::OK;
 }
 
 void Flarm2024::start()
 {
     xTaskCreate(flarmReceiveTask, "flarmReceiveTask", configMINIMAL_STACK_SIZE + 2048, this, tskIDLE_PRIORITY, &taskHandle);
-    getBus().subscribe(*this);
+    subscribe(*this);
 };
 
 void Flarm2024::stop()
 {
-    getBus().unsubscribe(*this);
+    unsubscribe(*this);
     vTaskDelete(taskHandle);
-    vQueueDelete(frameConsumerQueue);
 };
 
 void Flarm2024::getData(etl::string_stream &stream, const etl::string_view path) const
@@ -123,6 +181,11 @@ void Flarm2024::getData(etl::string_stream &stream, const etl::string_view path)
     stream << "\"receivedAircraftPositions\":" << statistics.receivedAircraftPositions;
     stream << ",\"transmittedAircraftPositions\":" << statistics.transmittedAircraftPositions;
     stream << ",\"crcErrors\":" << statistics.crcErrors;
+    stream << ",\"v8Frames\":" << statistics.v8Frames;
+    stream << ",\"v7Frames\":" << statistics.v7Frames;
+    stream << ",\"unknownFormat\":" << statistics.unknownFormat;
+    stream << ",\"decryptErrors\":" << statistics.decryptErrors;
+    stream << ",\"keyCacheMisses\":" << statistics.keyCacheMisses;
     stream << ",\"outOfDistance\":" << statistics.outOfDistance;
     stream << ",\"ownshipAddress\":" << openAceConfiguration.address;
     stream << ",\"addressType\":[" << statistics.addressType[0] << "," << statistics.addressType[1] << "," << statistics.addressType[2] << "," << statistics.addressType[3] << "]";
@@ -156,47 +219,26 @@ void Flarm2024::addReceiveStat(uint32_t frequency)
 int8_t Flarm2024::parseFrame(uint32_t *packet, uint32_t epochSeconds, int16_t rssiDbm)
 {
     // dumpBuffer(msg.frame, msg.length);
-    // Flarm messages are send well after PPS (400..1200ms after) so it would rarly
-    // happen we are not using the correct TS and thus decryption failures
     RadioPacket *radioPacket = (RadioPacket *)packet;
 
-#if !defined(UNIT_TESTING)
-
-    bteaDecode(packet + 2);
-    scramble(packet, epochSeconds);
-    uint32_t packetCpy[sizeof(RadioPacket)];
-    // Algorithm to find a possible epochTime where the received packed was scrambled at
-    // It currently assumes that only when the epochSec & 0x0F rolls over there is a potential
-    // This assumes the received packages is always send 'back' in time, echt current Epoch is always > epoch where
-    // the packages was scrambled at.
-    if (radioPacket->flarmTimestampLSB > ((uint8_t)(epochSeconds & 0x0F)))
-    {
-        constexpr int8_t timeOffsets[] = {-1, -2, 1};
-        RadioPacket *radioPacket = (RadioPacket *)packetCpy;
-        scramble(packet, epochSeconds);
-        bteaDecode(packet + 2);
-
-        for (auto offset : timeOffsets)
-        {
-            memcpy(packetCpy, packet, sizeof(RadioPacket));
-            bteaDecode(packetCpy + 2);
-            scramble(packetCpy, epochSeconds + offset);
-            if (radioPacket->flarmTimestampLSB - ((uint8_t)((epochSeconds + offset) & 0x0F)) >= 14)
-            {
-                printf(" Match found at %d", offset);
-                break;
-            }
-        }
-    }
-#endif
-
     // If it's not 0x02, it's not position data
     if (radioPacket->messageType != 0x02)
     {
         return -2;
     }
 
-    OpenAce::positionTs flarmTsMsEpoch = ((epochSeconds & ~0x0F) | radioPacket->flarmTimestampLSB) * 1000;
+#if !defined(UNIT_TESTING)
+    uint32_t sendAt = decrypt(packet, epochSeconds);
+    if (sendAt == 0)
+    {
+        statistics.decryptErrors++;
+        return -3;
+    }
+#else
+    uint32_t sendAt = (epochSeconds & ~0x0F) | radioPacket->flarmTimestampLSB;
+#endif
+
+    OpenAce::positionTs flarmTsMsEpoch = sendAt * 1000;
 
     auto ownlat = ownshipPosition.lat;
     auto ownLon = ownshipPosition.lon;
@@ -276,13 +318,14 @@ int8_t Flarm2024::parseFrame(uint32_t *packet, uint32_t epochSeconds, int16_t rs
 void Flarm2024::flarmReceiveTask(void *arg)
 {
     Flarm2024 *flarm = static_cast<Flarm2024 *>(arg);
+    OpenAce::RadioRxFrame msg;
     while (true)
     {
-        OpenAce::RadioRxFrame msg;
-        if (xQueueReceive(flarm->frameConsumerQueue, &msg, portMAX_DELAY) == pdPASS)
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (flarm->frameRing.pop(msg))
         {
             // Validate checksum
-            RadioPacket *packet = (RadioPacket *)msg.frame;
+            RadioPacket *packet = (RadioPacket *)msg.frame();
 
             // // Validate packet, and correct if possible
             // uint8_t check = ogn1->errorCorrect((uint8_t *)&packet, (uint8_t *)msg.frame, (uint8_t *)msg.err);
@@ -292,7 +335,7 @@ void Flarm2024::flarmReceiveTask(void *arg)
             //     continue;
             // }
 
-            uint16_t calculatedChecksum = flarmCalculateChecksum((uint8_t *)msg.frame, RadioPacket::packetLength);
+            uint16_t calculatedChecksum = flarmCalculateChecksum((uint8_t *)msg.frame(), RadioPacket::packetLength);
             if (calculatedChecksum != swapBytes16(packet->checksum))
             {
                 flarm->statistics.crcErrors++;
@@ -306,20 +349,35 @@ void Flarm2024::flarmReceiveTask(void *arg)
             }
 
             flarm->addReceiveStat(msg.frequency);
-            flarm->parseFrame(msg.frame, msg.epochSeconds, msg.rssidBm);
+
+            // The plain header tells the packet layout
+            if (packet->messageType == 0x02)
+            {
+                flarm->statistics.v8Frames++;
+                flarm->parseFrame(msg.frame(), msg.epochSeconds, msg.rssidBm);
+            }
+            else if (flarm->flarm2023 != nullptr && Flarm2023::isV7Position(msg.frame()))
+            {
+                flarm->statistics.v7Frames++;
+                flarm->flarm2023->parseFrame(msg.frame(), msg.epochSeconds, msg.rssidBm, flarm->ownshipPosition);
+            }
+            else
+            {
+                flarm->statistics.unknownFormat++;
+            }
         }
     }
 }
 
 void Flarm2024::on_receive(const OpenAce::RadioRxFrame &msg)
 {
-    if (msg.dataSource == OpenAce::DataSource::FLARM)
+    if (frameRing.push(msg))
     {
-        const OpenAce::RadioRxFrame cpy = msg;
-        if (xQueueSendToBack(frameConsumerQueue, &cpy, TASK_DELAY_MS(5)) != pdPASS)
-        {
-            statistics.queueFull++;
-        }
+        xTaskNotify(taskHandle, 1, eSetBits);
+    }
+    else
+    {
+        statistics.queueFull++;
     }
 }
 
@@ -28,7 +28,9 @@
 #include "ace/basemodule.hpp"
 #include "ace/messages.hpp"
 #include "ace/coreutils.hpp"
+#include "ace/mpscring.hpp"
 
+class Flarm2023;
 
 
 class Flarm2024 : public BaseModule, public etl::message_router<Flarm2024, OpenAce::ConfigUpdatedMsg, 
@@ -43,6 +45,11 @@ OpenAce::RadioRxFrame, OpenAce::OwnshipPositionMsg, OpenAce::RadioTxPositionRequ
     static constexpr uint32_t SCRAMBLE = 0x956f6c77;
     static constexpr uint8_t BTEA_N = 4;
     static constexpr uint8_t BTEA_ROUNDS = 6;
+    static constexpr uint8_t SCRAMBLE_KEYS = 4;
+    static constexpr uint8_t KEY_CACHE_SIZE = 8; // Must be a power of 2
+    // Frames are handled up to 2 seconds after sending, and the sender's clock may be a second ahead
+    static constexpr uint32_t MAX_FRAME_AGE = 2;
+    static constexpr uint32_t MAX_FRAME_AHEAD = 1;
 private:
 
 #pragma pack(push, 4)
@@ -84,6 +91,11 @@ private:
         uint32_t receivedAircraftPositions = 0;
         uint32_t transmittedAircraftPositions = 0;
         uint32_t crcErrors = 0;
+        uint32_t v8Frames = 0;
+        uint32_t v7Frames = 0;
+        uint32_t unknownFormat = 0;
+        uint32_t decryptErrors = 0;
+        uint32_t keyCacheMisses = 0;
         uint32_t outOfDistance = 0;
         etl::array<uint32_t, 4> addressType = {0, 0, 0, 0};
         uint32_t queueFull = 0;
@@ -97,8 +109,21 @@ private:
     };
     etl::vector<DataSourceTimeStats, 2> dataSourceTimeStats;
 
+    /**
+     * The scramble keys only depend on the first two (plain) words of a packet and the 16 second window it was send in,
+     * so all frames of an aircraft within a window share them
+     */
+    struct ScrambleKey
+    {
+        uint32_t header[2] = {0, 0};
+        uint32_t window = 0;
+        uint32_t keys[SCRAMBLE_KEYS] = {0, 0, 0, 0};
+    };
+    etl::array<ScrambleKey, KEY_CACHE_SIZE> keyCache;
+
     TaskHandle_t taskHandle;
-    QueueHandle_t frameConsumerQueue;
+    Flarm2023 *flarm2023; // Legacy v7 decoder, only when loaded
+    OpenAce::MpscRing<OpenAce::RadioRxFrame, 4> frameRing;
     OpenAce::OwnshipPositionInfo ownshipPosition;
     OpenAce::Config::OpenAceConfiguration openAceConfiguration;
     float deltaCourse;
@@ -107,8 +132,9 @@ public:
     static constexpr const etl::string_view NAME = "Flarm";
     Flarm2024(etl::imessage_bus& bus, const Configuration &config) :
         BaseModule(bus, NAME),
+        message_router(OpenAce::lockFreeRouterId(OpenAce::DataSource::FLARM)),
         taskHandle(nullptr),
-        frameConsumerQueue(nullptr),
+        flarm2023(nullptr),
         ownshipPosition(),
         deltaCourse(0.f)
     {
@@ -127,8 +153,10 @@ private:
 
 
     /**
-     * Send a FreeRTOS message when a FlarmFrame is received
+     * Push the FlarmFrame in the frame ring and notify the receive task
      * This will release the sender from the task and allow it to continue in a seperate thread
+     * Called without the bus mutex, so only touch the ring here
+     * The bus only delivers frames from our own DataSource
     */
     void on_receive(const OpenAce::RadioRxFrame &msg);
     void on_receive(const OpenAce::OwnshipPositionMsg &msg);
@@ -160,8 +188,22 @@ private:
 
     void bteaDecode(uint32_t *data) const;
     void bteaEncode(uint32_t *data) const;
+    void scrambleKey(const uint32_t *data, uint32_t window, uint32_t *keys) const;
     void scramble(uint32_t *data, uint32_t timestamp) const;
 
+    /**
+     * Scramble keys of the packet header for a window of 16 seconds from the key cache
+    */
+    const uint32_t *cachedScrambleKey(const uint32_t *data, uint32_t window);
+
+    /**
+     * Decrypt a received packet in place, trying the windows of 16 seconds the packet could have been send in.
+     * A window is accepted when the reserved bits decrypt to 0 and the timestamp LSB gives a time of sending
+     * between MAX_FRAME_AGE seconds before and MAX_FRAME_AHEAD seconds after epochSeconds.
+     * Returns the epoch second the packet was send at, or 0 when no window matches
+    */
+    uint32_t decrypt(uint32_t *packet, uint32_t epochSeconds);
+
 };
 
 
@@ -1,37 +1,19 @@
 #pragma once
 
-#include "flarm_common.hpp"
-
 /* System. */
 #include <stdint.h>
 #include <algorithm>
 
 /* Vendor. */
-#include "FreeRTOS.h"
-#include "task.h"
-#include "queue.h"
-#include "message_buffer.h"
-
-/* PICO. */
-#include "pico/stdlib.h"
-#include "pico/binary_info.h"
-
-/* Vendor. */
-#include "etl/map.h"
-#include "etl/message_bus.h"
+#include "etl/array.h"
 #include "etl/string.h"
-#include "etl/bitset.h"
 
 /* OpenACE. */
 #include "ace/constants.hpp"
-#include "ace/messagerouter.hpp"
 #include "ace/basemodule.hpp"
 #include "ace/messages.hpp"
-#include "ace/utils.hpp"
 #include "ace/coreutils.hpp"
 
-
-
 struct flarmV7Packet_t
 {
     /********************/
@@ -71,8 +53,6 @@ struct flarmV7Packet_t
     static constexpr uint8_t packetLength = 24; // Packet length
     static constexpr uint8_t totalLength = 26;  // Packet length with CRC
 };
-//__attribute__((packed))
-;
 
 //  0     AAAA AAAA    device address
 //  1     AAAA AAAA
@@ -121,131 +101,62 @@ void flarmMakekey(uint32_t key[4], uint32_t epochSeconds, uint32_t address);
 void flarmEncrypt(uint32_t *flarm_pkt, uint32_t epochSeconds);
 void flarmDecrypt(uint32_t *flarm_pkt, uint32_t epochSeconds);
 
-uint16_t flarmCalculateChecksum(uint8_t* flarm_pkt, uint8_t length);
-
-
-
-
-
-class Flarm_2023 : public BaseModule, public etl::message_router<Flarm_2023, OpenAce::RadioRxFrame, OpenAce::OwnshipPositionMsg, OpenAce::RadioTxPositionRequest>
+/**
+ * Decoder for the legacy (v7) FLARM position packet, still send by older FLARM units.
+ * The module has no receive queue of it's own: Flarm2024 validates the CRC of every FLARM frame and hands
+ * frames with the v7 header to this module when it is loaded. Load it before Flarm2024.
+ */
+class Flarm2023 : public BaseModule
 {
     static constexpr int32_t DEFAULT_IGNORE_DISTANCE = 25000;
-    static constexpr int32_t MAX_IGNORE_DISTANCE = 50000;
-    friend class message_router;
+    // Frames are handled up to 2 seconds after sending, and the sender's clock may be a second ahead
+    static constexpr uint32_t MAX_FRAME_AGE = 2;
+    static constexpr uint32_t MAX_FRAME_AHEAD = 1;
+
     struct
     {
         uint32_t receivedAircraftPositions = 0;
-        uint32_t transmittedAircraftPositions = 0;
-        uint32_t crcErrors = 0;
+        uint32_t decryptErrors = 0;
         uint32_t outOfDistance = 0;
-        uint32_t zero0x01Err = 0;
-        uint32_t zero0Err = 0;
-        uint32_t addressTypeErr = 0;
-        uint32_t addressTypeFlarm = 0;
-        uint32_t addressTypeRandom = 0;
-        uint32_t addressTypeICAO = 0;
-        uint32_t queueFull = 0;
+        etl::array<uint32_t, 4> addressType = {0, 0, 0, 0};
     } statistics;
 
-    struct DataSourceTimeStats
-    {
-        etl::bitset<100> timeTenthMs;
-        uint32_t frequency;
-    };
-    etl::vector<DataSourceTimeStats, 2> dataSourceTimeStats;
-
-    TaskHandle_t taskHandle;
-    QueueHandle_t frameConsumerQueue;
-    OpenAce::OwnshipPositionInfo ownshipPosition;
-    float deltaCourse;
     uint16_t distanceIgnore;
 public:
-    static constexpr const etl::string_view NAME = "Flarm_2023";
-    Flarm_2023(etl::imessage_bus& bus, const Configuration &config) :
-        BaseModule(bus, NAME),
-        taskHandle(nullptr),
-        frameConsumerQueue(nullptr),
-        ownshipPosition(),
-        deltaCourse(0.f)
+    static constexpr const etl::string_view NAME = "Flarm2023";
+    Flarm2023(etl::imessage_bus& bus, const Configuration &config) :
+        BaseModule(bus, NAME)
     {
-        int32_t v = config.valueByPath(25000, "Flarm_2023", "distanceIgnore");
-        distanceIgnore = std::max((int32_t)0, std::min(v, MAX_IGNORE_DISTANCE));
+        int32_t di = config.valueByPath(DEFAULT_IGNORE_DISTANCE, "Flarm2023", "distanceIgnore");
+        distanceIgnore = std::max((int32_t)0, std::min(di, DEFAULT_IGNORE_DISTANCE));
     }
 
-    virtual ~Flarm_2023() = default;
+    virtual ~Flarm2023() = default;
 
     virtual OpenAce::PostConstruct postConstruct() override;
     virtual void start() override;
     virtual void stop() override;
     virtual void getData(etl::string_stream &stream, const etl::string_view path) const override;
-private:
-    /**
-     * Send a FreeRTOS message when a FlarmFrame is received
-     * This will release the sender from the task and allow it to continue in a seperate thread
-    */
-    void on_receive(const OpenAce::RadioRxFrame &msg)
-    {
-        if (msg.dataSource == OpenAce::DataSource::FLARM)
-        {
-            const OpenAce::RadioRxFrame cpy = msg;
-            if (xQueueSendToBack(frameConsumerQueue, &cpy, TASK_DELAY_MS(5)) != pdPASS )
-            {
-                statistics.queueFull++;
-            }
-        }
-    }
-
-    void on_receive(const OpenAce::OwnshipPositionMsg &msg)
-    {
-        ownshipPosition = msg.position;
-    }
 
     /**
-     * Handle a request to send a Flarm packet.
-     * The packets is assembled and then send over the respected radio
-     * Only reason to return the packet is to beable to test it.
+     * True when the header of a (CRC checked) FLARM frame is the v7 position header
     */
-    const flarmV7Packet_t on_receive(const OpenAce::RadioTxPositionRequest &msg);
-
-    void on_receive(const OpenAce::ConfigUpdated &msg)
-    {
-    }
-
-    void on_receive_unknown(const etl::imessage& msg)
-    {
-        (void)msg;
-    }
-
-    // Transform a FLARM addressType to an openAce address type
-    OpenAce::AddressType addressType(uint8_t addressType);
+    static bool isV7Position(const uint32_t *packet);
 
     /**
-     * Keep track of what timestamp (roughly) we receive flarm frames
+     * Decrypt and parse a v7 position packet in place, and send it on the bus
+     * Returns 0 when an aircraft position was send, negative otherwise
     */
-    void addReceiveStat(uint32_t frequency);
-
-    /**
-     * Parse a flarm frame and send it
-     *
-     * Based on https://github.com/creaktive/flare/blob/master/flarm_decode.c
-    */
-    int8_t parseFrame(uint32_t *flarm_pkt, uint32_t epochSeconds, int16_t rssiDbm);
-    static void flarmReceiveTask(void *arg);
-
-
-    uint8_t getSpeedScaling() const;
-    uint8_t getSpeedScaling(float groundSpeed, float verticalSpeed) const;
-
-    uint8_t getTurnState() const;
+    int8_t parseFrame(uint32_t *packet, uint32_t epochSeconds, int16_t rssidBm, const OpenAce::OwnshipPositionInfo &ownshipPosition);
 
+private:
     /**
-     * THis generates a vector of 4 bytes that represents the velocity vector
-     * Each byte is a 4 second interval of the velocity vector as a uint8_t, but it's actually a two's complement signed int
-     * 217 means 39 (256-217) = 39
-     * So sends out a predicted path over the next 17 seconds in intervals of [2-5] [6-9] [10-13] []14-17]
+     * Decrypt a received packet in place, trying the keys of the 64 second windows the packet could have been send in.
+     * A key is accepted when the reserved bits decrypt to 0
+     * Returns false when no key matches
     */
-    void extrapolatVelocityVector(float deltaHeadingRad, float velNorthMS, float velEastMS, uint8_t speedScale, int8_t velN[4], int8_t velE[4]) const;
+    bool decrypt(uint32_t *packet, uint32_t epochSeconds) const;
 
+    // Transform a FLARM addressType to an openAce address type
+    OpenAce::AddressType addressTypeFromFlarm(uint8_t addressType) const;
 };
-
-
@@ -0,0 +1,109 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#define private public
+
+#include <stddef.h>
+#include <string.h>
+
+#include "mockconfig.h"
+
+#include "flarm_2023.hpp"
+#include "mockutils.h"
+
+OpenAce::ThreadSafeBus<50> bus;
+MockConfig mockConfig{bus};
+Flarm2023 flarm2023{bus, mockConfig};
+
+static flarmV7Packet_t v7Packet(float lat, float lon)
+{
+    flarmV7Packet_t packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.address = 0xDDA5BA;
+    packet.addressType = 0x02;
+    packet.turnRate = TURN_RATE_NO_TURN;
+    packet.aircraftType = 1;
+    packet.latitude = ((int32_t)(lat * 1e7) >> 7) & 0x7ffff;
+    packet.longitude = ((int32_t)(lon * 1e7) >> 7) & 0xfffff;
+    packet.altitude = 1200;
+    packet.speedscale = 0;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        packet.ns[i] = 100;
+        packet.ew[i] = 0;
+    }
+    return packet;
+}
+
+TEST_CASE("flarmV7Packet_t layout", "[single-file]")
+{
+    REQUIRE(offsetof(flarmV7Packet_t, ns) == 16);
+    REQUIRE(offsetof(flarmV7Packet_t, ew) == 20);
+    REQUIRE(offsetof(flarmV7Packet_t, checksum) == flarmV7Packet_t::packetLength);
+
+    flarmV7Packet_t packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.addressType = 0x02;
+    packet.zero1 = 0x3FF;
+    uint8_t bytes[flarmV7Packet_t::packetLength];
+    memcpy(bytes, &packet, sizeof(bytes));
+    REQUIRE(bytes[3] == 0x20);
+    REQUIRE(bytes[14] == 0xF0);
+    REQUIRE(bytes[15] == 0x3F);
+}
+
+TEST_CASE("v7 and v8 headers", "[single-file]")
+{
+    uint32_t v7[7];
+    auto packet = v7Packet(52.0f, 5.0f);
+    memcpy(v7, &packet, sizeof(v7));
+    REQUIRE(Flarm2023::isV7Position(v7));
+
+    // Flarm2024 position packets have message type 0x02
+    uint32_t v8[7] = {0x22DDA5BA, 0, 0, 0, 0, 0, 0};
+    REQUIRE_FALSE(Flarm2023::isV7Position(v8));
+}
+
+TEST_CASE("decrypt frames send around a 64 second key boundary", "[single-file]")
+{
+    auto org = v7Packet(52.0f, 5.0f);
+    uint32_t base = 1720119040; // Start of a key
+    for (uint32_t sendAt = base - 4; sendAt < base + 4; sendAt++)
+    {
+        uint32_t encrypted[7];
+        memcpy(encrypted, &org, sizeof(encrypted));
+        flarmEncrypt(encrypted, sendAt);
+
+        for (int32_t late = -(int32_t)Flarm2023::MAX_FRAME_AHEAD; late <= (int32_t)Flarm2023::MAX_FRAME_AGE; late++)
+        {
+            uint32_t work[7];
+            memcpy(work, encrypted, sizeof(work));
+            REQUIRE(flarm2023.decrypt(work, sendAt + late));
+            REQUIRE(memcmp(work, &org, flarmV7Packet_t::packetLength) == 0);
+        }
+    }
+}
+
+TEST_CASE("parseFrame v7 position", "[single-file]")
+{
+    OpenAce::OwnshipPositionInfo ownship;
+    ownship.lat = 52.01f;
+    ownship.lon = 5.01f;
+    flarm2023.distanceIgnore = 25000; // MockConfig returns 0 for all values
+
+    // Unit tests skip the decryption, the packet is send in plain
+    auto packet = v7Packet(52.0f, 5.0f);
+    uint32_t work[7];
+    memcpy(work, &packet, sizeof(work));
+    auto received = flarm2023.statistics.receivedAircraftPositions;
+    REQUIRE(flarm2023.parseFrame(work, 1720119040, -90, ownship) == 0);
+    REQUIRE(flarm2023.statistics.receivedAircraftPositions == received + 1);
+    REQUIRE(flarm2023.statistics.addressType[2] == 1);
+
+    // Far away
+    ownship.lat = 50.0f;
+    memcpy(work, &packet, sizeof(work));
+    auto outOfDistance = flarm2023.statistics.outOfDistance;
+    REQUIRE(flarm2023.parseFrame(work, 1720119040, -90, ownship) == -1);
+    REQUIRE(flarm2023.statistics.outOfDistance == outOfDistance + 1);
+}
@@ -216,4 +216,59 @@ TEST_CASE("bteaAndScramble compatibility SoftRF Moshe functions", "[single-file]
 
     // print_buffer_hex_uint32(work, 7);
     REQUIRE((work[6] & 0xFFFF0000) == 0xabcd0000);
-}
\ No newline at end of file
+}
+TEST_CASE("decrypt frames send around a 16 second window boundary", "[single-file]")
+{
+    Flarm2024::RadioPacket org;
+    memset(&org, 0, sizeof(org));
+    org.aircraftID = 0xDDA5BA;
+    org.messageType = 0x02;
+    org.addressType = 0x02;
+    org.reserved3 = 0b11;
+    org.reserved4 = 0b11;
+    org.latitude = 12345;
+    org.longitude = 54321;
+
+    uint32_t base = 1720119024; // Start of a window
+    for (uint32_t sendAt = base - 4; sendAt < base + 4; sendAt++)
+    {
+        org.flarmTimestampLSB = sendAt & 0x0F;
+        uint32_t encrypted[7];
+        memcpy(encrypted, &org, sizeof(encrypted));
+        flarm.scramble(encrypted, sendAt);
+        flarm.bteaEncode(encrypted + 2);
+
+        for (int32_t late = -(int32_t)Flarm2024::MAX_FRAME_AHEAD; late <= (int32_t)Flarm2024::MAX_FRAME_AGE; late++)
+        {
+            uint32_t work[7];
+            memcpy(work, encrypted, sizeof(work));
+            REQUIRE(flarm.decrypt(work, sendAt + late) == sendAt);
+            REQUIRE(memcmp(work, &org, Flarm2024::RadioPacket::packetLength) == 0);
+        }
+
+        // Too old
+        uint32_t work[7];
+        memcpy(work, encrypted, sizeof(work));
+        REQUIRE(flarm.decrypt(work, sendAt + 8) == 0);
+    }
+}
+
+TEST_CASE("decrypt uses cached scramble keys", "[single-file]")
+{
+    uint32_t packet[7] = {0x20DDA5BA, 0x0F000000, 0, 0, 0, 0, 0};
+    uint32_t epoch = 1720119030; // Only one window in reach
+    uint32_t work[7];
+    memcpy(work, packet, sizeof(work));
+    flarm.decrypt(work, epoch);
+    auto misses = flarm.statistics.keyCacheMisses;
+    for (int i = 0; i < 10; i++)
+    {
+        memcpy(work, packet, sizeof(work));
+        flarm.decrypt(work, epoch);
+    }
+    REQUIRE(flarm.statistics.keyCacheMisses == misses);
+
+    uint32_t keys[4];
+    flarm.scrambleKey(packet, epoch >> 4, keys);
+    REQUIRE(memcmp(flarm.cachedScrambleKey(packet, epoch >> 4), keys, sizeof(keys)) == 0);
+}
@@ -14,12 +14,12 @@ OpenAce::PostConstruct Gdl90Service::postConstruct()
 void Gdl90Service::start()
 {
     xTaskCreate(gdl90ServiceTask, "gdl90ServiceTask", configMINIMAL_STACK_SIZE + 1024, this, tskIDLE_PRIORITY, &taskHandle);
-    getBus().subscribe(*this);
+    subscribe(*this);
 };
 
 void Gdl90Service::stop()
 {
-    getBus().unsubscribe(*this);
+    unsubscribe(*this);
     xTaskNotify(taskHandle, TaskState::SHUTDOWN, eSetBits);
     while (eTaskGetState(taskHandle) != eDeleted)
     {
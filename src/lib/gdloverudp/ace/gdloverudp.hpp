@@ -73,12 +73,12 @@ public:
 
     virtual void start() override
     {
-        getBus().subscribe(*this);
+        subscribe(*this);
     };
 
     virtual void stop() override
     {
-        getBus().unsubscribe(*this);
+        unsubscribe(*this);
         vSemaphoreDelete(configMutex);
     };
 
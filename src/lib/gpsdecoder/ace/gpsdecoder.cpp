@@ -12,12 +12,12 @@ OpenAce::PostConstruct GpsDecoder::postConstruct()
 
 void GpsDecoder::start()
 {
-    getBus().subscribe(*this);
+    subscribe(*this);
 }
 
 void GpsDecoder::stop()
 {
-    getBus().unsubscribe(*this);
+    unsubscribe(*this);
 }
 
 void GpsDecoder::getData(etl::string_stream &stream, const etl::string_view path) const
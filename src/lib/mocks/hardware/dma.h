@@ -0,0 +1,154 @@
+#pragma once
+
+#include <stdint.h>
+#include "../pico.h"
+#include "irq.h"
+#include "spi.h"
+
+enum dma_channel_transfer_size
+{
+    DMA_SIZE_8 = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2
+};
+
+typedef struct
+{
+    uint dreq;
+    bool readIncrement;
+    bool writeIncrement;
+} dma_channel_config;
+
+struct MockDmaChannel
+{
+    bool claimed = false;
+    dma_channel_config config = {};
+    volatile void *write = nullptr;
+    const volatile void *read = nullptr;
+    uint count = 0;
+    bool irq1Enabled = false;
+    bool irq1Status = false;
+};
+
+static constexpr uint MOCK_DMA_CHANNELS = 12;
+inline MockDmaChannel mockDmaChannels[MOCK_DMA_CHANNELS];
+inline bool mockDmaComplete = true; // When false started transfers never finish
+
+inline int dma_claim_unused_channel(bool required)
+{
+    for (uint i = 0; i < MOCK_DMA_CHANNELS; i++)
+    {
+        if (!mockDmaChannels[i].claimed)
+        {
+            mockDmaChannels[i].claimed = true;
+            return i;
+        }
+    }
+    return -1;
+}
+
+inline void dma_channel_unclaim(uint channel)
+{
+    mockDmaChannels[channel] = MockDmaChannel{};
+}
+
+inline dma_channel_config dma_channel_get_default_config(uint channel)
+{
+    return dma_channel_config{0x3f, true, false};
+}
+
+inline void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size)
+{
+}
+
+inline void channel_config_set_dreq(dma_channel_config *c, uint dreq)
+{
+    c->dreq = dreq;
+}
+
+inline void channel_config_set_read_increment(dma_channel_config *c, bool incr)
+{
+    c->readIncrement = incr;
+}
+
+inline void channel_config_set_write_increment(dma_channel_config *c, bool incr)
+{
+    c->writeIncrement = incr;
+}
+
+inline void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr, const volatile void *read_addr, uint transfer_count, bool trigger)
+{
+    mockDmaChannels[channel].config = *config;
+    mockDmaChannels[channel].write = write_addr;
+    mockDmaChannels[channel].read = read_addr;
+    mockDmaChannels[channel].count = transfer_count;
+}
+
+inline void dma_channel_set_irq1_enabled(uint channel, bool enabled)
+{
+    mockDmaChannels[channel].irq1Enabled = enabled;
+}
+
+inline bool dma_channel_get_irq1_status(uint channel)
+{
+    return mockDmaChannels[channel].irq1Status;
+}
+
+inline void dma_channel_acknowledge_irq1(uint channel)
+{
+    mockDmaChannels[channel].irq1Status = false;
+}
+
+inline void dma_channel_abort(uint channel)
+{
+    mockDmaChannels[channel].count = 0;
+}
+
+/**
+ * Runs the paced TX and RX channel against the mock SPI peripheral and raises DMA_IRQ_1 for the channels that finished
+ */
+inline void dma_start_channel_mask(uint32_t chan_mask)
+{
+    if (!mockDmaComplete)
+    {
+        return;
+    }
+
+    MockDmaChannel *tx = nullptr;
+    MockDmaChannel *rx = nullptr;
+    for (uint i = 0; i < MOCK_DMA_CHANNELS; i++)
+    {
+        if (chan_mask & (1u << i))
+        {
+            if (mockDmaChannels[i].config.dreq == spi_get_dreq(spi0, true))
+            {
+                tx = &mockDmaChannels[i];
+            }
+            else if (mockDmaChannels[i].config.dreq == spi_get_dreq(spi0, false))
+            {
+                rx = &mockDmaChannels[i];
+            }
+        }
+    }
+    if (tx == nullptr || rx == nullptr)
+    {
+        return;
+    }
+
+    const volatile uint8_t *src = static_cast<const volatile uint8_t *>(tx->read);
+    volatile uint8_t *dst = static_cast<volatile uint8_t *>(rx->write);
+    for (uint i = 0; i < tx->count; i++)
+    {
+        uint8_t in = mockSpiPeripheral.exchange(src[tx->config.readIncrement ? i : 0]);
+        dst[rx->config.writeIncrement ? i : 0] = in;
+    }
+
+    tx->count = 0;
+    rx->count = 0;
+    tx->irq1Status = tx->irq1Enabled;
+    rx->irq1Status = rx->irq1Enabled;
+    if (mockIrqEnabled[DMA_IRQ_1] && mockIrqHandlers[DMA_IRQ_1] != nullptr && (tx->irq1Status || rx->irq1Status))
+    {
+        mockIrqHandlers[DMA_IRQ_1]();
+    }
+}
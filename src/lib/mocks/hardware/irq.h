@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+#include "../pico.h"
+
+typedef void (*irq_handler_t)(void);
+
+#define DMA_IRQ_0 11
+#define DMA_IRQ_1 12
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+
+inline irq_handler_t mockIrqHandlers[32] = {};
+inline bool mockIrqEnabled[32] = {};
+
+inline void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority)
+{
+    mockIrqHandlers[num] = handler;
+}
+
+inline void irq_remove_handler(uint num, irq_handler_t handler)
+{
+    mockIrqHandlers[num] = nullptr;
+}
+
+inline void irq_set_enabled(uint num, bool enabled)
+{
+    mockIrqEnabled[num] = enabled;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../pico.h"
+
+typedef struct
+{
+    uint32_t dr;
+} spi_hw_t;
+
+typedef struct spi_inst
+{
+    spi_hw_t hw;
+} spi_inst_t;
+
+inline spi_inst_t mockSpi0;
+#define spi0 (&mockSpi0)
+
+/**
+ * Mock SPI peripheral, keeps the bytes that where clocked out and returns the bytes from miso when clocking in
+ */
+struct MockSpiPeripheral
+{
+    static constexpr size_t SIZE = 256;
+    uint8_t mosi[SIZE];
+    uint8_t miso[SIZE];
+    size_t mosiLength = 0;
+    size_t misoPosition = 0;
+
+    void reset()
+    {
+        mosiLength = 0;
+        misoPosition = 0;
+    }
+
+    uint8_t exchange(uint8_t out)
+    {
+        if (mosiLength < SIZE)
+        {
+            mosi[mosiLength++] = out;
+        }
+        return misoPosition < SIZE ? miso[misoPosition++] : 0;
+    }
+};
+inline MockSpiPeripheral mockSpiPeripheral;
+
+inline spi_hw_t *spi_get_hw(spi_inst_t *spi)
+{
+    return &spi->hw;
+}
+
+inline uint spi_get_dreq(spi_inst_t *spi, bool isTx)
+{
+    return isTx ? 16 : 17;
+}
+
+inline bool spi_is_readable(const spi_inst_t *spi)
+{
+    return false;
+}
+
+inline int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        mockSpiPeripheral.exchange(src[i]);
+    }
+    return len;
+}
+
+inline int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        dst[i] = mockSpiPeripheral.exchange(repeated_tx_data);
+    }
+    return len;
+}
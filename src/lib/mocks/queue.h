@@ -64,11 +64,17 @@ inline void vQueueDelete( QueueHandle_t xQueue )
     //printf("vQueueDelete\n");
 }
 
+inline BaseType_t xQueueTakeMutexRecursiveReturn = pdTRUE;
+inline QueueHandle_t xQueueTakeMutexRecursiveBusy = nullptr; // Mutex that is held by another task
 inline BaseType_t xQueueTakeMutexRecursive( QueueHandle_t xMutex,
     TickType_t xTicksToWait )
 {
     //printf("xQueueTakeMutexRecursive\n");
-    return pdTRUE;
+    if (xMutex != nullptr && xMutex == xQueueTakeMutexRecursiveBusy)
+    {
+        return pdFALSE;
+    }
+    return xQueueTakeMutexRecursiveReturn;
 }
 
 inline BaseType_t xQueueGiveMutexRecursive(QueueHandle_t xMutex)
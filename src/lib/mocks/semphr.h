@@ -7,10 +7,12 @@
 
 // typedef QueueHandle_t SemaphoreHandle_t;
 
+// Each mutex gets it's own handle, so a test can make one of them busy with xQueueTakeMutexRecursiveBusy
+inline uintptr_t xSemaphoreCreateRecursiveMutexCount = 0;
 inline SemaphoreHandle_t xSemaphoreCreateRecursiveMutex()
 {
     printf("xSemaphoreCreateRecursiveMutex\n");
-    return NULL;
+    return reinterpret_cast<SemaphoreHandle_t>(++xSemaphoreCreateRecursiveMutexCount);
 }
 
 #define vSemaphoreDelete(xSemaphore) vQueueDelete((QueueHandle_t)(xSemaphore))
@@ -41,6 +41,8 @@ inline TaskHandle_t xTaskCreateStatic(TaskFunction_t pxTaskCode,
     return pdPASS;
 }
 
+// Bits set from an ISR, returned by xTaskNotifyWait
+inline uint32_t xTaskNotifyFromISRValue = 0;
 inline BaseType_t xTaskGenericNotifyFromISR(TaskHandle_t xTaskToNotify,
     UBaseType_t uxIndexToNotify,
     uint32_t ulValue,
@@ -49,6 +51,7 @@ inline BaseType_t xTaskGenericNotifyFromISR(TaskHandle_t xTaskToNotify,
     BaseType_t *pxHigherPriorityTaskWoken)
 {
     printf("xTaskGenericNotifyFromISR\n");
+    xTaskNotifyFromISRValue |= ulValue;
     return 0;
 }
 
@@ -87,10 +90,41 @@ inline uint32_t ulTaskGenericNotifyTake(UBaseType_t uxIndexToWaitOn,
 #define ulTaskNotifyTakeIndexed(uxIndexToWaitOn, xClearCountOnExit, xTicksToWait) \
     ulTaskGenericNotifyTake((uxIndexToWaitOn), (xClearCountOnExit), (xTicksToWait))
 
+// Returns pdFALSE (timeout) when nothing was notified
+inline BaseType_t xTaskNotifyWait(uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t *pulNotificationValue, TickType_t xTicksToWait)
+{
+    xTaskNotifyFromISRValue &= ~ulBitsToClearOnEntry;
+    if (xTaskNotifyFromISRValue == 0)
+    {
+        return pdFALSE;
+    }
+    *pulNotificationValue = xTaskNotifyFromISRValue;
+    xTaskNotifyFromISRValue &= ~ulBitsToClearOnExit;
+    return pdTRUE;
+}
+
+// Returns the value before the bits were cleared
+inline uint32_t ulTaskNotifyValueClear(TaskHandle_t xTask, uint32_t ulBitsToClear)
+{
+    uint32_t value = xTaskNotifyFromISRValue;
+    xTaskNotifyFromISRValue &= ~ulBitsToClear;
+    return value;
+}
+
+#define taskSCHEDULER_SUSPENDED 0
+#define taskSCHEDULER_NOT_STARTED 1
+#define taskSCHEDULER_RUNNING 2
+inline BaseType_t xTaskGetSchedulerStateValue = taskSCHEDULER_RUNNING;
+inline BaseType_t xTaskGetSchedulerState(void)
+{
+    return xTaskGetSchedulerStateValue;
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandleValue = nullptr;
 inline TaskHandle_t xTaskGetCurrentTaskHandle(void)
 {
     printf("xTaskGetCurrentTaskHandle\n");
-    return nullptr;
+    return xTaskGetCurrentTaskHandleValue;
 }
 
 inline TickType_t xTaskGetTickCount(void)
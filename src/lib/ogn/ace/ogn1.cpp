@@ -10,12 +10,6 @@ constexpr float POSITION_ENDECODE = 1.f / POSITION_DECODE;
 
 OpenAce::PostConstruct Ogn1::postConstruct()
 {
-    frameConsumerQueue = xQueueCreate(4, sizeof(OpenAce::RadioRxFrame));
-    if (frameConsumerQueue == nullptr)
-    {
-        return OpenAce::PostConstruct::XQUEUE_ERROR;
-    }
-
     if (sizeof(OGN1_Packet) != OGN_PACKET_LENGTH_FEC + 2) // 20byte + FEC == 6 byte + 2 extra for the word that is ignored
     {
         panic("OGN1 packet is smaller than expected");
@@ -30,17 +24,16 @@ void Ogn1::start()
     xTaskCreate(ognReceiveTask, "ognReceiveTask", configMINIMAL_STACK_SIZE + 1024, this, tskIDLE_PRIORITY, &taskHandle);
     // auto tuner = static_cast<Tuner *>(BaseModule::moduleByName(*this, Tuner::NAME));
     // tuner->startListen(OpenAce::DataSource::OGN1);
-    getBus().subscribe(*this);
+    subscribe(*this);
 };
 
 void Ogn1::stop()
 {
-    getBus().unsubscribe(*this);
+    unsubscribe(*this);
     // auto tuner = static_cast<Tuner *>(BaseModule::moduleByName(*this, Tuner::NAME));
     // tuner->stopListen(OpenAce::DataSource::OGN1);
 
     vTaskDelete(taskHandle);
-    vQueueDelete(frameConsumerQueue);
 };
 
 void Ogn1::getData(etl::string_stream &stream, const etl::string_view path) const
@@ -112,15 +105,18 @@ uint8_t Ogn1::ErrCount(const uint8_t *output, const uint8_t *data, const uint8_t
     return count;
 }
 
-uint8_t Ogn1::errorCorrect(uint8_t *output, uint8_t *data, uint8_t *err, uint8_t iter)
+uint8_t Ogn1::errorCorrect(uint8_t *output, uint8_t *data, uint8_t *err, int8_t rssidBm, uint8_t iter)
 {
-    uint8_t check = 0;
     uint8_t errCount = ErrCount(err, OGN_PACKET_LENGTH); // conunt Manchester decoding errors
-    decoder.Input(data, err);                            // put data into the FEC decoder
-    do                                                   // more loops is more chance to recover the packet
+    if (softDecision)
     {
-        check = decoder.ProcessChecks(); // do an iteration
-    } while ((iter--) && check); // if FEC all fine: break
+        decoder.Input(data, err, rssidBm); // grade bits next to Manchester errors
+    }
+    else
+    {
+        decoder.Input(data, err);
+    }
+    uint8_t check = decoder.Decode(iter); // more loops is more chance to recover the packet
     decoder.Output(output); // get corrected bytes into the OGN packet
     errCount += ErrCount(output, data, err, OGN_PACKET_LENGTH);
 
@@ -292,21 +288,22 @@ void Ogn1::on_receive(const OpenAce::RadioTxPositionRequest &msg)
 void Ogn1::ognReceiveTask(void *arg)
 {
     Ogn1 *ogn1 = static_cast<Ogn1 *>(arg);
+    OGN1_Packet packet;
+    OpenAce::RadioRxFrame msg;
     while (true)
     {
-        OGN1_Packet packet;
-        OpenAce::RadioRxFrame msg;
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
         // msg length expected to be 0x1a == 26byte
-        if (xQueueReceive(ogn1->frameConsumerQueue, &msg, portMAX_DELAY) == pdPASS)
+        while (ogn1->frameRing.pop(msg))
         {
             // Validate packet, and correct if possible
-            uint8_t check = ogn1->errorCorrect((uint8_t *)&packet, (uint8_t *)msg.frame, (uint8_t *)msg.err);
+            uint8_t check = ogn1->errorCorrect((uint8_t *)&packet, (uint8_t *)msg.frame(), (uint8_t *)msg.err(), msg.rssidBm);
             if (check & 0x0F)
             {
                 ogn1->statistics.fecErrors++;
                 continue;
             }
-            // dumpBuffer((uint8_t*)msg.frame, msg.length);
+            // dumpBuffer((uint8_t*)msg.frame(), msg.length);
             packet.Dewhiten();
             if (packet.Header.Encrypted)
             {
@@ -328,13 +325,13 @@ void Ogn1::ognReceiveTask(void *arg)
 
 void Ogn1::on_receive(const OpenAce::RadioRxFrame &msg)
 {
-    if (msg.dataSource == OpenAce::DataSource::OGN1)
+    if (frameRing.push(msg))
     {
-        const OpenAce::RadioRxFrame cpy = msg;
-        if (xQueueSendToBack(frameConsumerQueue, &cpy, TASK_DELAY_MS(5)) != pdPASS)
-        {
-            statistics.queueFull++;
-        }
+        xTaskNotify(taskHandle, 1, eSetBits);
+    }
+    else
+    {
+        statistics.queueFull++;
     }
 }
 
@@ -27,6 +27,7 @@
 #include "ace/messages.hpp"
 #include "ace/utils.hpp"
 #include "ace/coreutils.hpp"
+#include "ace/mpscring.hpp"
 #include "ace/basemodule.hpp"
 
 /* Utils. */
@@ -67,19 +68,20 @@ class Ogn1 : public BaseModule, public etl::message_router<Ogn1, OpenAce::RadioR
     etl::vector<DataSourceTimeStats, 2> dataSourceTimeStats;
 
     TaskHandle_t taskHandle;
-    QueueHandle_t frameConsumerQueue;
+    OpenAce::MpscRing<OpenAce::RadioRxFrame, 4> frameRing;
     OpenAce::OwnshipPositionInfo ownshipPosition;
     OpenAce::BarometricPressure lastBarometricPressure;
     OpenAce::GpsStatsMsg gpsStats;
     OpenAce::Config::OpenAceConfiguration openAceConfiguration;
     uint16_t distanceIgnore;
-    LDPC_Decoder<OGN_PACKET_LENGTH*8, 48> decoder;
+    bool softDecision;
+    LDPC_FastDecoder decoder;
 public:
     static constexpr const etl::string_view NAME = "Ogn1";
     Ogn1(etl::imessage_bus& bus, const Configuration &config) :
         BaseModule(bus, NAME),
+        message_router(OpenAce::lockFreeRouterId(OpenAce::DataSource::OGN1)),
         taskHandle(nullptr),
-        frameConsumerQueue(nullptr),
         ownshipPosition(),
         lastBarometricPressure(),
         gpsStats(),
@@ -87,6 +89,7 @@ public:
     {
         int32_t v = config.valueByPath(25000, "Ogn1", "distanceIgnore");
         distanceIgnore = std::max((int32_t)0, std::min(v, MAX_IGNORE_DISTANCE));
+        softDecision = config.valueByPath(true, "Ogn1", "softDecision");
     }
 
     virtual ~Ogn1() = default;
@@ -98,8 +101,10 @@ public:
 
 private:
     /**
-     * Send a FreeRTOS message when a OgnFrame is received
+     * Push the OgnFrame in the frame ring and notify the receive task
      * This will release the sender from the task and allow it to continue in a seperate thread
+     * Called without the bus mutex, so only touch the ring here
+     * The bus only delivers frames from our own DataSource
     */
     void on_receive(const OpenAce::RadioRxFrame &msg);
     void on_receive(const OpenAce::OwnshipPositionMsg &msg);
@@ -130,7 +135,7 @@ private:
 
     uint8_t ErrCount(const uint8_t *err, uint8_t length) const;
     uint8_t ErrCount(const uint8_t *output,const uint8_t *data, const uint8_t *err, uint8_t length) const;
-    uint8_t errorCorrect(uint8_t *output, uint8_t *data, uint8_t *err, uint8_t iter=32);
+    uint8_t errorCorrect(uint8_t *output, uint8_t *data, uint8_t *err, int8_t rssidBm, uint8_t iter=32);
 
 
 };
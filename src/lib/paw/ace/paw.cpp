@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "paw.hpp"
+
+OpenAce::PostConstruct Paw::postConstruct()
+{
+    return OpenAce::PostConstruct::OK;
+}
+
+void Paw::start()
+{
+    xTaskCreate(pawReceiveTask, "pawReceiveTask", configMINIMAL_STACK_SIZE + 256, this, tskIDLE_PRIORITY, &taskHandle);
+    subscribe(*this);
+};
+
+void Paw::stop()
+{
+    unsubscribe(*this);
+    vTaskDelete(taskHandle);
+};
+
+void Paw::getData(etl::string_stream &stream, const etl::string_view path) const
+{
+    (void)path;
+    stream << "{";
+    stream << "\"receivedAircraftPositions\":" << statistics.receivedAircraftPositions;
+    stream << ",\"crcErrors\":" << statistics.crcErrors;
+    stream << ",\"invalidFrames\":" << statistics.invalidFrames;
+    stream << ",\"outOfDistance\":" << statistics.outOfDistance;
+    stream << ",\"queueFullErr\":" << statistics.queueFullErr;
+    stream << "}\n";
+}
+
+void Paw::on_receive(const OpenAce::RadioRxFrame &msg)
+{
+    if (frameRing.push(msg))
+    {
+        xTaskNotify(taskHandle, 1, eSetBits);
+    }
+    else
+    {
+        statistics.queueFullErr++;
+    }
+}
+
+void Paw::on_receive(const OpenAce::OwnshipPositionMsg &msg)
+{
+    ownshipPosition = msg.position;
+}
+
+void Paw::dewhiten(uint8_t *frame, uint8_t length)
+{
+    for (uint8_t i = 0; i < length && i < WHITENING.size(); i++)
+    {
+        uint8_t b = frame[i];
+        b = ((b & 0xF0) >> 4) | ((b & 0x0F) << 4);
+        b = ((b & 0xCC) >> 2) | ((b & 0x33) << 2);
+        b = ((b & 0xAA) >> 1) | ((b & 0x55) << 1);
+        frame[i] = b ^ WHITENING[i];
+    }
+}
+
+uint8_t Paw::crc8(const uint8_t *data, uint8_t length)
+{
+    uint8_t crc = CRC_SEED;
+    for (uint8_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+bool Paw::decodePacket(const uint8_t *frame, Packet &packet)
+{
+    // 0 sync, 1..4 ICAO address, 5..8 longitude, 9..12 latitude, 13..14 altitude, 15..16 track, 17..18 knots,
+    // 19 vertical speed, 20 aircraft type, 21 GPS fix, 22 sequence. All little endian
+    if (frame[0] != PACKET_SYNC)
+    {
+        return false;
+    }
+
+    packet.address = (frame[1] | (frame[2] << 8) | (frame[3] << 16));
+    memcpy(&packet.lon, frame + 5, sizeof(float));
+    memcpy(&packet.lat, frame + 9, sizeof(float));
+    packet.altitude = frame[13] | (frame[14] << 8);
+    packet.track = frame[15] | (frame[16] << 8);
+    packet.groundSpeed = frame[17] | (frame[18] << 8);
+    packet.verticalSpeed = (int8_t)frame[19];
+    packet.aircraftType = frame[20] & 0x0F;
+    return true;
+}
+
+int8_t Paw::handleFrame(const uint8_t *frame, uint8_t length, int8_t rssidBm)
+{
+    if (length < FRAME_LENGTH)
+    {
+        statistics.invalidFrames++;
+        return -2;
+    }
+
+    // Work on a copy, the pool buffer is shared
+    uint8_t work[FRAME_LENGTH];
+    memcpy(work, frame, FRAME_LENGTH);
+    dewhiten(work, FRAME_LENGTH);
+    if (crc8(work, FRAME_LENGTH - 1) != work[FRAME_LENGTH - 1])
+    {
+        statistics.crcErrors++;
+        return -3;
+    }
+
+    Packet packet;
+    if (!decodePacket(work, packet))
+    {
+        statistics.invalidFrames++;
+        return -2;
+    }
+
+    return parseFrame(packet, rssidBm);
+}
+
+int8_t Paw::parseFrame(const Packet &packet, int8_t rssidBm)
+{
+    OpenAce::positionTs positionTs = CoreUtils::getPositionTs();
+
+    auto fromOwn = CoreUtils::getDistanceRelNorthRelEastInt(ownshipPosition.lat, ownshipPosition.lon, packet.lat, packet.lon);
+    if (fromOwn.distance > distanceIgnore)
+    {
+        statistics.outOfDistance++;
+        return -1;
+    }
+
+    OpenAce::IcaoAddress icaoAddress;
+    etl::string_stream stream(icaoAddress);
+    stream << etl::hex << packet.address;
+
+    float groundSpeed = packet.groundSpeed * KN_TO_MS;
+    OpenAce::AircraftPositionMsg aircraftPosition{
+        OpenAce::AircraftPositionInfo{
+            positionTs,
+            icaoAddress,
+            packet.address,
+            OpenAce::AddressType::ICAO,
+            OpenAce::DataSource::PAW,
+            static_cast<OpenAce::AircraftCategory>(packet.aircraftType), // We can cast this because AircraftCategory follows FLARM spec
+            false,
+            false,
+            groundSpeed > OpenAce::GROUNDSPEED_CONSIDERING_AIRBORN, // PAW has no airborne flag
+            packet.lat,
+            packet.lon,
+            static_cast<int16_t>(packet.altitude),
+            static_cast<float>(packet.verticalSpeed),
+            groundSpeed,
+            static_cast<int16_t>(packet.track % 360),
+            0.0f,
+            static_cast<uint16_t>(fromOwn.distance),
+            fromOwn.relNorth,
+            fromOwn.relEast,
+            fromOwn.bearing},
+        rssidBm};
+    statistics.receivedAircraftPositions++;
+    getBus().receive(aircraftPosition);
+    return 0;
+}
+
+void Paw::pawReceiveTask(void *arg)
+{
+    Paw *paw = static_cast<Paw *>(arg);
+    OpenAce::RadioRxFrame msg;
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        // Frames are not Manchester encoded, the CRC is checked here
+        while (paw->frameRing.pop(msg))
+        {
+            paw->handleFrame((const uint8_t *)msg.frame(), msg.length, msg.rssidBm);
+        }
+    }
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+/* System. */
+#include <stdint.h>
+#include <algorithm>
+
+/* Vendor. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* PICO. */
+#include "pico/stdlib.h"
+
+/* Vendor. */
+#include "etl/message_bus.h"
+#include "etl/string.h"
+#include "etl/array.h"
+
+/* OpenACE. */
+#include "ace/constants.hpp"
+#include "ace/messagerouter.hpp"
+#include "ace/basemodule.hpp"
+#include "ace/messages.hpp"
+#include "ace/coreutils.hpp"
+#include "ace/mpscring.hpp"
+
+/**
+ * PilotAware (P3I) receiver, mostly seen in the UK
+ * Frames are send with 2-FSK at 38.4kbps on 869.525Mhz without Manchester encoding. The radio receives them in the PAW slot
+ * of the tuner as 24 bytes with the bits of each byte reversed. After reversing the bits and removing the whitening
+ * the frame holds a 23 byte packet followed by a CRC8.
+ *
+ * Based on the P3I protocol of SoftRF https://github.com/lyusupov/SoftRF
+ */
+class Paw : public BaseModule, public etl::message_router<Paw,
+    OpenAce::RadioRxFrame,
+    OpenAce::OwnshipPositionMsg>
+{
+    static constexpr int32_t DEFAULT_IGNORE_DISTANCE = 25000;
+    static constexpr int32_t MAX_IGNORE_DISTANCE = 50000;
+
+    static constexpr uint8_t FRAME_LENGTH = 24;  // Packet length including the CRC
+    static constexpr uint8_t PACKET_SYNC = 0x24; // First byte of each packet
+    static constexpr uint8_t CRC_SEED = 0x71;
+
+    // Whitening pattern of the NiceRF modules used by PilotAware, only the first FRAME_LENGTH bytes are used
+    static constexpr etl::array<uint8_t, FRAME_LENGTH> WHITENING{
+        0x05, 0xB4, 0x05, 0xAE, 0x14, 0xDA, 0xBF, 0x83, 0xC4, 0x04, 0xB2, 0x04,
+        0xD6, 0x4D, 0x87, 0xE2, 0x01, 0xA3, 0x26, 0xAC, 0xBB, 0x63, 0xF1, 0x01};
+
+    friend class message_router;
+public:
+    struct Packet
+    {
+        OpenAce::AircraftAddress address; // ICAO address
+        float lat;
+        float lon;
+        uint16_t altitude;     // in meters
+        uint16_t track;        // 0..359
+        uint16_t groundSpeed;  // in knots
+        int8_t verticalSpeed;  // in m/s
+        uint8_t aircraftType;  // Same numbering as FLARM
+    };
+
+private:
+    mutable struct
+    {
+        uint32_t receivedAircraftPositions = 0;
+        uint32_t crcErrors = 0;
+        uint32_t invalidFrames = 0;
+        uint32_t outOfDistance = 0;
+        uint32_t queueFullErr = 0;
+    } statistics;
+
+    TaskHandle_t taskHandle;
+    OpenAce::MpscRing<OpenAce::RadioRxFrame, 4> frameRing;
+    OpenAce::OwnshipPositionInfo ownshipPosition;
+    uint16_t distanceIgnore;
+
+public:
+    static constexpr const etl::string_view NAME = "Paw";
+    Paw(etl::imessage_bus &bus, const Configuration &config) :
+        BaseModule(bus, NAME),
+        message_router(OpenAce::lockFreeRouterId(OpenAce::DataSource::PAW)),
+        taskHandle(nullptr),
+        ownshipPosition()
+    {
+        int32_t v = config.valueByPath(DEFAULT_IGNORE_DISTANCE, "Paw", "distanceIgnore");
+        distanceIgnore = std::max((int32_t)0, std::min(v, MAX_IGNORE_DISTANCE));
+    }
+
+    virtual ~Paw() = default;
+
+    virtual OpenAce::PostConstruct postConstruct() override;
+    virtual void start() override;
+    virtual void stop() override;
+    virtual void getData(etl::string_stream &stream, const etl::string_view path) const override;
+
+    /**
+     * Reverse the bits and remove the whitening of a frame as received by the radio, in place
+     */
+    static void dewhiten(uint8_t *frame, uint8_t length);
+
+    /**
+     * CRC8 (polynomial 0x07) with the PilotAware seed over length bytes
+     */
+    static uint8_t crc8(const uint8_t *data, uint8_t length);
+
+    /**
+     * Decode a dewhitened frame, returns false when the frame does not start with the packet sync byte
+     */
+    static bool decodePacket(const uint8_t *frame, Packet &packet);
+
+private:
+    /**
+     * Push the PAW frame in the frame ring and notify the receive task
+     * Called without the bus mutex, so only touch the ring here
+     * The bus only delivers frames from our own DataSource
+    */
+    void on_receive(const OpenAce::RadioRxFrame &msg);
+    void on_receive(const OpenAce::OwnshipPositionMsg &msg);
+    void on_receive_unknown(const etl::imessage &msg)
+    {
+        (void)msg;
+    }
+
+    /**
+     * Dewhiten, CRC check and decode a received frame and send the position on the bus
+     * Returns 0 when an aircraft position was send, negative otherwise
+     */
+    int8_t handleFrame(const uint8_t *frame, uint8_t length, int8_t rssidBm);
+    int8_t parseFrame(const Packet &packet, int8_t rssidBm);
+
+    static void pawReceiveTask(void *arg);
+};
@@ -0,0 +1,124 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+
+#define private public
+
+#include <string.h>
+
+#include "mockconfig.h"
+
+#include "pico/time.h"
+#include "paw.hpp"
+
+OpenAce::ThreadSafeBus<50> bus;
+MockConfig mockConfig{bus};
+Paw paw{bus, mockConfig};
+
+/**
+ * Build a frame as the radio would receive it: CRC, whitening and reversed bits
+ */
+static void pawFrame(uint8_t *frame, float lat, float lon)
+{
+    uint8_t packet[Paw::FRAME_LENGTH] = {
+        0x24,                   // Sync
+        0x56, 0x34, 0x40, 0x00, // ICAO 403456
+        0, 0, 0, 0,             // Longitude
+        0, 0, 0, 0,             // Latitude
+        0xF4, 0x01,             // 500m
+        0x0E, 0x01,             // 270 degrees
+        0x50, 0x00,             // 80 knots
+        0xFE,                   // -2 m/s
+        0x08,                   // Reciprocating engine
+        0x03,                   // GPS fix
+        0x11,                   // Sequence
+        0x00};
+    memcpy(packet + 5, &lon, sizeof(float));
+    memcpy(packet + 9, &lat, sizeof(float));
+    packet[Paw::FRAME_LENGTH - 1] = Paw::crc8(packet, Paw::FRAME_LENGTH - 1);
+
+    for (uint8_t i = 0; i < Paw::FRAME_LENGTH; i++)
+    {
+        uint8_t b = packet[i] ^ Paw::WHITENING[i];
+        uint8_t reversed = 0;
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            reversed |= ((b >> bit) & 0x01) << (7 - bit);
+        }
+        frame[i] = reversed;
+    }
+}
+
+TEST_CASE("crc8", "[single-file]")
+{
+    // CRC-8 with polynomial 0x07 of "123456789" is 0xF4 with a seed of 0, 0x1F with the PAW seed
+    const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    REQUIRE(Paw::crc8(check, sizeof(check)) == 0x1F);
+
+    // Zero length returns the seed
+    REQUIRE(Paw::crc8(check, 0) == 0x71);
+}
+
+TEST_CASE("dewhiten and decode", "[single-file]")
+{
+    uint8_t frame[Paw::FRAME_LENGTH];
+    pawFrame(frame, 51.5f, -0.12f);
+    Paw::dewhiten(frame, Paw::FRAME_LENGTH);
+    REQUIRE(frame[0] == 0x24);
+    REQUIRE(Paw::crc8(frame, Paw::FRAME_LENGTH - 1) == frame[Paw::FRAME_LENGTH - 1]);
+
+    Paw::Packet packet;
+    REQUIRE(Paw::decodePacket(frame, packet));
+    REQUIRE(packet.address == 0x403456);
+    REQUIRE(packet.lat == Catch::Approx(51.5f));
+    REQUIRE(packet.lon == Catch::Approx(-0.12f));
+    REQUIRE(packet.altitude == 500);
+    REQUIRE(packet.track == 270);
+    REQUIRE(packet.groundSpeed == 80);
+    REQUIRE(packet.verticalSpeed == -2);
+    REQUIRE(packet.aircraftType == 8);
+
+    frame[0] = 0x25;
+    REQUIRE_FALSE(Paw::decodePacket(frame, packet));
+}
+
+TEST_CASE("handle received frames", "[single-file]")
+{
+    paw.distanceIgnore = 25000; // MockConfig returns 0 for all values
+    paw.ownshipPosition.lat = 51.51f;
+    paw.ownshipPosition.lon = -0.13f;
+
+    // Sections run the test case from the start, compare to the counts before
+    auto statistics = paw.statistics;
+
+    uint8_t frame[Paw::FRAME_LENGTH];
+    pawFrame(frame, 51.5f, -0.12f);
+    REQUIRE(paw.handleFrame(frame, Paw::FRAME_LENGTH, -90) == 0);
+    REQUIRE(paw.statistics.receivedAircraftPositions == statistics.receivedAircraftPositions + 1);
+
+    SECTION("Received frames are not changed")
+    {
+        uint8_t copy[Paw::FRAME_LENGTH];
+        pawFrame(copy, 51.5f, -0.12f);
+        REQUIRE(memcmp(frame, copy, sizeof(copy)) == 0);
+    }
+
+    SECTION("Bit error")
+    {
+        frame[10] ^= 0x04;
+        REQUIRE(paw.handleFrame(frame, Paw::FRAME_LENGTH, -90) == -3);
+        REQUIRE(paw.statistics.crcErrors == statistics.crcErrors + 1);
+    }
+
+    SECTION("Too short")
+    {
+        REQUIRE(paw.handleFrame(frame, Paw::FRAME_LENGTH - 1, -90) == -2);
+        REQUIRE(paw.statistics.invalidFrames == statistics.invalidFrames + 1);
+    }
+
+    SECTION("Too far away")
+    {
+        paw.ownshipPosition.lat = 52.f;
+        REQUIRE(paw.handleFrame(frame, Paw::FRAME_LENGTH, -90) == -1);
+        REQUIRE(paw.statistics.outOfDistance == statistics.outOfDistance + 1);
+    }
+}
@@ -0,0 +1,134 @@
+#include "airtimeledger.hpp"
+
+AirtimeLedger::Channel *AirtimeLedger::channel(uint32_t frequency)
+{
+    for (auto &entry : channels)
+    {
+        if (entry.frequency == frequency)
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void AirtimeLedger::record(OpenAce::DataSource source, uint32_t frequency, uint32_t airtimeUs, uint32_t nowMs)
+{
+    if (static_cast<size_t>(source) < PROTOCOLS)
+    {
+        auto &protocol = protocols[static_cast<size_t>(source)];
+        protocol.window.add(airtimeUs, nowMs);
+        protocol.lastAirtimeUs = airtimeUs;
+        protocol.transmissions++;
+    }
+
+    auto entry = channel(frequency);
+    if (entry != nullptr)
+    {
+        entry->window.add(airtimeUs, nowMs);
+    }
+}
+
+bool AirtimeLedger::allowed(OpenAce::DataSource source, uint32_t frequency, uint16_t dutyCyclePerMille, uint32_t nowMs)
+{
+    if (dutyCyclePerMille >= CountryRegulations::NO_DUTY_CYCLE)
+    {
+        return true;
+    }
+
+    auto entry = channel(frequency);
+    if (entry == nullptr)
+    {
+        // Take a free entry, or one without airtime in the window. Forgetting airtime could break the duty cycle of that channel
+        for (auto &candidate : channels)
+        {
+            candidate.window.advance(nowMs);
+            if (candidate.frequency == 0 || candidate.window.total() == 0)
+            {
+                entry = &candidate;
+                break;
+            }
+        }
+        if (entry == nullptr)
+        {
+            return block(source);
+        }
+        *entry = Channel{frequency, dutyCyclePerMille, Window{}};
+    }
+    entry->dutyCyclePerMille = dutyCyclePerMille;
+
+    entry->window.advance(nowMs);
+    uint32_t estimateUs = 0;
+    if (static_cast<size_t>(source) < PROTOCOLS)
+    {
+        estimateUs = protocols[static_cast<size_t>(source)].lastAirtimeUs;
+    }
+    if (entry->window.total() + estimateUs <= budgetUs(dutyCyclePerMille))
+    {
+        return true;
+    }
+
+    return block(source);
+}
+
+bool AirtimeLedger::block(OpenAce::DataSource source)
+{
+    if (static_cast<size_t>(source) < PROTOCOLS)
+    {
+        protocols[static_cast<size_t>(source)].blocked++;
+    }
+    return false;
+}
+
+uint32_t AirtimeLedger::channelAirtimeUs(uint32_t frequency, uint32_t nowMs)
+{
+    auto entry = channel(frequency);
+    if (entry == nullptr)
+    {
+        return 0;
+    }
+    entry->window.advance(nowMs);
+    return entry->window.total();
+}
+
+uint32_t AirtimeLedger::protocolAirtimeUs(OpenAce::DataSource source, uint32_t nowMs)
+{
+    if (static_cast<size_t>(source) >= PROTOCOLS)
+    {
+        return 0;
+    }
+    auto &window = protocols[static_cast<size_t>(source)].window;
+    window.advance(nowMs);
+    return window.total();
+}
+
+void AirtimeLedger::getData(etl::string_stream &stream, uint32_t nowMs)
+{
+    // Utilization in permille of the hour, 10 is the 1% duty cycle limit of most channels
+    stream << "\"airtime\":{";
+    for (size_t i = 0; i < PROTOCOLS; i++)
+    {
+        auto source = static_cast<OpenAce::DataSource>(i);
+        const auto &protocol = protocols[i];
+        stream << (i == 0 ? "" : ",") << "\"" << OpenAce::dataSourceToString(source) << "\":{";
+        stream << "\"transmissions\":" << protocol.transmissions;
+        stream << ",\"blocked\":" << protocol.blocked;
+        stream << ",\"lastAirtimeUs\":" << protocol.lastAirtimeUs;
+        stream << ",\"utilizationPerMille\":" << protocolAirtimeUs(source, nowMs) / WINDOW_MS;
+        stream << "}";
+    }
+    stream << "},\"channels\":[";
+    bool first = true;
+    for (auto &entry : channels)
+    {
+        if (entry.frequency != 0)
+        {
+            stream << (first ? "" : ",") << "{\"frequency\":" << entry.frequency;
+            stream << ",\"dutyCyclePerMille\":" << entry.dutyCyclePerMille;
+            stream << ",\"utilizationPerMille\":" << channelAirtimeUs(entry.frequency, nowMs) / WINDOW_MS;
+            stream << "}";
+            first = false;
+        }
+    }
+    stream << "]";
+}
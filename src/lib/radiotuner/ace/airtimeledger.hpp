@@ -0,0 +1,146 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "ace/models.hpp"
+
+#include "countryregulations.hpp"
+
+#include "etl/array.h"
+#include "etl/string_stream.h"
+
+/**
+ * Keeps track of the time on air of all transmissions so the duty cycle of a channel stays within the regulations.
+ * The airtime is reported by the radio when the transmission is done, RadioTunerTx asks the ledger before it requests a transmission.
+ *
+ * - Airtime is kept in a rolling window of an hour made of BUCKETS buckets, so the window is between 55 and 60 minutes long.
+ * - Only channels with a duty cycle limit are kept, up to MAX_CHANNELS. Hopping bands have no duty cycle and would only churn the table.
+ *   An entry is only reused when it has no airtime left in the window, until then transmissions on a new channel are blocked.
+ * - Each protocol keeps it's own window for the utilization statistics and the airtime of the last transmission,
+ *   which is used as the estimate of the next transmission.
+ */
+class AirtimeLedger
+{
+public:
+    static constexpr uint32_t WINDOW_MS = 3'600'000;            // Duty cycles are measured over an hour
+    static constexpr uint8_t BUCKETS = 12;
+    static constexpr uint32_t BUCKET_MS = WINDOW_MS / BUCKETS;
+    static constexpr size_t MAX_CHANNELS = 6;
+    static constexpr size_t PROTOCOLS = static_cast<size_t>(OpenAce::DataSource::_TRANSPROTOCOLS);
+
+private:
+    /**
+     * Airtime in us over the last hour
+     */
+    struct Window
+    {
+        etl::array<uint32_t, BUCKETS> airtimeUs = {};
+        uint32_t lastBucket = 0;
+
+        /**
+         * Move the window to nowMs, buckets that fell out of the window are cleared
+         */
+        void advance(uint32_t nowMs)
+        {
+            uint32_t bucket = nowMs / BUCKET_MS;
+            if (static_cast<int32_t>(bucket - lastBucket) <= 0)
+            {
+                // Same bucket, or a transmission that was reported late
+                return;
+            }
+            if (bucket - lastBucket >= BUCKETS)
+            {
+                airtimeUs.fill(0);
+            }
+            else
+            {
+                for (uint32_t b = lastBucket + 1; b <= bucket; b++)
+                {
+                    airtimeUs[b % BUCKETS] = 0;
+                }
+            }
+            lastBucket = bucket;
+        }
+
+        void add(uint32_t airtime, uint32_t nowMs)
+        {
+            advance(nowMs);
+            airtimeUs[lastBucket % BUCKETS] += airtime;
+        }
+
+        uint32_t total() const
+        {
+            uint32_t sum = 0;
+            for (auto airtime : airtimeUs)
+            {
+                sum += airtime;
+            }
+            return sum;
+        }
+    };
+
+    struct Channel
+    {
+        uint32_t frequency = 0; // 0 when the entry is not in use
+        uint16_t dutyCyclePerMille = CountryRegulations::NO_DUTY_CYCLE;
+        Window window;
+    };
+
+    struct Protocol
+    {
+        Window window;
+        uint32_t lastAirtimeUs = 0;
+        uint32_t transmissions = 0;
+        uint32_t blocked = 0;   // Transmissions skipped because the channel was used up or could not be kept
+    };
+
+    etl::array<Channel, MAX_CHANNELS> channels;
+    etl::array<Protocol, PROTOCOLS> protocols;
+
+    /**
+     * Channel entry of the frequency, nullptr when the frequency is not kept
+     */
+    Channel *channel(uint32_t frequency);
+
+    /**
+     * Count a blocked transmission for the protocol, always returns false
+     */
+    bool block(OpenAce::DataSource source);
+
+public:
+    AirtimeLedger() = default;
+
+    /**
+     * Budget in us of airtime in the window for the duty cycle
+     */
+    static constexpr uint32_t budgetUs(uint16_t dutyCyclePerMille)
+    {
+        return WINDOW_MS * dutyCyclePerMille;
+    }
+
+    /**
+     * Add a transmission that ended at nowMs
+     */
+    void record(OpenAce::DataSource source, uint32_t frequency, uint32_t airtimeUs, uint32_t nowMs);
+
+    /**
+     * True when the next transmission of the protocol fits in the duty cycle of the channel at nowMs.
+     * When not allowed the transmission is counted as blocked for the protocol
+     */
+    bool allowed(OpenAce::DataSource source, uint32_t frequency, uint16_t dutyCyclePerMille, uint32_t nowMs);
+
+    /**
+     * Airtime in us of the channel over the last hour, 0 when the channel is not kept
+     */
+    uint32_t channelAirtimeUs(uint32_t frequency, uint32_t nowMs);
+
+    /**
+     * Airtime in us of the protocol over the last hour
+     */
+    uint32_t protocolAirtimeUs(OpenAce::DataSource source, uint32_t nowMs);
+
+    /**
+     * Utilization per protocol and per channel in permille of the hour
+     */
+    void getData(etl::string_stream &stream, uint32_t nowMs);
+};
@@ -38,32 +38,77 @@ CountryRegulations::Zone CountryRegulations::zone(float lat, float lon)
 }
 
 uint32_t CountryRegulations::determineFrequency(const CountryRegulations::ProtocolTimeSlot &protocolTimeSlot)
+{
+    return determineFrequency(protocolTimeSlot, CoreUtils::msSinceEpoch());
+}
+
+uint32_t CountryRegulations::determineFrequency(const CountryRegulations::ProtocolTimeSlot &protocolTimeSlot, uint64_t msSinceEpoch)
+{
+    return channelFrequency(protocolTimeSlot, protocolTimeSlot.channelMethod, msSinceEpoch);
+}
+
+uint32_t CountryRegulations::channelFrequency(const CountryRegulations::ProtocolTimeSlot &protocolTimeSlot, ChannelMethod channel, uint64_t msSinceEpoch)
 {
     auto const &frequency = protocolTimeSlot.frequency;
-    switch (protocolTimeSlot.channelMethod)
+    if (frequency.channels <= 1)
+    {
+        return frequency.baseFrequency;
+    }
+
+    switch (channel)
     {
     case CountryRegulations::ChannelMethod::CHANNEL_0:
         return frequency.baseFrequency;
     case CountryRegulations::ChannelMethod::CHANNEL_1:
         return frequency.baseFrequency + frequency.channelSeperation;
+    case CountryRegulations::ChannelMethod::FLARM_HOPPING:
+    case CountryRegulations::ChannelMethod::OGN_HOPPING:
+        return frequency.baseFrequency + frequency.channelSeperation * hoppingChannel(protocolTimeSlot, channel, msSinceEpoch);
     default:
         return 0;
     }
 }
 
+uint8_t CountryRegulations::hoppingChannel(const CountryRegulations::ProtocolTimeSlot &protocolTimeSlot, ChannelMethod channel, uint64_t msSinceEpoch)
+{
+    auto channels = protocolTimeSlot.frequency.channels;
+    if (channels <= 1)
+    {
+        return 0;
+    }
+
+    uint32_t seconds = msSinceEpoch / 1000;
+    if (CoreUtils::msInSecond(msSinceEpoch) < protocolTimeSlot.slotStartTime)
+    {
+        seconds--;
+    }
+    // The first slot has the lowest idx
+    uint8_t slot = protocolTimeSlot.idx <= protocolTimeSlot.nextSlotIdx ? 0 : 1;
+
+    uint8_t flarmChannel = freqHopHash((seconds << 1) + slot) % channels;
+    if (channel != ChannelMethod::OGN_HOPPING)
+    {
+        return flarmChannel;
+    }
+
+    // OGN uses the channel next to FLARM in the first slot, in the second slot the channel FLARM used in the first slot
+    if (slot == 0)
+    {
+        return (flarmChannel + 1) % channels;
+    }
+    uint8_t ognChannel = freqHopHash(seconds << 1) % channels;
+    return ognChannel == flarmChannel ? (ognChannel + 1) % channels : ognChannel;
+}
+
 // New simplified methods
 uint8_t CountryRegulations::getFirstSlotIdx(CountryRegulations::Zone zone, OpenAce::DataSource dataSource)
 {
-
-    for (const auto &slot : timings)
+    if (zone >= ZONES || static_cast<size_t>(dataSource) >= SOURCES)
     {
-        if (slot.source == dataSource && slot.zone == zone)
-        {
-            return slot.idx;
-        }
+        return NONE_DATASOURCE.idx;
     }
 
-    return NONE_DATASOURCE.idx;
+    return slotIndex.first[zone][static_cast<size_t>(dataSource)];
 }
 
 const CountryRegulations::ProtocolTimeSlot &CountryRegulations::protocolTimeslotById(uint8_t idx)
@@ -119,30 +164,27 @@ CountryRegulations::GetNextTxTimeResult CountryRegulations::getNextTxTime(uint16
     return GetNextTxTimeResult{idx, CoreUtils::msDelayToReference(randomTime, msInSecond) };
 }
 
-uint8_t CountryRegulations::nextProtocolTimeslot(uint16_t currentMs, CountryRegulations::Zone zone, OpenAce::DataSource source)
+uint16_t CountryRegulations::msLeftInSlot(const CountryRegulations::ProtocolTimeSlot &protocolTimeSlot, uint16_t msInSecond)
 {
-    currentMs = currentMs % 1000;
-    auto startIdx = getFirstSlotIdx(zone, source);
+    uint16_t ms = msInSecond % 1000;
+    if (ms < protocolTimeSlot.slotStartTime)
+    {
+        ms += 1000;
+    }
+    uint16_t slotEnd = protocolTimeSlot.slotStartTime + protocolTimeSlot.slotDuration;
+    return ms < slotEnd ? slotEnd - ms : 0;
+}
 
-    auto currentIdx = startIdx;
-    for (auto msOffset :
-            {
-                0, 1000
-            })
+uint8_t CountryRegulations::nextProtocolTimeslot(uint16_t currentMs, CountryRegulations::Zone zone, OpenAce::DataSource source)
+{
+    if (zone >= ZONES || static_cast<size_t>(source) >= SOURCES)
     {
-        do
-        {
-            const auto &slot = protocolTimeslotById(currentIdx);
-            if (currentMs <= (slot.slotStartTime + msOffset))
-            {
-                return slot.idx;
-            }
-            currentIdx = slot.nextSlotIdx;
-        }
-        while (currentIdx != startIdx);
+        return NONE_DATASOURCE.idx;
     }
 
-    return NONE_DATASOURCE.idx;
+    // Slots start at a multiple of SLOT_RESOLUTION, so rounding up gives the same slot as the exact time
+    uint8_t step = (currentMs % 1000 + SLOT_RESOLUTION - 1) / SLOT_RESOLUTION;
+    return slotIndex.next[zone][static_cast<size_t>(source)][step];
 }
 
 uint8_t CountryRegulations::findFittingTimeslot(uint16_t currentMs, uint8_t currentIdx)
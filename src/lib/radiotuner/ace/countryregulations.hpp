@@ -1,7 +1,7 @@
 #pragma once
 
 #include <stdint.h>
-#include <stdint.h>
+#include <utility>
 
 #include <etl/array.h>
 
@@ -43,28 +43,34 @@ public:
         uint32_t channelSeperation;
         uint8_t channels;
         int8_t powerdBm;
+        uint16_t dutyCyclePerMille; // Maximum airtime per channel over an hour, 1000 for no limit (frequency hopping bands)
     };
 
+    static constexpr uint16_t NO_DUTY_CYCLE = 1000;
+
     // From https://github.com/VirusPilot/esp32-ogn-tracker
-    static constexpr Frequency Europe{868'200'000, 200'000, 02, 14};
-    static constexpr Frequency NorthAmerica{902'200'000, 400'000, 65, 30};
-    static constexpr Frequency NewZealand{869'250'000, 200'000, 01, 10};
-    static constexpr Frequency Australia{917'000'000, 400'000, 24, 30};
-    static constexpr Frequency Israel{916'200'000, 200'000, 01, 22};
-    static constexpr Frequency SouthAmerica{917'000'000, 400'000, 24, 30};
-    static constexpr Frequency EuropeFanet{869'525'000, 000'000, 00, 14};
+    // Duty cycles from ETSI EN 300 220 (868.0-868.6Mhz 1%, 869.4-869.65Mhz 10%), the hopping bands have a dwell time limit instead
+    static constexpr Frequency Europe{868'200'000, 200'000, 02, 14, 10};
+    static constexpr Frequency NorthAmerica{902'200'000, 400'000, 65, 30, NO_DUTY_CYCLE};
+    static constexpr Frequency NewZealand{869'250'000, 200'000, 01, 10, 10};
+    static constexpr Frequency Australia{917'000'000, 400'000, 24, 30, NO_DUTY_CYCLE};
+    static constexpr Frequency Israel{916'200'000, 200'000, 01, 22, 10};
+    static constexpr Frequency SouthAmerica{917'000'000, 400'000, 24, 30, NO_DUTY_CYCLE};
+    static constexpr Frequency EuropePaw{869'525'000, 000'000, 01, 14, 100};
 
     // First byte of the syncWord is the preamble and currently always one byte
     static constexpr Radio::ProtocolConfig FLARM{Radio::Mode::GFSK, OpenAce::DataSource::FLARM, 24 + 2, 8, {0x55, 0x99, 0xA5, 0xA9, 0x55, 0x66, 0x65, 0x96}};   // 0 FLARM 0 airtime 6ms
     static constexpr Radio::ProtocolConfig OGN1{Radio::Mode::GFSK, OpenAce::DataSource::OGN1, 20 + 6, 8, {0xAA, 0x66, 0x55, 0xA5, 0x96, 0x99, 0x96, 0x5A}};     // 1 OGN 1 airtime 6ms <- This seems to be in use 20 Byte packet length :: 6 byte CRC
     static constexpr Radio::ProtocolConfig ADSL{Radio::Mode::GFSK, OpenAce::DataSource::ADSL, 2 + 20 + 3, 6, {0x55, 0x99, 0x95, 0xA6, 0x9A, 0x65, 0xA9, 0x6A}}; // 3 ADSL == SYNC  0x72 0x4B = Manchester 0x95, 0xA6, 0x9A, 0x65
-    static constexpr Radio::ProtocolConfig PAW{Radio::Mode::GFSK, OpenAce::DataSource::PAW, 00 + 0, 8, {0xB4, 0x2B, 0x00, 0x00, 0x00, 0x00, 0x18, 0x71}};       // 4 PAW
-    static constexpr Radio::ProtocolConfig FANET{Radio::Mode::LORA, OpenAce::DataSource::FANET, 00 + 0, 1, {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}};   // 5 FANET 3
+    static constexpr Radio::ProtocolConfig PAW{Radio::Mode::GFSK_NRZ, OpenAce::DataSource::PAW, 23 + 1, 3, {0x55, 0xB4, 0x2B, 0x00, 0x00, 0x00, 0x00, 0x00}};    // 4 PAW sync 0x2DD4 with the bits reversed, 24 byte whitened packet including CRC8
+    static constexpr Radio::ProtocolConfig FANET{Radio::Mode::LORA, OpenAce::DataSource::FANET, 00 + 0, 1, {0xF1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}};   // 5 FANET 3 LoRa sync word 0xF1, variable length
 
     enum class ChannelMethod : uint8_t
     {
         CHANNEL_0, // Europe has 2 channels channel 0 = 868.2MHz, channel 1 = 868.4MHz
-        CHANNEL_1
+        CHANNEL_1,
+        FLARM_HOPPING, // Channel changes every slot based on the time, see hoppingChannel()
+        OGN_HOPPING    // Next to FLARM in the first slot, FLARM's first slot channel in the second slot
     };
 
     struct ProtocolTimeSlot
@@ -87,36 +93,94 @@ public:
     //        protocol_t protocol;
     static constexpr ProtocolTimeSlot NONE_DATASOURCE = ProtocolTimeSlot{0, 0, CountryRegulations::Zone::ZONE0, OpenAce::DataSource::NONE, Europe, FLARM, 000, 0000, 000, 0000, 00, 000, ChannelMethod::CHANNEL_0};
 
-    // Table with timings for each protocol needs to adhere to the following rules for optimalisation reasons
-    // - Minimum of 1 and a maximum of 2 timings packages
-    // - slotStartTime of the first timeSlot must become before the slotStartTime of the second timeSlot
-    // - slotStartTime must be between 0..1000
-    // - Timeslots may not overlap
-    // - Timeslots may have one gap (see FLARM has a gap of 200ms between 200 and 400ms in the second)
-    // - nextSlotId must contain the index of 'the other' timeslot
-
-    static constexpr etl::array<const ProtocolTimeSlot, 10> timings{
-        NONE_DATASOURCE,
+    /**
+     * A row of the regulation table, the idx and nextSlotIdx of the ProtocolTimeSlot are generated
+     */
+    struct TimeSlot
+    {
+        CountryRegulations::Zone zone;
+        OpenAce::DataSource source;
+        const Frequency &frequency;
+        const Radio::ProtocolConfig &radioConfig;
+        uint16_t slotStartTime;
+        uint16_t slotDuration;
+        uint16_t txMinTime;
+        uint16_t txMaxTime;
+        uint8_t waitAfterCatStart;
+        uint8_t waitAfterCatEnd;
+        ChannelMethod channelMethod;
+    };
 
+    // Table with timings for each protocol needs to adhere to the following rules, they are checked at compile time
+    // - Minimum of 1 and a maximum of 2 timeslots per zone and protocol
+    // - slotStartTime of the first timeSlot must not come after the slotStartTime of the second timeSlot
+    // - slotStartTime must be between 0..1000 and a multiple of SLOT_RESOLUTION
+    // - Timeslots on the same channel may not overlap
+    // - Timeslots may have one gap (see FLARM has a gap of 200ms between 200 and 400ms in the second)
+    // Adding a zone or protocol only needs rows here, timings and slotIndex are generated from them
+    static constexpr etl::array<const TimeSlot, 27> slots{
         // FLARM packages are send/rceived 400..1200ms after PPS channel is based on FLARM_TIME_BASED_2SLOTS. Minimum 600ms between packages, maximum of 1400ms between packages
-        ProtocolTimeSlot{1, 2, CountryRegulations::Zone::ZONE1, OpenAce::DataSource::FLARM, Europe, FLARM, 400, 400, 600, 1400, 15, 150, ChannelMethod::CHANNEL_0},
-        ProtocolTimeSlot{2, 1, CountryRegulations::Zone::ZONE1, OpenAce::DataSource::FLARM, Europe, FLARM, 800, 400, 600, 1400, 15, 150, ChannelMethod::CHANNEL_1},
+        TimeSlot{CountryRegulations::Zone::ZONE1, OpenAce::DataSource::FLARM, Europe, FLARM, 400, 400, 600, 1400, 15, 150, ChannelMethod::CHANNEL_0},
+        TimeSlot{CountryRegulations::Zone::ZONE1, OpenAce::DataSource::FLARM, Europe, FLARM, 800, 400, 600, 1400, 15, 150, ChannelMethod::CHANNEL_1},
 
-        ProtocolTimeSlot{3, 4, CountryRegulations::Zone::ZONE5, OpenAce::DataSource::FLARM, Israel, FLARM, 400, 400, 600, 1400, 15, 150, ChannelMethod::CHANNEL_0},
-        ProtocolTimeSlot{4, 3, CountryRegulations::Zone::ZONE5, OpenAce::DataSource::FLARM, Israel, FLARM, 800, 400, 600, 1400, 15, 150, ChannelMethod::CHANNEL_1},
+        TimeSlot{CountryRegulations::Zone::ZONE5, OpenAce::DataSource::FLARM, Israel, FLARM, 400, 400, 600, 1400, 15, 150, ChannelMethod::CHANNEL_0},
+        TimeSlot{CountryRegulations::Zone::ZONE5, OpenAce::DataSource::FLARM, Israel, FLARM, 800, 400, 600, 1400, 15, 150, ChannelMethod::CHANNEL_1},
 
         // OGN packages are send/rceived 400..1200ms after PPS channel is based on OGN_TIME_BASED_2SLOTS. Minimum 600ms between packages, maximum of 1400ms between packages
-        ProtocolTimeSlot{5, 6, CountryRegulations::Zone::ZONE1, OpenAce::DataSource::OGN1, Europe, OGN1, 400, 400, 600, 1400, 15, 150, ChannelMethod::CHANNEL_1},
-        ProtocolTimeSlot{6, 5, CountryRegulations::Zone::ZONE1, OpenAce::DataSource::OGN1, Europe, OGN1, 800, 400, 600, 1400, 15, 150, ChannelMethod::CHANNEL_0},
+        TimeSlot{CountryRegulations::Zone::ZONE1, OpenAce::DataSource::OGN1, Europe, OGN1, 400, 400, 600, 1400, 15, 150, ChannelMethod::CHANNEL_1},
+        TimeSlot{CountryRegulations::Zone::ZONE1, OpenAce::DataSource::OGN1, Europe, OGN1, 800, 400, 600, 1400, 15, 150, ChannelMethod::CHANNEL_0},
 
         // ADSL
-        ProtocolTimeSlot{7, 8, CountryRegulations::Zone::ZONE1, OpenAce::DataSource::ADSL, Europe, ADSL, 800, 400, 600, 1400, 15, 250, ChannelMethod::CHANNEL_0},
-        ProtocolTimeSlot{8, 7, CountryRegulations::Zone::ZONE1, OpenAce::DataSource::ADSL, Europe, ADSL, 800, 400, 600, 1400, 15, 250, ChannelMethod::CHANNEL_1},
+        TimeSlot{CountryRegulations::Zone::ZONE1, OpenAce::DataSource::ADSL, Europe, ADSL, 800, 400, 600, 1400, 15, 250, ChannelMethod::CHANNEL_0},
+        TimeSlot{CountryRegulations::Zone::ZONE1, OpenAce::DataSource::ADSL, Europe, ADSL, 800, 400, 600, 1400, 15, 250, ChannelMethod::CHANNEL_1},
 
-        // Fanet
-        ProtocolTimeSlot{9, 9, CountryRegulations::Zone::ZONE1, OpenAce::DataSource::FANET, Europe, FANET, 000, 1000, 500, 1500, 00, 000, ChannelMethod::CHANNEL_0},
+        // Fanet is not slotted, but received and send in the 200..400ms gap between the GFSK slots so it does not take receive time from them
+        TimeSlot{CountryRegulations::Zone::ZONE1, OpenAce::DataSource::FANET, Europe, FANET, 200, 200, 500, 1500, 00, 000, ChannelMethod::CHANNEL_0},
+
+        // PilotAware is not slotted and uses a single frequency, receive it at the same time as the other GFSK protocols
+        TimeSlot{CountryRegulations::Zone::ZONE1, OpenAce::DataSource::PAW, EuropePaw, PAW, 400, 400, 600, 1400, 15, 150, ChannelMethod::CHANNEL_0},
+        TimeSlot{CountryRegulations::Zone::ZONE1, OpenAce::DataSource::PAW, EuropePaw, PAW, 800, 400, 600, 1400, 15, 150, ChannelMethod::CHANNEL_0},
+
+        // Outside Europe FLARM and OGN use the same slots, with many channels they hop every slot
+        TimeSlot{CountryRegulations::Zone::ZONE2, OpenAce::DataSource::FLARM, NorthAmerica, FLARM, 400, 400, 600, 1400, 15, 150, ChannelMethod::FLARM_HOPPING},
+        TimeSlot{CountryRegulations::Zone::ZONE2, OpenAce::DataSource::FLARM, NorthAmerica, FLARM, 800, 400, 600, 1400, 15, 150, ChannelMethod::FLARM_HOPPING},
+        TimeSlot{CountryRegulations::Zone::ZONE2, OpenAce::DataSource::OGN1, NorthAmerica, OGN1, 400, 400, 600, 1400, 15, 150, ChannelMethod::OGN_HOPPING},
+        TimeSlot{CountryRegulations::Zone::ZONE2, OpenAce::DataSource::OGN1, NorthAmerica, OGN1, 800, 400, 600, 1400, 15, 150, ChannelMethod::OGN_HOPPING},
+
+        TimeSlot{CountryRegulations::Zone::ZONE3, OpenAce::DataSource::FLARM, NewZealand, FLARM, 400, 400, 600, 1400, 15, 150, ChannelMethod::CHANNEL_0},
+        TimeSlot{CountryRegulations::Zone::ZONE3, OpenAce::DataSource::FLARM, NewZealand, FLARM, 800, 400, 600, 1400, 15, 150, ChannelMethod::CHANNEL_0},
+        TimeSlot{CountryRegulations::Zone::ZONE3, OpenAce::DataSource::OGN1, NewZealand, OGN1, 400, 400, 600, 1400, 15, 150, ChannelMethod::CHANNEL_0},
+        TimeSlot{CountryRegulations::Zone::ZONE3, OpenAce::DataSource::OGN1, NewZealand, OGN1, 800, 400, 600, 1400, 15, 150, ChannelMethod::CHANNEL_0},
+
+        TimeSlot{CountryRegulations::Zone::ZONE4, OpenAce::DataSource::FLARM, Australia, FLARM, 400, 400, 600, 1400, 15, 150, ChannelMethod::FLARM_HOPPING},
+        TimeSlot{CountryRegulations::Zone::ZONE4, OpenAce::DataSource::FLARM, Australia, FLARM, 800, 400, 600, 1400, 15, 150, ChannelMethod::FLARM_HOPPING},
+        TimeSlot{CountryRegulations::Zone::ZONE4, OpenAce::DataSource::OGN1, Australia, OGN1, 400, 400, 600, 1400, 15, 150, ChannelMethod::OGN_HOPPING},
+        TimeSlot{CountryRegulations::Zone::ZONE4, OpenAce::DataSource::OGN1, Australia, OGN1, 800, 400, 600, 1400, 15, 150, ChannelMethod::OGN_HOPPING},
+
+        TimeSlot{CountryRegulations::Zone::ZONE6, OpenAce::DataSource::FLARM, SouthAmerica, FLARM, 400, 400, 600, 1400, 15, 150, ChannelMethod::FLARM_HOPPING},
+        TimeSlot{CountryRegulations::Zone::ZONE6, OpenAce::DataSource::FLARM, SouthAmerica, FLARM, 800, 400, 600, 1400, 15, 150, ChannelMethod::FLARM_HOPPING},
+        TimeSlot{CountryRegulations::Zone::ZONE6, OpenAce::DataSource::OGN1, SouthAmerica, OGN1, 400, 400, 600, 1400, 15, 150, ChannelMethod::OGN_HOPPING},
+        TimeSlot{CountryRegulations::Zone::ZONE6, OpenAce::DataSource::OGN1, SouthAmerica, OGN1, 800, 400, 600, 1400, 15, 150, ChannelMethod::OGN_HOPPING},
     };
 
+    static constexpr size_t ZONES = Zone::ZONE6 + 1;
+    static constexpr size_t SOURCES = static_cast<size_t>(OpenAce::DataSource::_TRANSPROTOCOLS);
+    static constexpr uint16_t SLOT_RESOLUTION = 100;                 // Slots start at a multiple of this
+    static constexpr size_t STEPS = 1000 / SLOT_RESOLUTION + 1;      // Steps of SLOT_RESOLUTION in the second, rounded up
+
+    // NONE_DATASOURCE followed by the slots, the idx of a ProtocolTimeSlot is its position
+    static const etl::array<const ProtocolTimeSlot, slots.size() + 1> timings;
+
+    /**
+     * Direct lookups on zone and protocol
+     */
+    struct SlotIndex
+    {
+        uint8_t first[ZONES][SOURCES];        // First slot of the protocol in the zone
+        uint8_t next[ZONES][SOURCES][STEPS];  // Slot that starts next, indexed on the ms in the second rounded up to SLOT_RESOLUTION
+    };
+    static const SlotIndex slotIndex;
+
 private:
 public:
     // Constructor
@@ -139,6 +203,32 @@ public:
      * \returns the freuwqncy in Hz of the current protocol and the current time
      */
     static uint32_t determineFrequency(const CountryRegulations::ProtocolTimeSlot &protocolTimeSlot);
+    static uint32_t determineFrequency(const CountryRegulations::ProtocolTimeSlot &protocolTimeSlot, uint64_t msSinceEpoch);
+
+    /**
+     * Frequency in Hz of a channel of the timeslot at the given time
+     */
+    static uint32_t channelFrequency(const CountryRegulations::ProtocolTimeSlot &protocolTimeSlot, ChannelMethod channel, uint64_t msSinceEpoch);
+
+    /**
+     * Channel a hopping protocol uses in the timeslot. The second slot runs into the next second, the channel
+     * is based on the second the slot started in
+     * From https://github.com/VirusPilot/esp32-ogn-tracker freqplan.h
+     */
+    static uint8_t hoppingChannel(const CountryRegulations::ProtocolTimeSlot &protocolTimeSlot, ChannelMethod channel, uint64_t msSinceEpoch);
+
+    /**
+     * Hash of the slot time ((UTC seconds << 1) + slot) used by FLARM to hop channels
+     */
+    static constexpr uint32_t freqHopHash(uint32_t time)
+    {
+        time = (time << 15) + (~time);
+        time ^= time >> 12;
+        time += time << 2;
+        time ^= time >> 4;
+        time *= 2057;
+        return time ^ (time >> 16);
+    }
 
     // New Interface
     /**
@@ -166,6 +256,12 @@ public:
     };
     static GetNextTxTimeResult getNextTxTime(uint16_t msInSecond, uint8_t currentIdx);
 
+    /**
+     * Time left in the slot at msInSecond, the second slot of a protocol may run into the next second
+     * \returns 0 when msInSecond is not inside the slot
+     */
+    static uint16_t msLeftInSlot(const CountryRegulations::ProtocolTimeSlot &protocolTimeSlot, uint16_t msInSecond);
+
     /**
      * Based on the current time in Ms, decide for the given zone and protocol what the next timeslot is going to be
      */
@@ -175,4 +271,122 @@ public:
      * Find a timeslot that fits the givenMs
      */
     static uint8_t findFittingTimeslot(uint16_t currentMs, uint8_t currentIdx);
+
+    // ******************** Generation of the tables, only used at compile time ********************
+
+    /**
+     * idx of the other slot of the same zone and protocol, the slot itself when it is the only one
+     */
+    static constexpr uint8_t otherSlotIdx(size_t idx)
+    {
+        for (size_t i = 0; i < slots.size(); i++)
+        {
+            if (i + 1 != idx && slots[i].zone == slots[idx - 1].zone && slots[i].source == slots[idx - 1].source)
+            {
+                return i + 1;
+            }
+        }
+        return idx;
+    }
+
+    static constexpr ProtocolTimeSlot makeTimeslot(size_t idx)
+    {
+        if (idx == 0)
+        {
+            return NONE_DATASOURCE;
+        }
+        const auto &slot = slots[idx - 1];
+        return ProtocolTimeSlot{static_cast<uint8_t>(idx), otherSlotIdx(idx), slot.zone, slot.source, slot.frequency, slot.radioConfig,
+                                slot.slotStartTime, slot.slotDuration, slot.txMinTime, slot.txMaxTime, slot.waitAfterCatStart, slot.waitAfterCatEnd, slot.channelMethod};
+    }
+
+    template <size_t... IDX>
+    static constexpr etl::array<const ProtocolTimeSlot, sizeof...(IDX)> makeTimings(std::index_sequence<IDX...>)
+    {
+        return {{makeTimeslot(IDX)...}};
+    }
+
+    static constexpr SlotIndex makeSlotIndex()
+    {
+        SlotIndex index{};
+        for (size_t i = slots.size(); i > 0; i--)
+        {
+            // Walk backwards so the first slot of a zone and protocol ends up in the index
+            if (static_cast<size_t>(slots[i - 1].source) < SOURCES)
+            {
+                index.first[slots[i - 1].zone][static_cast<size_t>(slots[i - 1].source)] = i;
+            }
+        }
+
+        for (size_t zone = 0; zone < ZONES; zone++)
+        {
+            for (size_t source = 0; source < SOURCES; source++)
+            {
+                uint8_t first = index.first[zone][source];
+                if (first == NONE_DATASOURCE.idx)
+                {
+                    continue;
+                }
+                uint8_t second = otherSlotIdx(first);
+                for (size_t step = 0; step < STEPS; step++)
+                {
+                    // The first slot that did not start yet, after the last slot of the second the first slot of the next second
+                    uint16_t ms = step * SLOT_RESOLUTION;
+                    index.next[zone][source][step] = (ms > slots[first - 1].slotStartTime && ms <= slots[second - 1].slotStartTime) ? second : first;
+                }
+            }
+        }
+        return index;
+    }
+
+    /**
+     * True when the slots follow the rules of the slots table
+     */
+    static constexpr bool validSlots()
+    {
+        for (size_t i = 0; i < slots.size(); i++)
+        {
+            const auto &slot = slots[i];
+            if (slot.slotStartTime >= 1000 || slot.slotStartTime % SLOT_RESOLUTION != 0 || slot.slotDuration == 0 || slot.slotDuration > 1000)
+            {
+                return false;
+            }
+
+            size_t sameProtocol = 0;
+            for (size_t j = 0; j < slots.size(); j++)
+            {
+                const auto &other = slots[j];
+                if (i == j || slot.zone != other.zone || slot.source != other.source)
+                {
+                    continue;
+                }
+                sameProtocol++;
+                // The first slot may not start after the second
+                if (j > i && slot.slotStartTime > other.slotStartTime)
+                {
+                    return false;
+                }
+                // Slots on the same channel may not overlap, also not over the whole second
+                if (slot.channelMethod == other.channelMethod &&
+                    ((other.slotStartTime + 1000 - slot.slotStartTime) % 1000 < slot.slotDuration ||
+                     (slot.slotStartTime + 1000 - other.slotStartTime) % 1000 < other.slotDuration))
+                {
+                    return false;
+                }
+            }
+            if (sameProtocol > 1)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
 };
+
+inline constexpr etl::array<const CountryRegulations::ProtocolTimeSlot, CountryRegulations::slots.size() + 1> CountryRegulations::timings =
+    CountryRegulations::makeTimings(std::make_index_sequence<CountryRegulations::slots.size() + 1>{});
+
+inline constexpr CountryRegulations::SlotIndex CountryRegulations::slotIndex = CountryRegulations::makeSlotIndex();
+
+static_assert(CountryRegulations::validSlots(), "CountryRegulations::slots does not follow the rules, slots overlap or start outside the second");
+static_assert(CountryRegulations::timings.size() < UINT8_MAX, "Slot idx must fit in 8 bits");
@@ -10,19 +10,26 @@
 
 OpenAce::PostConstruct RadioTunerRx::postConstruct()
 {
-    moduleByName(*this, Radio::NAMES[0]);
-    uint8_t numRadios = 1;
-    if (moduleByName(*this, Radio::NAMES[1], false))
+    radios.push_back(static_cast<Radio *>(moduleByName(*this, Radio::NAMES[0])));
+    auto second = static_cast<Radio *>(moduleByName(*this, Radio::NAMES[1], false));
+    if (second && !radios.full())
     {
-        numRadios++;
+        radios.push_back(second);
+    }
+    planner.numRadios = radios.size();
+
+    timerHandle = xTimerCreate("rxTaskTimer", TASK_DELAY_MS(1'000), pdFALSE /* Must not be autostart */, this, timerTuneCallback);
+    if (timerHandle == nullptr)
+    {
+        return OpenAce::PostConstruct::TIMER_ERROR;
     }
-    addRadioTasks(numRadios);
     return OpenAce::PostConstruct::OK;
 }
 
 void RadioTunerRx::start()
 {
-    getBus().subscribe(*this);
+    xTaskCreate(radioTuneTask, "rxTask", configMINIMAL_STACK_SIZE + 64, this, tskIDLE_PRIORITY, &taskHandle);
+    subscribe(*this);
 
     Configuration *config = static_cast<Configuration *>(BaseModule::moduleByName(*this, Configuration::NAME, false));
     if (config)
@@ -33,77 +40,55 @@ void RadioTunerRx::start()
 
 void RadioTunerRx::stop()
 {
-    getBus().unsubscribe(*this);
+    unsubscribe(*this);
 
-    for (auto it = radioTasks.cbegin(); it != radioTasks.cend(); it++)
+    xTimerDelete(timerHandle, TASK_DELAY_MS(2'000));
+    xTaskNotify(taskHandle, TaskState::EXIT, eSetBits);
+    while (eTaskGetState(taskHandle) != eDeleted)
     {
-        xTimerDelete(it->timerHandle, TASK_DELAY_MS(2'000));
-        xTaskNotify(it->taskHandle, TaskState::EXIT, eSetBits);
-        while (eTaskGetState(it->taskHandle) != eDeleted)
-        {
-            vTaskDelay(TASK_DELAY_MS(50));
-        }
+        vTaskDelay(TASK_DELAY_MS(50));
     }
-    radioTasks.clear();
 };
 
-/**
- * Create a tune task per radio
- */
-void RadioTunerRx::addRadioTasks(uint8_t numRadios)
-{
-    for (uint8_t radioNo = 0; radioNo < numRadios; radioNo++)
-    {
-
-        auto radio = static_cast<Radio *>(moduleByName(*this, Radio::NAMES[radioNo], false));
-        auto &ref = radioTasks.emplace_back(this, radio);
-
-        ref.timerHandle = xTimerCreate("rxTaskTimer", TASK_DELAY_MS(1'000), pdFALSE /* Must not be autostart */, &ref, timerTuneCallback);
-        if (ref.timerHandle == nullptr)
-        {
-            radioTasks.pop_back();
-            puts("RadioTunerRx: Failed to create timer.");
-            continue;
-        }
-
-        xTaskCreate(radioTuneTask, "rxTask", configMINIMAL_STACK_SIZE + 64, &ref, tskIDLE_PRIORITY, &ref.taskHandle);
-        if (ref.taskHandle == nullptr)
-        {
-
-            radioTasks.pop_back();
-            puts("RadioTunerRx: Failed to create task.");
-            continue;
-        }
-    }
-}
-
 void RadioTunerRx::getData(etl::string_stream &stream, const etl::string_view path) const
 {
     (void)path;
     stream << "{";
-    for (auto it = radioTasks.cbegin(); it != radioTasks.cend(); ++it)
+    stream << "\"txRadio\":" << planner.txRadio;
+    for (uint8_t r = 0; r < radios.size(); r++)
     {
-        it->getData(stream);
+        const auto &listen = planner.listens[r];
+        stream << ",\"radio_" << r << "\":";
+        stream << "\"" << OpenAce::dataSourceToString(listen.valid() ? listen.slot().source : OpenAce::DataSource::NONE) << "/" << listen.frequency << "\"";
+        stream << ",\"rxRequestsRadio_" << r << "\":" << statistics.rxRequests[r];
     }
+    stream << ",\"windows\":" << statistics.windows;
+    stream << ",\"timerMissed\":" << statistics.timerMissed;
     stream << ",\"zone\":\"" << CountryRegulations::zoneToString(currentZone) << "\"";
+    stream << ",\"slotRates\":[";
+    for (size_t i = 0; i < slotRates.rate.size(); i++)
+    {
+        stream << (i == 0 ? "" : ",") << slotRates.rate[i];
+    }
+    stream << "]";
     stream << "}\n";
 }
 
-//*********************** Tuner tasks ***********************
+//*********************** Tuner task ***********************
 
 /**
- * Call back the task that handle the radio indicating that the wait period is completed and that the radio needs to change to the new datasource
+ * Call back the task that handles the radios indicating that the next window starts
  */
 void RadioTunerRx::timerTuneCallback(TimerHandle_t xTimer)
 {
-    RadioTunerRx::RadioProtocolCtx *taskCtx = (RadioTunerRx::RadioProtocolCtx *)pvTimerGetTimerID(xTimer);
-    xTaskNotify(taskCtx->taskHandle, TaskState::TIMER, eSetBits);
+    RadioTunerRx *tuner = static_cast<RadioTunerRx *>(pvTimerGetTimerID(xTimer));
+    xTaskNotify(tuner->taskHandle, TaskState::TIMER, eSetBits);
 }
 
 void RadioTunerRx::radioTuneTask(void *arg)
 {
     constexpr uint16_t TIMEOUT_DELAY = 2'000;
-    RadioTunerRx::RadioProtocolCtx *taskCtx = static_cast<RadioTunerRx::RadioProtocolCtx *>(arg);
+    RadioTunerRx *tuner = static_cast<RadioTunerRx *>(arg);
     bool taskBlock = false;
     while (true)
     {
@@ -128,33 +113,45 @@ void RadioTunerRx::radioTuneTask(void *arg)
         }
         else if (notifyValue & TaskState::TIMER)
         {
-            if (taskCtx->upcomingTimeslot != CountryRegulations::NONE_DATASOURCE.idx)
-            {
-                // printf("Set frequency to f:%ld ms:%d zone:%d source:%s\n", frequency, CoreUtils::msInSecond(), taskCtx->nextTimeSlot.zone, OpenAce::dataSourceToString(radioTask->nextTimeSlot.source));
-                auto nextTimeSlot = CountryRegulations::protocolTimeslotById(taskCtx->upcomingTimeslot);
-                auto frequency = CountryRegulations::determineFrequency(nextTimeSlot);
-
-                // Send a message to the radio to indicate to switch and listen to a different protocol
-                taskCtx->radio->rxMode(
-                    {Radio::RadioParameters{
-                        nextTimeSlot.radioConfig,
-                        frequency,
-                        nextTimeSlot.frequency.powerdBm}});
-
-                // Set timer for the next slot
-                auto delay = taskCtx->advanceReceiveSlot(taskCtx->controller->currentZone);
-                xTimerChangePeriod(taskCtx->timerHandle, TASK_DELAY_MS(delay), TASK_DELAY_MS(10));
-                taskCtx->statistics.rxRequests++;
-            }
+            tuner->tuneWindow();
         }
         else
         {
-            // Try to find a next slot
-            taskCtx->advanceReceiveSlot(taskCtx->controller->currentZone);
-            xTimerChangePeriod(taskCtx->timerHandle, TASK_DELAY_MS(TIMEOUT_DELAY / 2), TASK_DELAY_MS(2));
-            taskCtx->statistics.timerMissed++;
+            // Try to find a next window
+            tuner->upcomingWindow = NO_WINDOW;
+            tuner->tuneWindow();
+            tuner->statistics.timerMissed++;
+        }
+    }
+}
+
+void RadioTunerRx::tuneWindow()
+{
+    CountryRegulations::Zone zone = currentZone;
+    if (upcomingWindow != NO_WINDOW)
+    {
+        planner.account(slotRates, slotReceive);
+        uint8_t retune = planner.plan(upcomingWindow, zone, slotRates, CoreUtils::msSinceEpoch());
+        for (uint8_t r = 0; r < radios.size(); r++)
+        {
+            if (retune & (1 << r))
+            {
+                const auto &listen = planner.listens[r];
+                radios[r]->rxMode(
+                    {Radio::RadioParameters{
+                        listen.slot().radioConfig,
+                        listen.frequency,
+                        listen.slot().frequency.powerdBm}});
+                statistics.rxRequests[r]++;
+            }
         }
+        statistics.windows++;
     }
+
+    auto currentMs = CoreUtils::msInSecond();
+    upcomingWindow = planner.nextWindow(currentMs, zone);
+    uint16_t delay = upcomingWindow == NO_WINDOW ? 500 : CoreUtils::msDelayToReference(upcomingWindow, currentMs) + 1;
+    xTimerChangePeriod(timerHandle, TASK_DELAY_MS(delay), TASK_DELAY_MS(10));
 }
 
 // ******************** Message bus receive handlers ********************
@@ -173,19 +170,8 @@ void RadioTunerRx::on_receive(const OpenAce::OwnshipPositionMsg &msg)
 
 void RadioTunerRx::on_receive(const OpenAce::AircraftPositionMsg &msg)
 {
-    static uint32_t lastTime = CoreUtils::msSinceBoot();
+    // The tune task takes the difference at the end of each window
     slotReceive[(uint8_t)msg.position.dataSource]++;
-
-    // Update the tasks at least every seconds, but not on each and every aircraft message
-    auto msSinceBoot = CoreUtils::msSinceBoot();
-    if (CoreUtils::msElapsed(lastTime, msSinceBoot) > 1000)
-    {
-        lastTime = msSinceBoot;
-        for (auto &taskCtx : radioTasks)
-        {
-            taskCtx.updateSlotReceive(slotReceive);
-        }
-    }
 }
 
 void RadioTunerRx::on_receive_unknown(const etl::imessage &msg)
@@ -204,43 +190,12 @@ void RadioTunerRx::on_receive(const OpenAce::ConfigUpdatedMsg &msg)
 
 void RadioTunerRx::enableDisableDatasources(const etl::ivector<OpenAce::DataSource> &dataSources)
 {
-    // Step 1: Block all tasks first
-    for (auto &taskCtx : radioTasks)
-    {
-        xTaskNotify(taskCtx.taskHandle, TaskState::BLOCK, eSetBits);
-    }
+    xTaskNotify(taskHandle, TaskState::BLOCK, eSetBits);
 
     // TODO: Synchronize task blocking here instead of fixed delay
     vTaskDelay(TASK_DELAY_MS(50)); // This delay could be replaced with a synchronization mechanism
 
-    // Step 2: Precompute how many protocols each radio should handle
-    uint8_t dsPerRadio = dataSources.size() / radioTasks.size();
-    uint8_t remainingSources = dataSources.size() % radioTasks.size(); // Handle remainder for last radio
-    uint8_t newDsPos = 0;
-
-    // Step 3: Distribute data sources across radios
-    for (auto &taskCtx : radioTasks)
-    {
-        uint8_t sourcesForThisRadio = dsPerRadio;
-
-        // Distribute the remainder to the last radio
-        if (&taskCtx == &radioTasks.back())
-        {
-            sourcesForThisRadio += remainingSources;
-        }
-
-        // Copy the assigned data sources for this radio
-        etl::vector<OpenAce::DataSource, MAX_SOURCE_PER_RADIO> newDataSources;
-        for (uint8_t i = 0; i < sourcesForThisRadio; ++i)
-        {
-            newDataSources.emplace_back(dataSources[newDsPos]);
-            newDsPos++;
-        }
-
-        // Step 4: Update task with new data sources
-        taskCtx.updateDataSources(newDataSources);
-
-        // Unblock the task
-        xTaskNotify(taskCtx.taskHandle, TaskState::UNBLOCK, eSetBits);
-    }
+    planner.updateDataSources(dataSources);
+    upcomingWindow = NO_WINDOW;
+    xTaskNotify(taskHandle, TaskState::UNBLOCK, eSetBits);
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <algorithm>
 
 #include "ace/constants.hpp"
 #include "ace/messagerouter.hpp"
@@ -13,12 +14,12 @@
 
 #include "etl/map.h"
 #include "etl/message_bus.h"
-#include "etl/list.h"
 #include "etl/array.h"
 #include <etl/array_view.h>
 #include "etl/string.h"
 #include "etl/bitset.h"
-#include "etl/circular_iterator.h"
+#include "etl/vector.h"
+#include "etl/algorithm.h"
 
 #include "timers.h"
 
@@ -28,189 +29,366 @@
  * This class is responsible for controlling the radio's
  */
 /**
- * Note: Currently using array's indexed on datasource to give fast lookups on statistics but will cost a bit more memory
- * The downside is that only one protocol can be configured on one radio so listening on the same protocol on two radios would not be possible
+ * All radios are planned together by a single task. The second is cut in windows at the start times of the timeslots of
+ * the enabled datasources, at the start of each window the planner decides what every radio listens to.
  */
 class RadioTunerRx : public BaseModule, public etl::message_router<RadioTunerRx, OpenAce::OwnshipPositionMsg, OpenAce::AircraftPositionMsg, OpenAce::ConfigUpdatedMsg>
 {
     using  SlotReceive = etl::array<uint8_t, static_cast<uint8_t>(OpenAce::DataSource::_ITEMS)>;
 public:
     static constexpr const uint32_t UPDATE_ZONE_REGULATION_EVERY = 30000; // Get new regulatory dataset every XXms
-    static constexpr const size_t   MAX_SLOTS_PER_SOURCE = 3;             // Maximum slots a datasource can get while receiving
-    static constexpr const size_t   MAX_SOURCE_PER_RADIO = 3;             // Maximum source per radio, eg maximum protocols it will search for
-    static constexpr const size_t   TIME_SLOT_SIZE = MAX_SLOTS_PER_SOURCE * MAX_SLOTS_PER_SOURCE;
+    static constexpr const size_t   MAX_SOURCES = 6;                      // Maximum datasources that can be received
+    static constexpr const uint16_t NO_WINDOW = UINT16_MAX;               // No timeslot of an enabled datasource in the zone
 
 private:
-    // Each radio will get one task Context to handle
-    struct RadioProtocolCtx
+    /**
+     * Learned reception rate of each timeslot. A timeslot is a zone, frequency and time window in the second, so this
+     * tells how many frames each protocol brings in at a given moment in the second. Shared by all radios.
+     */
+    struct SlotRates
     {
-        mutable struct
-        {
-            uint32_t rxRequests = 0;
-            uint32_t timerMissed = 0;
-        } statistics;
-
-        // Pointers needed to control the radio
-        RadioTunerRx *controller;
-        Radio *radio;
-        TaskHandle_t taskHandle;
-        TimerHandle_t timerHandle;
+        static constexpr uint16_t RATE_ONE = 256;    // One frame per listen
+        static constexpr uint8_t RATE_AVERAGE = 8;   // Number of listens the rate is averaged over
+        static constexpr uint8_t MAX_FRAMES = 200;   // Keeps the rate within 16 bits
 
-        // The DataSources this radio will handle
-        etl::vector<OpenAce::DataSource, MAX_SOURCE_PER_RADIO> dataSources;
+        // Frames received per listen of each timeslot, as an exponential moving average
+        etl::array<uint16_t, CountryRegulations::timings.size()> rate = {};
 
-        // datasources processed by this task and used by prioritizeDatasources
-        using DataSources = etl::vector<OpenAce::DataSource, TIME_SLOT_SIZE>;
-        using CircularDataSourceIterator = etl::circular_iterator<DataSources::iterator>;
-        DataSources dataSourceTimeSlots;
-        CircularDataSourceIterator upcomingDataSource;
+        /**
+         * Add the frames received during a listen of the timeslot to the average
+         */
+        void update(uint8_t slotIdx, uint8_t frames)
+        {
+            // Rounds down, so the rate of a silent timeslot decays all the way to 0
+            uint32_t target = std::min(frames, MAX_FRAMES) * RATE_ONE;
+            rate[slotIdx] = (rate[slotIdx] * (RATE_AVERAGE - 1) + target) / RATE_AVERAGE;
+        }
 
-        // Data of the upcoming timeslot set by advanceReceiveSlot
-        uint8_t upcomingTimeslot = CountryRegulations::NONE_DATASOURCE.idx;
+        /**
+         * Average rate over the timeslots of the datasource in the zone, 0 when the datasource has no slots in the zone
+         */
+        uint16_t dataSourceRate(CountryRegulations::Zone zone, OpenAce::DataSource ds) const
+        {
+            auto idx = CountryRegulations::getFirstSlotIdx(zone, ds);
+            if (idx == CountryRegulations::NONE_DATASOURCE.idx)
+            {
+                return 0;
+            }
+            auto other = CountryRegulations::protocolTimeslotById(idx).nextSlotIdx;
+            return (rate[idx] + rate[other]) / 2;
+        }
+    };
 
-        SlotReceive slotReceive = {};
-        SlotReceive previousReceived = {};
+    /**
+     * What a radio listens to during a window: a timeslot on one of the channels of the timeslot's frequency
+     */
+    struct Listen
+    {
+        uint8_t slotIdx = CountryRegulations::NONE_DATASOURCE.idx;
+        CountryRegulations::ChannelMethod channel = CountryRegulations::ChannelMethod::CHANNEL_0;
+        bool counted = false;   // Frames received during the window are counted for the timeslot
+        uint32_t weight = 0;    // Weight of the timeslot in the window, the radio with the lowest weight transmits
+        uint32_t frequency = 0; // Frequency of the channel when the window started, hopping protocols change it every window
 
-        // Constructor
-        RadioProtocolCtx(RadioTunerRx *controller_, Radio *radio_) : controller(controller_), radio(radio_), taskHandle(nullptr), timerHandle(nullptr)
+        bool valid() const
         {
-            prioritizeDatasources();
+            return slotIdx != CountryRegulations::NONE_DATASOURCE.idx;
         }
 
-        // Ensure we never copy
-        RadioProtocolCtx(const RadioProtocolCtx &) = delete;
-        RadioProtocolCtx &operator=(RadioProtocolCtx const &) = delete;
+        const CountryRegulations::ProtocolTimeSlot &slot() const
+        {
+            return CountryRegulations::protocolTimeslotById(slotIdx);
+        }
 
-        void getData(etl::string_stream &stream) const
+        /**
+         * True when both receive the same protocol on the same frequency
+         */
+        bool sameAs(const Listen &other) const
         {
+            return valid() && other.valid() && slot().source == other.slot().source && frequency == other.frequency;
+        }
+    };
+
+    /**
+     * Plans the listens of all radios for each window.
+     *
+     * - The candidates of a window are the timeslots of the enabled datasources that start at the window.
+     * - Candidates are picked with a smooth weighted round robin, the weight is a base weight plus the learned rate of
+     *   the timeslot, so a protocol without traffic is still listened to now and then. When a datasource has two timeslots
+     *   in the same window (ADS-L hops at 800ms) the weight is shared between them.
+     * - Every radio gets a different protocol or frequency. When there are more radios than candidates, a spare radio
+     *   listens to the other channel of a picked timeslot, this covers both channels of the FLARM and OGN hopping.
+     * - A radio that is already tuned to what it needs is not retuned, a radio without anything to do keeps its listen.
+     * - The radio with the least valuable listen is the one that transmits, so the other radio keeps receiving.
+     */
+    struct ReceivePlanner
+    {
+        static constexpr uint32_t BASE_WEIGHT = SlotRates::RATE_ONE / 4;
 
-            stream << "\"radio_" << radio->radio() << "\":[";
-            for (auto it = dataSourceTimeSlots.cbegin(); it != dataSourceTimeSlots.cend(); ++it)
+        uint8_t numRadios = 1;
+        etl::vector<OpenAce::DataSource, MAX_SOURCES> dataSources;
+        etl::array<Listen, OPEN_ACE_MAX_RADIOS> listens;
+        uint8_t txRadio = 0;
+
+        // Smooth weighted round robin credit of each timeslot
+        etl::array<int32_t, CountryRegulations::timings.size()> credit = {};
+
+        // Receive counts at the start of the window
+        SlotReceive receivedAtWindowStart = {};
+
+        /**
+         * Set the datasources to be received, the round robin starts again
+         */
+        void updateDataSources(const etl::ivector<OpenAce::DataSource> &ds)
+        {
+            dataSources.clear();
+            for (auto source : ds)
             {
-                stream << "\"" << OpenAce::dataSourceToString(*it) << "\"";
-                if (std::next(it) != dataSourceTimeSlots.cend())
+                if (!dataSources.full())
                 {
-                    stream << ",";
+                    dataSources.push_back(source);
                 }
             }
-            stream << "]";
-            stream << ",\"nextRx_" << radio->radio() << "\":" << "\"" << OpenAce::dataSourceToString(*upcomingDataSource) << "\"";
-            stream << ",\"timerMissedRadio_" << radio->radio() << "\":" << statistics.timerMissed;
-            stream << ",\"rxRequestsRadio_" << radio->radio() << "\":" << statistics.rxRequests;
+            credit.fill(0);
         }
 
         /**
-         * Update the receive counts, this works as an incremental counter (8 bit) where the differences between the last received and the current
-         * will be calculate to know if any data was received
+         * Call func for each timeslot of the datasource in the zone, there are at most two
          */
-        void updateSlotReceive(const SlotReceive &sr)
+        template <typename Func>
+        static void forEachSlot(CountryRegulations::Zone zone, OpenAce::DataSource source, Func func)
         {
-            // Update slotReceive with the difference between sr and previousReceived
-            for (size_t i = 0; i < slotReceive.size(); ++i)
+            auto first = CountryRegulations::getFirstSlotIdx(zone, source);
+            if (first == CountryRegulations::NONE_DATASOURCE.idx)
             {
-                // Subtract the previous value from the new value to get the difference
-                slotReceive[i] = sr[i] - previousReceived[i];
+                return;
+            }
+            func(CountryRegulations::protocolTimeslotById(first));
+            auto second = CountryRegulations::protocolTimeslotById(first).nextSlotIdx;
+            if (second != first)
+            {
+                func(CountryRegulations::protocolTimeslotById(second));
             }
-            previousReceived = sr;
         }
 
         /**
-         * Set the datasources to be received
+         * Start of the next window after currentMs, NO_WINDOW when no enabled datasource has a timeslot in the zone
          */
-        void updateDataSources(const etl::ivector<OpenAce::DataSource> &ds)
+        uint16_t nextWindow(uint16_t currentMs, CountryRegulations::Zone zone) const
         {
-            dataSources.clear();
-            dataSources.assign(ds.cbegin(), ds.cend());
-            prioritizeDatasources();
+            uint16_t window = NO_WINDOW;
+            uint16_t shortestDelay = UINT16_MAX;
+            for (auto source : dataSources)
+            {
+                forEachSlot(zone, source, [&](const CountryRegulations::ProtocolTimeSlot &slot)
+                {
+                    auto delay = CoreUtils::msDelayToReference(slot.slotStartTime, currentMs);
+                    if (delay < shortestDelay)
+                    {
+                        shortestDelay = delay;
+                        window = slot.slotStartTime;
+                    }
+                });
+            }
+            return window;
         }
 
         /**
-         * Sets the next receive slot based on the current time and the specified zone.
-         *
-         * This method advances the iterator `upcomingDataSource` to point to the next data source
-         * in the `dataSourceTimeSlots` vector. If the iterator reaches the beginning of the vector,
-         * it calls `prioritizeDatasources()` to regenerate the dataSourceTimeSlots.
-         *
-         * After selecting the next data source, the method calculates the appropriate time slot
-         * for that data source using the provided zone and the current time.
-         *
-         * @param zone The geographical zone that influences the timing regulations.
-         * @return The delay in milliseconds until the next protocol timeslot starts, minimum delay is 1 ms
+         * Count the frames received during the window that ends for the timeslots that were listened to.
+         * Receive counts are per datasource, when more radios listened to timeslots of the same datasource the frames are shared
          */
+        void account(SlotRates &slotRates, const SlotReceive &received)
+        {
+            SlotReceive listeners = {};
+            for (uint8_t r = 0; r < numRadios; r++)
+            {
+                if (listens[r].counted)
+                {
+                    listeners[(uint8_t)listens[r].slot().source]++;
+                }
+            }
+            for (uint8_t r = 0; r < numRadios; r++)
+            {
+                if (listens[r].counted)
+                {
+                    auto ds = (uint8_t)listens[r].slot().source;
+                    slotRates.update(listens[r].slotIdx, (uint8_t)(received[ds] - receivedAtWindowStart[ds]) / listeners[ds]);
+                }
+            }
+            receivedAtWindowStart = received;
+        }
 
-        int16_t advanceReceiveSlot(CountryRegulations::Zone zone)
+        /**
+         * Plan all radios for the window starting at windowStart, msSinceEpoch is the time the window starts at
+         * @return bit per radio that needs to be tuned
+         */
+        uint8_t plan(uint16_t windowStart, CountryRegulations::Zone zone, const SlotRates &slotRates, uint64_t msSinceEpoch)
         {
-            // Can we do better than this??
-            if (dataSources.empty())
+            // Collect the candidates of this window
+            etl::vector<Listen, CountryRegulations::timings.size()> candidates;
+            for (auto source : dataSources)
+            {
+                forEachSlot(zone, source, [&](const CountryRegulations::ProtocolTimeSlot &slot)
+                {
+                    if (slot.slotStartTime == windowStart)
+                    {
+                        candidates.push_back(Listen{slot.idx, slot.channelMethod, true, BASE_WEIGHT + slotRates.rate[slot.idx], CountryRegulations::determineFrequency(slot, msSinceEpoch)});
+                    }
+                });
+            }
+            for (auto &candidate : candidates)
+            {
+                auto sameSource = etl::count_if(candidates.cbegin(), candidates.cend(), [&candidate](const Listen &other)
+                {
+                    return other.slot().source == candidate.slot().source;
+                });
+                candidate.weight /= sameSource;
+            }
+
+            // Smooth weighted round robin, picking up to one candidate per radio
+            uint8_t picks = std::min((size_t)numRadios, candidates.size());
+            int32_t totalWeight = 0;
+            for (const auto &candidate : candidates)
             {
-                upcomingTimeslot = CountryRegulations::NONE_DATASOURCE.idx;
-                return 500;
+                totalWeight += candidate.weight;
+                credit[candidate.slotIdx] += candidate.weight * picks;
             }
 
-            // Once full circle, prioritizeDatasources to see if priority needs to be re evaluated
-            if (upcomingDataSource == dataSourceTimeSlots.begin())
+            etl::vector<Listen, OPEN_ACE_MAX_RADIOS> chosen;
+            while (chosen.size() < picks)
             {
-                prioritizeDatasources();
+                const Listen *best = nullptr;
+                for (const auto &candidate : candidates)
+                {
+                    bool taken = etl::find_if(chosen.cbegin(), chosen.cend(), [&candidate](const Listen &other)
+                    {
+                        return other.slotIdx == candidate.slotIdx || other.sameAs(candidate);
+                    }) != chosen.cend();
+                    if (!taken && (best == nullptr || credit[candidate.slotIdx] > credit[best->slotIdx]))
+                    {
+                        best = &candidate;
+                    }
+                }
+                if (best == nullptr)
+                {
+                    break;
+                }
+                credit[best->slotIdx] = std::min(credit[best->slotIdx] - totalWeight, totalWeight);
+                chosen.push_back(*best);
             }
 
-            auto currentMs = CoreUtils::msInSecond();
-            upcomingTimeslot = CountryRegulations::nextProtocolTimeslot(currentMs, zone, *upcomingDataSource);
-            ++upcomingDataSource;
-            const auto &next = CountryRegulations::protocolTimeslotById(upcomingTimeslot);
-            return CoreUtils::msDelayToReference(next.slotStartTime, currentMs) + 1;
+            // Spare radios listen to the other channel of what was picked, hopping over more channels cannot be covered
+            for (size_t i = 0; i < chosen.size() && chosen.size() < numRadios; i++)
+            {
+                if (chosen[i].slot().frequency.channels == 2)
+                {
+                    auto otherChannel = chosen[i].channel == CountryRegulations::ChannelMethod::CHANNEL_0 ? CountryRegulations::ChannelMethod::CHANNEL_1 : CountryRegulations::ChannelMethod::CHANNEL_0;
+                    Listen alternate{chosen[i].slotIdx, otherChannel, false, 0, CountryRegulations::channelFrequency(chosen[i].slot(), otherChannel, msSinceEpoch)};
+                    bool taken = etl::find_if(chosen.cbegin(), chosen.cend(), [&alternate](const Listen &other)
+                    {
+                        return other.sameAs(alternate);
+                    }) != chosen.cend();
+                    if (!taken)
+                    {
+                        chosen.push_back(alternate);
+                    }
+                }
+            }
+
+            return assign(chosen);
         }
 
         /**
-         * Prioritizes and organizes data sources based on their slot receive configuration.
-         *
-         * This method processes the `dataSources` vector and populates the `dataSourceTimeSlots`
-         * vector based on the priority specified in the `slotReceive` array. Each `DataSource`
-         * in `dataSources` is added to `dataSourceTimeSlots` one or more times, depending on
-         * its corresponding value in `slotReceive`.
-         *
-         * - If `slotReceive` value is 0: The `DataSource` is added once.
-         * - If `slotReceive` value is 1: The `DataSource` is added twice.
-         * - If `slotReceive` value is 2 or more: The `DataSource` is added three times.
-         *
-         * After constructing the `dataSourceTimeSlots`, the method re-initializes the circular
-         * iterator `upcomingDataSource` to iterate over the updated `dataSourceTimeSlots` vector.
+         * Give each chosen listen a radio, preferring a radio that is already tuned to it
+         * @return bit per radio that needs to be tuned
          */
-        void prioritizeDatasources()
+        uint8_t assign(const etl::ivector<Listen> &chosen)
         {
-            // Clear the dataSourceTimeSlots vector to start fresh
-            dataSourceTimeSlots.clear();
-
-            for (const auto &ds : dataSources)
+            etl::array<bool, OPEN_ACE_MAX_RADIOS> assigned = {};
+            etl::array<bool, OPEN_ACE_MAX_RADIOS> placed = {};
+            for (size_t c = 0; c < chosen.size(); c++)
             {
-                uint8_t slotCount;
+                for (uint8_t r = 0; r < numRadios; r++)
+                {
+                    if (!assigned[r] && listens[r].sameAs(chosen[c]))
+                    {
+                        listens[r] = chosen[c];
+                        assigned[r] = true;
+                        placed[c] = true;
+                        break;
+                    }
+                }
+            }
 
-                // Check the slotReceive array to see if more entries are needed
-                if (slotReceive[(uint8_t)ds] == 0)
+            // The others go to the radio with the least valuable listen
+            uint8_t retune = 0;
+            for (size_t c = 0; c < chosen.size(); c++)
+            {
+                if (placed[c])
                 {
-                    slotCount = 1;
+                    continue;
                 }
-                else if (slotReceive[(uint8_t)ds] == 1)
+                int8_t radio = -1;
+                for (uint8_t r = 0; r < numRadios; r++)
                 {
-                    slotCount = 2;
+                    if (!assigned[r] && (radio < 0 || listens[r].weight < listens[radio].weight))
+                    {
+                        radio = r;
+                    }
                 }
-                else
+                if (radio >= 0)
                 {
-                    slotCount = MAX_SLOTS_PER_SOURCE;
+                    listens[radio] = chosen[c];
+                    assigned[radio] = true;
+                    retune |= 1 << radio;
                 }
+            }
 
-                dataSourceTimeSlots.insert(dataSourceTimeSlots.end(), slotCount, ds);
+            // Radios without a new listen keep listening, frames are only counted in the window of a timeslot
+            for (uint8_t r = 0; r < numRadios; r++)
+            {
+                if (!assigned[r])
+                {
+                    listens[r].counted = false;
+                    listens[r].weight = 0;
+                }
             }
 
-            // Re-initialize the circular iterator after modifying the dataSourceTimeSlots
-            upcomingDataSource = CircularDataSourceIterator{dataSourceTimeSlots.begin(), dataSourceTimeSlots.end()};
+            // Lowest weight transmits, on a tie the highest radio so the first radio keeps the picked timeslots
+            txRadio = 0;
+            for (uint8_t r = 1; r < numRadios; r++)
+            {
+                if (listens[r].weight <= listens[txRadio].weight)
+                {
+                    txRadio = r;
+                }
+            }
+            return retune;
         }
     };
 
-    // Keep track if there is any traffic on the datasources
-    SlotReceive slotReceive;
+    // Aircraft positions received per datasource, 8 bit counters that wrap
+    SlotReceive slotReceive = {};
+
+    SlotRates slotRates;
+
+    ReceivePlanner planner;
+
+    // Radios in the order of Radio::NAMES
+    etl::vector<Radio *, OPEN_ACE_MAX_RADIOS> radios;
+
+    mutable struct
+    {
+        etl::array<uint32_t, OPEN_ACE_MAX_RADIOS> rxRequests = {};
+        uint32_t windows = 0;
+        uint32_t timerMissed = 0;
+    } statistics;
 
-    // Keep track of one task per each radio
-    etl::list<RadioProtocolCtx, OPEN_ACE_MAX_RADIOS> radioTasks;
+    TaskHandle_t taskHandle;
+    TimerHandle_t timerHandle;
+
+    // Start of the window the timer is set for
+    uint16_t upcomingWindow = NO_WINDOW;
 
     enum TaskState : uint32_t
     {
@@ -231,6 +409,11 @@ private:
     static void timerTuneCallback(TimerHandle_t xTimer);
     static void radioTuneTask(void *arg);
 
+    /**
+     * Account the window that ends, plan the radios for the window that starts and set the timer for the next window
+     */
+    void tuneWindow();
+
     // ******************** Message bus receive handlers ********************
     void on_receive(const OpenAce::OwnshipPositionMsg &msg);
     void on_receive(const OpenAce::AircraftPositionMsg &msg);
@@ -241,6 +424,8 @@ public:
     static constexpr const etl::string_view NAME = "RadioTunerRx";
 
     RadioTunerRx(etl::imessage_bus &bus, const Configuration &config) : BaseModule(bus, NAME),
+        taskHandle(nullptr),
+        timerHandle(nullptr),
         currentZone(CountryRegulations::Zone::ZONE0)
     {
         (void)config;
@@ -251,7 +436,14 @@ public:
     virtual void start() override;
     virtual void stop() override;
     virtual void getData(etl::string_stream &stream, const etl::string_view path) const override;
-    void addRadioTasks(uint8_t numRadios);
+
+    /**
+     * Radio that transmits in the current window, the other radios keep receiving
+     */
+    uint8_t txRadio() const
+    {
+        return planner.txRadio;
+    }
 
 private:
     void enableDisableDatasources(const etl::ivector<OpenAce::DataSource> &datasources);
@@ -1,4 +1,5 @@
 #include "radiotunertx.hpp"
+#include "radiotunerrx.hpp"
 
 #include "FreeRTOS.h"
 #include "task.h"
@@ -6,6 +7,8 @@
 
 #include "etl/algorithm.h"
 
+#include "ace/semaphoreguard.hpp"
+
 #include "pico/rand.h"
 
 OpenAce::PostConstruct RadioTunerTx::postConstruct()
@@ -16,9 +19,31 @@ OpenAce::PostConstruct RadioTunerTx::postConstruct()
     {
         numRadios++;
     }
+    radioTunerRx = static_cast<RadioTunerRx *>(moduleByName(*this, RadioTunerRx::NAME, false));
+    ledgerMutex = xSemaphoreCreateMutex();
+    if (ledgerMutex == nullptr)
+    {
+        return OpenAce::PostConstruct::MUTEX_ERROR;
+    }
     return OpenAce::PostConstruct::OK;
 }
 
+uint8_t RadioTunerTx::txRadio(const SendPositionCtx &taskCtx) const
+{
+    return radioTunerRx ? radioTunerRx->txRadio() : taskCtx.radioNo;
+}
+
+bool RadioTunerTx::airtimeAllowed(const CountryRegulations::ProtocolTimeSlot &slot, uint32_t frequency)
+{
+    SemaphoreGuard<5> guard{ledgerMutex};
+    if (!guard)
+    {
+        // Without the ledger we cannot tell, skip this one. The next slot will try again
+        return false;
+    }
+    return airtimeLedger.allowed(slot.source, frequency, slot.frequency.dutyCyclePerMille, CoreUtils::msSinceBoot());
+}
+
 void RadioTunerTx::start()
 {
     //    addDataSourceToTasks(dataSource, radio);
@@ -29,12 +54,12 @@ void RadioTunerTx::start()
         enableDisableDatasources(config->openAceConfig().protocols);
     }
 
-    getBus().subscribe(*this);
+    subscribe(*this);
 };
 
 void RadioTunerTx::stop()
 {
-    getBus().unsubscribe(*this);
+    unsubscribe(*this);
 
     // Remove all DataSources that are not required
     for (auto const &it : txTasks)
@@ -70,6 +95,12 @@ void RadioTunerTx::getData(etl::string_stream &stream, const etl::string_view pa
         it->getData(stream);
     }
     stream << ",\"zone\":\"" << CountryRegulations::zoneToString(currentZone) << "\"";
+    SemaphoreGuard<25> guard{ledgerMutex};
+    if (guard)
+    {
+        stream << ",";
+        airtimeLedger.getData(stream, CoreUtils::msSinceBoot());
+    }
     stream << "}\n";
 }
 
@@ -112,17 +143,31 @@ void RadioTunerTx::radioTxTask(void *arg)
             if (taskCtx->protocolTimingIdx != CountryRegulations::NONE_DATASOURCE.idx)
             {
                 // Create a message on the message bus to request positional message for a specific protocol
+                // unless the channel used up it's duty cycle, then the slot is skipped
                 uint32_t frequency = CountryRegulations::determineFrequency(protocolTimeSlot);
-                taskCtx->controller->getBus().receive(
-                    OpenAce::RadioTxPositionRequest
+                auto msInSecond = CoreUtils::msInSecond();
+                if (taskCtx->controller->airtimeAllowed(protocolTimeSlot, frequency))
+                {
+                    // When the channel is busy the radio may back off, but not beyond the end of the slot
+                    Radio::CarrierSense carrierSense{
+                        protocolTimeSlot.waitAfterCatStart,
+                        protocolTimeSlot.waitAfterCatEnd,
+                        CoreUtils::msSinceBoot() + CountryRegulations::msLeftInSlot(protocolTimeSlot, msInSecond)};
+                    taskCtx->controller->getBus().receive(
+                        OpenAce::RadioTxPositionRequest
+                    {
+                        Radio::RadioParameters{
+                            protocolTimeSlot.radioConfig,
+                            frequency,
+                            protocolTimeSlot.frequency.powerdBm,
+                            carrierSense},
+                        taskCtx->controller->txRadio(*taskCtx)});
+                }
+                else
                 {
-                    Radio::RadioParameters{
-                        protocolTimeSlot.radioConfig,
-                        frequency,
-                        protocolTimeSlot.frequency.powerdBm},
-                    taskCtx->radioNo});
+                    taskCtx->statistics.txBlocked++;
+                }
 
-                auto msInSecond = CoreUtils::msInSecond();
                 auto nextTxTime = CountryRegulations::getNextTxTime(msInSecond, taskCtx->protocolTimingIdx);
 
                 taskCtx->protocolTimingIdx = nextTxTime.idx;
@@ -150,6 +195,15 @@ void RadioTunerTx::on_receive(const OpenAce::OwnshipPositionMsg &msg)
     }
 }
 
+void RadioTunerTx::on_receive(const OpenAce::RadioTxDoneMsg &msg)
+{
+    SemaphoreGuard<5> guard{ledgerMutex};
+    if (guard)
+    {
+        airtimeLedger.record(msg.dataSource, msg.frequency, msg.airtimeUs, msg.msSinceBoot);
+    }
+}
+
 void RadioTunerTx::on_receive(const OpenAce::ConfigUpdatedMsg &msg)
 {
     if (msg.moduleName == "config")
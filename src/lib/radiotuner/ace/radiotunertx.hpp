@@ -9,6 +9,7 @@
 #include "ace/coreutils.hpp"
 
 #include "countryregulations.hpp"
+#include "airtimeledger.hpp"
 
 #include "etl/message_bus.h"
 #include "etl/list.h"
@@ -16,15 +17,19 @@
 #include "etl/functional.h"
 
 #include "timers.h"
+#include "semphr.h"
+
+class RadioTunerRx;
 
 /**
  * This class is responsible for controlling the radio's
+ * Before a transmission is requested the AirtimeLedger is asked if it fits in the duty cycle of the channel
  */
 /**
  * Note: Currently using array's indexed on datasource to give fast lookups on statistics but will cost a bit more memory
  * The downside is that only one protocol can be configured on one radio so listening on the same protocol on two radios would not be possible
  */
-class RadioTunerTx : public BaseModule, public etl::message_router<RadioTunerTx, OpenAce::OwnshipPositionMsg, OpenAce::ConfigUpdatedMsg>
+class RadioTunerTx : public BaseModule, public etl::message_router<RadioTunerTx, OpenAce::OwnshipPositionMsg, OpenAce::ConfigUpdatedMsg, OpenAce::RadioTxDoneMsg>
 {
     static constexpr const size_t MAX_PROTOCOLS = 6;                      // Maximum number of datasources per radio
     static constexpr const uint32_t UPDATE_ZONE_REGULATION_EVERY = 30000; // Get new regulatory dataset every XXms
@@ -43,6 +48,7 @@ private:
         {
             uint32_t txRequests = 0;
             uint32_t timerMissed = 0;
+            uint32_t txBlocked = 0; // Skipped, the duty cycle of the channel was used up
         } statistics;
 
         OpenAce::DataSource source;
@@ -62,6 +68,7 @@ private:
         {
             stream << ",\"timerMissed_" << dataSourceToString(source) << "\":" << statistics.timerMissed;
             stream << ",\"txRequests_" << dataSourceToString(source) << "\":" << statistics.txRequests;
+            stream << ",\"txBlocked_" << dataSourceToString(source) << "\":" << statistics.txBlocked;
         }
     };
 
@@ -75,20 +82,40 @@ private:
     volatile CountryRegulations::Zone currentZone;
     uint8_t numRadios;
 
+    // When loaded, the receive planner decides which radio transmits
+    const RadioTunerRx *radioTunerRx;
+
+    // Airtime of all transmissions, written by the bus and read by the tx tasks
+    mutable AirtimeLedger airtimeLedger;
+    mutable SemaphoreHandle_t ledgerMutex;
+
 private:
     static void timerTxCallback(TimerHandle_t xTimer);
     static void radioTxTask(void *arg);
 
     void on_receive(const OpenAce::ConfigUpdatedMsg &msg);
     void on_receive(const OpenAce::OwnshipPositionMsg &msg);
+    void on_receive(const OpenAce::RadioTxDoneMsg &msg);
     void on_receive_unknown(const etl::imessage &msg);
     void enableDisableDatasources(const etl::ivector<OpenAce::DataSource> &datasources);
 
+    /**
+     * Radio to transmit on, the one RadioTunerRx has least to lose on or the fixed radio of the datasource
+     */
+    uint8_t txRadio(const SendPositionCtx &taskCtx) const;
+
+    /**
+     * True when the next transmission of the slot fits in the duty cycle of the frequency
+     */
+    bool airtimeAllowed(const CountryRegulations::ProtocolTimeSlot &slot, uint32_t frequency);
+
 public:
     static constexpr const etl::string_view NAME = "RadioTunerTx";
     RadioTunerTx(etl::imessage_bus &bus, const Configuration &config) : BaseModule(bus, NAME),
         currentZone(CountryRegulations::Zone::ZONE0),
-        numRadios(0)
+        numRadios(0),
+        radioTunerRx(nullptr),
+        ledgerMutex(nullptr)
     {
         (void)config;
     }
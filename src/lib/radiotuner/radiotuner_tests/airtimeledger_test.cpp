@@ -0,0 +1,112 @@
+#include <catch2/catch_test_macros.hpp>
+
+#define private public
+
+#include "../ace/airtimeledger.hpp"
+#include "etl/string.h"
+
+// A FLARM frame takes about 6ms on air
+static constexpr uint32_t FRAME_US = 6'000;
+static constexpr uint32_t START_MS = 10'000'000;
+
+TEST_CASE("Airtime per protocol and channel", "[single-file]")
+{
+    AirtimeLedger ledger;
+    const auto &europe = CountryRegulations::Europe;
+
+    // Channels are kept when a transmission is allowed on them
+    REQUIRE(ledger.allowed(OpenAce::DataSource::FLARM, europe.baseFrequency, europe.dutyCyclePerMille, START_MS));
+    ledger.record(OpenAce::DataSource::FLARM, europe.baseFrequency, FRAME_US, START_MS);
+    ledger.record(OpenAce::DataSource::OGN1, europe.baseFrequency, FRAME_US, START_MS + 500);
+
+    REQUIRE(ledger.channelAirtimeUs(europe.baseFrequency, START_MS + 1000) == 2 * FRAME_US);
+    REQUIRE(ledger.protocolAirtimeUs(OpenAce::DataSource::FLARM, START_MS + 1000) == FRAME_US);
+    REQUIRE(ledger.protocols[(uint8_t)OpenAce::DataSource::FLARM].lastAirtimeUs == FRAME_US);
+
+    SECTION("Hopping channels are not kept")
+    {
+        REQUIRE(ledger.allowed(OpenAce::DataSource::FLARM, 915'000'000, CountryRegulations::NO_DUTY_CYCLE, START_MS));
+        ledger.record(OpenAce::DataSource::FLARM, 915'000'000, FRAME_US, START_MS);
+        REQUIRE(ledger.channelAirtimeUs(915'000'000, START_MS) == 0);
+        REQUIRE(ledger.protocolAirtimeUs(OpenAce::DataSource::FLARM, START_MS) == 2 * FRAME_US);
+    }
+
+    SECTION("Airtime leaves the window after an hour")
+    {
+        REQUIRE(ledger.channelAirtimeUs(europe.baseFrequency, START_MS + AirtimeLedger::WINDOW_MS - AirtimeLedger::BUCKET_MS) == 2 * FRAME_US);
+        REQUIRE(ledger.channelAirtimeUs(europe.baseFrequency, START_MS + AirtimeLedger::WINDOW_MS) == 0);
+        REQUIRE(ledger.protocolAirtimeUs(OpenAce::DataSource::FLARM, START_MS + 5 * AirtimeLedger::WINDOW_MS) == 0);
+    }
+
+    SECTION("Late reports are added to the current bucket")
+    {
+        ledger.record(OpenAce::DataSource::FLARM, europe.baseFrequency, FRAME_US, START_MS - AirtimeLedger::BUCKET_MS);
+        REQUIRE(ledger.channelAirtimeUs(europe.baseFrequency, START_MS) == 3 * FRAME_US);
+    }
+
+    SECTION("Statistics")
+    {
+        etl::string<512> data;
+        etl::string_stream stream(data);
+        ledger.getData(stream, START_MS);
+        REQUIRE(data.find("\"FLARM\":{\"transmissions\":1,\"blocked\":0,\"lastAirtimeUs\":6000,\"utilizationPerMille\":0}") != etl::string<512>::npos);
+        REQUIRE(data.find("{\"frequency\":868200000,\"dutyCyclePerMille\":10,\"utilizationPerMille\":0}") != etl::string<512>::npos);
+    }
+}
+
+TEST_CASE("Duty cycle is enforced", "[single-file]")
+{
+    AirtimeLedger ledger;
+    const auto &europe = CountryRegulations::Europe;
+    const auto &paw = CountryRegulations::EuropePaw;
+
+    // Fill 1% of an hour on 868.2Mhz, ten frames per second
+    uint32_t now = START_MS;
+    uint32_t sent = 0;
+    while (ledger.allowed(OpenAce::DataSource::FLARM, europe.baseFrequency, europe.dutyCyclePerMille, now))
+    {
+        ledger.record(OpenAce::DataSource::FLARM, europe.baseFrequency, FRAME_US, now);
+        now += 100;
+        sent++;
+    }
+    REQUIRE(sent == AirtimeLedger::budgetUs(europe.dutyCyclePerMille) / FRAME_US);
+    REQUIRE(ledger.channelAirtimeUs(europe.baseFrequency, now) <= AirtimeLedger::budgetUs(europe.dutyCyclePerMille));
+    REQUIRE(ledger.protocols[(uint8_t)OpenAce::DataSource::FLARM].blocked == 1);
+
+    // Other channels are not affected
+    REQUIRE(ledger.allowed(OpenAce::DataSource::FLARM, europe.baseFrequency + europe.channelSeperation, europe.dutyCyclePerMille, now));
+    REQUIRE(ledger.allowed(OpenAce::DataSource::PAW, paw.baseFrequency, paw.dutyCyclePerMille, now));
+
+    // Allowed again when the first bucket leaves the window
+    REQUIRE(ledger.allowed(OpenAce::DataSource::FLARM, europe.baseFrequency, europe.dutyCyclePerMille, START_MS + AirtimeLedger::WINDOW_MS));
+}
+
+TEST_CASE("Channel entries are reused", "[single-file]")
+{
+    AirtimeLedger ledger;
+
+    for (uint32_t i = 0; i < AirtimeLedger::MAX_CHANNELS; i++)
+    {
+        uint32_t frequency = 868'000'000 + i * 100'000;
+        REQUIRE(ledger.allowed(OpenAce::DataSource::FLARM, frequency, 10, START_MS));
+        ledger.record(OpenAce::DataSource::FLARM, frequency, FRAME_US * (i + 1), START_MS);
+    }
+
+    SECTION("Channels with airtime are never forgotten")
+    {
+        REQUIRE_FALSE(ledger.allowed(OpenAce::DataSource::FLARM, 869'000'000, 10, START_MS));
+        REQUIRE(ledger.protocols[(uint8_t)OpenAce::DataSource::FLARM].blocked == 1);
+        REQUIRE(ledger.channelAirtimeUs(868'000'000, START_MS) == FRAME_US);
+        REQUIRE(ledger.channelAirtimeUs(869'000'000, START_MS) == 0);
+    }
+
+    SECTION("Entries without airtime in the window are reused")
+    {
+        uint32_t later = START_MS + AirtimeLedger::BUCKET_MS;
+        ledger.record(OpenAce::DataSource::FLARM, 868'200'000, FRAME_US, later);
+        later = START_MS + AirtimeLedger::WINDOW_MS;
+        REQUIRE(ledger.allowed(OpenAce::DataSource::FLARM, 869'000'000, 10, later));
+        REQUIRE(ledger.channelAirtimeUs(868'000'000, later) == 0);
+        REQUIRE(ledger.channelAirtimeUs(868'200'000, later) == FRAME_US);
+    }
+}
@@ -36,7 +36,7 @@ TEST_CASE ( "nextProtocolTimeslot", "[single-file]" )
     REQUIRE( 400  == countryRegulations.protocolTimeslotById(idx).slotStartTime );
 
     // Unconfigured ZONE/Datasource
-    idx = countryRegulations.nextProtocolTimeslot(0, CountryRegulations::Zone::ZONE2, OpenAce::DataSource::FLARM);
+    idx = countryRegulations.nextProtocolTimeslot(0, CountryRegulations::Zone::ZONE2, OpenAce::DataSource::ADSL);
     REQUIRE( CountryRegulations::Zone::ZONE0  == countryRegulations.protocolTimeslotById(idx).zone );
 }
 
@@ -63,6 +63,24 @@ TEST_CASE ( "findFittingTimeSlot", "[single-file]" )
     REQUIRE( 0  == countryRegulations.findFittingTimeslot(300, idx) );
 }
 
+TEST_CASE ( "msLeftInSlot", "[single-file]" )
+{
+    uint8_t idx = countryRegulations.getFirstSlotIdx(CountryRegulations::Zone::ZONE1, OpenAce::DataSource::FLARM);
+    const auto &first = countryRegulations.protocolTimeslotById(idx);
+    const auto &second = countryRegulations.protocolTimeslotById(first.nextSlotIdx);
+
+    REQUIRE( 400 == countryRegulations.msLeftInSlot(first, 400) );
+    REQUIRE( 1 == countryRegulations.msLeftInSlot(first, 799) );
+    REQUIRE( 0 == countryRegulations.msLeftInSlot(first, 800) );
+    REQUIRE( 0 == countryRegulations.msLeftInSlot(first, 300) );
+
+    // The second slot runs into the next second
+    REQUIRE( 300 == countryRegulations.msLeftInSlot(second, 900) );
+    REQUIRE( 150 == countryRegulations.msLeftInSlot(second, 50) );
+    REQUIRE( 0 == countryRegulations.msLeftInSlot(second, 200) );
+    REQUIRE( 0 == countryRegulations.msLeftInSlot(second, 700) );
+}
+
 TEST_CASE ( "protocolTimeslotById", "[single-file]" )
 {
     uint8_t idx;
@@ -79,4 +97,150 @@ TEST_CASE ( "getFirstSlotIdx", "[single-file]" )
     REQUIRE ( idx+1 == countryRegulations.nextSlotIdx(CountryRegulations::Zone::ZONE1, idx) );
     // FLARM has two slots for ZONE1, so should warm over
     REQUIRE ( idx == countryRegulations.nextSlotIdx(CountryRegulations::Zone::ZONE1, idx+1) );
-}
\ No newline at end of file
+}
+
+TEST_CASE ( "FANET slot", "[single-file]" )
+{
+    // Single slot in the gap between the GFSK slots
+    auto idx = countryRegulations.nextProtocolTimeslot(500, CountryRegulations::Zone::ZONE1, OpenAce::DataSource::FANET);
+    const auto &slot = countryRegulations.protocolTimeslotById(idx);
+    REQUIRE( slot.radioConfig.mode == Radio::Mode::LORA );
+    REQUIRE( 200 == slot.slotStartTime );
+    REQUIRE( idx == countryRegulations.nextSlotIdx(CountryRegulations::Zone::ZONE1, idx) );
+    REQUIRE( 0  != countryRegulations.findFittingTimeslot(300, idx) );
+    REQUIRE( 0  == countryRegulations.findFittingTimeslot(500, idx) );
+}
+
+TEST_CASE ( "PAW slot", "[single-file]" )
+{
+    // Two slots on a single frequency, received together with the other GFSK protocols
+    auto idx = countryRegulations.getFirstSlotIdx(CountryRegulations::Zone::ZONE1, OpenAce::DataSource::PAW);
+    const auto &slot = countryRegulations.protocolTimeslotById(idx);
+    REQUIRE( slot.radioConfig.mode == Radio::Mode::GFSK_NRZ );
+    REQUIRE( slot.radioConfig.packetLength == 24 );
+    REQUIRE( 869'525'000 == countryRegulations.determineFrequency(slot) );
+    REQUIRE( idx+1 == countryRegulations.nextSlotIdx(CountryRegulations::Zone::ZONE1, idx) );
+    REQUIRE( countryRegulations.determineFrequency(countryRegulations.protocolTimeslotById(idx+1)) == countryRegulations.determineFrequency(slot) );
+}
+
+TEST_CASE ( "Frequency hopping", "[single-file]" )
+{
+    constexpr uint64_t second = 1'718'000'000'000;
+    auto idx = countryRegulations.getFirstSlotIdx(CountryRegulations::Zone::ZONE2, OpenAce::DataSource::FLARM);
+    const auto &first = countryRegulations.protocolTimeslotById(idx);
+    const auto &next = countryRegulations.protocolTimeslotById(first.nextSlotIdx);
+    REQUIRE( 400 == first.slotStartTime );
+    REQUIRE( 800 == next.slotStartTime );
+
+    REQUIRE( 16 == countryRegulations.hoppingChannel(first, first.channelMethod, second + 400) );
+    REQUIRE( 908'600'000 == countryRegulations.determineFrequency(first, second + 400) );
+    REQUIRE( 917'400'000 == countryRegulations.determineFrequency(next, second + 800) );
+    // The second slot runs into the next second and keeps its channel
+    REQUIRE( 917'400'000 == countryRegulations.determineFrequency(next, second + 1'050) );
+    REQUIRE( 918'600'000 == countryRegulations.determineFrequency(first, second + 1'400) );
+
+    // OGN never uses the channel of FLARM
+    auto ognIdx = countryRegulations.getFirstSlotIdx(CountryRegulations::Zone::ZONE2, OpenAce::DataSource::OGN1);
+    const auto &ogn = countryRegulations.protocolTimeslotById(ognIdx);
+    const auto &ognNext = countryRegulations.protocolTimeslotById(ogn.nextSlotIdx);
+    REQUIRE( 909'000'000 == countryRegulations.determineFrequency(ogn, second + 400) );
+    for (uint64_t s = second; s < second + 1'000'000; s += 1'000)
+    {
+        auto flarmChannel = countryRegulations.hoppingChannel(first, first.channelMethod, s + 400);
+        auto ognChannel = countryRegulations.hoppingChannel(ogn, ogn.channelMethod, s + 400);
+        REQUIRE( flarmChannel < 65 );
+        REQUIRE( ognChannel < 65 );
+        REQUIRE( flarmChannel != ognChannel );
+        flarmChannel = countryRegulations.hoppingChannel(next, next.channelMethod, s + 800);
+        ognChannel = countryRegulations.hoppingChannel(ognNext, ognNext.channelMethod, s + 800);
+        REQUIRE( flarmChannel != ognChannel );
+    }
+
+    // Australia has 24 channels
+    idx = countryRegulations.getFirstSlotIdx(CountryRegulations::Zone::ZONE4, OpenAce::DataSource::FLARM);
+    REQUIRE( 925'000'000 == countryRegulations.determineFrequency(countryRegulations.protocolTimeslotById(idx), second + 400) );
+
+    // Single channel zones stay on their channel
+    idx = countryRegulations.getFirstSlotIdx(CountryRegulations::Zone::ZONE3, OpenAce::DataSource::FLARM);
+    REQUIRE( 869'250'000 == countryRegulations.determineFrequency(countryRegulations.protocolTimeslotById(idx), second + 400) );
+    idx = countryRegulations.getFirstSlotIdx(CountryRegulations::Zone::ZONE5, OpenAce::DataSource::FLARM);
+    REQUIRE( 916'200'000 == countryRegulations.determineFrequency(countryRegulations.protocolTimeslotById(countryRegulations.protocolTimeslotById(idx).nextSlotIdx), second + 800) );
+
+    // Europe keeps its two channels
+    idx = countryRegulations.getFirstSlotIdx(CountryRegulations::Zone::ZONE1, OpenAce::DataSource::FLARM);
+    REQUIRE( 868'200'000 == countryRegulations.determineFrequency(countryRegulations.protocolTimeslotById(idx), second + 400) );
+    REQUIRE( 868'400'000 == countryRegulations.determineFrequency(countryRegulations.protocolTimeslotById(idx + 1), second + 800) );
+}
+
+TEST_CASE ( "Generated slot tables", "[single-file]" )
+{
+    // idx is the position in the table and slots of the same zone and protocol point to each other
+    for (const auto &slot : CountryRegulations::timings)
+    {
+        REQUIRE( slot.idx == &slot - CountryRegulations::timings.data() );
+        const auto &other = countryRegulations.protocolTimeslotById(slot.nextSlotIdx);
+        REQUIRE( other.nextSlotIdx == slot.idx );
+        REQUIRE( other.zone == slot.zone );
+        REQUIRE( other.source == slot.source );
+    }
+
+    // The direct lookup gives the first slot that did not start yet, otherwise the first slot of the next second
+    for (uint8_t zone = CountryRegulations::Zone::ZONE0; zone <= CountryRegulations::Zone::ZONE6; zone++)
+    {
+        for (uint8_t source = 0; source < (uint8_t)OpenAce::DataSource::_TRANSPROTOCOLS; source++)
+        {
+            auto first = countryRegulations.getFirstSlotIdx((CountryRegulations::Zone)zone, (OpenAce::DataSource)source);
+            for (uint16_t ms = 0; ms < 1000; ms++)
+            {
+                uint8_t expected = first;
+                if (first != CountryRegulations::NONE_DATASOURCE.idx && ms > countryRegulations.protocolTimeslotById(first).slotStartTime)
+                {
+                    auto second = countryRegulations.protocolTimeslotById(first).nextSlotIdx;
+                    expected = ms <= countryRegulations.protocolTimeslotById(second).slotStartTime ? second : first;
+                }
+                REQUIRE( expected == countryRegulations.nextProtocolTimeslot(ms, (CountryRegulations::Zone)zone, (OpenAce::DataSource)source) );
+            }
+        }
+    }
+
+    // Out of range
+    REQUIRE( CountryRegulations::NONE_DATASOURCE.idx == countryRegulations.getFirstSlotIdx(CountryRegulations::Zone::ZONE1, OpenAce::DataSource::ADSB) );
+    REQUIRE( CountryRegulations::NONE_DATASOURCE.idx == countryRegulations.nextProtocolTimeslot(400, CountryRegulations::Zone::ZONE1, OpenAce::DataSource::ADSB) );
+}
+
+TEST_CASE ( "Hopping channels per UTC second and slot", "[single-file]" )
+{
+    // Channels in the 65 channel plan of north america, following getChannel() of esp32-ogn-tracker
+    struct Hop
+    {
+        uint32_t second;
+        uint8_t slot;
+        uint8_t flarm;
+        uint8_t ogn;
+    };
+    const Hop hops[] = {
+        {0, 0, 20, 21},
+        {0, 1, 4, 20},
+        {1, 0, 34, 35},
+        {1, 1, 14, 34},
+        {1'718'000'000, 0, 16, 17},
+        {1'718'000'000, 1, 38, 16},
+        {1'718'000'044, 0, 64, 0},  // OGN wraps around to the first channel
+        {1'718'000'044, 1, 3, 64},
+        {1'718'000'157, 0, 59, 60},
+        {1'718'000'157, 1, 59, 60}, // Same channel as FLARM, OGN moves up
+    };
+
+    auto flarmIdx = countryRegulations.getFirstSlotIdx(CountryRegulations::Zone::ZONE2, OpenAce::DataSource::FLARM);
+    auto ognIdx = countryRegulations.getFirstSlotIdx(CountryRegulations::Zone::ZONE2, OpenAce::DataSource::OGN1);
+    const CountryRegulations::ProtocolTimeSlot *flarm[] = {&countryRegulations.protocolTimeslotById(flarmIdx), &countryRegulations.protocolTimeslotById(countryRegulations.protocolTimeslotById(flarmIdx).nextSlotIdx)};
+    const CountryRegulations::ProtocolTimeSlot *ogn[] = {&countryRegulations.protocolTimeslotById(ognIdx), &countryRegulations.protocolTimeslotById(countryRegulations.protocolTimeslotById(ognIdx).nextSlotIdx)};
+    REQUIRE( 65 == flarm[0]->frequency.channels );
+
+    for (const auto &hop : hops)
+    {
+        uint64_t ms = hop.second * 1'000ull;
+        REQUIRE( hop.flarm == countryRegulations.hoppingChannel(*flarm[hop.slot], flarm[hop.slot]->channelMethod, ms + flarm[hop.slot]->slotStartTime) );
+        REQUIRE( hop.ogn == countryRegulations.hoppingChannel(*ogn[hop.slot], ogn[hop.slot]->channelMethod, ms + ogn[hop.slot]->slotStartTime) );
+    }
+}
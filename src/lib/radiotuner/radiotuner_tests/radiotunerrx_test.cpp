@@ -1,4 +1,3 @@
-
 #include <catch2/catch_test_macros.hpp>
 
 #define private public
@@ -9,97 +8,189 @@
 #include "pico/time.h"
 #include "etl/vector.h"
 
-using RadioProtocolCtx = RadioTunerRx::RadioProtocolCtx;
+using ReceivePlanner = RadioTunerRx::ReceivePlanner;
+using Listen = RadioTunerRx::Listen;
 OpenAce::ThreadSafeBus<50> bus;
 OpenAce::OwnshipPositionMsg ownshipPosition{};
 
-TEST_CASE("RadioProtocolCtx", "[single-file]")
+// Time of a window in a whole second
+static uint64_t at(uint16_t windowStart)
+{
+    return 1'718'000'000'000 + windowStart;
+}
+
+TEST_CASE("ReceivePlanner", "[single-file]")
 {
-    RadioProtocolCtx ctx{nullptr, nullptr};
+    RadioTunerRx::SlotRates slotRates;
+    ReceivePlanner planner;
+    auto zone = CountryRegulations::Zone::ZONE1;
 
-    etl::array<uint8_t, (uint8_t)OpenAce::DataSource::_TRANSPROTOCOLS> slotReceived = {};
+    auto flarm0 = CountryRegulations::getFirstSlotIdx(zone, OpenAce::DataSource::FLARM);
+    auto flarm1 = CountryRegulations::protocolTimeslotById(flarm0).nextSlotIdx;
+    auto ogn0 = CountryRegulations::getFirstSlotIdx(zone, OpenAce::DataSource::OGN1);
 
-    ctx.updateDataSources(etl::vector<OpenAce::DataSource, 1> {});
-    ctx.prioritizeDatasources();
-    REQUIRE(etl::vector<OpenAce::DataSource, 1> {} == ctx.dataSourceTimeSlots);
+    REQUIRE(planner.nextWindow(0, zone) == RadioTunerRx::NO_WINDOW);
 
-    SECTION("Prioritise should return 500ms on default zone", "[single-file]")
+    SECTION("No windows in ZONE0", "[single-file]")
     {
-        REQUIRE( ctx.advanceReceiveSlot(CountryRegulations::ZONE0) == 500);
+        planner.updateDataSources(etl::vector{OpenAce::DataSource::FLARM});
+        REQUIRE(planner.nextWindow(0, CountryRegulations::Zone::ZONE0) == RadioTunerRx::NO_WINDOW);
     }
-    SECTION("extra FLARM Data Source", "[single-file]")
+
+    SECTION("Windows start at the timeslots of the enabled datasources", "[single-file]")
     {
-        ctx.updateDataSources(etl::vector{OpenAce::DataSource::FLARM});
-        ctx.prioritizeDatasources();
-        REQUIRE(etl::vector{OpenAce::DataSource::FLARM} == ctx.dataSourceTimeSlots);
+        planner.updateDataSources(etl::vector{OpenAce::DataSource::FLARM, OpenAce::DataSource::FANET});
+        REQUIRE(planner.nextWindow(0, zone) == 200);
+        REQUIRE(planner.nextWindow(200, zone) == 400);
+        REQUIRE(planner.nextWindow(500, zone) == 800);
+        REQUIRE(planner.nextWindow(900, zone) == 200);
     }
 
-    SECTION("3 Data Sources", "[single-file]")
+    SECTION("One radio takes turns", "[single-file]")
     {
-        ctx.updateDataSources(etl::vector{OpenAce::DataSource::FLARM, OpenAce::DataSource::OGN1, OpenAce::DataSource::ADSL});
-        ctx.prioritizeDatasources();
-        REQUIRE(etl::vector{OpenAce::DataSource::FLARM, OpenAce::DataSource::OGN1, OpenAce::DataSource::ADSL} == ctx.dataSourceTimeSlots);
-
-        SECTION("FLARM Data Received", "[single-file]")
+        planner.updateDataSources(etl::vector{OpenAce::DataSource::FLARM, OpenAce::DataSource::OGN1});
+        REQUIRE(planner.plan(400, zone, slotRates, at(400)) == 0b1);
+        REQUIRE(planner.listens[0].slotIdx == flarm0);
+        REQUIRE(planner.listens[0].counted);
+        REQUIRE(planner.plan(400, zone, slotRates, at(400)) == 0b1);
+        REQUIRE(planner.listens[0].slotIdx == ogn0);
+        REQUIRE(planner.txRadio == 0);
+
+        SECTION("Busy timeslot is listened to more, but not only", "[single-file]")
         {
-            slotReceived[(uint8_t)(OpenAce::DataSource::FLARM)]++;
-            ctx.updateSlotReceive(slotReceived);
-            ctx.prioritizeDatasources();
-            REQUIRE(etl::vector{OpenAce::DataSource::FLARM, OpenAce::DataSource::FLARM, OpenAce::DataSource::OGN1, OpenAce::DataSource::ADSL} == ctx.dataSourceTimeSlots);
-
-            SECTION("OGN and FLARM Data Received", "[single-file]")
+            for (int i = 0; i < 8; i++)
             {
-                slotReceived[(uint8_t)(OpenAce::DataSource::FLARM)]++;
-                slotReceived[(uint8_t)(OpenAce::DataSource::OGN1)]++;
-                ctx.updateSlotReceive(slotReceived);
-                ctx.prioritizeDatasources();
-                REQUIRE(etl::vector{OpenAce::DataSource::FLARM, OpenAce::DataSource::FLARM, OpenAce::DataSource::OGN1, OpenAce::DataSource::OGN1, OpenAce::DataSource::ADSL} == ctx.dataSourceTimeSlots);
-                REQUIRE(*ctx.upcomingDataSource == OpenAce::DataSource::FLARM);
-
-                SECTION("Should be circular receive slots", "[single-file]")
-                {
-                    ctx.advanceReceiveSlot(CountryRegulations::Zone::ZONE1);
-                    REQUIRE(*ctx.upcomingDataSource == OpenAce::DataSource::FLARM);
-                    ctx.advanceReceiveSlot(CountryRegulations::Zone::ZONE1);
-                    REQUIRE(*ctx.upcomingDataSource == OpenAce::DataSource::OGN1);
-                    ctx.advanceReceiveSlot(CountryRegulations::Zone::ZONE1);
-                    REQUIRE(*ctx.upcomingDataSource == OpenAce::DataSource::OGN1);
-                    ctx.advanceReceiveSlot(CountryRegulations::Zone::ZONE1);
-                    REQUIRE(*ctx.upcomingDataSource == OpenAce::DataSource::ADSL);
-                    ctx.advanceReceiveSlot(CountryRegulations::Zone::ZONE1);
-                    // Here prioritsation should happen
-                    REQUIRE(*ctx.upcomingDataSource == OpenAce::DataSource::FLARM);
-                    ctx.advanceReceiveSlot(CountryRegulations::Zone::ZONE1);
-                    REQUIRE(*ctx.upcomingDataSource == OpenAce::DataSource::FLARM);
-                    ctx.advanceReceiveSlot(CountryRegulations::Zone::ZONE1);
-                    REQUIRE(*ctx.upcomingDataSource == OpenAce::DataSource::OGN1);
-                }
+                slotRates.update(flarm0, 4);
             }
-
-            SECTION("OGN Data, no FLARM Received", "[single-file]")
+            uint32_t flarmPicks = 0;
+            uint32_t ognPicks = 0;
+            for (int i = 0; i < 40; i++)
             {
-                slotReceived[(uint8_t)(OpenAce::DataSource::OGN1)]++;
-                ctx.updateSlotReceive(slotReceived);
-                ctx.prioritizeDatasources();
-                REQUIRE(etl::vector{OpenAce::DataSource::FLARM, OpenAce::DataSource::OGN1, OpenAce::DataSource::OGN1, OpenAce::DataSource::ADSL} == ctx.dataSourceTimeSlots);
-
-                SECTION("NO Data Received", "[single-file]")
-                {
-                    ctx.updateSlotReceive(slotReceived);
-                    ctx.prioritizeDatasources();
-                    REQUIRE(etl::vector{OpenAce::DataSource::FLARM, OpenAce::DataSource::OGN1, OpenAce::DataSource::ADSL} == ctx.dataSourceTimeSlots);
-                }
-
-                SECTION("Data sources removed", "[single-file]")
-                {
-                    ctx.updateDataSources(etl::vector<OpenAce::DataSource, 1> {});
-                    ctx.prioritizeDatasources();
-                    REQUIRE(etl::vector{etl::vector<OpenAce::DataSource, 1>{}} == ctx.dataSourceTimeSlots);
-                }
+                planner.plan(400, zone, slotRates, at(400));
+                flarmPicks += planner.listens[0].slotIdx == flarm0;
+                ognPicks += planner.listens[0].slotIdx == ogn0;
             }
+            REQUIRE(flarmPicks > 3 * ognPicks);
+            REQUIRE(ognPicks > 0);
         }
     }
+
+    SECTION("Timeslots of one datasource in the same window share the weight", "[single-file]")
+    {
+        planner.updateDataSources(etl::vector{OpenAce::DataSource::ADSL, OpenAce::DataSource::OGN1});
+        uint32_t adslPicks = 0;
+        uint32_t ognPicks = 0;
+        for (int i = 0; i < 40; i++)
+        {
+            planner.plan(800, zone, slotRates, at(800));
+            adslPicks += planner.listens[0].slot().source == OpenAce::DataSource::ADSL;
+            ognPicks += planner.listens[0].slot().source == OpenAce::DataSource::OGN1;
+        }
+        REQUIRE(adslPicks == ognPicks);
+    }
+
+    SECTION("Two radios cover both FLARM channels", "[single-file]")
+    {
+        planner.numRadios = 2;
+        planner.updateDataSources(etl::vector{OpenAce::DataSource::FLARM});
+        REQUIRE(planner.plan(400, zone, slotRates, at(400)) == 0b11);
+        REQUIRE(planner.listens[0].slotIdx == flarm0);
+        REQUIRE(planner.listens[0].counted);
+        REQUIRE(planner.listens[0].frequency == 868'200'000);
+        REQUIRE(planner.listens[1].frequency == 868'400'000);
+        REQUIRE_FALSE(planner.listens[1].counted);
+        REQUIRE(planner.txRadio == 1);
+
+        // FLARM hops to channel 1, both radios are already there
+        REQUIRE(planner.plan(800, zone, slotRates, at(800)) == 0);
+        REQUIRE(planner.listens[1].slotIdx == flarm1);
+        REQUIRE(planner.listens[1].counted);
+        REQUIRE_FALSE(planner.listens[0].counted);
+        REQUIRE(planner.txRadio == 0);
+    }
+
+    SECTION("Two radios never listen to the same protocol and frequency", "[single-file]")
+    {
+        planner.numRadios = 2;
+        planner.updateDataSources(etl::vector{OpenAce::DataSource::FLARM, OpenAce::DataSource::OGN1, OpenAce::DataSource::ADSL});
+        for (int i = 0; i < 20; i++)
+        {
+            planner.plan(i % 2 ? 800 : 400, zone, slotRates, at(i % 2 ? 800 : 400));
+            REQUIRE(planner.listens[0].valid());
+            REQUIRE(planner.listens[1].valid());
+            REQUIRE_FALSE(planner.listens[0].sameAs(planner.listens[1]));
+        }
+    }
+
+    SECTION("Hopping protocols are retuned every window", "[single-file]")
+    {
+        planner.numRadios = 2;
+        planner.updateDataSources(etl::vector{OpenAce::DataSource::FLARM});
+        auto hoppingZone = CountryRegulations::Zone::ZONE2;
+        auto first = CountryRegulations::getFirstSlotIdx(hoppingZone, OpenAce::DataSource::FLARM);
+
+        // Nothing to listen to on the other channel, the second radio has nothing to do
+        REQUIRE(planner.plan(400, hoppingZone, slotRates, at(400)) == 0b01);
+        REQUIRE(planner.listens[0].frequency == CountryRegulations::determineFrequency(CountryRegulations::protocolTimeslotById(first), at(400)));
+        REQUIRE(planner.plan(800, hoppingZone, slotRates, at(800)) == 0b10);
+        REQUIRE(planner.listens[1].frequency == 917'400'000);
+    }
+
+    SECTION("A radio without anything to do keeps listening", "[single-file]")
+    {
+        planner.numRadios = 2;
+        planner.updateDataSources(etl::vector{OpenAce::DataSource::PAW, OpenAce::DataSource::FANET});
+        REQUIRE(planner.plan(400, zone, slotRates, at(400)) == 0b01);
+        REQUIRE(planner.plan(200, zone, slotRates, at(200)) == 0b10);
+        REQUIRE(planner.listens[0].slot().source == OpenAce::DataSource::PAW);
+        REQUIRE_FALSE(planner.listens[0].counted);
+        REQUIRE(planner.listens[1].slot().source == OpenAce::DataSource::FANET);
+        REQUIRE(planner.txRadio == 0);
+    }
 }
+
+TEST_CASE("Frames are counted for the timeslots listened to", "[single-file]")
+{
+    RadioTunerRx::SlotRates slotRates;
+    ReceivePlanner planner;
+    planner.numRadios = 2;
+    RadioTunerRx::SlotReceive received = {};
+
+    auto flarm0 = CountryRegulations::getFirstSlotIdx(CountryRegulations::Zone::ZONE1, OpenAce::DataSource::FLARM);
+    auto flarm1 = CountryRegulations::protocolTimeslotById(flarm0).nextSlotIdx;
+    auto ogn0 = CountryRegulations::getFirstSlotIdx(CountryRegulations::Zone::ZONE1, OpenAce::DataSource::OGN1);
+
+    // Counters wrap, only the difference during the window counts
+    received[(uint8_t)OpenAce::DataSource::FLARM] = 254;
+    planner.account(slotRates, received);
+    REQUIRE(slotRates.rate[flarm0] == 0);
+
+    planner.listens[0] = Listen{flarm0, CountryRegulations::ChannelMethod::CHANNEL_0, true, 0};
+    planner.listens[1] = Listen{ogn0, CountryRegulations::ChannelMethod::CHANNEL_1, true, 0};
+    received[(uint8_t)OpenAce::DataSource::FLARM] += 8;
+    received[(uint8_t)OpenAce::DataSource::OGN1] += 3;
+    planner.account(slotRates, received);
+    REQUIRE(slotRates.rate[flarm0] == 8 * RadioTunerRx::SlotRates::RATE_ONE / RadioTunerRx::SlotRates::RATE_AVERAGE);
+    REQUIRE(slotRates.rate[ogn0] == 3 * RadioTunerRx::SlotRates::RATE_ONE / RadioTunerRx::SlotRates::RATE_AVERAGE);
+
+    // Both radios on FLARM share the frames
+    planner.listens[1] = Listen{flarm1, CountryRegulations::ChannelMethod::CHANNEL_1, true, 0};
+    received[(uint8_t)OpenAce::DataSource::FLARM] += 4;
+    planner.account(slotRates, received);
+    REQUIRE(slotRates.rate[flarm0] == 288);
+    REQUIRE(slotRates.rate[flarm1] == 64);
+
+    // Frames of the other channel are not counted
+    planner.listens[1].counted = false;
+    received[(uint8_t)OpenAce::DataSource::FLARM] += 8;
+    planner.account(slotRates, received);
+    REQUIRE(slotRates.rate[flarm0] == 508);
+    REQUIRE(slotRates.rate[flarm1] == 64);
+
+    // Both FLARM slots are averaged
+    REQUIRE(slotRates.dataSourceRate(CountryRegulations::Zone::ZONE1, OpenAce::DataSource::FLARM) == (508 + 64) / 2);
+}
+
 // TEST_CASE( "When ownship is received", "[single-file]" )
 // {
 //     auto radioController = RadioTunerRx{&bus};
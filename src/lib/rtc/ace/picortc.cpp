@@ -31,12 +31,12 @@ OpenAce::PostConstruct PicoRtc::postConstruct()
 
 void PicoRtc::start()
 {
-    getBus().subscribe(*this);
+    subscribe(*this);
 };
 
 void PicoRtc::stop()
 {
-    getBus().unsubscribe(*this);
+    unsubscribe(*this);
 };
 
 
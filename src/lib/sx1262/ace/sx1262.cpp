@@ -6,21 +6,26 @@
 #include "queue.h"
 #include "timers.h"
 
+/* PICO. */
+#include "pico/rand.h"
+
 /* OpenACE. */
 #include "etl/map.h"
+#include "etl/optional.h"
+#include "etl/algorithm.h"
 #include "ace/manchester.hpp"
 #include "ace/coreutils.hpp"
 
 void Sx1262::start()
 {
-    getBus().subscribe(*this);
+    subscribe(*this);
 
     // startListen();
 };
 
 void Sx1262::stop()
 {
-    getBus().unsubscribe(*this);
+    unsubscribe(*this);
     vQueueDelete(commandQueue);
     xTaskNotify(taskHandle, TaskState::DELETE, eSetBits);
 };
@@ -88,8 +93,17 @@ void Sx1262::getData(etl::string_stream &stream, const etl::string_view path) co
     stream << ",\"receivedPackets\":" << statistics.receivedPackets;
     stream << ",\"buzyWaitsTimeout\":" << statistics.buzyWaitsTimeout;
     stream << ",\"queueFull\":" << statistics.queueFull;
+    stream << ",\"framePoolEmpty\":" << statistics.framePoolEmpty;
+    stream << ",\"framePoolAvailable\":" << OpenAce::RadioFramePool::available();
     stream << ",\"txTimeout\":" << statistics.txTimeout;
     stream << ",\"txOk\":" << statistics.txOk;
+    stream << ",\"txChannelBusy\":" << statistics.txChannelBusy;
+    stream << ",\"txBackoff\":" << statistics.txBackoff;
+    stream << ",\"txDropped\":" << statistics.txDropped;
+    stream << ",\"retunes\":" << statistics.retunes;
+    stream << ",\"retuneSkipped\":" << statistics.retuneSkipped;
+    stream << ",\"crcErrors\":" << statistics.crcErrors;
+    stream << ",\"frameTooLong\":" << statistics.frameTooLong;
     stream << ",\"mode\":" << "\"" << Radio::modeString(statistics.mode) << "\"";
     stream << ",\"dataSource\":" << "\"" << OpenAce::dataSourceToString(statistics.dataSource) << "\"";
     stream << ",\"frequency\":" << statistics.frequency;
@@ -183,16 +197,16 @@ uint8_t Sx1262::receivedPacketLength() const
 
 bool Sx1262::applyNewLoraParameters(const Radio::ProtocolConfig &config)
 {
-    (void)config;
-    // // Set the Sync Word
-    // LoRa Sync Word, Differentiate the LoRa® signal for Public or Private Network
-    uint8_t data[] = {0xF4, 0x14};
-    sx126x_write_register(this, 0x0740, data, 2); // SX126X_REG_LR_SYNCWORD
+    sx126x_set_lora_mod_params(this, &DEFAULT_MOD_PARAMS_LORA);
+    // The driver also applies the inverted IQ workaround (register 0x0736) when setting the packet parameters
+    sx126x_set_lora_pkt_params(this, &DEFAULT_PKT_PARAMS_LORA);
 
-    // Optimizing the Inverted IQ Operation
-    sx126x_read_register(this, 0x0736, data, 1); // SX126X_REG_IQ_POLARITY
-    data[0] |= 0x04;
-    sx126x_write_register(this, 0x0736, data, 1);
+    // LoRa Sync Word, Differentiate the LoRa® signal for Public or Private Network
+    // A single byte in the protocol config, eg FANET uses 0xF1 which is written as 0xF4 0x14 to SX126X_REG_LR_SYNCWORD
+    if (sx126x_set_lora_sync_word(this, config.syncWord[0]) != SX126X_STATUS_OK)
+    {
+        return false;
+    }
 
     //     if (sx126x_buzy_wait(busyPin, 150000)) {
     //         statistics.buzyWaitsTimeout++;
@@ -220,37 +234,62 @@ void Sx1262::checkAndClearDeviceErrors()
 void Sx1262::configureSx1262(const RadioParameters &lastParameters, const RadioParameters &newParameters)
 {
     standBy();
-    if (newParameters.config.mode == Radio::Mode::GFSK)
+    statistics.retunes++;
+
+    // The SX1262 keeps it's configuration in standby, only write what changed since the last configuration
+    // Setting the packet type resets the modulation and packet parameters, so a new mode always configures all
+    bool modeChanged = lastParameters.config.mode != newParameters.config.mode;
+    bool protocolChanged = modeChanged || lastParameters.config.dataSource != newParameters.config.dataSource;
+
+    if (newParameters.config.mode == Radio::Mode::GFSK || newParameters.config.mode == Radio::Mode::GFSK_NRZ)
     {
-        // if (lastParameters.config.mode != newParameters.config.mode || true)
-        // {
-        sx126x_set_pkt_type(this, SX126X_PKT_TYPE_GFSK);
-        sx126x_clear_irq_status(this, SX126X_IRQ_ALL);
-        sx126x_set_gfsk_mod_params(this, &DEFAULT_MOD_PARAMS_GFSK);
-        // }
-
-        if (lastParameters.config.dataSource != newParameters.config.dataSource || true)
+        bool manchester = newParameters.config.mode == Radio::Mode::GFSK;
+        if (modeChanged)
+        {
+            sx126x_set_pkt_type(this, SX126X_PKT_TYPE_GFSK);
+            sx126x_clear_irq_status(this, SX126X_IRQ_ALL);
+            sx126x_set_gfsk_mod_params(this, manchester ? &DEFAULT_MOD_PARAMS_GFSK : &MOD_PARAMS_GFSK_NRZ);
+        }
+        else
+        {
+            statistics.retuneSkipped++;
+        }
+
+        if (protocolChanged)
         {
             //    printf("DataSource:%s\n",  OpenAce::dataSourceToString(newParameters.config.dataSource));
             auto pkt_params_gfsk = DEFAULT_PKG_PARAMS_GFSK;
             pkt_params_gfsk.preamble_len_in_bits = 1 * 8;
             pkt_params_gfsk.sync_word_len_in_bits = (newParameters.config.syncLength) * 8;
-            pkt_params_gfsk.pld_len_in_bytes = newParameters.config.packetLength * MANCHESTER;
+            pkt_params_gfsk.pld_len_in_bytes = newParameters.config.packetLength * (manchester ? MANCHESTER : 1);
 
             sx126x_set_gfsk_pkt_params(this, &pkt_params_gfsk);
 
             sx126x_set_ocp_value(this, (uint8_t)(60.0 / 2.5));
             sx126x_set_gfsk_sync_word(this, newParameters.config.syncWord.data(), newParameters.config.syncLength);
         }
+        else
+        {
+            statistics.retuneSkipped++;
+        }
         statistics.mode = newParameters.config.mode;
     }
     else if (newParameters.config.mode == Radio::Mode::LORA)
     {
-        // to implement
-        applyNewLoraParameters(newParameters.config);
+        if (protocolChanged)
+        {
+            if (modeChanged)
+            {
+                sx126x_set_pkt_type(this, SX126X_PKT_TYPE_LORA);
+                sx126x_clear_irq_status(this, SX126X_IRQ_ALL);
+            }
+            applyNewLoraParameters(newParameters.config);
+        }
+        else
+        {
+            statistics.retuneSkipped++;
+        }
         statistics.mode = newParameters.config.mode;
-
-        printf("Lora not yet supported");
     }
 
     if (lastParameters.frequency != newParameters.frequency)
@@ -259,6 +298,10 @@ void Sx1262::configureSx1262(const RadioParameters &lastParameters, const RadioP
         sx126x_set_rf_freq(this, newParameters.frequency + offset);
         statistics.frequency = newParameters.frequency + offset;
     }
+    else
+    {
+        statistics.retuneSkipped++;
+    }
 
     checkAndClearDeviceErrors();
 
@@ -285,7 +328,7 @@ void Sx1262::Listen()
     sx126x_set_rx(this, OPENACE_SX126X_MAX_RX_TIME);
 }
 
-void Sx1262::sendGFSKPacket(const RadioParameters &parameters, const uint8_t *data, uint8_t length)
+void Sx1262::sendPacket(const RadioParameters &parameters, const uint8_t *data, uint8_t length)
 {
     sx126x_set_dio_irq_params(this,
                               SX126X_IRQ_TX_DONE | SX126X_IRQ_TIMEOUT | SX126X_IRQ_CRC_ERROR | SX126X_IRQ_HEADER_ERROR | SX126X_IRQ_HEADER_VALID | SX126X_IRQ_SYNC_WORD_VALID | SX126X_IRQ_PREAMBLE_DETECTED,
@@ -301,6 +344,28 @@ void Sx1262::sendGFSKPacket(const RadioParameters &parameters, const uint8_t *da
     sx126x_set_tx(this, SX126X_MAX_TIMEOUT_IN_MS);
 }
 
+void Sx1262::sendGFSKPacket(const RadioParameters &parameters, const uint8_t *data, uint8_t length)
+{
+    if (parameters.config.mode == Radio::Mode::GFSK_NRZ)
+    {
+        sendPacket(parameters, data, length);
+        return;
+    }
+
+    uint8_t frame[OpenAce::RADIO_MAX_FRAME_LENGTH * MANCHESTER];
+    manchechesterEncode(frame, data, length);
+    sendPacket(parameters, frame, length * MANCHESTER);
+}
+
+uint32_t Sx1262::sendLoRaPacket(const RadioParameters &parameters, const uint8_t *data, uint8_t length)
+{
+    auto pkt_params_lora = DEFAULT_PKT_PARAMS_LORA;
+    pkt_params_lora.pld_len_in_bytes = length;
+    sx126x_set_lora_pkt_params(this, &pkt_params_lora);
+    sendPacket(parameters, data, length);
+    return sx126x_get_lora_time_on_air_in_ms(&pkt_params_lora, &DEFAULT_MOD_PARAMS_LORA);
+}
+
 void Sx1262::receiveGFSKPacket(Radio::RadioParameters const &parameters)
 {
     // 13.5.3 GetPacketStatus
@@ -313,15 +378,37 @@ void Sx1262::receiveGFSKPacket(Radio::RadioParameters const &parameters)
         constexpr uint8_t maxFrameLength = OpenAce::RADIO_MAX_FRAME_LENGTH * MANCHESTER;
         if (receivedFrameLength > 0 && receivedFrameLength <= maxFrameLength)
         {
+            auto buffer = OpenAce::RadioFramePool::acquire();
+            if (!buffer.valid())
+            {
+                statistics.framePoolEmpty++;
+                return;
+            }
+
+            if (parameters.config.mode == Radio::Mode::GFSK_NRZ)
+            {
+                if (receivedFrameLength > OpenAce::RADIO_MAX_FRAME_LENGTH)
+                {
+                    statistics.frameTooLong++;
+                    return;
+                }
+                // Not Manchester encoded, read straight into the pool buffer and mark all bits as good
+                sx126x_read_buffer(this, 0x00, (uint8_t *)buffer.frame(), receivedFrameLength);
+                memset(buffer.err(), 0, receivedFrameLength);
+                OpenAce::RadioRxFrame radioRxFrame{etl::move(buffer), receivedFrameLength, CoreUtils::secondsSinceEpoch(), (int8_t)(-pkt_status.rssi_sync / 2), parameters.frequency, parameters.config.dataSource};
+                sendToBus(radioRxFrame);
+                return;
+            }
+
             uint8_t data[maxFrameLength];
             sx126x_read_buffer(this, 0x00, data, receivedFrameLength);
 
-            OpenAce::RadioRxFrame RadioRxFrame{(uint8_t)(receivedFrameLength / MANCHESTER), CoreUtils::secondsSinceEpoch(), (int8_t)(-pkt_status.rssi_sync / 2), parameters.frequency, parameters.config.dataSource};
-
             // Seems like all GFSK packets are Manchester encoded.
-            manchesterDecode((uint8_t *)RadioRxFrame.frame, (uint8_t *)RadioRxFrame.err, data, receivedFrameLength);
-            sendToBus(RadioRxFrame);
-            // dumpBuffer((uint8_t *)RadioRxFrame.frame, RadioRxFrame.length);
+            // Decoded straight into the pool buffer, decoders read it from there without copying
+            manchesterDecode((uint8_t *)buffer.frame(), (uint8_t *)buffer.err(), data, receivedFrameLength);
+            OpenAce::RadioRxFrame radioRxFrame{etl::move(buffer), (uint8_t)(receivedFrameLength / MANCHESTER), CoreUtils::secondsSinceEpoch(), (int8_t)(-pkt_status.rssi_sync / 2), parameters.frequency, parameters.config.dataSource};
+            sendToBus(radioRxFrame);
+            // dumpBuffer((uint8_t *)radioRxFrame.frame(), radioRxFrame.length);
         }
         else
         {
@@ -332,6 +419,40 @@ void Sx1262::receiveGFSKPacket(Radio::RadioParameters const &parameters)
     // printf("\n");
 }
 
+void Sx1262::receiveLoRaPacket(Radio::RadioParameters const &parameters, sx126x_irq_mask_t irqStatus)
+{
+    // The chip checks the CRC of LoRa frames, no need to hand over bad frames
+    if (irqStatus & (SX126X_IRQ_CRC_ERROR | SX126X_IRQ_HEADER_ERROR))
+    {
+        statistics.crcErrors++;
+        return;
+    }
+
+    statistics.receivedPackets++;
+    uint8_t receivedFrameLength = receivedPacketLength();
+    if (receivedFrameLength == 0 || receivedFrameLength > OpenAce::RADIO_MAX_FRAME_LENGTH)
+    {
+        statistics.frameTooLong++;
+        return;
+    }
+
+    auto buffer = OpenAce::RadioFramePool::acquire();
+    if (!buffer.valid())
+    {
+        statistics.framePoolEmpty++;
+        return;
+    }
+
+    // LoRa frames are not Manchester encoded, read straight into the pool buffer and mark all bits as good
+    sx126x_read_buffer(this, 0x00, (uint8_t *)buffer.frame(), receivedFrameLength);
+    memset(buffer.err(), 0, receivedFrameLength);
+
+    sx126x_pkt_status_lora_t pkt_status;
+    sx126x_get_lora_pkt_status(this, &pkt_status);
+    OpenAce::RadioRxFrame radioRxFrame{etl::move(buffer), receivedFrameLength, CoreUtils::secondsSinceEpoch(), pkt_status.rssi_pkt_in_dbm, parameters.frequency, parameters.config.dataSource};
+    sendToBus(radioRxFrame);
+}
+
 sx126x_irq_mask_t Sx1262::getIrqStatus()
 {
     sx126x_irq_mask_t mask;
@@ -339,6 +460,63 @@ sx126x_irq_mask_t Sx1262::getIrqStatus()
     return mask;
 }
 
+bool Sx1262::channelClear(const RadioParameters &parameters)
+{
+    // Interrupts are polled, so nothing on DIO1
+    sx126x_set_dio_irq_params(this,
+                              SX126X_IRQ_CAD_DONE | SX126X_IRQ_CAD_DETECTED | SX126X_IRQ_PREAMBLE_DETECTED | SX126X_IRQ_SYNC_WORD_VALID,
+                              SX126X_IRQ_NONE, // Dio1
+                              SX126X_IRQ_NONE, // Dio2
+                              SX126X_IRQ_NONE  // Dio3
+                             );
+    sx126x_clear_irq_status(this, SX126X_IRQ_ALL);
+
+    bool clear = true;
+    if (parameters.config.mode == Radio::Mode::LORA)
+    {
+        // 13.1.8 SetCAD, the chip goes to standby when CAD is done
+        sx126x_set_cad_params(this, &cad_params_lora);
+        sx126x_set_cad(this);
+        sx126x_irq_mask_t irqStatus = getIrqStatus();
+        for (uint8_t waitedMs = 0; !(irqStatus & SX126X_IRQ_CAD_DONE) && waitedMs < CAD_TIMEOUT_MS; waitedMs++)
+        {
+            vTaskDelay(TASK_DELAY_MS(1));
+            irqStatus = getIrqStatus();
+        }
+        clear = (irqStatus & SX126X_IRQ_CAD_DETECTED) == 0;
+    }
+    else
+    {
+        // GFSK has no CAD, sample the RSSI on the channel. A frame that starts while listening also makes the channel busy
+        sx126x_set_rx_with_timeout_in_rtc_step(this, SX126X_RX_CONTINUOUS);
+        for (uint8_t i = 0; i < CARRIER_SENSE_SAMPLES && clear; i++)
+        {
+            busy_wait_us_32(CARRIER_SENSE_INTERVAL_US);
+            int16_t rssidBm = 0;
+            sx126x_get_rssi_inst(this, &rssidBm);
+            clear = rssidBm < CARRIER_SENSE_THRESHOLD_DBM;
+        }
+        clear = clear && (getIrqStatus() & SX126X_IRQ_PREAMBLE_DETECTED) == 0;
+    }
+
+    standBy();
+    return clear;
+}
+
+uint32_t Sx1262::backoffMs(const Radio::CarrierSense &carrierSense, uint32_t nowMs, uint32_t random)
+{
+    int32_t msLeft = static_cast<int32_t>(carrierSense.txBeforeMs - nowMs);
+    if (carrierSense.txBeforeMs == 0 || msLeft <= carrierSense.backoffMinMs || carrierSense.backoffMaxMs < carrierSense.backoffMinMs)
+    {
+        return 0;
+    }
+
+    // Keep the backoff inside the slot
+    uint32_t maxMs = etl::min<int32_t>(carrierSense.backoffMaxMs, msLeft - 1);
+    uint32_t backoff = carrierSense.backoffMinMs + random % (maxMs - carrierSense.backoffMinMs + 1);
+    return etl::max<uint32_t>(backoff, 1);
+}
+
 void Sx1262::rxMode(const RxMode &rxMode)
 {
     auto command = Command_t{rxMode};
@@ -367,6 +545,12 @@ void Sx1262::clearTXCallback(TimerHandle_t xTimer)
     xTaskNotify(handle, TaskState::CLEAR_TX, eSetBits);
 }
 
+void Sx1262::txBackoffCallback(TimerHandle_t xTimer)
+{
+    TaskHandle_t handle = (TaskHandle_t)pvTimerGetTimerID(xTimer);
+    xTaskNotify(handle, TaskState::TX_BACKOFF, eSetBits);
+}
+
 void Sx1262::sx1262Task(void *arg)
 {
     constexpr uint8_t GFSK_PACKET_INTERRUPT_STATUS = SX126X_IRQ_RX_DONE | SX126X_IRQ_PREAMBLE_DETECTED | SX126X_IRQ_SYNC_WORD_VALID;
@@ -374,13 +558,18 @@ void Sx1262::sx1262Task(void *arg)
     Sx1262 *sx1262 = static_cast<Sx1262 *>(arg);
     SpiModule *aceSpi = static_cast<SpiModule *>(BaseModule::moduleByName(*sx1262, SpiModule::NAME));
     TaskHandle_t taskHandle = xTaskGetCurrentTaskHandle();
-    TimerHandle_t txClearTimerHandle = xTimerCreate("txClearTimerHandle", TASK_DELAY_MS(12), pdFALSE, taskHandle, clearTXCallback); // TX takes about 5ms, 8ms to clear should be fine
+    TimerHandle_t txClearTimerHandle = xTimerCreate("txClearTimerHandle", TASK_DELAY_MS(TX_CLEAR_MARGIN_MS), pdFALSE, taskHandle, clearTXCallback); // GFSK TX takes about 5ms, 8ms to clear should be fine
+    TimerHandle_t txBackoffTimerHandle = xTimerCreate("txBackoffTimerHandle", TASK_DELAY_MS(1), pdFALSE, taskHandle, txBackoffCallback);
 
     Radio::RadioParameters lastRadioParameters{DEFAULT_PROTOCOL_CONFIG, 868'000'000, -100};
-    Radio::RadioParameters beforeSendConfig{DEFAULT_PROTOCOL_CONFIG, 868'200'000, -100};
+    // Parameters the chip was configured with for sending, to restore the receive parameters from
+    Radio::RadioParameters txRadioParameters{DEFAULT_PROTOCOL_CONFIG, 868'200'000, -100};
 
     aceSpi->aquireSlot(OPENOPENACE_SPI_DEFAULT_BUS_FREQUENCY, taskHandle);
     bool txMode = false;
+    uint64_t txStartUs = 0;
+    // Transmission that found the channel busy, send again when the backoff timer expired
+    etl::optional<Radio::TxPacket> txBackoffPacket;
     while (true)
     {
         if (uint32_t notifyValue = ulTaskNotifyTake(pdTRUE, TASK_DELAY_MS(OPENACE_SX126X_MAX_RX_TIME)))
@@ -392,7 +581,16 @@ void Sx1262::sx1262Task(void *arg)
                 // Read device status to validate if there is anything to do
                 auto irqStatus = sx1262->getIrqStatus();
                 // printf("IRQ Status: %d %ld\n", irqStatus, notifyValue);
-                if ((irqStatus & GFSK_PACKET_INTERRUPT_STATUS) == GFSK_PACKET_INTERRUPT_STATUS)
+                if (lastRadioParameters.config.mode == Radio::Mode::LORA)
+                {
+                    // LoRa has no sync word valid interrupt, RX_DONE is also set for frames with a CRC error
+                    if (irqStatus & SX126X_IRQ_RX_DONE)
+                    {
+                        sx1262->receiveLoRaPacket(lastRadioParameters, irqStatus);
+                        sx1262->Listen();
+                    }
+                }
+                else if ((irqStatus & GFSK_PACKET_INTERRUPT_STATUS) == GFSK_PACKET_INTERRUPT_STATUS)
                 {
                     // printf("Packet RX: %s %d\n", OpenAce::dataSourceToString(lastRadioParameters.config.dataSource), CoreUtils::msInSecond());
                     sx1262->receiveGFSKPacket(lastRadioParameters);
@@ -404,16 +602,23 @@ void Sx1262::sx1262Task(void *arg)
                     //                    printf("TX_CLEAR %d\n", CoreUtils::msInSecond());
                     sx1262->statistics.txTimeout++;
                 }
-                if (irqStatus & SX126X_IRQ_TX_DONE)
+                if (irqStatus & SX126X_IRQ_TX_DONE || notifyValue & TaskState::CLEAR_TX)
                 {
-                    //                    printf("TX_DONE %d\n", CoreUtils::msInSecond());
-                    sx1262->statistics.txOk++;
+                    if (irqStatus & SX126X_IRQ_TX_DONE)
+                    {
+                        //                    printf("TX_DONE %d\n", CoreUtils::msInSecond());
+                        sx1262->statistics.txOk++;
+                    }
+                    // Includes the time to handle the interrupt, so the airtime is a little on the safe side
+                    // Without TX_DONE the frame most likely went out, the time until the timeout covers all of it's airtime
+                    uint32_t airtimeUs = CoreUtils::usSinceBoot() - txStartUs;
+                    sx1262->getBus().receive(OpenAce::RadioTxDoneMsg{txRadioParameters.config.dataSource, txRadioParameters.frequency, airtimeUs, CoreUtils::msSinceBoot(), sx1262->radioNo});
                 }
 
                 if (irqStatus & SX126X_IRQ_TX_DONE || notifyValue & TaskState::CLEAR_TX)
                 {
                     xTimerStop(txClearTimerHandle, TASK_DELAY_MS(5));
-                    sx1262->configureSx1262(beforeSendConfig, lastRadioParameters);
+                    sx1262->configureSx1262(txRadioParameters, lastRadioParameters);
                     sx1262->Listen();
                     txMode = false;
                     // printf("TX_HANDLE %d\n", CoreUtils::msInSecond());
@@ -421,13 +626,25 @@ void Sx1262::sx1262Task(void *arg)
 
                 if (notifyValue & TaskState::FAILSAVE_LISTEN_MODE)
                 {
-                    sx1262->configureSx1262(beforeSendConfig, lastRadioParameters);
+                    // Nothing is known about the state of the chip, configure everything again
+                    sx1262->configureSx1262(Radio::RadioParameters{DEFAULT_PROTOCOL_CONFIG, 0, -100}, lastRadioParameters);
                     sx1262->Listen();
                     txMode = false;
                 }
 
                 if (!txMode)
                 {
+                    // The backoff is over, the transmission goes before other commands
+                    if (txBackoffPacket.has_value() && xTimerIsTimerActive(txBackoffTimerHandle) == pdFALSE)
+                    {
+                        Command_t retry{*txBackoffPacket};
+                        if (xQueueSendToFront(sx1262->commandQueue, &retry, 0) == pdFALSE)
+                        {
+                            sx1262->statistics.txDropped++;
+                        }
+                        txBackoffPacket.reset();
+                    }
+
                     // Read the next command if available
                     Command_t command;
                     BaseType_t hasData = xQueueReceive(sx1262->commandQueue, &command, 0);
@@ -447,15 +664,43 @@ void Sx1262::sx1262Task(void *arg)
                         {
                             if (sx1262->txEnabled)
                             {
-                                beforeSendConfig = lastRadioParameters;
-                                sx1262->configureSx1262(lastRadioParameters, command.txPacket.radioParameters);
-
-                                uint8_t frame[OpenAce::RADIO_MAX_FRAME_LENGTH * 2];
-                                manchechesterEncode(frame, command.txPacket.data.data(), command.txPacket.length);
-
-                                sx1262->sendGFSKPacket(command.txPacket.radioParameters, frame, command.txPacket.length * 2);
+                                const auto &txParameters = command.txPacket.radioParameters;
+                                sx1262->configureSx1262(lastRadioParameters, txParameters);
+                                txRadioParameters = txParameters;
+
+                                // Listen before talk, when the channel is busy try again after a random backoff within the slot
+                                if (txParameters.carrierSense.txBeforeMs != 0 && !sx1262->channelClear(txParameters))
+                                {
+                                    sx1262->statistics.txChannelBusy++;
+                                    uint32_t backoff = backoffMs(txParameters.carrierSense, CoreUtils::msSinceBoot(), get_rand_32());
+                                    if (backoff != 0 && !txBackoffPacket.has_value())
+                                    {
+                                        txBackoffPacket.emplace(command.txPacket);
+                                        xTimerChangePeriod(txBackoffTimerHandle, TASK_DELAY_MS(backoff), TASK_DELAY_MS(5));
+                                        sx1262->statistics.txBackoff++;
+                                    }
+                                    else
+                                    {
+                                        sx1262->statistics.txDropped++;
+                                    }
+                                    sx1262->configureSx1262(txParameters, lastRadioParameters);
+                                    sx1262->Listen();
+                                    break;
+                                }
+
+                                uint32_t clearTxMs = TX_CLEAR_MARGIN_MS;
+                                txStartUs = CoreUtils::usSinceBoot();
+                                if (txParameters.config.mode == Radio::Mode::LORA)
+                                {
+                                    clearTxMs += sx1262->sendLoRaPacket(txParameters, command.txPacket.data.data(), command.txPacket.length);
+                                }
+                                else
+                                {
+                                    sx1262->sendGFSKPacket(txParameters, command.txPacket.data.data(), command.txPacket.length);
+                                }
                                 txMode = true;
-                                xTimerStart(txClearTimerHandle, TASK_DELAY_MS(5));
+                                // Changing the period also starts the timer
+                                xTimerChangePeriod(txClearTimerHandle, TASK_DELAY_MS(clearTxMs), TASK_DELAY_MS(5));
                             }
                             // printf("TX REQ %s %d\n",OpenAce::dataSourceToString(command.txPacket.radioParameters.config.dataSource), CoreUtils::msInSecond());
                             break;
@@ -472,6 +717,7 @@ void Sx1262::sx1262Task(void *arg)
                 if (notifyValue & TaskState::DELETE)
                 {
                     xTimerStop(txClearTimerHandle, TASK_DELAY_MS(5));
+                    xTimerStop(txBackoffTimerHandle, TASK_DELAY_MS(5));
                     vTaskDelete(nullptr);
                     return;
                 }
@@ -38,7 +38,7 @@ class Sx1262 : public Radio, public etl::message_router<Sx1262, OpenAce::RadioTx
     static constexpr uint8_t MANCHESTER = 2;               // Used to just clarify why we sometime multiply by 2
     static constexpr uint8_t CRCBYTES = 2;                 // Used for clarifications in calculations
 
-    enum TaskState : uint8_t
+    enum TaskState : uint16_t
     {
         DELETE = 1 << 0,
         START = 1 << 1,
@@ -47,7 +47,8 @@ class Sx1262 : public Radio, public etl::message_router<Sx1262, OpenAce::RadioTx
         WAIT_FOR_IRQ = 1 << 4,
         WAIT_FOR_TX_DONE = 1 << 5,
         NEW_COMMAND = 1 << 6,
-        CLEAR_TX = 1 << 7
+        CLEAR_TX = 1 << 7,
+        TX_BACKOFF = 1 << 8
     };
 
     mutable struct
@@ -57,8 +58,16 @@ class Sx1262 : public Radio, public etl::message_router<Sx1262, OpenAce::RadioTx
         uint32_t receivedPackets = 0;
         uint32_t buzyWaitsTimeout = 0;
         uint32_t queueFull = 0;
+        uint32_t framePoolEmpty = 0;
         uint32_t txTimeout = 0;
         uint32_t txOk = 0;
+        uint32_t txChannelBusy = 0; // Channel was busy when we wanted to transmit
+        uint32_t txBackoff = 0;     // Transmissions tried again after a random backoff
+        uint32_t txDropped = 0;     // Channel stayed busy until the end of the slot
+        uint32_t crcErrors = 0;    // LoRa frames only, GFSK frames are checked by the protocol modules
+        uint32_t frameTooLong = 0; // LoRa and NRZ GFSK frames that do not fit in a RadioFramePool buffer
+        uint32_t retunes = 0;
+        uint32_t retuneSkipped = 0; // Parts of a retune that were already configured
         Radio::Mode mode=Radio::Mode::NONE;
         OpenAce::DataSource dataSource=OpenAce::DataSource::NONE;
         uint32_t frequency=0;
@@ -103,6 +112,15 @@ class Sx1262 : public Radio, public etl::message_router<Sx1262, OpenAce::RadioTx
         .bw_dsb_param = SX126X_GFSK_BW_125000         // 
     };
 
+    // PilotAware: 38.4kbps NRZ, 9.6Khz deviation
+    static constexpr sx126x_mod_params_gfsk_t MOD_PARAMS_GFSK_NRZ =
+    {
+        .br_in_bps = 38400,
+        .fdev_in_hz = 9600,
+        .pulse_shape = SX126X_GFSK_PULSE_SHAPE_BT_05,
+        .bw_dsb_param = SX126X_GFSK_BW_58600          // 2 * (fdev + br / 2)
+    };
+
     // static constexpr sx126x_mod_params_gfsk_t mod_params_gfsk_adsl =
     // {
     //     .br_in_bps = 100000,  // 100Kbps
@@ -114,6 +132,36 @@ class Sx1262 : public Radio, public etl::message_router<Sx1262, OpenAce::RadioTx
     // ************************************************************************************
     // LORA
 
+    // FANET: SF7, 250Khz, CR 4/5, explicit header with CRC
+    // 13.4.5 SetModulationParams
+    static constexpr sx126x_mod_params_lora_t DEFAULT_MOD_PARAMS_LORA =
+    {
+        .sf = SX126X_LORA_SF7,
+        .bw = SX126X_LORA_BW_250,
+        .cr = SX126X_LORA_CR_4_5,
+        .ldro = 0 // Only needed when a symbol takes longer than 16ms
+    };
+
+    // 13.4.6 SetPacketParams
+    static constexpr sx126x_pkt_params_lora_t DEFAULT_PKT_PARAMS_LORA =
+    {
+        .preamble_len_in_symb = 8,
+        .header_type = SX126X_LORA_PKT_EXPLICIT,
+        .pld_len_in_bytes = 255, // Receive any length, the explicit header holds the actual length. SET per packet on TX
+        .crc_is_on = true,
+        .invert_iq_is_on = false
+    };
+
+    // Margin on top of the time on air before a transmission is considered timed out
+    static constexpr uint32_t TX_CLEAR_MARGIN_MS = 12;
+
+    // Listen before talk for GFSK, the channel is busy when one of the RSSI samples is above the threshold
+    static constexpr int16_t CARRIER_SENSE_THRESHOLD_DBM = -90;
+    static constexpr uint8_t CARRIER_SENSE_SAMPLES = 4;
+    static constexpr uint32_t CARRIER_SENSE_INTERVAL_US = 250;
+    // Listen before talk for LoRa, CAD of 8 symbols takes about 4ms at SF7 250Khz
+    static constexpr uint8_t CAD_TIMEOUT_MS = 10;
+
     // 13.1.8 SetCAD
     // CAD is only used by LORA
     static constexpr sx126x_cad_params_t cad_params_lora =
@@ -228,15 +276,33 @@ public:
     void radioInit();
     void checkAndClearDeviceErrors();
     void receiveGFSKPacket(Radio::RadioParameters const &parameters);
+    void receiveLoRaPacket(Radio::RadioParameters const &parameters, sx126x_irq_mask_t irqStatus);
+    void sendPacket(const RadioParameters &parameters, const uint8_t *data, uint8_t length);
     void sendGFSKPacket(const RadioParameters &parameters, const uint8_t *data, uint8_t length);
+    /**
+     * Send a LoRa packet as is, returns the time on air in ms
+     */
+    uint32_t sendLoRaPacket(const RadioParameters &parameters, const uint8_t *data, uint8_t length);
     void configureSx1262(const RadioParameters &lastParameters, const RadioParameters &newParameters);
     bool applyNewLoraParameters(const Radio::ProtocolConfig &parameters);
     sx126x_irq_mask_t getIrqStatus();
 
+    /**
+     * Listen on the frequency the chip is configured for, CAD for LoRa and RSSI for GFSK
+     * Leaves the chip in standby, returns false when the channel is busy
+     */
+    bool channelClear(const RadioParameters &parameters);
+
+    /**
+     * Random backoff from the carrier sense parameters, 0 when there is no time left in the slot to back off
+     */
+    static uint32_t backoffMs(const Radio::CarrierSense &carrierSense, uint32_t nowMs, uint32_t random);
+
     void Listen();
     void standBy();
 
     static void clearTXCallback(TimerHandle_t xTimer);
+    static void txBackoffCallback(TimerHandle_t xTimer);
     static void sx1262Task(void *arg);
 
     uint8_t receivedPacketLength() const;
@@ -13,6 +13,9 @@
 #include "ace/basemodule.hpp"
 #include "ace/coreutils.hpp"
 
+// BUSY is high for a few us after most commands, spin for it before giving up the task for a whole tick
+static constexpr uint32_t BUSY_SPIN_US = 100;
+
 /**
  * Wait for BUZY pin to go low or timeout.
  * When BUZY is low, the SX1262 is ready for new commands
@@ -20,6 +23,15 @@
  */
 uint8_t sx126x_buzy_wait(uint8_t busyPin, uint32_t timeoutMs)
 {
+    auto startUs = time_us_32();
+    while (gpio_get(busyPin))
+    {
+        if (time_us_32() - startUs > BUSY_SPIN_US)
+        {
+            break;
+        }
+    }
+
     auto startTime = CoreUtils::msSinceBoot();
     while (gpio_get(busyPin))
     {
@@ -47,10 +59,10 @@ sx126x_hal_status_t sx126x_hal_write(const void *context, const uint8_t *command
     else
     {
         spi->cs_select(sx1262->cs());
-        spi_write_blocking(OPENACE_SPI_DEFAULT, command, command_length);
+        spi->write_data(command, command_length);
         if (data_length != 0)
         {
-            spi_write_blocking(OPENACE_SPI_DEFAULT, data, data_length);
+            spi->write_data(data, data_length);
         }
     }
     spi->cs_deselect(sx1262->cs());
@@ -72,7 +84,7 @@ sx126x_hal_status_t sx126x_hal_read(const void *context, const uint8_t *command,
     else
     {
         spi->cs_select(sx1262->cs());
-        int length = spi_write_blocking(OPENACE_SPI_DEFAULT, command, command_length);
+        int length = spi->write_data(command, command_length);
         if (length != command_length)
         {
             puts("sx126x_hal_read write error");
@@ -80,7 +92,7 @@ sx126x_hal_status_t sx126x_hal_read(const void *context, const uint8_t *command,
         }
         else
         {
-            length = spi_read_blocking(OPENACE_SPI_DEFAULT, 0, data, data_length);
+            length = spi->read_data(data, data_length);
             if (length != data_length)
             {
                 puts("sx126x_hal_read read error");
@@ -16,7 +16,7 @@
 // FindVectors65432bit(10,20,23, 500) => 208, Delta=2579
 
 // every row represents a parity check to be performed on the received codeword
-static const uint32_t LDPC_ParityCheck_n208k160[48][7]
+const uint32_t LDPC_ParityCheck_n208k160[48][7]
 #ifdef __AVR__
 PROGMEM
 #endif
@@ -829,6 +829,203 @@ uint8_t LDPC_Check(const uint8_t *Data) // 20 data bytes followed by 6 parity by
     }
     return Errors;
 }
+
+// ===================================================================================================================
+
+void LDPC_FastDecoder::Input(const uint8_t *Data, const uint8_t *Err)
+{
+    for(uint8_t Idx=0; Idx<CodeWords; Idx++)
+    {
+        HardBit[Idx]=0;
+        EraseBit[Idx]=0;
+    }
+    for(uint8_t Idx=0; Idx<CodeBytes; Idx++)
+    {
+        uint8_t Shift = (Idx&3)<<3;
+        HardBit[Idx>>2]  |= (uint32_t)Data[Idx]<<Shift;
+        EraseBit[Idx>>2] |= (uint32_t)Err[Idx]<<Shift;
+    }
+    for(uint8_t Bit=0; Bit<CodeBits; Bit++)
+    {
+        uint32_t Mask = (uint32_t)1<<(Bit&31);
+        int8_t Inp;
+        if(EraseBit[Bit>>5]&Mask) Inp=0;
+        else Inp=(HardBit[Bit>>5]&Mask) ? +InpAmpl:-InpAmpl;
+        OutBit[Bit] = InpBit[Bit] = Inp;
+    }
+}
+
+int8_t LDPC_FastDecoder::NearAmpl(int8_t RssidBm)
+{
+    if(RssidBm<=WeakRssidBm) return InpAmpl;
+    if(RssidBm>=StrongRssidBm) return InpAmpl/4;
+    return InpAmpl - (InpAmpl*3/4)*(RssidBm-WeakRssidBm)/(StrongRssidBm-WeakRssidBm);
+}
+
+void LDPC_FastDecoder::Input(const uint8_t *Data, const uint8_t *Err, int8_t RssidBm)
+{
+    Input(Data, Err);
+    int8_t Ampl = NearAmpl(RssidBm);
+    if(Ampl>=InpAmpl) return;
+    for(uint8_t Idx=0; Idx<CodeBytes; Idx++)
+    {
+        // bits are sent MSB first, so the LSB of a byte is followed by the MSB of the next byte
+        uint8_t Near = (Err[Idx]<<1) | (Err[Idx]>>1);
+        if(Idx>0) Near |= Err[Idx-1]<<7;
+        if(Idx<CodeBytes-1) Near |= Err[Idx+1]>>7;
+        Near &= ~Err[Idx];
+        for(uint8_t Bit=Idx<<3; Near; Bit++, Near>>=1)
+        {
+            if(Near&1) OutBit[Bit] = InpBit[Bit] = InpBit[Bit]>0 ? Ampl:-Ampl;
+        }
+    }
+}
+
+void LDPC_FastDecoder::Output(uint8_t Data[CodeBytes]) const
+{
+    for(uint8_t Idx=0; Idx<CodeBytes; Idx++)
+    {
+        Data[Idx] = HardBit[Idx>>2]>>((Idx&3)<<3);
+    }
+}
+
+uint8_t LDPC_FastDecoder::BitFlip(uint8_t Loops)
+{
+    uint8_t Errors=0;
+    for(uint8_t Loop=0; ; Loop++)
+    {
+        // bit-sliced counters of failed checks per bit, erased bits start with one so they flip first
+        uint32_t Count0[CodeWords], Count1[CodeWords], Count2[CodeWords], Failed[CodeWords];
+        for(uint8_t Idx=0; Idx<CodeWords; Idx++)
+        {
+            Count0[Idx]=EraseBit[Idx];
+            Count1[Idx]=Count2[Idx]=Failed[Idx]=0;
+        }
+        Errors=0;
+        for(uint8_t Row=0; Row<ParityBits; Row++)
+        {
+            const uint32_t *Check=LDPC_ParityCheck_n208k160[Row];
+            uint8_t Count=0;
+            for(uint8_t Idx=0; Idx<CodeWords; Idx++)
+            {
+                Count+=Count1s(HardBit[Idx]&Check[Idx]);
+            }
+            if((Count&1)==0) continue;
+            Errors++;
+            for(uint8_t Idx=0; Idx<CodeWords; Idx++)                // add one to the counters of the bits in this check
+            {
+                uint32_t Carry=Check[Idx];
+                Failed[Idx] |= Carry;
+                uint32_t Next=Count0[Idx]&Carry;
+                Count0[Idx]^=Carry;
+                Carry=Next;
+                Next=Count1[Idx]&Carry;
+                Count1[Idx]^=Carry;
+                Count2[Idx]|=Next;                                      // 4 and more share the top plane
+            }
+        }
+        if(Errors==0 || Loop>=Loops) break;
+        // select the bits of failed checks with the highest count, one bit plane at a time
+        const uint32_t *Planes[3] = { Count2, Count1, Count0 };
+        for(uint8_t Plane=0; Plane<3; Plane++)
+        {
+            uint32_t Any=0;
+            for(uint8_t Idx=0; Idx<CodeWords; Idx++)
+            {
+                Any|=Failed[Idx]&Planes[Plane][Idx];
+            }
+            if(Any==0) continue;
+            for(uint8_t Idx=0; Idx<CodeWords; Idx++)
+            {
+                Failed[Idx]&=Planes[Plane][Idx];
+            }
+        }
+        for(uint8_t Idx=0; Idx<CodeWords; Idx++)
+        {
+            HardBit[Idx]^=Failed[Idx];
+            EraseBit[Idx]&=~Failed[Idx];                              // a flipped bit is no longer in doubt
+        }
+    }
+    return Errors;
+}
+
+uint8_t LDPC_FastDecoder::ProcessChecks(void)
+{
+    for(uint8_t Bit=0; Bit<CodeBits; Bit++)
+        ExtBit[Bit]=0;
+    uint8_t Count=0;
+    for(uint8_t Row=0; Row<ParityBits; Row++)
+    {
+        uint8_t MinAmpl=127;
+        uint8_t MinAmpl2=MinAmpl;                                      // look for 1st and 2nd smallest LL
+        uint8_t MinBit=0;
+        uint32_t Word=0;
+        uint32_t Mask=1;
+        const uint8_t *CheckIndex = LDPC_ParityCheckIndex_n208k160[Row];
+        uint8_t CheckWeight = *CheckIndex++;
+        for(uint8_t Bit=0; Bit<CheckWeight; Bit++)
+        {
+            int8_t Ampl=OutBit[CheckIndex[Bit]];
+            if(Ampl>0) Word|=Mask;
+            Mask<<=1;
+            uint8_t Abs = Ampl<0 ? -Ampl:Ampl;                          // OutBit is kept within +/-127
+            if(Abs<MinAmpl)
+            {
+                MinAmpl2=MinAmpl;
+                MinAmpl=Abs;
+                MinBit=Bit;
+            }
+            else if(Abs<MinAmpl2)
+            {
+                MinAmpl2=Abs;
+            }
+        }
+        uint8_t CheckFails = Count1s(Word)&1;
+        if(CheckFails || MinAmpl==0) Count++;
+        Mask=1;
+        for(uint8_t Bit=0; Bit<CheckWeight; Bit++)
+        {
+            int16_t Ampl = Bit==MinBit ? MinAmpl2 : MinAmpl;
+            if(CheckFails) Ampl=(-Ampl);
+            ExtBit[CheckIndex[Bit]] += (Word&Mask) ? Ampl:-Ampl;
+            Mask<<=1;
+        }
+    }
+    if(Count==0) return 0;
+    for(uint8_t Bit=0; Bit<CodeBits; Bit++)
+    {
+        int16_t Out = InpBit[Bit] + (ExtBit[Bit]>>1);
+        if(Out>127) Out=127;
+        else if(Out<(-127)) Out=(-127);
+        OutBit[Bit] = Out;
+    }
+    return Count;
+}
+
+uint8_t LDPC_FastDecoder::Decode(const uint8_t *Data, const uint8_t *Err, uint8_t Loops)
+{
+    Input(Data, Err);
+    return Decode(Loops);
+}
+
+uint8_t LDPC_FastDecoder::Decode(uint8_t Loops)
+{
+    if(Check()==0) return 0;                                        // received without errors
+    if(BitFlip()==0) return 0;                                      // few errors, corrected by bit-flipping
+    uint8_t Count;
+    do
+    {
+        Count=ProcessChecks();
+    } while((Loops--) && Count);
+    for(uint8_t Idx=0; Idx<CodeWords; Idx++)
+        HardBit[Idx]=0;
+    for(uint8_t Bit=0; Bit<CodeBits; Bit++)
+    {
+        if(OutBit[Bit]>0) HardBit[Bit>>5] |= (uint32_t)1<<(Bit&31);
+    }
+    return Count;
+}
+
 #ifdef WITH_PPM
 uint8_t LDPC_Check_n354k160(const uint32_t *Data, const uint32_t *Parity) // Data and Parity are 32-bit words
 {
@@ -73,6 +73,7 @@ uint8_t LDPC_Check_n354k160(const uint32_t *Data);
 
 #ifndef __AVR__
 
+extern const uint32_t LDPC_ParityCheck_n208k160[48][7];
 extern const uint8_t LDPC_ParityCheckIndex_n208k160[48][24];
 
 template< int SIZE_BITS, int PARITY_BITS >
@@ -250,6 +251,59 @@ public:
 
 } ;
 
+// Fast decoder for the n208k160 code, corrects as many frames as LDPC_Decoder<160,48> but does less work:
+// 1. the packed hard bits are checked first: most frames are received without errors
+// 2. a hard-decision bit-flipping pass on the packed parity check words corrects the few bit errors cases
+// 3. only the remaining frames go through the (int8) min-sum loop over the parity check index table
+// More than one bit-flipping loop converges too often to a wrong codeword, see ldpc_test.cpp
+// With the RSSI the input is graded: on a strong signal a Manchester error is likely caused by interference which
+// hits a burst of chips, so the bits next to it get a lower amplitude. Near the sensitivity the errors are caused
+// by noise, are independent and all valid bits keep the same amplitude.
+class LDPC_FastDecoder
+{
+public:
+    static const uint8_t CodeBits   = 208;
+    static const uint8_t CodeBytes  = (CodeBits+ 7)/ 8;
+    static const uint8_t CodeWords  = (CodeBits+31)/32;
+    static const uint8_t ParityBits = 48;
+    static const int8_t  InpAmpl    = 32;    // a-priori amplitude of a correctly received bit
+    static const uint8_t FlipLoops  = 1;     // max. number of bit-flipping iterations
+    static const int8_t  WeakRssidBm   = -105; // below: bits next to a Manchester error keep the full amplitude
+    static const int8_t  StrongRssidBm =  -85; // above: bits next to a Manchester error get a quarter amplitude
+
+public:
+
+    uint32_t HardBit[CodeWords];  // packed hard bits: input and decoded result
+    uint32_t EraseBit[CodeWords]; // packed erasures: Manchester decoding errors
+    int8_t   InpBit[CodeBits];    // a-priori bits
+    int8_t   OutBit[CodeBits];    // a-posteriori bits
+    int16_t  ExtBit[CodeBits];    // extrinsic inf.
+
+    void Input(const uint8_t *Data, const uint8_t *Err);
+    void Input(const uint8_t *Data, const uint8_t *Err, int8_t RssidBm); // graded by the RSSI of the frame
+    void Output(uint8_t Data[CodeBytes]) const;
+
+    // number of failed parity checks of the packed hard bits
+    uint8_t Check(void) const
+    {
+        return LDPC_Check(HardBit);
+    }
+
+    // hard-decision bit-flipping on the packed hard bits, returns the number of failed checks
+    uint8_t BitFlip(uint8_t Loops=FlipLoops);
+
+    // one min-sum iteration on the soft bits, returns the number of failed checks
+    uint8_t ProcessChecks(void);
+
+    // decode the input with up to Loops min-sum iterations, returns the number of failed checks, 0 when corrected
+    uint8_t Decode(uint8_t Loops=32);
+    uint8_t Decode(const uint8_t *Data, const uint8_t *Err, uint8_t Loops=32);
+
+    // amplitude of bits next to a Manchester error for a frame received with RssidBm
+    static int8_t NearAmpl(int8_t RssidBm);
+
+} ;
+
 template <class Float=float>
 class LDPC_FloatDecoder
 {
@@ -20,6 +20,23 @@ constexpr uint8_t manchesterDecodeLookupTable[] =
     0xFC, 0xED, 0xEC, 0xFD, 0xDE, 0xCF, 0xCE, 0xDF, 0xDC, 0xCD, 0xCC, 0xDD, 0xFE, 0xEF, 0xEE, 0xFF
 } ;
 
+/**
+ * Same as manchesterDecodeLookupTable, with the 4 error bits moved to bits 8..11.
+ * Two lookups, one shifted by 4, OR into a data byte in the low and an error byte in the high byte.
+ */
+struct ManchesterDecodeWordTable
+{
+    uint16_t value[256];
+    constexpr ManchesterDecodeWordTable() : value()
+    {
+        for (uint16_t i = 0; i < 256; i++)
+        {
+            value[i] = (manchesterDecodeLookupTable[i] & 0x0F) | ((manchesterDecodeLookupTable[i] & 0xF0) << 4);
+        }
+    }
+};
+constexpr ManchesterDecodeWordTable manchesterDecodeWordTable;
+
 constexpr uint8_t manchesterEncodeLookupTable[] =
 {
     0xAA, 0xA9, 0xA6, 0xA5, 0x9A, 0x99, 0x96, 0x95, 0x6A, 0x69, 0x66, 0x65, 0x5A, 0x59, 0x56, 0x55
@@ -71,18 +88,37 @@ void manchesterDecode(uint8_t *destination, const uint8_t *source, uint8_t sourc
 
 /**
  * @brief Decode a Manchester encoded buffer directy into a destination including the err array
+ * Called for every received frame from the radio task, so it handles 4 chip bytes per loop with one lookup per chip byte
 */
 void manchesterDecode(uint8_t *destination, uint8_t *err, const uint8_t *source, uint8_t sourceLength)
 {
+    const uint16_t *table = manchesterDecodeWordTable.value;
     uint8_t idx = 0;
-    for (uint8_t i = 0; i < sourceLength; i++)                               // loop over packet bytes
+    uint8_t i = 0;
+    for (; i + 4 <= sourceLength; i += 4)
     {
-        uint8_t valh = manchesterDecodeLookupTable[source[i]];
-        uint8_t vall = manchesterDecodeLookupTable[source[i+1]];
-        destination[idx] = (valh << 4) | (vall & 0x0F);
-        err[idx] = (valh & 0xF0) | (vall >> 4);
+        uint16_t first = (table[source[i]] << 4) | table[source[i + 1]];
+        uint16_t second = (table[source[i + 2]] << 4) | table[source[i + 3]];
+        destination[idx] = first;
+        err[idx] = first >> 8;
+        destination[idx + 1] = second;
+        err[idx + 1] = second >> 8;
+        idx += 2;
+    }
+    if (i + 2 <= sourceLength)
+    {
+        uint16_t word = (table[source[i]] << 4) | table[source[i + 1]];
+        destination[idx] = word;
+        err[idx] = word >> 8;
         idx++;
-        i++;
+        i += 2;
+    }
+    if (i < sourceLength)
+    {
+        // Odd length, the missing chips of the last data nibble are errors
+        uint16_t word = (table[source[i]] << 4) | 0x0F00;
+        destination[idx] = word;
+        err[idx] = word >> 8;
     }
 }
 
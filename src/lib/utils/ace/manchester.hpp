@@ -16,6 +16,7 @@ void manchesterDecode(uint8_t *destination, const uint8_t *source, uint8_t sourc
 /**
  * Decode a manchester encoded buffer into a destination buffer of half the length of the source
  * This version includes the err frame for galagan correction
+ * With an odd sourceLength the last chip byte decodes into the high nibble, the low nibble is marked as error
 */
 void manchesterDecode(uint8_t *destination, uint8_t *err, const uint8_t *source, uint8_t sourceLength);
 
@@ -0,0 +1,240 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "ldpc.hpp"
+#include "manchester.hpp"
+
+constexpr uint8_t CODE_BYTES = 26;
+constexpr uint8_t DATA_BYTES = 20;
+constexpr uint32_t FRAMES = 10000;
+
+static uint32_t rngState = 0x12345678;
+static uint32_t rng()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+/**
+ * A received frame, Manchester decoded after flipping chips with the given chip error rate
+ */
+struct TestFrame
+{
+    uint8_t sent[CODE_BYTES];
+    uint8_t data[CODE_BYTES];
+    uint8_t err[CODE_BYTES];
+};
+
+static void makeFrame(TestFrame &frame, float chipErrorRate)
+{
+    for (uint8_t i = 0; i < DATA_BYTES; i++)
+    {
+        frame.sent[i] = rng();
+    }
+    LDPC_Encode(frame.sent);
+
+    uint8_t chips[CODE_BYTES * 2];
+    manchechesterEncode(chips, frame.sent, CODE_BYTES);
+    uint32_t threshold = chipErrorRate * 0xFFFFFFFFu;
+    for (uint8_t i = 0; i < sizeof(chips); i++)
+    {
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            if (rng() < threshold)
+            {
+                chips[i] ^= 1 << bit;
+            }
+        }
+    }
+    manchesterDecode(frame.data, frame.err, chips, sizeof(chips));
+}
+
+/**
+ * A strong frame hit by a burst of interference: the chips within the burst are random
+ */
+static void makeBurstFrame(TestFrame &frame, uint16_t burstChips)
+{
+    for (uint8_t i = 0; i < DATA_BYTES; i++)
+    {
+        frame.sent[i] = rng();
+    }
+    LDPC_Encode(frame.sent);
+
+    uint8_t chips[CODE_BYTES * 2];
+    manchechesterEncode(chips, frame.sent, CODE_BYTES);
+    uint16_t start = rng() % (sizeof(chips) * 8 - burstChips);
+    for (uint16_t chip = start; chip < start + burstChips; chip++)
+    {
+        if (rng() & 1)
+        {
+            chips[chip / 8] ^= 1 << (chip % 8);
+        }
+    }
+    manchesterDecode(frame.data, frame.err, chips, sizeof(chips));
+}
+
+struct DecodeResult
+{
+    uint32_t corrected = 0; // decoded and equal to the frame sent
+    uint32_t wrong = 0;     // all parity checks pass, but not the frame sent
+    double framesPerSecond = 0;
+};
+
+template <typename Decode>
+static DecodeResult runDecoder(const TestFrame *frames, Decode decode)
+{
+    DecodeResult result;
+    uint8_t output[CODE_BYTES];
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < FRAMES; i++)
+    {
+        uint8_t check = decode(output, frames[i]);
+        if (check == 0)
+        {
+            if (memcmp(output, frames[i].sent, CODE_BYTES) == 0)
+            {
+                result.corrected++;
+            }
+            else
+            {
+                result.wrong++;
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.framesPerSecond = FRAMES / seconds;
+    return result;
+}
+
+TEST_CASE("LDPC_FastDecoder error free frame", "[single-file]")
+{
+    TestFrame frame;
+    makeFrame(frame, 0);
+    REQUIRE(LDPC_Check(frame.data) == 0);
+
+    LDPC_FastDecoder decoder;
+    uint8_t output[CODE_BYTES];
+    REQUIRE(decoder.Decode(frame.data, frame.err) == 0);
+    decoder.Output(output);
+    REQUIRE(memcmp(output, frame.sent, CODE_BYTES) == 0);
+}
+
+TEST_CASE("LDPC_FastDecoder bit errors and erasures", "[single-file]")
+{
+    LDPC_FastDecoder decoder;
+    uint8_t output[CODE_BYTES];
+    for (uint8_t bit = 0; bit < LDPC_FastDecoder::CodeBits; bit++)
+    {
+        TestFrame frame;
+        makeFrame(frame, 0);
+
+        // Single bit error
+        frame.data[bit / 8] ^= 1 << (bit % 8);
+        REQUIRE(decoder.Decode(frame.data, frame.err) == 0);
+        decoder.Output(output);
+        REQUIRE(memcmp(output, frame.sent, CODE_BYTES) == 0);
+
+        // Same bit as erasure together with an other erasure
+        uint8_t other = (bit + 101) % LDPC_FastDecoder::CodeBits;
+        frame.err[bit / 8] |= 1 << (bit % 8);
+        frame.err[other / 8] |= 1 << (other % 8);
+        frame.data[other / 8] ^= 1 << (other % 8);
+        REQUIRE(decoder.Decode(frame.data, frame.err) == 0);
+        decoder.Output(output);
+        REQUIRE(memcmp(output, frame.sent, CODE_BYTES) == 0);
+    }
+}
+
+TEST_CASE("LDPC_FastDecoder RSSI graded input", "[single-file]")
+{
+    constexpr int8_t ampl = LDPC_FastDecoder::InpAmpl;
+    REQUIRE(LDPC_FastDecoder::NearAmpl(-120) == ampl);
+    REQUIRE(LDPC_FastDecoder::NearAmpl(-105) == ampl);
+    REQUIRE(LDPC_FastDecoder::NearAmpl(-95) < ampl);
+    REQUIRE(LDPC_FastDecoder::NearAmpl(-95) > ampl / 4);
+    REQUIRE(LDPC_FastDecoder::NearAmpl(-85) == ampl / 4);
+    REQUIRE(LDPC_FastDecoder::NearAmpl(-40) == ampl / 4);
+
+    // Erasure at bit 8 (LSB of byte 1) has neighbours bit 9 and bit 23 (MSB of byte 2)
+    LDPC_FastDecoder decoder;
+    TestFrame frame;
+    makeFrame(frame, 0);
+    frame.err[1] = 0x01;
+    decoder.Input(frame.data, frame.err, -60);
+    REQUIRE(decoder.InpBit[8] == 0);
+    REQUIRE(abs(decoder.InpBit[9]) == ampl / 4);
+    REQUIRE(abs(decoder.InpBit[23]) == ampl / 4);
+    REQUIRE(abs(decoder.InpBit[10]) == ampl);
+    REQUIRE(abs(decoder.InpBit[7]) == ampl);
+
+    // Strong frames hit by interference bursts decode better when graded
+    uint32_t flat = 0;
+    uint32_t graded = 0;
+    uint8_t output[CODE_BYTES];
+    for (uint32_t i = 0; i < 2000; i++)
+    {
+        makeBurstFrame(frame, 24);
+        decoder.Input(frame.data, frame.err);
+        decoder.Decode();
+        decoder.Output(output);
+        flat += memcmp(output, frame.sent, CODE_BYTES) == 0;
+        decoder.Input(frame.data, frame.err, -60);
+        decoder.Decode();
+        decoder.Output(output);
+        graded += memcmp(output, frame.sent, CODE_BYTES) == 0;
+    }
+    CAPTURE(flat, graded);
+    REQUIRE(graded > flat);
+}
+
+TEST_CASE("LDPC_FastDecoder benchmark against LDPC_Decoder", "[benchmark]")
+{
+    static TestFrame frames[FRAMES];
+    static LDPC_Decoder<DATA_BYTES * 8, 48> reference;
+    static LDPC_FastDecoder fast;
+
+    printf("chip BER   reference frames/s  corrected  wrong   fast frames/s  corrected  wrong\n");
+    for (float chipErrorRate : {0.0f, 0.002f, 0.005f, 0.01f, 0.02f, 0.03f, 0.05f})
+    {
+        for (uint32_t i = 0; i < FRAMES; i++)
+        {
+            makeFrame(frames[i], chipErrorRate);
+        }
+
+        // Same as Ogn1::errorCorrect
+        auto referenceResult = runDecoder(frames, [](uint8_t *output, const TestFrame &frame)
+        {
+            uint8_t iter = 32;
+            uint8_t check;
+            reference.Input(frame.data, frame.err);
+            do
+            {
+                check = reference.ProcessChecks();
+            } while ((iter--) && check);
+            reference.Output(output);
+            return check;
+        });
+
+        auto fastResult = runDecoder(frames, [](uint8_t *output, const TestFrame &frame)
+        {
+            uint8_t check = fast.Decode(frame.data, frame.err, 32);
+            fast.Output(output);
+            return check;
+        });
+
+        printf("%7.1f%%  %18.0f  %8.2f%%  %5u  %14.0f  %8.2f%%  %5u\n",
+               chipErrorRate * 100,
+               referenceResult.framesPerSecond, referenceResult.corrected * 100.0 / FRAMES, referenceResult.wrong,
+               fastResult.framesPerSecond, fastResult.corrected * 100.0 / FRAMES, fastResult.wrong);
+
+        // The fast decoder may not lose frames or decode more of them wrong
+        REQUIRE(fastResult.corrected + FRAMES / 1000 >= referenceResult.corrected);
+        REQUIRE(fastResult.wrong <= referenceResult.wrong + FRAMES / 1000);
+    }
+}
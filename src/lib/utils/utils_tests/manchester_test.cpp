@@ -0,0 +1,132 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+
+#include <stdio.h>
+#include <string.h>
+
+#include "manchester.hpp"
+
+constexpr uint8_t MAX_CHIP_BYTES = 56;
+
+/**
+ * Reference decoder, one chip pair at a time
+ */
+static void referenceDecode(uint8_t *destination, uint8_t *err, const uint8_t *source, uint8_t sourceLength)
+{
+    constexpr uint8_t chipsToNibble[4] = {0x10, 0x01, 0x00, 0x11}; // pair 00 and 11 are errors, data is the second chip
+    for (uint8_t i = 0; i + 1 < sourceLength; i += 2)
+    {
+        uint8_t data = 0;
+        uint8_t error = 0;
+        uint16_t chips = (source[i] << 8) | source[i + 1];
+        for (int8_t pair = 7; pair >= 0; pair--)
+        {
+            uint8_t value = chipsToNibble[(chips >> (pair * 2)) & 0x03];
+            data = (data << 1) | (value & 0x01);
+            error = (error << 1) | (value >> 4);
+        }
+        destination[i / 2] = data;
+        err[i / 2] = error;
+    }
+}
+
+static uint32_t rngState = 0x87654321;
+static uint32_t rng()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+TEST_CASE("manchesterDecode all 16 chip combinations", "[single-file]")
+{
+    for (uint32_t chips = 0; chips < 0x10000; chips++)
+    {
+        uint8_t source[2] = {(uint8_t)(chips >> 8), (uint8_t)chips};
+        uint8_t data, err, refData, refErr;
+        manchesterDecode(&data, &err, source, 2);
+        referenceDecode(&refData, &refErr, source, 2);
+        REQUIRE(data == refData);
+        REQUIRE(err == refErr);
+
+        // Same through the 4 chip bytes per loop path, in both halves
+        uint8_t source4[4] = {source[0], source[1], (uint8_t)~source[0], (uint8_t)~source[1]};
+        uint8_t data4[2], err4[2], refData4[2], refErr4[2];
+        manchesterDecode(data4, err4, source4, 4);
+        referenceDecode(refData4, refErr4, source4, 4);
+        REQUIRE(memcmp(data4, refData4, 2) == 0);
+        REQUIRE(memcmp(err4, refErr4, 2) == 0);
+    }
+}
+
+TEST_CASE("manchesterDecode all even lengths", "[single-file]")
+{
+    for (uint8_t length = 0; length <= MAX_CHIP_BYTES; length += 2)
+    {
+        uint8_t source[MAX_CHIP_BYTES];
+        for (uint8_t i = 0; i < length; i++)
+        {
+            source[i] = rng();
+        }
+        uint8_t data[MAX_CHIP_BYTES / 2 + 1], err[MAX_CHIP_BYTES / 2 + 1];
+        uint8_t refData[MAX_CHIP_BYTES / 2 + 1], refErr[MAX_CHIP_BYTES / 2 + 1];
+        memset(data, 0xA5, sizeof(data));
+        manchesterDecode(data, err, source, length);
+        referenceDecode(refData, refErr, source, length);
+        REQUIRE(memcmp(data, refData, length / 2) == 0);
+        REQUIRE(memcmp(err, refErr, length / 2) == 0);
+        REQUIRE(data[length / 2] == 0xA5); // Nothing written beyond the frame
+    }
+}
+
+TEST_CASE("manchesterDecode odd length", "[single-file]")
+{
+    uint8_t source[3] = {0x55, 0xAA, 0x99}; // 1111 0000 0101
+    uint8_t data[2], err[2];
+    manchesterDecode(data, err, source, 3);
+    REQUIRE(data[0] == 0xF0);
+    REQUIRE(err[0] == 0x00);
+    REQUIRE(data[1] == 0x50);
+    REQUIRE(err[1] == 0x0F);
+}
+
+TEST_CASE("manchesterDecode encode decode", "[single-file]")
+{
+    uint8_t frame[MAX_CHIP_BYTES / 2];
+    for (uint8_t i = 0; i < sizeof(frame); i++)
+    {
+        frame[i] = rng();
+    }
+    uint8_t chips[MAX_CHIP_BYTES];
+    manchechesterEncode(chips, frame, sizeof(frame));
+    uint8_t data[sizeof(frame)], err[sizeof(frame)];
+    manchesterDecode(data, err, chips, sizeof(chips));
+    REQUIRE(memcmp(data, frame, sizeof(frame)) == 0);
+    for (uint8_t i = 0; i < sizeof(err); i++)
+    {
+        REQUIRE(err[i] == 0);
+    }
+}
+
+TEST_CASE("manchesterDecode benchmark", "[benchmark]")
+{
+    uint8_t source[MAX_CHIP_BYTES];
+    for (uint8_t i = 0; i < sizeof(source); i++)
+    {
+        source[i] = rng();
+    }
+    uint8_t data[MAX_CHIP_BYTES / 2], err[MAX_CHIP_BYTES / 2];
+
+    BENCHMARK("reference 56 chip bytes")
+    {
+        referenceDecode(data, err, source, sizeof(source));
+        return data[0] ^ err[0];
+    };
+
+    BENCHMARK("manchesterDecode 56 chip bytes")
+    {
+        manchesterDecode(data, err, source, sizeof(source));
+        return data[0] ^ err[0];
+    };
+}
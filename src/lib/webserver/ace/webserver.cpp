@@ -300,12 +300,12 @@ void Webserver::start()
 {
     webserver = this;
     httpd_init();
-    getBus().subscribe(*this);
+    subscribe(*this);
 };
 
 void Webserver::stop()
 {
-    getBus().unsubscribe(*this);
+    unsubscribe(*this);
 };
 
 void Webserver::on_receive_unknown(const etl::imessage &msg)
@@ -21,12 +21,12 @@ void WifiService::start()
     // timerHandle = xTimerCreate("wifiServiceTask", TASK_DELAY_MS(2'500), pdTRUE /* Must not be autostart */, this, timerTask);
     xTaskCreate(wifiTask, "wifiTask", configMINIMAL_STACK_SIZE + 128, this, tskIDLE_PRIORITY, &taskHandle);
 
-    getBus().subscribe(*this);
+    subscribe(*this);
 };
 
 void WifiService::stop()
 {
-    getBus().unsubscribe(*this);
+    unsubscribe(*this);
 }
 
 void WifiService::on_receive_unknown(const etl::imessage &msg)
@@ -27,6 +27,7 @@
 #include "ace/messagerouter.hpp"
 #include "ace/constants.hpp"
 #include "ace/aircrafttracker.hpp"
+#include "ace/collisiondetector.hpp"
 #include "ace/basemodule.hpp"
 #include "ace/config.hpp"
 #include "ace/inmemorystore.hpp"
@@ -43,8 +44,11 @@
 #include "ace/radiotunerrx.hpp"
 #include "ace/radiotunertx.hpp"
 #include "ace/flarm2024.hpp"
+#include "ace/flarm_2023.hpp"
 #include "ace/ogn1.hpp"
 #include "ace/adsl.hpp"
+#include "ace/fanet.hpp"
+#include "ace/paw.hpp"
 #include "ace/gdl90service.hpp"
 #include "ace/gdloverudp.hpp"
 
@@ -100,6 +104,35 @@ public:
     }
 };
 
+using OpenAceBus = OpenAce::ThreadSafeBus<25>;
+
+/**
+ * Exposes the statistics of the messagebus, per message ID and per subscriber
+ */
+class MessageBus : public BaseModule
+{
+    const OpenAceBus &messageBus;
+
+public:
+    static constexpr const etl::string_view NAME = "MessageBus";
+    MessageBus(etl::imessage_bus &bus, const Configuration &config) : BaseModule(bus, NAME), messageBus(static_cast<const OpenAceBus &>(bus))
+    {
+        (void)config;
+    }
+    virtual ~MessageBus() = default;
+    virtual OpenAce::PostConstruct postConstruct() override
+    {
+        return OpenAce::PostConstruct::OK;
+    }
+    virtual void start() override {}
+    virtual void stop() override {}
+    virtual void getData(etl::string_stream &stream, const etl::string_view path) const override
+    {
+        (void)path;
+        messageBus.getData(stream);
+    }
+};
+
 void registerModules()
 {
     // // *INDENT-OFF*
@@ -128,10 +161,16 @@ void registerModules()
                                { return new ADSBDecoder(bus, config); });
     BaseModule::registerModule(Flarm2024::NAME, [](etl::imessage_bus &bus, const Configuration &config) -> BaseModule *
                                { return new Flarm2024(bus, config); });
+    BaseModule::registerModule(Flarm2023::NAME, [](etl::imessage_bus &bus, const Configuration &config) -> BaseModule *
+                               { return new Flarm2023(bus, config); });
     BaseModule::registerModule(Ogn1::NAME, [](etl::imessage_bus &bus, const Configuration &config) -> BaseModule *
                                { return new Ogn1(bus, config); });
     BaseModule::registerModule(ADSL::NAME, [](etl::imessage_bus &bus, const Configuration &config) -> BaseModule *
                                { return new ADSL(bus, config); });
+    BaseModule::registerModule(Fanet::NAME, [](etl::imessage_bus &bus, const Configuration &config) -> BaseModule *
+                               { return new Fanet(bus, config); });
+    BaseModule::registerModule(Paw::NAME, [](etl::imessage_bus &bus, const Configuration &config) -> BaseModule *
+                               { return new Paw(bus, config); });
     BaseModule::registerModule(GDLoverUDP::NAME, [](etl::imessage_bus &bus, const Configuration &config) -> BaseModule *
                                { return new GDLoverUDP(bus, config); });
     BaseModule::registerModule(GpsDecoder::NAME, [](etl::imessage_bus &bus, const Configuration &config) -> BaseModule *
@@ -144,8 +183,12 @@ void registerModules()
                                { return new Dump1090Client(bus, config); });
     BaseModule::registerModule(ModuleManager::NAME, [](etl::imessage_bus &bus, const Configuration &config) -> BaseModule *
                                { return new ModuleManager(bus, config); });
+    BaseModule::registerModule(MessageBus::NAME, [](etl::imessage_bus &bus, const Configuration &config) -> BaseModule *
+                               { return new MessageBus(bus, config); });
     BaseModule::registerModule(AircraftTracker::NAME, [](etl::imessage_bus &bus, const Configuration &config) -> BaseModule *
                                { return new AircraftTracker(bus, config); });
+    BaseModule::registerModule(CollisionDetector::NAME, [](etl::imessage_bus &bus, const Configuration &config) -> BaseModule *
+                               { return new CollisionDetector(bus, config); });
     // // *INDENT-ON*
 
     for (auto a : BaseModule::registeredModules())
@@ -156,7 +199,7 @@ void registerModules()
 
 static InMemoryStore volatileStore;
 static FlashStore permanentStore{4096, 0};
-static OpenAce::ThreadSafeBus<25> bus;
+static OpenAceBus bus;
 static Config config(bus, volatileStore, permanentStore, DEFAULT_OPENACE_CONFIG);
 
 static void load(const etl::string_view str, etl::imessage_bus &bus, const Configuration &config, bool force = false)
@@ -210,6 +253,7 @@ static void loadModules(void *arch)
     (void)arch;
     load(WifiService::NAME, bus, config, true);
     load(ModuleManager::NAME, bus, config);
+    load(MessageBus::NAME, bus, config, true);
 
     WifiService *client = (WifiService *)(config.moduleByName(config, WifiService::NAME, false));
     if (client != nullptr)
@@ -229,10 +273,15 @@ static void loadModules(void *arch)
 
     load(Bmp280::NAME, bus, config);
     load(Gdl90Service::NAME, bus, config);
+    load(CollisionDetector::NAME, bus, config);
     load(ADSBDecoder::NAME, bus, config);
     load(ADSL::NAME, bus, config);
+    // Flarm2024 picks up the legacy decoder when it's loaded first
+    load(Flarm2023::NAME, bus, config);
     load(Flarm2024::NAME, bus, config);
     load(Ogn1::NAME, bus, config);
+    load(Fanet::NAME, bus, config);
+    load(Paw::NAME, bus, config);
     load(GDLoverUDP::NAME, bus, config);
     load(GpsDecoder::NAME, bus, config);
     load(UbloxM8N::NAME, bus, config);
@@ -274,6 +323,10 @@ void vLaunch(void)
     BaseModule::setModuleStatus(Configuration::NAME, &config, status);
     BaseModule::setModuleStatus(Config::NAME, &config, status);
     config.start();
+    if (!bus.start())
+    {
+        panic("Failed to start message bus");
+    }
     // Bootstap
 
     // + 1024 because we run the message bus in this task
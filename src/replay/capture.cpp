@@ -0,0 +1,254 @@
+#include "capture.hpp"
+
+/* System. */
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+namespace Replay
+{
+    static uint16_t get16(const uint8_t *data)
+    {
+        return data[0] | (data[1] << 8);
+    }
+
+    static uint32_t get32(const uint8_t *data)
+    {
+        return get16(data) | (static_cast<uint32_t>(get16(data + 2)) << 16);
+    }
+
+    static void put16(std::vector<uint8_t> &out, uint16_t value)
+    {
+        out.push_back(value & 0xff);
+        out.push_back(value >> 8);
+    }
+
+    static void put32(std::vector<uint8_t> &out, uint32_t value)
+    {
+        put16(out, value & 0xffff);
+        put16(out, value >> 16);
+    }
+
+    static bool parseHex(const char *text, std::vector<uint8_t> &out)
+    {
+        size_t length = strlen(text);
+        if (length % 2 != 0)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < length; i += 2)
+        {
+            if (!isxdigit(text[i]) || !isxdigit(text[i + 1]))
+            {
+                return false;
+            }
+            char byte[3] = {text[i], text[i + 1], 0};
+            out.push_back(strtoul(byte, nullptr, 16));
+        }
+        return true;
+    }
+
+    Capture::~Capture()
+    {
+        if (file != nullptr)
+        {
+            fclose(file);
+        }
+    }
+
+    bool Capture::fail(const std::string &message)
+    {
+        error = message;
+        return false;
+    }
+
+    bool Capture::open(const char *path)
+    {
+        file = fopen(path, "rb");
+        if (file == nullptr)
+        {
+            return fail(std::string("Can't open ") + path);
+        }
+
+        uint8_t header[HEADER_LENGTH];
+        if (fread(header, 1, sizeof(header), file) != sizeof(header) || get32(header) != MAGIC)
+        {
+            return fail("Not a capture file");
+        }
+        if (get16(header + 4) != VERSION)
+        {
+            return fail("Unsupported capture version");
+        }
+        epochMs = get32(header + 8) | (static_cast<uint64_t>(get32(header + 12)) << 32);
+        return true;
+    }
+
+    bool Capture::next(Record &record)
+    {
+        if (file == nullptr)
+        {
+            return false;
+        }
+
+        uint8_t header[RECORD_HEADER_LENGTH];
+        size_t read = fread(header, 1, sizeof(header), file);
+        if (read == 0 && feof(file))
+        {
+            return false;
+        }
+        if (read != sizeof(header))
+        {
+            return fail("Truncated record header");
+        }
+
+        record.timeMs = get32(header);
+        record.type = static_cast<RecordType>(header[4]);
+        uint16_t length = get16(header + 6);
+        if (record.timeMs < lastTimeMs)
+        {
+            return fail("Records out of time order");
+        }
+        lastTimeMs = record.timeMs;
+
+        record.data.resize(length);
+        if (fread(record.data.data(), 1, length, file) != length)
+        {
+            return fail("Truncated record");
+        }
+
+        switch (record.type)
+        {
+        case RecordType::RADIO:
+            if (length < RADIO_HEADER_LENGTH)
+            {
+                return fail("Radio record too short");
+            }
+            record.frequency = get32(record.data.data());
+            record.rssidBm = static_cast<int8_t>(record.data[4]);
+            record.dataSource = record.data[5];
+            record.epochSeconds = get32(record.data.data() + 8);
+            record.data.erase(record.data.begin(), record.data.begin() + RADIO_HEADER_LENGTH);
+            return true;
+        case RecordType::NMEA:
+        case RecordType::ADSB:
+            return true;
+        default:
+            return fail("Unknown record type");
+        }
+    }
+
+    int32_t Capture::convert(const char *textPath, const char *capturePath, std::string &error)
+    {
+        FILE *in = fopen(textPath, "r");
+        if (in == nullptr)
+        {
+            error = std::string("Can't open ") + textPath;
+            return -1;
+        }
+
+        uint64_t epochMs = 0;
+        std::vector<uint8_t> records;
+        int32_t count = 0;
+        uint32_t lineNumber = 0;
+        uint32_t lastTimeMs = 0;
+        char line[1024];
+        while (fgets(line, sizeof(line), in) != nullptr)
+        {
+            lineNumber++;
+            line[strcspn(line, "\r\n")] = 0;
+            if (line[0] == 0 || line[0] == '#')
+            {
+                continue;
+            }
+
+            unsigned long long epoch;
+            if (sscanf(line, "epoch %llu", &epoch) == 1)
+            {
+                epochMs = epoch;
+                continue;
+            }
+
+            char type[8];
+            int consumed = 0;
+
+            unsigned long timeMs;
+            if (sscanf(line, "%lu %7s %n", &timeMs, type, &consumed) != 2 || timeMs < lastTimeMs)
+            {
+                error = "Invalid record or out of order at line " + std::to_string(lineNumber);
+                fclose(in);
+                return -1;
+            }
+            lastTimeMs = timeMs;
+            const char *rest = line + consumed;
+
+            std::vector<uint8_t> payload;
+            RecordType recordType;
+            if (strcmp(type, "RADIO") == 0)
+            {
+                unsigned long frequency, epochSeconds;
+                int rssidBm, dataSource;
+                char hex[sizeof(line)];
+                if (sscanf(rest, "%lu %d %d %lu %s", &frequency, &rssidBm, &dataSource, &epochSeconds, hex) != 5)
+                {
+                    error = "Invalid RADIO record at line " + std::to_string(lineNumber);
+                    fclose(in);
+                    return -1;
+                }
+                recordType = RecordType::RADIO;
+                put32(payload, frequency);
+                payload.push_back(static_cast<uint8_t>(rssidBm));
+                payload.push_back(static_cast<uint8_t>(dataSource));
+                put16(payload, 0);
+                put32(payload, epochSeconds);
+                if (!parseHex(hex, payload))
+                {
+                    error = "Invalid frame hex at line " + std::to_string(lineNumber);
+                    fclose(in);
+                    return -1;
+                }
+            }
+            else if (strcmp(type, "NMEA") == 0 || strcmp(type, "ADSB") == 0)
+            {
+                recordType = type[0] == 'N' ? RecordType::NMEA : RecordType::ADSB;
+                payload.assign(rest, rest + strlen(rest));
+            }
+            else
+            {
+                error = "Unknown record type at line " + std::to_string(lineNumber);
+                fclose(in);
+                return -1;
+            }
+
+            put32(records, timeMs);
+            records.push_back(static_cast<uint8_t>(recordType));
+            records.push_back(0);
+            put16(records, payload.size());
+            records.insert(records.end(), payload.begin(), payload.end());
+            count++;
+        }
+        fclose(in);
+
+        std::vector<uint8_t> header;
+        put32(header, MAGIC);
+        put16(header, VERSION);
+        put16(header, 0);
+        put32(header, epochMs & 0xffffffff);
+        put32(header, epochMs >> 32);
+
+        FILE *out = fopen(capturePath, "wb");
+        if (out == nullptr)
+        {
+            error = std::string("Can't create ") + capturePath;
+            return -1;
+        }
+        bool written = fwrite(header.data(), 1, header.size(), out) == header.size() &&
+                       fwrite(records.data(), 1, records.size(), out) == records.size();
+        fclose(out);
+        if (!written)
+        {
+            error = std::string("Failed to write ") + capturePath;
+            return -1;
+        }
+        return count;
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+/* System. */
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace Replay
+{
+    /**
+     * Reader and writer of replay capture files.
+     *
+     * A capture starts with a 16 byte header: magic "OARC", uint16 version, uint16 reserved and uint64 epochMs, the time
+     * since epoch at the start of the capture. The header is followed by records, each with an 8 byte header: uint32 timeMs
+     * since the start of the capture, uint8 type, uint8 reserved and uint16 length of the payload that follows.
+     * All values are little endian.
+     *
+     * RADIO payload: uint32 frequency, int8 rssidBm, uint8 dataSource, uint16 reserved, uint32 epochSeconds followed by the
+     *                Manchester encoded frame as read from the radio. LoRa (FANET) and PilotAware frames are stored as is.
+     * NMEA payload:  NMEA sentence without line ending.
+     * ADSB payload:  Raw hex line as send by dump1090, eg *8D4840D6202CC371C32CE0576098;
+     */
+    class Capture
+    {
+    public:
+        static constexpr uint32_t MAGIC = 0x4352414f; // OARC
+        static constexpr uint16_t VERSION = 1;
+        static constexpr size_t HEADER_LENGTH = 16;
+        static constexpr size_t RECORD_HEADER_LENGTH = 8;
+        static constexpr size_t RADIO_HEADER_LENGTH = 12;
+
+        enum class RecordType : uint8_t
+        {
+            RADIO = 1,
+            NMEA = 2,
+            ADSB = 3
+        };
+
+        struct Record
+        {
+            uint32_t timeMs;
+            RecordType type;
+            uint32_t frequency;    // RADIO only
+            int8_t rssidBm;        // RADIO only
+            uint8_t dataSource;    // RADIO only, as OpenAce::DataSource
+            uint32_t epochSeconds; // RADIO only
+            std::vector<uint8_t> data;
+
+            std::string text() const
+            {
+                return std::string(data.begin(), data.end());
+            }
+        };
+
+    private:
+        FILE *file;
+        uint64_t epochMs;
+        uint32_t lastTimeMs;
+        std::string error;
+
+        bool fail(const std::string &message);
+
+    public:
+        Capture() : file(nullptr), epochMs(0), lastTimeMs(0) {}
+        ~Capture();
+
+        Capture(const Capture &) = delete;
+        Capture &operator=(const Capture &) = delete;
+
+        /**
+         * Open a capture for reading and read it's header
+         */
+        bool open(const char *path);
+
+        /**
+         * Read the next record, returns false at the end of the capture or on an error, see lastError()
+         */
+        bool next(Record &record);
+
+        uint64_t startEpochMs() const
+        {
+            return epochMs;
+        }
+
+        const std::string &lastError() const
+        {
+            return error;
+        }
+
+        /**
+         * Convert a text capture into a binary capture. The text capture has one record per line, empty lines and lines
+         * starting with # are ignored:
+         *   epoch <epochMs>
+         *   <timeMs> RADIO <frequency> <rssidBm> <dataSource> <epochSeconds> <hex Manchester encoded frame>
+         *   <timeMs> NMEA <sentence>
+         *   <timeMs> ADSB <hex line>
+         * Records must be in time order. Returns the number of records written or -1 on an error, with the reason in error
+         */
+        static int32_t convert(const char *textPath, const char *capturePath, std::string &error);
+    };
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+/**
+ * FreeRTOS API for the replay harness. The API is implemented by Replay::Scheduler in scheduler.cpp,
+ * this directory must come before lib/mocks in the include path so these headers replace the mocks.
+ */
+
+#include <stdint.h>
+
+#include "FreeRTOSconfig.h"
+
+#define BaseType_t int
+#define TickType_t uint32_t
+typedef void (*TaskFunction_t)(void *);
+
+#define UBaseType_t uint32_t
+#define pdPASS 1
+#define pdFAIL 0
+#define pdFALSE 0
+#define pdTRUE 1
+#define StaticTask_t int
+#define StackType_t uint8_t
+#define StaticTimer_t int
+#define StaticSemaphore_t int
+
+#define portMAX_DELAY (TickType_t)0xffffffffUL
+
+struct tskTaskControlBlock; /* The old naming convention is used to prevent breaking kernel aware debuggers. */
+typedef struct tskTaskControlBlock *TaskHandle_t;
+
+struct QueueDefinition;
+typedef struct QueueDefinition *QueueHandle_t;
+typedef QueueHandle_t SemaphoreHandle_t;
+
+struct tmrTimerControl;
+typedef struct tmrTimerControl *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t xTimer);
+
+#define tskIDLE_PRIORITY 0
+#define tskDEFAULT_INDEX_TO_NOTIFY 0
+
+typedef enum
+{
+    eNoAction = 0,            /* Notify the task without updating its notify value. */
+    eSetBits,                 /* Set bits in the task's notification value. */
+    eIncrement,               /* Increment the task's notification value. */
+    eSetValueWithOverwrite,   /* Set the task's notification value to a specific value even if the previous value has not yet been read by the task. */
+    eSetValueWithoutOverwrite /* Set the task's notification value if the previous value has been read by the task. */
+} eNotifyAction;
+
+typedef enum
+{
+    eRunning = 0,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted,
+    eInvalid
+} eTaskState;
+
+#define portYIELD_FROM_ISR(x) (void)(x)
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
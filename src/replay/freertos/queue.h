@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+QueueHandle_t xQueueCreate(const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize);
+
+BaseType_t xQueueSendToBack(QueueHandle_t xQueue, const void *const pvItemToQueue, TickType_t xTicksToWait);
+
+#define xQueueSend(xQueue, pvItemToQueue, xTicksToWait) xQueueSendToBack((xQueue), (pvItemToQueue), (xTicksToWait))
+
+BaseType_t xQueueSendToBackFromISR(QueueHandle_t xQueue, const void *const pvItemToQueue, BaseType_t *pxHigherPriorityTaskWoken);
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *const pvBuffer, TickType_t xTicksToWait);
+
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t xQueue);
+
+void vQueueDelete(QueueHandle_t xQueue);
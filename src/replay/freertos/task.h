@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode,
+                       const char *const pcName,
+                       const configSTACK_DEPTH_TYPE usStackDepth,
+                       void *const pvParameters,
+                       UBaseType_t uxPriority,
+                       TaskHandle_t *const pxCreatedTask);
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t pxTaskCode,
+                               const char *const pcName,
+                               const configSTACK_DEPTH_TYPE usStackDepth,
+                               void *const pvParameters,
+                               UBaseType_t uxPriority,
+                               StackType_t *puxStackBuffer,
+                               StaticTask_t *pxTaskBuffer);
+
+void vTaskDelete(TaskHandle_t xTaskToDelete);
+
+void vTaskDelay(const TickType_t xTicksToDelay);
+
+BaseType_t xTaskNotify(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction);
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, BaseType_t *pxHigherPriorityTaskWoken);
+
+#define xTaskNotifyGive(xTaskToNotify) xTaskNotify((xTaskToNotify), 0, eIncrement)
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait);
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+TickType_t xTaskGetTickCount(void);
+
+eTaskState eTaskGetState(TaskHandle_t xTask);
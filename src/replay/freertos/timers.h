@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include "FreeRTOS.h"
+
+TimerHandle_t xTimerCreate(const char *const pcTimerName,
+                           const TickType_t xTimerPeriodInTicks,
+                           const BaseType_t xAutoReload,
+                           void *const pvTimerID,
+                           TimerCallbackFunction_t pxCallbackFunction);
+
+TimerHandle_t xTimerCreateStatic(const char *const pcTimerName,
+                                 const TickType_t xTimerPeriodInTicks,
+                                 const BaseType_t xAutoReload,
+                                 void *const pvTimerID,
+                                 TimerCallbackFunction_t pxCallbackFunction,
+                                 StaticTimer_t *pxTimerBuffer);
+
+void *pvTimerGetTimerID(const TimerHandle_t xTimer);
+
+BaseType_t xTimerStart(TimerHandle_t xTimer, TickType_t xTicksToWait);
+
+BaseType_t xTimerReset(TimerHandle_t xTimer, TickType_t xTicksToWait);
+
+BaseType_t xTimerStop(TimerHandle_t xTimer, TickType_t xTicksToWait);
+
+BaseType_t xTimerChangePeriod(TimerHandle_t xTimer, TickType_t xNewPeriod, TickType_t xTicksToWait);
+
+BaseType_t xTimerDelete(TimerHandle_t xTimer, TickType_t xTicksToWait);
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t xTimer);
@@ -0,0 +1,622 @@
+/**
+ * Replay a capture of radio frames, NMEA sentences and ADS-B messages through the real OpenAce modules on the host.
+ *
+ * Usage: replay <capture.bin> [seconds]       Replay a capture, run for seconds more after the last record (default 5)
+ *        replay --radios <n> <capture.bin> [seconds]
+ *                                              Same, but only frames that one of n simulated radios is tuned to are received
+ *        replay --convert <capture.txt> <capture.bin>
+ *
+ * The decoders, tracker, collision detector and GDL90 service run on the deterministic scheduler of scheduler.hpp in
+ * virtual time, two runs of the same capture give the same targets in the same order.
+ */
+
+/* System. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <array>
+#include <chrono>
+#include <map>
+
+/* FreeRTOS. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Vendor. */
+#include "etl/message_router.h"
+#include "etl/string.h"
+#include "etl/string_stream.h"
+
+/* OpenACE. */
+#include "ace/basemodule.hpp"
+#include "ace/coreutils.hpp"
+#include "ace/messagerouter.hpp"
+#include "ace/messages.hpp"
+#include "ace/radioframepool.hpp"
+#include "ace/manchester.hpp"
+
+#include "ace/adsbdecoder.hpp"
+#include "ace/adsl.hpp"
+#include "ace/aircrafttracker.hpp"
+#include "ace/collisiondetector.hpp"
+#include "ace/fanet.hpp"
+#include "ace/paw.hpp"
+#include "ace/flarm2024.hpp"
+#include "ace/flarm_2023.hpp"
+#include "ace/gdl90service.hpp"
+#include "ace/gpsdecoder.hpp"
+#include "ace/ogn1.hpp"
+#include "ace/radiotunerrx.hpp"
+
+#include "capture.hpp"
+#include "scheduler.hpp"
+
+using OpenAceBus = OpenAce::ThreadSafeBus<25>;
+
+/**
+ * Configuration with the defaults of every module
+ */
+class ReplayConfig : public Configuration
+{
+public:
+    ReplayConfig(etl::imessage_bus &bus) : Configuration(bus)
+    {
+    }
+    virtual ~ReplayConfig() = default;
+
+    virtual void start() override
+    {
+    }
+    virtual void stop() override
+    {
+    }
+    virtual OpenAce::PostConstruct postConstruct() override
+    {
+        return OpenAce::PostConstruct::OK;
+    }
+
+    virtual const OpenAce::Config::OpenAceConfiguration openAceConfig() const override
+    {
+        return OpenAce::Config::OpenAceConfiguration{
+            OpenAce::AircraftCategory::GliderMotorGlider,
+            OpenAce::AddressType::FLARM,
+            0xFFFFFE,
+            false,
+            false,
+            {OpenAce::DataSource::FLARM, OpenAce::DataSource::OGN1, OpenAce::DataSource::ADSL}};
+    }
+
+    virtual const OpenAce::PinTypeMap pinMap(const etl::string_view moduleName, OpenAce::PinTypeMap map = OpenAce::PinTypeMap()) const override
+    {
+        (void)moduleName;
+        return map;
+    }
+
+    virtual bool deleteData(const etl::string_view fullPath) override
+    {
+        (void)fullPath;
+        return false;
+    }
+
+    virtual int valueByPath(int defaultValue, const etl::string_view pathToValue, const etl::string_view key) const override
+    {
+        (void)pathToValue;
+        (void)key;
+        return defaultValue;
+    }
+
+    virtual const OpenAce::ConfigString strValueByPath(const etl::string_view defaultValue, const etl::string_view pathToValue, const etl::string_view key) const override
+    {
+        (void)pathToValue;
+        (void)key;
+        return OpenAce::ConfigString{defaultValue.data(), defaultValue.size()};
+    }
+
+    virtual bool isModuleEnabled(const etl::string_view moduleName) const override
+    {
+        (void)moduleName;
+        return true;
+    }
+
+    virtual const OpenAce::Config::WifiServiceData wifiService() const override
+    {
+        return OpenAce::Config::WifiServiceData{};
+    }
+
+    virtual const OpenAce::Config::IpPort ipPortBypath(const etl::string_view pathToValue, const etl::string_view key) const override
+    {
+        (void)pathToValue;
+        (void)key;
+        return {0, 0};
+    }
+};
+
+/**
+ * Radio that remembers what RadioTunerRx tuned it to, frames are only received when the radio listens to the protocol
+ * on the frequency they were captured on
+ */
+class ReplayRadio : public Radio
+{
+    uint8_t radioNo;
+    bool listening = false;
+    OpenAce::DataSource dataSource = OpenAce::DataSource::NONE;
+    uint32_t frequency = 0;
+    uint32_t rxModes = 0;
+    uint32_t txPackets = 0;
+
+public:
+    ReplayRadio(etl::imessage_bus &bus, uint8_t radioNo_) : Radio(bus, Radio::NAMES[radioNo_]), radioNo(radioNo_)
+    {
+    }
+    virtual ~ReplayRadio() = default;
+
+    virtual OpenAce::PostConstruct postConstruct() override
+    {
+        return OpenAce::PostConstruct::OK;
+    }
+    virtual void start() override
+    {
+    }
+    virtual void stop() override
+    {
+    }
+    virtual void getData(etl::string_stream &stream, const etl::string_view path) const override
+    {
+        (void)path;
+        stream << "{\"rxModes\":" << rxModes << ",\"txPackets\":" << txPackets << "}\n";
+    }
+
+    virtual void rxMode(const RxMode &rxMode) override
+    {
+        listening = true;
+        dataSource = rxMode.radioParameters.config.dataSource;
+        frequency = rxMode.radioParameters.frequency;
+        rxModes++;
+    }
+    virtual void txPacket(const TxPacket &txpacket) override
+    {
+        (void)txpacket;
+        txPackets++;
+    }
+    virtual uint8_t radio() const override
+    {
+        return radioNo;
+    }
+
+    bool tunedTo(OpenAce::DataSource dataSource_, uint32_t frequency_) const
+    {
+        return listening && dataSource == dataSource_ && frequency == frequency_;
+    }
+};
+
+/**
+ * Subscriber that collects what comes out of the pipeline
+ */
+class Probe : public etl::message_router<Probe, OpenAce::AircraftPositionMsg, OpenAce::TrackedAircraftPositionMsg, OpenAce::GDLMsg, OpenAce::CollisionWarning>
+{
+    friend class message_router;
+
+public:
+    struct Target
+    {
+        OpenAce::AircraftPositionInfo last;
+        uint16_t dataSources = 0; // Bit per OpenAce::DataSource
+        uint32_t reports = 0;
+        uint32_t tracked = 0;
+        uint8_t maxAlarmLevel = 0;
+    };
+
+    std::map<uint32_t, Target> targets;
+    uint32_t gdlMessages = 0;
+    uint32_t warnings = 0;
+
+    // Virtual time from a report until the tracker sends the aircraft out
+    uint32_t latencySamples = 0;
+    uint64_t latencyTotalMs = 0;
+    uint32_t latencyMaxMs = 0;
+
+private:
+    std::map<uint32_t, uint64_t> pendingSinceUs;
+
+    static uint32_t keyOf(OpenAce::AircraftAddress address, OpenAce::AddressType addressType)
+    {
+        return (static_cast<uint32_t>(addressType) << 24) | (address & 0xffffff);
+    }
+
+    void on_receive(const OpenAce::AircraftPositionMsg &msg)
+    {
+        uint32_t key = keyOf(msg.position.address, msg.position.addressType);
+        auto &target = targets[key];
+        target.last = msg.position;
+        target.dataSources |= 1 << static_cast<uint8_t>(msg.position.dataSource);
+        target.reports++;
+        pendingSinceUs.emplace(key, Replay::Scheduler::instance().now());
+    }
+
+    void on_receive(const OpenAce::TrackedAircraftPositionMsg &msg)
+    {
+        uint32_t key = keyOf(msg.position.address, msg.position.addressType);
+        targets[key].tracked++;
+        auto it = pendingSinceUs.find(key);
+        if (it != pendingSinceUs.end())
+        {
+            uint32_t latencyMs = (Replay::Scheduler::instance().now() - it->second) / 1'000;
+            latencySamples++;
+            latencyTotalMs += latencyMs;
+            latencyMaxMs = latencyMs > latencyMaxMs ? latencyMs : latencyMaxMs;
+            pendingSinceUs.erase(it);
+        }
+    }
+
+    void on_receive(const OpenAce::GDLMsg &msg)
+    {
+        (void)msg;
+        gdlMessages++;
+    }
+
+    void on_receive(const OpenAce::CollisionWarning &msg)
+    {
+        warnings++;
+        auto &target = targets[keyOf(msg.address, msg.addressType)];
+        target.maxAlarmLevel = msg.alarmLevel > target.maxAlarmLevel ? msg.alarmLevel : target.maxAlarmLevel;
+    }
+
+    void on_receive_unknown(const etl::imessage &msg)
+    {
+        (void)msg;
+    }
+};
+
+/**
+ * Wall clock time spent injecting one type of record, this includes the handlers that run on the bus
+ */
+struct InputStage
+{
+    const char *name;
+    uint32_t records = 0;
+    uint32_t dropped = 0;
+    uint64_t totalUs = 0;
+    uint64_t maxUs = 0;
+};
+
+static uint64_t wallClockUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool injectRadio(OpenAceBus &bus, const Replay::Capture::Record &record)
+{
+    constexpr size_t maxFrameLength = OpenAce::RADIO_MAX_FRAME_LENGTH * OpenAce::MANCHESTER;
+    if (record.data.empty() || record.data.size() > maxFrameLength)
+    {
+        return false;
+    }
+    auto buffer = OpenAce::RadioFramePool::acquire();
+    if (!buffer.valid())
+    {
+        return false;
+    }
+
+    // Same as the radio does, decode straight into the pool buffer
+    uint8_t length = static_cast<uint8_t>(record.data.size());
+    auto dataSource = static_cast<OpenAce::DataSource>(record.dataSource);
+    if (dataSource == OpenAce::DataSource::FANET || dataSource == OpenAce::DataSource::PAW)
+    {
+        // LoRa and PilotAware frames are not Manchester encoded
+        if (length > OpenAce::RADIO_MAX_FRAME_LENGTH)
+        {
+            return false;
+        }
+        memcpy(buffer.frame(), record.data.data(), length);
+        memset(buffer.err(), 0, length);
+    }
+    else
+    {
+        manchesterDecode((uint8_t *)buffer.frame(), (uint8_t *)buffer.err(), record.data.data(), length);
+        length /= OpenAce::MANCHESTER;
+    }
+    bus.receive(OpenAce::RadioRxFrame{etl::move(buffer), length, record.epochSeconds, record.rssidBm, record.frequency, dataSource});
+    return true;
+}
+
+static bool injectNmea(OpenAceBus &bus, const Replay::Capture::Record &record)
+{
+    if (record.data.size() > OpenAce::NMEA_MAX_LENGTH - 2)
+    {
+        return false;
+    }
+    OpenAce::NMEAString sentence{record.text().c_str()};
+    sentence.append("\r\n");
+    bus.receive(OpenAce::GPSMessage{sentence});
+    return true;
+}
+
+static bool injectAdsb(OpenAceBus &bus, const Replay::Capture::Record &record)
+{
+    // dump1090 raw format: *<hex>;
+    auto text = record.text();
+    if (text.size() < 3 || text.front() != '*' || text.back() != ';')
+    {
+        return false;
+    }
+
+    OpenAce::ADSBMessageBin msg;
+    for (size_t i = 1; i + 1 < text.size() - 1; i += 2)
+    {
+        char byte[3] = {text[i], text[i + 1], 0};
+        char *end;
+        uint8_t value = strtoul(byte, &end, 16);
+        if (*end != 0 || msg.data.full())
+        {
+            return false;
+        }
+        msg.data.push_back(value);
+    }
+    if (msg.data.size() != 7 && msg.data.size() != 14)
+    {
+        return false;
+    }
+    bus.receive(msg);
+    return true;
+}
+
+/**
+ * Frames on air and frames received by the simulated radios, per datasource
+ */
+struct CaptureRate
+{
+    uint32_t offered = 0;
+    uint32_t captured = 0;
+};
+
+static bool tunedTo(ReplayRadio *const *radios, uint8_t numRadios, const Replay::Capture::Record &record)
+{
+    for (uint8_t r = 0; r < numRadios; r++)
+    {
+        if (radios[r]->tunedTo(static_cast<OpenAce::DataSource>(record.dataSource), record.frequency))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void printModule(const BaseModule &module)
+{
+    etl::string<2048> buffer;
+    etl::string_stream stream{buffer};
+    module.getData(stream, "");
+    printf("  %.*s: %s", static_cast<int>(module.name().size()), module.name().data(), buffer.c_str());
+}
+
+static int replay(const char *path, uint32_t extraSeconds, uint8_t numRadios)
+{
+    Replay::Capture capture;
+    if (!capture.open(path))
+    {
+        printf("%s\n", capture.lastError().c_str());
+        return 1;
+    }
+
+    auto &scheduler = Replay::Scheduler::instance();
+    static OpenAceBus bus;
+    static ReplayConfig config{bus};
+
+    BaseModule::initBase();
+    CoreUtils::setOffsetMsSinceEpoch(capture.startEpochMs());
+    bus.start();
+
+    Probe probe;
+    bus.subscribe(probe);
+
+    GpsDecoder gpsDecoder{bus, config};
+    ADSBDecoder adsbDecoder{bus, config};
+    Flarm2023 flarm2023{bus, config};
+    Flarm2024 flarm{bus, config};
+    Ogn1 ogn{bus, config};
+    ADSL adsl{bus, config};
+    Fanet fanet{bus, config};
+    Paw paw{bus, config};
+    AircraftTracker aircraftTracker{bus, config};
+    CollisionDetector collisionDetector{bus, config};
+    Gdl90Service gdl90Service{bus, config};
+    RadioTunerRx radioTunerRx{bus, config};
+    BaseModule *modules[] = {&gpsDecoder, &adsbDecoder, &flarm2023, &flarm, &ogn, &adsl, &fanet, &paw, &aircraftTracker, &collisionDetector, &gdl90Service, &radioTunerRx};
+
+    // Radios and the tuner only take part when radios are simulated
+    ReplayRadio radio0{bus, 0};
+    ReplayRadio radio1{bus, 1};
+    ReplayRadio *radios[] = {&radio0, &radio1};
+    BaseModule::setModuleStatus(config.name(), &config, OpenAce::PostConstruct::OK);
+    for (uint8_t r = 0; r < numRadios; r++)
+    {
+        BaseModule::setModuleStatus(radios[r]->name(), radios[r], OpenAce::PostConstruct::OK);
+    }
+
+    for (auto *module : modules)
+    {
+        if (module == &radioTunerRx && numRadios == 0)
+        {
+            continue;
+        }
+        auto status = module->postConstruct();
+        BaseModule::setModuleStatus(module->name(), module, status);
+        if (status != OpenAce::PostConstruct::OK)
+        {
+            printf("%.*s failed: %s\n", static_cast<int>(module->name().size()), module->name().data(), postConstructToString(status));
+            return 1;
+        }
+        module->start();
+    }
+
+    InputStage radio{"radio"};
+    InputStage nmea{"nmea"};
+    InputStage adsb{"adsb"};
+    std::array<CaptureRate, static_cast<uint8_t>(OpenAce::DataSource::_ITEMS)> captureRates = {};
+
+    uint64_t wallStartUs = wallClockUs();
+    Replay::Capture::Record record;
+    while (capture.next(record))
+    {
+        scheduler.runUntil(static_cast<uint64_t>(record.timeMs) * 1'000);
+
+        InputStage *stage;
+        bool injected;
+        uint64_t startUs = wallClockUs();
+        switch (record.type)
+        {
+        case Replay::Capture::RecordType::RADIO:
+            stage = &radio;
+            if (numRadios > 0 && record.dataSource < captureRates.size())
+            {
+                auto &rate = captureRates[record.dataSource];
+                rate.offered++;
+                if (!tunedTo(radios, numRadios, record))
+                {
+                    // None of the radios listened, the frame never reaches the decoders
+                    continue;
+                }
+                rate.captured++;
+            }
+            injected = injectRadio(bus, record);
+            break;
+        case Replay::Capture::RecordType::NMEA:
+            stage = &nmea;
+            injected = injectNmea(bus, record);
+            break;
+        default:
+            stage = &adsb;
+            injected = injectAdsb(bus, record);
+            break;
+        }
+        uint64_t tookUs = wallClockUs() - startUs;
+
+        stage->records++;
+        stage->dropped += injected ? 0 : 1;
+        stage->totalUs += tookUs;
+        stage->maxUs = tookUs > stage->maxUs ? tookUs : stage->maxUs;
+    }
+    if (!capture.lastError().empty())
+    {
+        printf("%s\n", capture.lastError().c_str());
+    }
+
+    // Let the tracker and GDL service send out what is left
+    scheduler.runUntil(scheduler.now() + extraSeconds * 1'000'000ull);
+    uint64_t wallUs = wallClockUs() - wallStartUs;
+    scheduler.shutdown();
+
+    uint32_t records = radio.records + nmea.records + adsb.records;
+    printf("Replayed %s: %u records over %.1fs virtual time in %.3fs wall clock\n",
+           path, records, scheduler.now() / 1e6, wallUs / 1e6);
+    printf("  %.0f records/s, %.0f radio frames/s\n",
+           records * 1e6 / (wallUs ? wallUs : 1), radio.records * 1e6 / (wallUs ? wallUs : 1));
+
+    printf("\nStage                     runs  dropped    avg us    max us  total ms\n");
+    for (const auto *stage : {&radio, &nmea, &adsb})
+    {
+        printf("  inject %-16s %6u %8u %9.1f %9llu %9.1f\n", stage->name, stage->records, stage->dropped,
+               stage->records ? static_cast<double>(stage->totalUs) / stage->records : 0.0,
+               static_cast<unsigned long long>(stage->maxUs), stage->totalUs / 1e3);
+    }
+    for (const auto &task : scheduler.taskStatistics())
+    {
+        printf("  task %-18s %6u %8s %9.1f %9llu %9.1f\n", task.name.c_str(), task.activations, "-",
+               task.activations ? static_cast<double>(task.totalUs) / task.activations : 0.0,
+               static_cast<unsigned long long>(task.maxUs), task.totalUs / 1e3);
+    }
+
+    printf("\nReport to track: %u samples, avg %.0f ms, max %u ms (virtual time)\n", probe.latencySamples,
+           probe.latencySamples ? static_cast<double>(probe.latencyTotalMs) / probe.latencySamples : 0.0, probe.latencyMaxMs);
+    printf("GDL90 messages: %u, collision warnings: %u\n", probe.gdlMessages, probe.warnings);
+
+    printf("\nTargets: %zu\n", probe.targets.size());
+    printf("  %-8s %-7s %-24s %7s %7s %5s %10s %10s %6s\n", "type", "address", "sources", "reports", "tracked", "alarm", "lat", "lon", "alt");
+    for (const auto &entry : probe.targets)
+    {
+        const auto &target = entry.second;
+        char sources[64] = "";
+        for (uint8_t ds = 0; ds < static_cast<uint8_t>(OpenAce::DataSource::_ITEMS); ds++)
+        {
+            if (target.dataSources & (1 << ds))
+            {
+                if (sources[0] != 0)
+                {
+                    strcat(sources, ",");
+                }
+                strncat(sources, OpenAce::dataSourceToString(static_cast<OpenAce::DataSource>(ds)), sizeof(sources) - strlen(sources) - 2);
+            }
+        }
+        printf("  %-8s %06X  %-24s %7u %7u %5u %10.5f %10.5f %6ld\n", OpenAce::addressTypeToString(target.last.addressType),
+               static_cast<unsigned>(target.last.address), sources, target.reports, target.tracked, target.maxAlarmLevel,
+               target.last.lat, target.last.lon, static_cast<long>(target.last.altitudeWgs84));
+    }
+
+    if (numRadios > 0)
+    {
+        printf("\nCapture rate with %u radio%s\n", numRadios, numRadios > 1 ? "s" : "");
+        printf("  %-8s %8s %8s %7s\n", "source", "offered", "captured", "rate");
+        for (uint8_t ds = 0; ds < captureRates.size(); ds++)
+        {
+            const auto &rate = captureRates[ds];
+            if (rate.offered > 0)
+            {
+                printf("  %-8s %8u %8u %6.1f%%\n", OpenAce::dataSourceToString(static_cast<OpenAce::DataSource>(ds)),
+                       rate.offered, rate.captured, 100.0 * rate.captured / rate.offered);
+            }
+        }
+    }
+
+    printf("\nModules\n");
+    for (auto *module : modules)
+    {
+        if (module != &radioTunerRx || numRadios > 0)
+        {
+            printModule(*module);
+        }
+    }
+    for (uint8_t r = 0; r < numRadios; r++)
+    {
+        printModule(*radios[r]);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 4 && strcmp(argv[1], "--convert") == 0)
+    {
+        std::string error;
+        int32_t records = Replay::Capture::convert(argv[2], argv[3], error);
+        if (records < 0)
+        {
+            printf("%s\n", error.c_str());
+            return 1;
+        }
+        printf("Wrote %d records to %s\n", records, argv[3]);
+        return 0;
+    }
+
+    const char *name = argv[0];
+    uint8_t numRadios = 0;
+    if (argc >= 4 && strcmp(argv[1], "--radios") == 0)
+    {
+        numRadios = atoi(argv[2]);
+        if (numRadios < 1 || numRadios > OPEN_ACE_MAX_RADIOS)
+        {
+            printf("Between 1 and %d radios can be simulated\n", OPEN_ACE_MAX_RADIOS);
+            return 1;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+
+    if (argc == 2 || argc == 3)
+    {
+        return replay(argv[1], argc == 3 ? atoi(argv[2]) : 5, numRadios);
+    }
+
+    printf("Usage: %s [--radios n] <capture.bin> [seconds]\n", name);
+    printf("       %s --convert <capture.txt> <capture.bin>\n", name);
+    return 1;
+}
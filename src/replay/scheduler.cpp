@@ -0,0 +1,727 @@
+#include "scheduler.hpp"
+
+/* System. */
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+/* FreeRTOS. */
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "timers.h"
+
+/* Mocks. */
+#include "pico/time.h"
+
+namespace Replay
+{
+    // Owner of a mutex taken from the thread that drives the scheduler
+    static const char DRIVER_OWNER = 0;
+
+    Scheduler::Scheduler() : running(nullptr), terminating(false), nowUs(0), runSequence(0)
+    {
+        setTime(0);
+    }
+
+    Scheduler::~Scheduler()
+    {
+        shutdown();
+    }
+
+    Scheduler &Scheduler::instance()
+    {
+        static Scheduler scheduler;
+        return scheduler;
+    }
+
+    uint64_t Scheduler::ticksToUs(TickType_t ticks)
+    {
+        return static_cast<uint64_t>(ticks) * portTICK_PERIOD_MS * 1'000;
+    }
+
+    uint64_t Scheduler::wallClockUs()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void Scheduler::setTime(uint64_t us)
+    {
+        nowUs = us;
+        get_absolute_timeValue = us;
+        time_us_64Value = us;
+    }
+
+    const void *Scheduler::owner() const
+    {
+        return running != nullptr ? static_cast<const void *>(running) : &DRIVER_OWNER;
+    }
+
+    Scheduler::Task *Scheduler::nextReady()
+    {
+        Task *next = nullptr;
+        bool nextTimedOut = false;
+        for (auto &task : tasks)
+        {
+            bool timedOut = false;
+            if (task->state == Task::State::BLOCKED)
+            {
+                if (task->until && task->until())
+                {
+                    timedOut = false;
+                }
+                else if (task->wakeUs <= nowUs)
+                {
+                    timedOut = true;
+                }
+                else
+                {
+                    continue;
+                }
+            }
+            else if (task->state != Task::State::READY)
+            {
+                continue;
+            }
+
+            if (next == nullptr || task->priority > next->priority ||
+                (task->priority == next->priority && task->lastRun < next->lastRun))
+            {
+                next = task.get();
+                nextTimedOut = timedOut;
+            }
+        }
+
+        if (next != nullptr)
+        {
+            next->timedOut = nextTimedOut;
+            next->state = Task::State::READY;
+        }
+        return next;
+    }
+
+    uint64_t Scheduler::nextEventUs() const
+    {
+        uint64_t next = UINT64_MAX;
+        for (const auto &timer : timers)
+        {
+            if (timer->active)
+            {
+                next = std::min(next, timer->expiryUs);
+            }
+        }
+        for (const auto &task : tasks)
+        {
+            if (task->state == Task::State::BLOCKED)
+            {
+                next = std::min(next, task->wakeUs);
+            }
+        }
+        return next;
+    }
+
+    void Scheduler::fireTimers()
+    {
+        while (true)
+        {
+            // Earliest expiry first, timers that expire together fire in order of creation
+            Timer *due = nullptr;
+            for (auto &timer : timers)
+            {
+                if (timer->active && timer->expiryUs <= nowUs && (due == nullptr || timer->expiryUs < due->expiryUs))
+                {
+                    due = timer.get();
+                }
+            }
+            if (due == nullptr)
+            {
+                return;
+            }
+
+            if (due->autoReload)
+            {
+                due->expiryUs += due->periodUs;
+            }
+            else
+            {
+                due->active = false;
+            }
+            due->callback(due);
+        }
+    }
+
+    void Scheduler::resume(Task &task)
+    {
+        std::unique_lock<std::mutex> lock{batonMutex};
+        task.lastRun = ++runSequence;
+        running = &task;
+        if (!task.thread.joinable())
+        {
+            task.thread = std::thread(&Scheduler::taskEntry, this, std::ref(task));
+        }
+        baton.notify_all();
+        baton.wait(lock, [this]
+                   { return running == nullptr; });
+    }
+
+    void Scheduler::taskEntry(Task &task)
+    {
+        {
+            std::unique_lock<std::mutex> lock{batonMutex};
+            baton.wait(lock, [this, &task]
+                       { return running == &task; });
+        }
+
+        task.activations++;
+        task.activationStartUs = wallClockUs();
+        try
+        {
+            if (!terminating)
+            {
+                task.function(task.parameters);
+            }
+        }
+        catch (const Terminated &)
+        {
+        }
+        uint64_t elapsedUs = wallClockUs() - task.activationStartUs;
+        task.totalUs += elapsedUs;
+        task.maxUs = std::max(task.maxUs, elapsedUs);
+        task.state = Task::State::DELETED;
+        task.exited = true;
+
+        std::lock_guard<std::mutex> lock{batonMutex};
+        running = nullptr;
+        baton.notify_all();
+    }
+
+    bool Scheduler::wait(const std::function<bool()> &until, TickType_t ticks)
+    {
+        if (until && until())
+        {
+            return true;
+        }
+        if (ticks == 0)
+        {
+            return false;
+        }
+        uint64_t wakeUs = ticks == portMAX_DELAY ? UINT64_MAX : nowUs + ticksToUs(ticks);
+
+        // The driver has no thread to block, it runs the scheduler until the condition is met
+        if (running == nullptr)
+        {
+            runUntil(wakeUs, until);
+            return until && until();
+        }
+
+        Task &task = *running;
+        if (task.state == Task::State::DELETED)
+        {
+            // vTaskDelete(nullptr) never returns on FreeRTOS
+            throw Terminated{};
+        }
+        task.until = until;
+        task.wakeUs = wakeUs;
+        task.state = Task::State::BLOCKED;
+
+        uint64_t elapsedUs = wallClockUs() - task.activationStartUs;
+        task.totalUs += elapsedUs;
+        task.maxUs = std::max(task.maxUs, elapsedUs);
+
+        {
+            std::unique_lock<std::mutex> lock{batonMutex};
+            running = nullptr;
+            baton.notify_all();
+            baton.wait(lock, [this, &task]
+                       { return running == &task; });
+        }
+
+        if (terminating)
+        {
+            throw Terminated{};
+        }
+        task.activations++;
+        task.activationStartUs = wallClockUs();
+        task.until = nullptr;
+        return !task.timedOut;
+    }
+
+    void Scheduler::runUntil(uint64_t untilUs, const std::function<bool()> &done)
+    {
+        while (!(done && done()))
+        {
+            if (Task *task = nextReady())
+            {
+                resume(*task);
+                continue;
+            }
+
+            uint64_t next = nextEventUs();
+            if (next > untilUs)
+            {
+                setTime(std::max(nowUs, untilUs));
+                return;
+            }
+            setTime(std::max(nowUs, next));
+            fireTimers();
+        }
+    }
+
+    void Scheduler::shutdown()
+    {
+        terminating = true;
+        for (auto &task : tasks)
+        {
+            if (task->thread.joinable() && !task->exited)
+            {
+                resume(*task);
+            }
+            task->state = Task::State::DELETED;
+        }
+        for (auto &task : tasks)
+        {
+            if (task->thread.joinable())
+            {
+                task->thread.join();
+            }
+        }
+    }
+
+    std::vector<Scheduler::TaskStatistics> Scheduler::taskStatistics() const
+    {
+        std::vector<TaskStatistics> statistics;
+        for (const auto &task : tasks)
+        {
+            statistics.push_back({task->name, task->activations, task->totalUs, task->maxUs});
+        }
+        return statistics;
+    }
+
+    TaskHandle_t Scheduler::createTask(TaskFunction_t function, const char *name, void *parameters, UBaseType_t priority)
+    {
+        Task *task = new Task;
+        task->name = name;
+        task->function = function;
+        task->parameters = parameters;
+        task->priority = priority;
+        tasks.emplace_back(task);
+        return task;
+    }
+
+    void Scheduler::deleteTask(TaskHandle_t handle)
+    {
+        Task *task = handle == nullptr ? running : handle;
+        if (task == nullptr)
+        {
+            return;
+        }
+        // A task deleting itself returns from it's task function right after, other tasks are simply never run again
+        task->state = Task::State::DELETED;
+        task->until = nullptr;
+    }
+
+    eTaskState Scheduler::taskState(TaskHandle_t handle) const
+    {
+        if (handle == nullptr)
+        {
+            return eInvalid;
+        }
+        if (handle == running)
+        {
+            return eRunning;
+        }
+        switch (handle->state)
+        {
+        case Task::State::READY:
+            return eReady;
+        case Task::State::BLOCKED:
+            return eBlocked;
+        default:
+            return eDeleted;
+        }
+    }
+
+    TaskHandle_t Scheduler::currentTask() const
+    {
+        return running;
+    }
+
+    BaseType_t Scheduler::notify(TaskHandle_t handle, uint32_t value, eNotifyAction action)
+    {
+        if (handle == nullptr || handle->state == Task::State::DELETED)
+        {
+            return pdFAIL;
+        }
+
+        switch (action)
+        {
+        case eSetBits:
+            handle->notifyValue |= value;
+            break;
+        case eIncrement:
+            handle->notifyValue++;
+            break;
+        case eSetValueWithOverwrite:
+            handle->notifyValue = value;
+            break;
+        case eSetValueWithoutOverwrite:
+            if (handle->notifyPending)
+            {
+                return pdFAIL;
+            }
+            handle->notifyValue = value;
+            break;
+        case eNoAction:
+            break;
+        }
+        handle->notifyPending = true;
+        return pdPASS;
+    }
+
+    uint32_t Scheduler::notifyTake(bool clearOnExit, TickType_t ticks)
+    {
+        Task *task = running;
+        if (task == nullptr)
+        {
+            return 0;
+        }
+
+        wait([task]
+             { return task->notifyValue != 0; }, ticks);
+
+        uint32_t value = task->notifyValue;
+        if (value != 0)
+        {
+            task->notifyValue = clearOnExit ? 0 : value - 1;
+        }
+        task->notifyPending = task->notifyValue != 0;
+        return value;
+    }
+
+    void Scheduler::delay(TickType_t ticks)
+    {
+        wait(nullptr, ticks);
+    }
+
+    TimerHandle_t Scheduler::createTimer(const char *name, TickType_t period, bool autoReload, void *id, TimerCallbackFunction_t callback)
+    {
+        timers.emplace_back(new Timer{name, ticksToUs(period), autoReload, id, callback, false, false, 0});
+        return timers.back().get();
+    }
+
+    void Scheduler::startTimer(TimerHandle_t handle)
+    {
+        if (handle != nullptr && !handle->deleted)
+        {
+            handle->active = true;
+            handle->expiryUs = nowUs + handle->periodUs;
+        }
+    }
+
+    void Scheduler::stopTimer(TimerHandle_t handle)
+    {
+        if (handle != nullptr)
+        {
+            handle->active = false;
+        }
+    }
+
+    void Scheduler::changeTimerPeriod(TimerHandle_t handle, TickType_t period)
+    {
+        if (handle != nullptr)
+        {
+            // Like FreeRTOS, changing the period of a dormant timer also starts it
+            handle->periodUs = ticksToUs(period);
+            startTimer(handle);
+        }
+    }
+
+    void Scheduler::deleteTimer(TimerHandle_t handle)
+    {
+        if (handle != nullptr)
+        {
+            handle->active = false;
+            handle->deleted = true;
+        }
+    }
+
+    QueueHandle_t Scheduler::createQueue(size_t length, size_t itemSize)
+    {
+        queues.emplace_back(new Queue{false, false, nullptr, 0, length, itemSize, {}});
+        return queues.back().get();
+    }
+
+    QueueHandle_t Scheduler::createMutex(bool recursive)
+    {
+        queues.emplace_back(new Queue{true, recursive, nullptr, 0, 1, 0, {}});
+        return queues.back().get();
+    }
+
+    BaseType_t Scheduler::queueSend(QueueHandle_t handle, const void *item, TickType_t ticks)
+    {
+        if (handle == nullptr || handle->isMutex)
+        {
+            return pdFAIL;
+        }
+        if (!wait([handle]
+                  { return handle->items.size() < handle->length; }, ticks))
+        {
+            return pdFAIL;
+        }
+        const uint8_t *bytes = static_cast<const uint8_t *>(item);
+        handle->items.emplace_back(bytes, bytes + handle->itemSize);
+        return pdPASS;
+    }
+
+    BaseType_t Scheduler::queueReceive(QueueHandle_t handle, void *item, TickType_t ticks)
+    {
+        if (handle == nullptr || handle->isMutex)
+        {
+            return pdFAIL;
+        }
+        if (!wait([handle]
+                  { return !handle->items.empty(); }, ticks))
+        {
+            return pdFAIL;
+        }
+        memcpy(item, handle->items.front().data(), handle->itemSize);
+        handle->items.pop_front();
+        return pdPASS;
+    }
+
+    BaseType_t Scheduler::mutexTake(QueueHandle_t handle, bool recursive, TickType_t ticks)
+    {
+        if (handle == nullptr || !handle->isMutex)
+        {
+            return pdFAIL;
+        }
+        const void *self = owner();
+        if (recursive && handle->holdCount > 0 && handle->owner == self)
+        {
+            handle->holdCount++;
+            return pdPASS;
+        }
+        if (!wait([handle]
+                  { return handle->holdCount == 0; }, ticks))
+        {
+            return pdFAIL;
+        }
+        handle->owner = self;
+        handle->holdCount = 1;
+        return pdPASS;
+    }
+
+    BaseType_t Scheduler::mutexGive(QueueHandle_t handle, bool recursive)
+    {
+        if (handle == nullptr || !handle->isMutex || handle->holdCount == 0 || handle->owner != owner())
+        {
+            return pdFAIL;
+        }
+        handle->holdCount = recursive ? handle->holdCount - 1 : 0;
+        if (handle->holdCount == 0)
+        {
+            handle->owner = nullptr;
+        }
+        return pdPASS;
+    }
+
+    void Scheduler::deleteQueue(QueueHandle_t handle)
+    {
+        if (handle != nullptr)
+        {
+            handle->items.clear();
+        }
+    }
+}
+
+/**
+ * FreeRTOS API
+ */
+using Replay::Scheduler;
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char *const pcName, const configSTACK_DEPTH_TYPE usStackDepth, void *const pvParameters, UBaseType_t uxPriority, TaskHandle_t *const pxCreatedTask)
+{
+    (void)usStackDepth;
+    TaskHandle_t handle = Scheduler::instance().createTask(pxTaskCode, pcName, pvParameters, uxPriority);
+    if (pxCreatedTask != nullptr)
+    {
+        *pxCreatedTask = handle;
+    }
+    return pdPASS;
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t pxTaskCode, const char *const pcName, const configSTACK_DEPTH_TYPE usStackDepth, void *const pvParameters, UBaseType_t uxPriority, StackType_t *puxStackBuffer, StaticTask_t *pxTaskBuffer)
+{
+    (void)usStackDepth;
+    (void)puxStackBuffer;
+    (void)pxTaskBuffer;
+    return Scheduler::instance().createTask(pxTaskCode, pcName, pvParameters, uxPriority);
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete)
+{
+    Scheduler::instance().deleteTask(xTaskToDelete);
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay)
+{
+    Scheduler::instance().delay(xTicksToDelay);
+}
+
+BaseType_t xTaskNotify(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction)
+{
+    return Scheduler::instance().notify(xTaskToNotify, ulValue, eAction);
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    if (pxHigherPriorityTaskWoken != nullptr)
+    {
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    }
+    return Scheduler::instance().notify(xTaskToNotify, ulValue, eAction);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    return Scheduler::instance().notifyTake(xClearCountOnExit == pdTRUE, xTicksToWait);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return Scheduler::instance().currentTask();
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return static_cast<TickType_t>(Scheduler::instance().now() / 1'000 / portTICK_PERIOD_MS);
+}
+
+eTaskState eTaskGetState(TaskHandle_t xTask)
+{
+    return Scheduler::instance().taskState(xTask);
+}
+
+TimerHandle_t xTimerCreate(const char *const pcTimerName, const TickType_t xTimerPeriodInTicks, const BaseType_t xAutoReload, void *const pvTimerID, TimerCallbackFunction_t pxCallbackFunction)
+{
+    return Scheduler::instance().createTimer(pcTimerName, xTimerPeriodInTicks, xAutoReload == pdTRUE, pvTimerID, pxCallbackFunction);
+}
+
+TimerHandle_t xTimerCreateStatic(const char *const pcTimerName, const TickType_t xTimerPeriodInTicks, const BaseType_t xAutoReload, void *const pvTimerID, TimerCallbackFunction_t pxCallbackFunction, StaticTimer_t *pxTimerBuffer)
+{
+    (void)pxTimerBuffer;
+    return xTimerCreate(pcTimerName, xTimerPeriodInTicks, xAutoReload, pvTimerID, pxCallbackFunction);
+}
+
+void *pvTimerGetTimerID(const TimerHandle_t xTimer)
+{
+    return xTimer != nullptr ? xTimer->id : nullptr;
+}
+
+BaseType_t xTimerStart(TimerHandle_t xTimer, TickType_t xTicksToWait)
+{
+    (void)xTicksToWait;
+    Scheduler::instance().startTimer(xTimer);
+    return pdPASS;
+}
+
+BaseType_t xTimerReset(TimerHandle_t xTimer, TickType_t xTicksToWait)
+{
+    return xTimerStart(xTimer, xTicksToWait);
+}
+
+BaseType_t xTimerStop(TimerHandle_t xTimer, TickType_t xTicksToWait)
+{
+    (void)xTicksToWait;
+    Scheduler::instance().stopTimer(xTimer);
+    return pdPASS;
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t xTimer, TickType_t xNewPeriod, TickType_t xTicksToWait)
+{
+    (void)xTicksToWait;
+    Scheduler::instance().changeTimerPeriod(xTimer, xNewPeriod);
+    return pdPASS;
+}
+
+BaseType_t xTimerDelete(TimerHandle_t xTimer, TickType_t xTicksToWait)
+{
+    (void)xTicksToWait;
+    Scheduler::instance().deleteTimer(xTimer);
+    return pdPASS;
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t xTimer)
+{
+    return xTimer != nullptr && xTimer->active ? pdTRUE : pdFALSE;
+}
+
+QueueHandle_t xQueueCreate(const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize)
+{
+    return Scheduler::instance().createQueue(uxQueueLength, uxItemSize);
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t xQueue, const void *const pvItemToQueue, TickType_t xTicksToWait)
+{
+    return Scheduler::instance().queueSend(xQueue, pvItemToQueue, xTicksToWait);
+}
+
+BaseType_t xQueueSendToBackFromISR(QueueHandle_t xQueue, const void *const pvItemToQueue, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    if (pxHigherPriorityTaskWoken != nullptr)
+    {
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    }
+    return Scheduler::instance().queueSend(xQueue, pvItemToQueue, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *const pvBuffer, TickType_t xTicksToWait)
+{
+    return Scheduler::instance().queueReceive(xQueue, pvBuffer, xTicksToWait);
+}
+
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t xQueue)
+{
+    return xQueue != nullptr ? xQueue->items.size() : 0;
+}
+
+void vQueueDelete(QueueHandle_t xQueue)
+{
+    Scheduler::instance().deleteQueue(xQueue);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return Scheduler::instance().createMutex(false);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *pxMutexBuffer)
+{
+    (void)pxMutexBuffer;
+    return Scheduler::instance().createMutex(false);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void)
+{
+    return Scheduler::instance().createMutex(true);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime)
+{
+    return Scheduler::instance().mutexTake(xSemaphore, false, xBlockTime);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore)
+{
+    return Scheduler::instance().mutexGive(xSemaphore, false);
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t xMutex, TickType_t xBlockTime)
+{
+    return Scheduler::instance().mutexTake(xMutex, true, xBlockTime);
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t xMutex)
+{
+    return Scheduler::instance().mutexGive(xMutex, true);
+}
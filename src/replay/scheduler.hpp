@@ -0,0 +1,184 @@
+#pragma once
+
+/* System. */
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* FreeRTOS. */
+#include "FreeRTOS.h"
+
+/**
+ * A FreeRTOS task as seen by the replay scheduler
+ */
+struct tskTaskControlBlock
+{
+    enum class State : uint8_t
+    {
+        READY,   // Created, or woken up and waiting for it's turn
+        BLOCKED, // Waiting for until() or wakeUs
+        DELETED
+    };
+
+    std::string name;
+    TaskFunction_t function = nullptr;
+    void *parameters = nullptr;
+    UBaseType_t priority = 0;
+    State state = State::READY;
+    std::function<bool()> until; // Condition the task is blocked on, empty for a delay
+    uint64_t wakeUs = UINT64_MAX; // Virtual time the block times out
+    bool timedOut = false;
+    uint32_t notifyValue = 0;
+    bool notifyPending = false;
+    uint64_t lastRun = 0; // Sequence number of the last activation, ready tasks of equal priority run round robin
+    std::thread thread;
+    bool exited = false; // The task function returned or was unwound
+
+    uint32_t activations = 0;
+    uint64_t totalUs = 0;
+    uint64_t maxUs = 0;
+    uint64_t activationStartUs = 0;
+};
+
+/**
+ * A FreeRTOS software timer
+ */
+struct tmrTimerControl
+{
+    std::string name;
+    uint64_t periodUs;
+    bool autoReload;
+    void *id;
+    TimerCallbackFunction_t callback;
+    bool active;
+    bool deleted;
+    uint64_t expiryUs;
+};
+
+/**
+ * A FreeRTOS queue, or a mutex when isMutex is set
+ */
+struct QueueDefinition
+{
+    bool isMutex;
+    bool recursive;
+    const void *owner;
+    uint32_t holdCount;
+    size_t length;
+    size_t itemSize;
+    std::deque<std::vector<uint8_t>> items;
+};
+
+namespace Replay
+{
+    /**
+     * Deterministic scheduler behind the FreeRTOS API of the replay harness.
+     *
+     * Every task runs on it's own thread, but only one thread runs at any time. A task runs until it blocks in one of the
+     * FreeRTOS calls, then the highest priority ready task runs next, tasks of the same priority take turns.
+     * There is no preemption and no time slicing, so the order of execution only depends on the replayed input.
+     * Time is virtual and only advances when no task is ready. Timer callbacks run on the thread that drives the scheduler,
+     * like they would on the FreeRTOS timer service task.
+     */
+    class Scheduler
+    {
+    public:
+        using Task = tskTaskControlBlock;
+        using Timer = tmrTimerControl;
+        using Queue = QueueDefinition;
+
+        struct TaskStatistics
+        {
+            std::string name;
+            uint32_t activations;
+            uint64_t totalUs; // Wall clock time spent running
+            uint64_t maxUs;   // Longest single activation in wall clock time
+        };
+
+    private:
+        // Thrown from a blocking call to unwind a task during shutdown
+        struct Terminated
+        {
+        };
+
+        std::vector<std::unique_ptr<Task>> tasks;
+        std::vector<std::unique_ptr<Timer>> timers;
+        std::vector<std::unique_ptr<Queue>> queues;
+
+        std::mutex batonMutex;
+        std::condition_variable baton;
+        Task *running;
+        bool terminating;
+        uint64_t nowUs;
+        uint64_t runSequence;
+
+        Scheduler();
+
+        void setTime(uint64_t us);
+        Task *nextReady();
+        uint64_t nextEventUs() const;
+        void fireTimers();
+        void resume(Task &task);
+        void taskEntry(Task &task);
+        bool wait(const std::function<bool()> &until, TickType_t ticks);
+        static uint64_t ticksToUs(TickType_t ticks);
+        static uint64_t wallClockUs();
+        const void *owner() const;
+
+    public:
+        ~Scheduler();
+
+        Scheduler(const Scheduler &) = delete;
+        Scheduler &operator=(const Scheduler &) = delete;
+
+        static Scheduler &instance();
+
+        /**
+         * Current virtual time in us, this is also what time_us_64() and get_absolute_time() return
+         */
+        uint64_t now() const
+        {
+            return nowUs;
+        }
+
+        /**
+         * Run tasks and timers until virtual time reaches untilUs, or until done() returns true
+         */
+        void runUntil(uint64_t untilUs, const std::function<bool()> &done = nullptr);
+
+        /**
+         * Unwind all tasks and join their threads, no task runs after this
+         */
+        void shutdown();
+
+        std::vector<TaskStatistics> taskStatistics() const;
+
+        TaskHandle_t createTask(TaskFunction_t function, const char *name, void *parameters, UBaseType_t priority);
+        void deleteTask(TaskHandle_t handle);
+        eTaskState taskState(TaskHandle_t handle) const;
+        TaskHandle_t currentTask() const;
+        BaseType_t notify(TaskHandle_t handle, uint32_t value, eNotifyAction action);
+        uint32_t notifyTake(bool clearOnExit, TickType_t ticks);
+        void delay(TickType_t ticks);
+
+        TimerHandle_t createTimer(const char *name, TickType_t period, bool autoReload, void *id, TimerCallbackFunction_t callback);
+        void startTimer(TimerHandle_t handle);
+        void stopTimer(TimerHandle_t handle);
+        void changeTimerPeriod(TimerHandle_t handle, TickType_t period);
+        void deleteTimer(TimerHandle_t handle);
+
+        QueueHandle_t createQueue(size_t length, size_t itemSize);
+        QueueHandle_t createMutex(bool recursive);
+        BaseType_t queueSend(QueueHandle_t handle, const void *item, TickType_t ticks);
+        BaseType_t queueReceive(QueueHandle_t handle, void *item, TickType_t ticks);
+        BaseType_t mutexTake(QueueHandle_t handle, bool recursive, TickType_t ticks);
+        BaseType_t mutexGive(QueueHandle_t handle, bool recursive);
+        void deleteQueue(QueueHandle_t handle);
+    };
+}